@@ -1,60 +1,55 @@
 #include "demo_nodes.hpp"
+#include <QDataStream>
 #include <QGraphicsProxyWidget>
 #include <QGridLayout>
 #include <QKeyEvent>
 #include <QLabel>
 #include <QLineEdit>
 #include <QMenu>
+#include <QThread>
+#include <QtConcurrent>
+#include <qnodes/node_type.hpp>
+#include <qnodes/result_cache.hpp>
+#include <qnodes/stream.hpp>
+#include <qnodes/typed_slot.hpp>
 
 Vec3Editor::Vec3Editor() {
     setAttribute(Qt::WA_TranslucentBackground);
 
     QGridLayout *layout = new QGridLayout(this);
 
+    m_x = new QLineEdit("0");
+    m_y = new QLineEdit("0");
+    m_z = new QLineEdit("0");
+
     layout->addWidget(new QLabel("X:"), 0, 0);
-    layout->addWidget(new QLineEdit("0"), 0, 1);
+    layout->addWidget(m_x, 0, 1);
 
     layout->addWidget(new QLabel("Y:"), 1, 0);
-    layout->addWidget(new QLineEdit("0"), 1, 1);
+    layout->addWidget(m_y, 1, 1);
 
     layout->addWidget(new QLabel("Z:"), 2, 0);
-    layout->addWidget(new QLineEdit("0"), 2, 1);
+    layout->addWidget(m_z, 2, 1);
+}
+
+void Vec3Editor::setValue(const QVector3D &value) {
+    m_x->setText(QString::number(double(value.x())));
+    m_y->setText(QString::number(double(value.y())));
+    m_z->setText(QString::number(double(value.z())));
+}
+
+QVector3D Vec3Editor::value() const {
+    return QVector3D(m_x->text().toFloat(), m_y->text().toFloat(),
+                     m_z->text().toFloat());
 }
 
 DemoNode::DemoNode() {
+    setBodyCacheEnabled(true);
+
     connect(this, &qnodes::Node::contextMenuRequested, this,
             &DemoNode::showContextMenu);
 }
 
-std::vector<DemoNode::TypeListItem> DemoNode::getTypes() {
-    return {
-        TypeListItem{"Float", FloatNode::bgColor(),
-                     []() -> DemoNode * { return new FloatNode(); }},
-        TypeListItem{"Vector3", Vec3Node::bgColor(),
-                     []() -> DemoNode * { return new Vec3Node(); }},
-        TypeListItem{
-            "Add", BinaryNode::bgColor(BinaryNode::Add),
-            []() -> DemoNode * { return new BinaryNode(BinaryNode::Add); }},
-        TypeListItem{"Subtract", BinaryNode::bgColor(BinaryNode::Subtract),
-                     []() -> DemoNode * {
-                         return new BinaryNode(BinaryNode::Subtract);
-                     }},
-        TypeListItem{"Multiply", BinaryNode::bgColor(BinaryNode::Multiply),
-                     []() -> DemoNode * {
-                         return new BinaryNode(BinaryNode::Multiply);
-                     }},
-        TypeListItem{
-            "Divide", BinaryNode::bgColor(BinaryNode::Divide),
-            []() -> DemoNode * { return new BinaryNode(BinaryNode::Divide); }},
-        TypeListItem{
-            "Dot product", BinaryNode::bgColor(BinaryNode::Dot),
-            []() -> DemoNode * { return new BinaryNode(BinaryNode::Dot); }},
-        TypeListItem{
-            "Cross product", BinaryNode::bgColor(BinaryNode::Cross),
-            []() -> DemoNode * { return new BinaryNode(BinaryNode::Cross); }},
-    };
-}
-
 void DemoNode::keyReleaseEvent(QKeyEvent *event) {
     if (event->key() == Qt::Key_Delete) {
         deleteLater();
@@ -73,32 +68,89 @@ void DemoNode::showContextMenu(const QPoint &screenPos) {
 FloatNode::FloatNode() {
     setLabel("Float");
 
-    auto slot = addSlot(qnodes::Slot::Output, "value");
+    auto slot = addSlot(std::make_unique<qnodes::TypedSlot<double>>(
+        qnodes::Slot::Output, "value"));
     slot->setToolTip("float");
 
+    m_editor = new QLineEdit("0");
+
     QGraphicsProxyWidget *editor_proxy = new QGraphicsProxyWidget();
-    editor_proxy->setWidget(new QLineEdit("0"));
+    editor_proxy->setWidget(m_editor);
     setContent(editor_proxy);
 
     setBackgroundBrush(bgColor());
 }
 
+// Streams a fixed number of chunks filled with a constant.
+class ConstantStream : public qnodes::StreamProcessor {
+public:
+    static const int numChunks = 4096;
+
+    explicit ConstantStream(float value) : m_value(value) {}
+
+    bool process(const std::vector<const qnodes::Chunk *> &inputs,
+                 const std::vector<qnodes::Chunk *> &outputs) override {
+        ((void)inputs);
+
+        if (m_count == numChunks) {
+            return false;
+        }
+
+        qnodes::Chunk *out = outputs[0];
+        std::fill(out->data(), out->data() + out->capacity(), m_value);
+        out->setSize(out->capacity());
+
+        ++m_count;
+        return true;
+    }
+
+private:
+    float m_value;
+    int m_count = 0;
+};
+
 QColor FloatNode::bgColor() { return QColor(26, 188, 156); }
 
+QVariantList FloatNode::compute(const QVariantList &inputs) {
+    ((void)inputs);
+    return {m_editor->text().toDouble()};
+}
+
+bool FloatNode::isPure() const { return true; }
+
+std::unique_ptr<qnodes::StreamProcessor> FloatNode::createStreamProcessor() {
+    return std::make_unique<ConstantStream>(m_editor->text().toFloat());
+}
+
+quint64 FloatNode::parameterHash() const {
+    return qHash(m_editor->text().toDouble());
+}
+
+QByteArray FloatNode::typeName() const { return "float"; }
+
+QByteArray FloatNode::saveState() const { return m_editor->text().toUtf8(); }
+
+void FloatNode::restoreState(const QByteArray &state) {
+    m_editor->setText(QString::fromUtf8(state));
+}
+
 Vec3Node::Vec3Node() {
     setLabel("Vector3");
 
-    auto slot = addSlot(qnodes::Slot::Output, "value");
+    auto slot = addSlot(std::make_unique<qnodes::TypedSlot<QVector3D>>(
+        qnodes::Slot::Output, "value"));
     slot->setToolTip("vec3");
-    slot = addSlot(qnodes::Slot::Output, "x");
-    slot->setToolTip("float");
-    slot = addSlot(qnodes::Slot::Output, "y");
-    slot->setToolTip("float");
-    addSlot(qnodes::Slot::Output, "z");
-    slot->setToolTip("float");
+
+    for (const char *component : {"x", "y", "z"}) {
+        slot = addSlot(std::make_unique<qnodes::TypedSlot<double>>(
+            qnodes::Slot::Output, component));
+        slot->setToolTip("float");
+    }
+
+    m_editor = new Vec3Editor();
 
     QGraphicsProxyWidget *editor_proxy = new QGraphicsProxyWidget();
-    editor_proxy->setWidget(new Vec3Editor());
+    editor_proxy->setWidget(m_editor);
     setContent(editor_proxy);
 
     setBackgroundBrush(bgColor());
@@ -106,37 +158,358 @@ Vec3Node::Vec3Node() {
 
 QColor Vec3Node::bgColor() { return QColor(46, 204, 113); }
 
+QVariantList Vec3Node::compute(const QVariantList &inputs) {
+    ((void)inputs);
+
+    QVector3D v = m_editor->value();
+    return {QVariant::fromValue(v), double(v.x()), double(v.y()),
+            double(v.z())};
+}
+
+bool Vec3Node::isPure() const { return true; }
+
+quint64 Vec3Node::parameterHash() const {
+    return qnodes::ResultCache::hashValue(
+        QVariant::fromValue(m_editor->value()));
+}
+
+QByteArray Vec3Node::typeName() const { return "vec3"; }
+
+QByteArray Vec3Node::saveState() const {
+    QByteArray state;
+    QDataStream out(&state, QIODevice::WriteOnly);
+    out << m_editor->value();
+    return state;
+}
+
+void Vec3Node::restoreState(const QByteArray &state) {
+    QVector3D value;
+    QDataStream in(state);
+    in >> value;
+
+    if (in.status() == QDataStream::Ok) {
+        m_editor->setValue(value);
+    }
+}
+
+DelayNode::DelayNode() {
+    setLabel("Delay");
+
+    auto slot = addSlot(qnodes::Slot::Input, "value");
+    slot->setToolTip("any");
+    slot = addSlot(qnodes::Slot::Output, "value");
+    slot->setToolTip("any");
+
+    setBackgroundBrush(bgColor());
+}
+
+QColor DelayNode::bgColor() { return QColor(230, 126, 34); }
+
+QVariantList DelayNode::compute(const QVariantList &inputs) {
+    return {inputs.value(0)};
+}
+
+QFuture<QVariantList> DelayNode::computeAsync(const QVariantList &inputs) {
+    QFutureInterface<QVariantList> iface;
+    iface.setProgressRange(0, 100);
+    iface.reportStarted();
+
+    QtConcurrent::run([iface, inputs]() mutable {
+        for (int i = 1; (i <= 100) && !iface.isCanceled(); ++i) {
+            QThread::msleep(20);
+            iface.setProgressValue(i);
+        }
+
+        QVariantList outputs = {inputs.value(0)};
+        iface.reportFinished(&outputs);
+    });
+
+    return iface.future();
+}
+
+bool DelayNode::isPure() const { return true; }
+
+QByteArray DelayNode::typeName() const { return "delay"; }
+
+class PassThroughStream : public qnodes::StreamProcessor {
+public:
+    bool process(const std::vector<const qnodes::Chunk *> &inputs,
+                 const std::vector<qnodes::Chunk *> &outputs) override {
+        const qnodes::Chunk *in = inputs[0];
+        qnodes::Chunk *out = outputs[0];
+
+        if (in) {
+            std::copy(in->data(), in->data() + in->size(), out->data());
+        }
+
+        out->setSize(in ? in->size() : 0);
+
+        return true;
+    }
+};
+
+std::unique_ptr<qnodes::StreamProcessor> DelayNode::createStreamProcessor() {
+    return std::make_unique<PassThroughStream>();
+}
+
+enum PortTypeFlags { FloatPort = 1, Vec3Port = 2 };
+
+static qnodes::PortTypeMask toMask(int flags) {
+    qnodes::PortTypeMask mask = 0;
+    if (flags & FloatPort) {
+        mask |= qnodes::PortTypeRegistry::maskOf(qnodes::portTypeId<double>());
+    }
+    if (flags & Vec3Port) {
+        mask |=
+            qnodes::PortTypeRegistry::maskOf(qnodes::portTypeId<QVector3D>());
+    }
+
+    return mask;
+}
+
+static QString toTypeString(int flags) {
+    switch (flags) {
+    case FloatPort:
+        return "float";
+    case Vec3Port:
+        return "vec3";
+    default:
+        return "float or vec3";
+    }
+}
+
 struct BinaryNodeType {
+    const char *id;
     QString label;
     QColor color;
-    QString in1Type, in2Type;
-    QString outType;
+    int in1Type, in2Type;
+    int outType;
 };
 
 static const BinaryNodeType g_types[] = {
-    {"Add", QColor(52, 152, 219), "float or vec3", "float or vec3",
-     "float or vec3"},
-    {"Subtract", QColor(155, 89, 182), "float or vec3", "float or vec3",
-     "float or vec3"},
-    {"Multiply", QColor(22, 160, 133), "float or vec3", "float",
-     "float or vec3"},
-    {"Divide", QColor(39, 174, 96), "float or vec3", "float", "float or vec3"},
-    {"Dot product", QColor(41, 128, 185), "vec3", "vec3", "float"},
-    {"Cross product", QColor(142, 68, 173), "vec3", "vec3", "vec3"}};
-
-BinaryNode::BinaryNode(Type type) {
+    {"add", "Add", QColor(52, 152, 219), FloatPort | Vec3Port,
+     FloatPort | Vec3Port, FloatPort | Vec3Port},
+    {"subtract", "Subtract", QColor(155, 89, 182), FloatPort | Vec3Port,
+     FloatPort | Vec3Port, FloatPort | Vec3Port},
+    {"multiply", "Multiply", QColor(22, 160, 133), FloatPort | Vec3Port,
+     FloatPort, FloatPort | Vec3Port},
+    {"divide", "Divide", QColor(39, 174, 96), FloatPort | Vec3Port, FloatPort,
+     FloatPort | Vec3Port},
+    {"dot", "Dot product", QColor(41, 128, 185), Vec3Port, Vec3Port,
+     FloatPort},
+    {"cross", "Cross product", QColor(142, 68, 173), Vec3Port, Vec3Port,
+     Vec3Port}};
+
+BinaryNode::BinaryNode(Type type) : m_type(type) {
     const auto &bnt = g_types[type];
 
     setLabel(bnt.label);
 
     auto slot = addSlot(qnodes::Slot::Input, "a");
-    slot->setToolTip(bnt.in1Type);
+    slot->setAcceptedTypes(toMask(bnt.in1Type));
+    slot->setToolTip(toTypeString(bnt.in1Type));
+
     slot = addSlot(qnodes::Slot::Input, "b");
-    slot->setToolTip(bnt.in2Type);
+    slot->setAcceptedTypes(toMask(bnt.in2Type));
+    slot->setToolTip(toTypeString(bnt.in2Type));
+
+    // Add, Subtract, Multiply and Divide produce the type of their first
+    // input, so their output stays untyped.
     slot = addSlot(qnodes::Slot::Output, "result");
-    slot->setToolTip(bnt.outType);
+    if (bnt.outType == FloatPort) {
+        slot->setPortType(qnodes::portTypeId<double>());
+    } else if (bnt.outType == Vec3Port) {
+        slot->setPortType(qnodes::portTypeId<QVector3D>());
+    }
+    slot->setToolTip(toTypeString(bnt.outType));
 
     setBackgroundBrush(bgColor(type));
 }
 
 QColor BinaryNode::bgColor(Type type) { return g_types[type].color; }
+
+static bool isVec3(const QVariant &v) {
+    return v.userType() == QMetaType::QVector3D;
+}
+
+static bool isFloat(const QVariant &v) {
+    return v.userType() == QMetaType::Double;
+}
+
+QVariantList BinaryNode::compute(const QVariantList &inputs) {
+    const QVariant a = inputs.value(0);
+    const QVariant b = inputs.value(1);
+
+    QVariant result;
+
+    switch (m_type) {
+    case Add:
+    case Subtract: {
+        double sign = (m_type == Add) ? 1.0 : -1.0;
+        if (isFloat(a) && isFloat(b)) {
+            result = a.toDouble() + sign * b.toDouble();
+        } else if (isVec3(a) && isVec3(b)) {
+            result = QVariant::fromValue(a.value<QVector3D>() +
+                                         float(sign) * b.value<QVector3D>());
+        }
+        break;
+    }
+    case Multiply:
+    case Divide: {
+        if (!isFloat(b)) {
+            break;
+        }
+
+        double factor = b.toDouble();
+        if (m_type == Divide) {
+            factor = 1.0 / factor;
+        }
+
+        if (isFloat(a)) {
+            result = a.toDouble() * factor;
+        } else if (isVec3(a)) {
+            result = QVariant::fromValue(a.value<QVector3D>() * float(factor));
+        }
+        break;
+    }
+    case Dot:
+        if (isVec3(a) && isVec3(b)) {
+            result = double(QVector3D::dotProduct(a.value<QVector3D>(),
+                                                  b.value<QVector3D>()));
+        }
+        break;
+    case Cross:
+        if (isVec3(a) && isVec3(b)) {
+            result = QVariant::fromValue(QVector3D::crossProduct(
+                a.value<QVector3D>(), b.value<QVector3D>()));
+        }
+        break;
+    }
+
+    return {result};
+}
+
+bool BinaryNode::isPure() const { return true; }
+
+quint64 BinaryNode::parameterHash() const {
+    return static_cast<quint64>(m_type);
+}
+
+QByteArray BinaryNode::typeName() const { return g_types[m_type].id; }
+
+// Element-wise arithmetic on float streams; a missing input counts as zero.
+class BinaryStream : public qnodes::StreamProcessor {
+public:
+    explicit BinaryStream(BinaryNode::Type type) : m_type(type) {}
+
+    bool process(const std::vector<const qnodes::Chunk *> &inputs,
+                 const std::vector<qnodes::Chunk *> &outputs) override {
+        const qnodes::Chunk *a = inputs[0];
+        const qnodes::Chunk *b = inputs[1];
+        qnodes::Chunk *out = outputs[0];
+
+        int size = std::max(a ? a->size() : 0, b ? b->size() : 0);
+        out->setSize(size);
+
+        float *dst = out->data();
+        for (int i = 0; i < size; ++i) {
+            float x = (a && (i < a->size())) ? a->data()[i] : 0.0f;
+            float y = (b && (i < b->size())) ? b->data()[i] : 0.0f;
+
+            switch (m_type) {
+            case BinaryNode::Add:
+                dst[i] = x + y;
+                break;
+            case BinaryNode::Subtract:
+                dst[i] = x - y;
+                break;
+            case BinaryNode::Multiply:
+                dst[i] = x * y;
+                break;
+            case BinaryNode::Divide:
+            default:
+                dst[i] = x / y;
+                break;
+            }
+        }
+
+        return true;
+    }
+
+private:
+    BinaryNode::Type m_type;
+};
+
+std::unique_ptr<qnodes::StreamProcessor> BinaryNode::createStreamProcessor() {
+    switch (m_type) {
+    case Add:
+    case Subtract:
+    case Multiply:
+    case Divide:
+        return std::make_unique<BinaryStream>(m_type);
+    default:
+        return nullptr;
+    }
+}
+
+static qnodes::PortTypeMask anyMask() {
+    return qnodes::PortTypeRegistry::maskOf(qnodes::PortTypeRegistry::anyType);
+}
+
+static qnodes::PortTypeId outputType(int flags) {
+    switch (flags) {
+    case FloatPort:
+        return qnodes::portTypeId<double>();
+    case Vec3Port:
+        return qnodes::portTypeId<QVector3D>();
+    default:
+        return qnodes::PortTypeRegistry::anyType;
+    }
+}
+
+static qnodes::NodeTypeInfo binaryType(BinaryNode::Type type) {
+    const auto &bnt = g_types[type];
+    QString category = (bnt.in1Type == Vec3Port) ? "Vector" : "Math";
+
+    return {bnt.id,
+            bnt.label,
+            category,
+            bnt.color,
+            {toMask(bnt.in1Type), toMask(bnt.in2Type)},
+            {outputType(bnt.outType)},
+            [type]() -> qnodes::Node * { return new BinaryNode(type); }};
+}
+
+static const qnodes::NodeTypeRegistrar g_registrars[] = {
+    qnodes::NodeTypeRegistrar(
+        {"float",
+         "Float",
+         "Values",
+         FloatNode::bgColor(),
+         {},
+         {qnodes::portTypeId<double>()},
+         []() -> qnodes::Node * { return new FloatNode(); }}),
+    qnodes::NodeTypeRegistrar(
+        {"vec3",
+         "Vector3",
+         "Values",
+         Vec3Node::bgColor(),
+         {},
+         {qnodes::portTypeId<QVector3D>(), qnodes::portTypeId<double>(),
+          qnodes::portTypeId<double>(), qnodes::portTypeId<double>()},
+         []() -> qnodes::Node * { return new Vec3Node(); }}),
+    qnodes::NodeTypeRegistrar(
+        {"delay",
+         "Delay",
+         "Flow",
+         DelayNode::bgColor(),
+         {anyMask()},
+         {qnodes::PortTypeRegistry::anyType},
+         []() -> qnodes::Node * { return new DelayNode(); }}),
+    qnodes::NodeTypeRegistrar(binaryType(BinaryNode::Add)),
+    qnodes::NodeTypeRegistrar(binaryType(BinaryNode::Subtract)),
+    qnodes::NodeTypeRegistrar(binaryType(BinaryNode::Multiply)),
+    qnodes::NodeTypeRegistrar(binaryType(BinaryNode::Divide)),
+    qnodes::NodeTypeRegistrar(binaryType(BinaryNode::Dot)),
+    qnodes::NodeTypeRegistrar(binaryType(BinaryNode::Cross)),
+};
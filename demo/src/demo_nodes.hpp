@@ -1,26 +1,29 @@
 #ifndef DEMO_NODES_HPP_INCLUDED
 #define DEMO_NODES_HPP_INCLUDED
 
+#include <QVector3D>
 #include <QWidget>
 #include <qnodes/node.hpp>
 
+class QLineEdit;
+
 class Vec3Editor : public QWidget {
 public:
     Vec3Editor();
+
+    void setValue(const QVector3D &value);
+    QVector3D value() const;
+
+private:
+    QLineEdit *m_x;
+    QLineEdit *m_y;
+    QLineEdit *m_z;
 };
 
 class DemoNode : public qnodes::Node {
 public:
-    struct TypeListItem {
-        QString name;
-        QColor color;
-        DemoNode *(*factoryFn)();
-    };
-
     DemoNode();
 
-    static std::vector<TypeListItem> getTypes();
-
 protected:
     void keyReleaseEvent(QKeyEvent *event) override;
 
@@ -33,6 +36,19 @@ public:
     FloatNode();
 
     static QColor bgColor();
+
+    QVariantList compute(const QVariantList &inputs) override;
+    bool isPure() const override;
+    quint64 parameterHash() const override;
+
+    std::unique_ptr<qnodes::StreamProcessor> createStreamProcessor() override;
+
+    QByteArray typeName() const override;
+    QByteArray saveState() const override;
+    void restoreState(const QByteArray &state) override;
+
+private:
+    QLineEdit *m_editor;
 };
 
 class Vec3Node : public DemoNode {
@@ -40,6 +56,33 @@ public:
     Vec3Node();
 
     static QColor bgColor();
+
+    QVariantList compute(const QVariantList &inputs) override;
+    bool isPure() const override;
+    quint64 parameterHash() const override;
+
+    QByteArray typeName() const override;
+    QByteArray saveState() const override;
+    void restoreState(const QByteArray &state) override;
+
+private:
+    Vec3Editor *m_editor;
+};
+
+// Passes its input through after a delay, to show asynchronous evaluation.
+class DelayNode : public DemoNode {
+public:
+    DelayNode();
+
+    static QColor bgColor();
+
+    QVariantList compute(const QVariantList &inputs) override;
+    QFuture<QVariantList> computeAsync(const QVariantList &inputs) override;
+    bool isPure() const override;
+
+    std::unique_ptr<qnodes::StreamProcessor> createStreamProcessor() override;
+
+    QByteArray typeName() const override;
 };
 
 class BinaryNode : public DemoNode {
@@ -50,6 +93,14 @@ public:
 
     static QColor bgColor(Type type);
 
+    QVariantList compute(const QVariantList &inputs) override;
+    bool isPure() const override;
+    quint64 parameterHash() const override;
+
+    std::unique_ptr<qnodes::StreamProcessor> createStreamProcessor() override;
+
+    QByteArray typeName() const override;
+
 private:
     Type m_type;
 };
@@ -0,0 +1,90 @@
+#include "graph_view.hpp"
+#include <QMouseEvent>
+#include <QPainter>
+#include <QRubberBand>
+#include <qnodes/scene.hpp>
+
+GraphView::GraphView(QWidget *parent)
+    : QGraphicsView(parent),
+      m_rubberBand(new QRubberBand(QRubberBand::Rectangle, viewport())) {}
+
+void GraphView::mousePressEvent(QMouseEvent *event) {
+    if ((event->button() != Qt::LeftButton) || itemAt(event->pos()) ||
+        !qobject_cast<qnodes::Scene *>(scene())) {
+        QGraphicsView::mousePressEvent(event);
+        return;
+    }
+
+    m_operation = (event->modifiers() & Qt::ControlModifier)
+                      ? Qt::AddToSelection
+                      : Qt::ReplaceSelection;
+    m_origin = event->pos();
+
+    if (event->modifiers() & Qt::AltModifier) {
+        m_tool = Lasso;
+        m_lasso = QPolygonF({mapToScene(m_origin)});
+    } else {
+        m_tool = RubberBand;
+        m_rubberBand->setGeometry(QRect(m_origin, QSize()));
+        m_rubberBand->show();
+    }
+
+    event->accept();
+}
+
+void GraphView::mouseMoveEvent(QMouseEvent *event) {
+    switch (m_tool) {
+    case RubberBand:
+        m_rubberBand->setGeometry(QRect(m_origin, event->pos()).normalized());
+        break;
+
+    case Lasso:
+        m_lasso.append(mapToScene(event->pos()));
+        viewport()->update();
+        break;
+
+    case NoTool:
+        QGraphicsView::mouseMoveEvent(event);
+        break;
+    }
+}
+
+void GraphView::mouseReleaseEvent(QMouseEvent *event) {
+    auto graphScene = qobject_cast<qnodes::Scene *>(scene());
+
+    if ((m_tool == NoTool) || (event->button() != Qt::LeftButton) ||
+        !graphScene) {
+        QGraphicsView::mouseReleaseEvent(event);
+        return;
+    }
+
+    if (m_tool == RubberBand) {
+        m_rubberBand->hide();
+        QRectF area =
+            mapToScene(QRect(m_origin, event->pos()).normalized())
+                .boundingRect();
+        graphScene->selectInRect(area, Qt::IntersectsItemShape, m_operation);
+    } else {
+        graphScene->selectInPolygon(m_lasso, Qt::IntersectsItemShape,
+                                    m_operation);
+        m_lasso.clear();
+        viewport()->update();
+    }
+
+    m_tool = NoTool;
+    event->accept();
+}
+
+void GraphView::drawForeground(QPainter *painter, const QRectF &rect) {
+    QGraphicsView::drawForeground(painter, rect);
+
+    if ((m_tool != Lasso) || (m_lasso.size() < 2)) {
+        return;
+    }
+
+    QColor color = palette().color(QPalette::Highlight);
+    painter->setPen(QPen(color, 0.0, Qt::DashLine));
+    color.setAlphaF(0.2);
+    painter->setBrush(color);
+    painter->drawPolygon(m_lasso);
+}
@@ -0,0 +1,32 @@
+#ifndef GRAPH_VIEW_HPP_INCLUDED
+#define GRAPH_VIEW_HPP_INCLUDED
+
+#include <QGraphicsView>
+#include <QPolygonF>
+
+class QRubberBand;
+
+// View with rubber-band selection on empty space, or a lasso while Alt is
+// held. Ctrl adds to the current selection.
+class GraphView : public QGraphicsView {
+public:
+    explicit GraphView(QWidget *parent = nullptr);
+
+protected:
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+
+    void drawForeground(QPainter *painter, const QRectF &rect) override;
+
+private:
+    enum SelectionTool { NoTool, RubberBand, Lasso };
+
+    SelectionTool m_tool = NoTool;
+    Qt::ItemSelectionOperation m_operation = Qt::ReplaceSelection;
+    QPoint m_origin;
+    QRubberBand *m_rubberBand;
+    QPolygonF m_lasso;
+};
+
+#endif // GRAPH_VIEW_HPP_INCLUDED
@@ -1,17 +1,32 @@
 #include "main_window.hpp"
 #include "demo_nodes.hpp"
 #include <QAction>
+#include <QActionGroup>
 #include <QApplication>
+#include <QClipboard>
+#include <QDockWidget>
 #include <QFile>
-#include <QGraphicsView>
+#include <QFileDialog>
+#include <QInputDialog>
 #include <QMenu>
 #include <QMenuBar>
+#include <QMessageBox>
+#include <QStatusBar>
 #include <QTextStream>
+#include <QThread>
 #include <QVBoxLayout>
+#include <algorithm>
 #include <qnodes/connection.hpp>
+#include <qnodes/graph_diff.hpp>
+#include <qnodes/group_node.hpp>
+#include <qnodes/overview.hpp>
+
+static qnodes::Node *createNode(const QByteArray &id) {
+    return qnodes::NodeTypeRegistry::global().create(id);
+}
 
 MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
-    m_scene = std::make_unique<QGraphicsScene>();
+    m_scene = std::make_unique<qnodes::Scene>();
 
     DemoNode *node = new Vec3Node();
     node->setPos(-100.0, -100.0);
@@ -29,14 +44,73 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
     QVBoxLayout *layout = new QVBoxLayout(central_widget);
     setCentralWidget(central_widget);
 
-    m_view = new QGraphicsView();
+    m_view = new GraphView();
     m_view->setScene(m_scene.get());
     m_view->setRenderHint(QPainter::Antialiasing);
     layout->addWidget(m_view);
 
+    qnodes::Overview *overview = new qnodes::Overview();
+    overview->setView(m_view);
+
+    QDockWidget *overviewDock = new QDockWidget("Overview");
+    overviewDock->setWidget(overview);
+    addDockWidget(Qt::RightDockWidgetArea, overviewDock);
+
+    m_palette = new qnodes::NodePalette(qnodes::NodeTypeRegistry::global(),
+                                        this);
+    connect(m_palette, &qnodes::NodePalette::typeChosen, this,
+            &MainWindow::addNodeFromPalette);
+
     m_view->setContextMenuPolicy(Qt::CustomContextMenu);
     connect(m_view, &QWidget::customContextMenuRequested, this,
-            &MainWindow::showAddNodeMenu);
+            [&](const QPoint &pos) {
+                showNodePalette(m_view->mapToScene(pos), nullptr);
+            });
+    connect(m_scene.get(), &qnodes::Scene::connectionDropped, this,
+            &MainWindow::showNodePalette);
+
+    m_search = new qnodes::SearchIndex(m_scene.get(), m_scene.get());
+    connect(m_scene.get(), &qnodes::Scene::nodeRemoved, this,
+            [&](qnodes::Node *node) {
+                m_searchResults.erase(std::remove(m_searchResults.begin(),
+                                                  m_searchResults.end(), node),
+                                      m_searchResults.end());
+            });
+
+    m_layout = new qnodes::GraphLayout(this);
+    m_router = new qnodes::ConnectionRouter(m_scene.get(), m_scene.get());
+
+    m_evaluator = new qnodes::Evaluator(m_scene.get(), m_scene.get());
+    m_evaluator->setCache(&m_resultCache);
+    m_evaluator->setProfiler(&m_profiler);
+    connect(m_evaluator, &qnodes::Evaluator::evaluated, this,
+            &MainWindow::showEvaluationResults);
+
+    m_processExecutor = new qnodes::ProcessExecutor(
+        m_scene.get(),
+        QCoreApplication::applicationDirPath() + "/qnodes_worker",
+        m_scene.get());
+    m_processExecutor->setPartitionCount(
+        std::max(2, QThread::idealThreadCount() / 2));
+    connect(m_processExecutor, &qnodes::ProcessExecutor::evaluated, this,
+            &MainWindow::showProcessResults);
+
+    m_stream = new qnodes::StreamExecutor(m_scene.get(), m_scene.get());
+    m_stream->setProfiler(&m_profiler);
+
+    m_probes = new qnodes::ProbeMonitor(m_scene.get(), m_scene.get());
+
+    m_profileOverlay =
+        new qnodes::ProfileOverlay(m_scene.get(), &m_profiler, m_scene.get());
+    connect(m_stream, &qnodes::StreamExecutor::finished, this, [&]() {
+        double seconds = std::max(1e-3, m_streamTimer.elapsed() / 1000.0);
+        qint64 chunks = m_stream->processedChunks();
+        statusBar()->showMessage(
+            QString("Streamed %1 chunks in %2 s (%3 chunks/s)")
+                .arg(chunks)
+                .arg(seconds, 0, 'f', 2)
+                .arg(qRound64(chunks / seconds)));
+    });
 
     initMenuBar();
 }
@@ -52,27 +126,556 @@ void MainWindow::initMenuBar() {
     action = menu->addAction("Dark");
     connect(action, &QAction::triggered, this,
             [&]() { setStyleFromFile(":qdarkstyle/dark/style.qss"); });
+
+    menu = bar->addMenu("File");
+
+    action = menu->addAction("Open graph...");
+    action->setShortcut(QKeySequence::Open);
+    connect(action, &QAction::triggered, this, [&]() { openGraph(); });
+
+    action = menu->addAction("Save graph...");
+    action->setShortcut(QKeySequence::Save);
+    connect(action, &QAction::triggered, this, [&]() { saveGraph(); });
+
+    action = menu->addAction("Compare with saved graph...");
+    connect(action, &QAction::triggered, this,
+            [&]() { compareWithSavedGraph(); });
+
+    action = menu->addAction("Clear comparison");
+    connect(action, &QAction::triggered, this,
+            [&]() { qnodes::clearDiffOverlay(m_scene.get()); });
+
+    menu->addSeparator();
+
+    action = menu->addAction("Open tiled store...");
+    connect(action, &QAction::triggered, this, [&]() { openTiledStore(); });
+
+    action = menu->addAction("Export tiled store...");
+    connect(action, &QAction::triggered, this,
+            [&]() { exportTiledStore(); });
+
+    menu = bar->addMenu("Edit");
+
+    action = menu->addAction("Copy");
+    action->setShortcut(QKeySequence::Copy);
+    connect(action, &QAction::triggered, this, [&]() { copySelection(); });
+
+    action = menu->addAction("Paste");
+    action->setShortcut(QKeySequence::Paste);
+    connect(action, &QAction::triggered, this, [&]() {
+        paste(qnodes::GraphSnapshot::fromMimeData(
+            QApplication::clipboard()->mimeData()));
+    });
+
+    action = menu->addAction("Duplicate");
+    action->setShortcut(QKeySequence("Ctrl+D"));
+    connect(action, &QAction::triggered, this, [&]() {
+        paste(qnodes::GraphSnapshot::capture(selectedNodes()));
+    });
+
+    menu->addSeparator();
+
+    action = menu->addAction("Find...");
+    action->setShortcut(QKeySequence::Find);
+    connect(action, &QAction::triggered, this, [&]() { find(); });
+
+    action = menu->addAction("Find next");
+    action->setShortcut(QKeySequence::FindNext);
+    connect(action, &QAction::triggered, this, [&]() { findNext(); });
+
+    menu = bar->addMenu("Graph");
+
+    action = menu->addAction("Arrange all nodes");
+    action->setShortcut(QKeySequence("Ctrl+L"));
+    connect(action, &QAction::triggered, this,
+            [&]() { m_layout->layout(m_scene->nodes()); });
+
+    action = menu->addAction("Arrange selected nodes");
+    action->setShortcut(QKeySequence("Ctrl+Shift+L"));
+    connect(action, &QAction::triggered, this,
+            [&]() { m_layout->layout(m_scene->nodes(), selectedNodes()); });
+
+    menu->addSeparator();
+
+    action = menu->addAction("Group selected nodes");
+    action->setShortcut(QKeySequence("Ctrl+G"));
+    connect(action, &QAction::triggered, this, [&]() {
+        if (qnodes::GroupNode *group =
+                qnodes::GroupNode::collapse(selectedNodes())) {
+            group->setSelected(true);
+        }
+    });
+
+    action = menu->addAction("Ungroup selected nodes");
+    action->setShortcut(QKeySequence("Ctrl+Shift+G"));
+    connect(action, &QAction::triggered, this, [&]() {
+        for (qnodes::Node *node : selectedNodes()) {
+            if (auto group = qobject_cast<qnodes::GroupNode *>(node)) {
+                for (qnodes::Node *member : group->expand()) {
+                    member->setSelected(true);
+                }
+            }
+        }
+    });
+
+    menu->addSeparator();
+
+    action = menu->addAction("Route connections around nodes");
+    action->setCheckable(true);
+    connect(action, &QAction::toggled, this,
+            [&](bool checked) { m_router->setEnabled(checked); });
+
+    menu->addSeparator();
+
+    action = menu->addAction("Evaluate");
+    action->setShortcut(QKeySequence("F5"));
+    connect(action, &QAction::triggered, this,
+            [&]() { m_evaluator->evaluate(); });
+
+    action = menu->addAction("Evaluate in background");
+    action->setShortcut(QKeySequence("Shift+F5"));
+    connect(action, &QAction::triggered, this, [&]() {
+        statusBar()->showMessage("Evaluating...");
+        m_evaluator->evaluateAsync();
+    });
+
+    action = menu->addAction("Evaluate in worker processes");
+    action->setShortcut(QKeySequence("Ctrl+F5"));
+    connect(action, &QAction::triggered, this, [&]() {
+        if (m_processExecutor->evaluate()) {
+            statusBar()->showMessage("Evaluating in worker processes...");
+        } else {
+            statusBar()->showMessage("Cannot start worker processes");
+        }
+    });
+
+    action = menu->addAction("Run stream");
+    action->setShortcut(QKeySequence("F6"));
+    connect(action, &QAction::triggered, this, [&]() { runStream(); });
+
+    action = menu->addAction("Clear result cache");
+    connect(action, &QAction::triggered, this,
+            [&]() { m_resultCache.clear(); });
+
+    menu->addSeparator();
+
+    action = menu->addAction("Probe selected connections");
+    action->setShortcut(QKeySequence("Ctrl+P"));
+    connect(action, &QAction::triggered, this, [&]() { toggleProbes(); });
+
+    action = menu->addAction("Clear probes");
+    connect(action, &QAction::triggered, this, [&]() { m_probes->clear(); });
+
+    menu->addSeparator();
+
+    action = menu->addAction("Show profile");
+    action->setCheckable(true);
+    connect(action, &QAction::toggled, this,
+            [&](bool checked) { m_profileOverlay->setEnabled(checked); });
+
+    QMenu *metricMenu = menu->addMenu("Profile metric");
+    QActionGroup *metrics = new QActionGroup(metricMenu);
+    const std::pair<const char *, qnodes::ProfileOverlay::Metric>
+        metricNames[] = {{"Total time", qnodes::ProfileOverlay::TotalTime},
+                         {"Slowest call", qnodes::ProfileOverlay::MaxTime},
+                         {"Calls", qnodes::ProfileOverlay::CallCount},
+                         {"Memory", qnodes::ProfileOverlay::Memory}};
+
+    for (const auto &entry : metricNames) {
+        qnodes::ProfileOverlay::Metric metric = entry.second;
+        action = metricMenu->addAction(entry.first);
+        action->setCheckable(true);
+        action->setChecked(metric == m_profileOverlay->metric());
+        metrics->addAction(action);
+        connect(action, &QAction::triggered, this,
+                [this, metric]() { m_profileOverlay->setMetric(metric); });
+    }
+
+    action = menu->addAction("Reset profile");
+    connect(action, &QAction::triggered, this, [&]() {
+        m_profiler.reset();
+        if (m_profileOverlay->isEnabled()) {
+            m_profileOverlay->update();
+        }
+    });
+
+    menu->addSeparator();
+
+    action = menu->addAction("Show memory usage...");
+    connect(action, &QAction::triggered, this, [&]() { showMemoryUsage(); });
+}
+
+std::vector<qnodes::Node *> MainWindow::selectedNodes() const {
+    std::vector<qnodes::Node *> nodes;
+    for (QGraphicsItem *item : m_scene->selectedItems()) {
+        qnodes::Node *node = dynamic_cast<qnodes::Node *>(item);
+        if (node) {
+            nodes.push_back(node);
+        }
+    }
+
+    return nodes;
+}
+
+static const char *const graphFileFilter = "qnodes graphs (*.qnodes)";
+
+void MainWindow::saveGraph() {
+    QString fileName =
+        QFileDialog::getSaveFileName(this, "Save graph", {}, graphFileFilter);
+    if (fileName.isEmpty()) {
+        return;
+    }
+
+    QFile file(fileName);
+    if (!file.open(QFile::WriteOnly) ||
+        (file.write(qnodes::GraphSnapshot::capture(m_scene->nodes())
+                        ->toBinary()) < 0)) {
+        statusBar()->showMessage("Cannot write " + fileName);
+    }
+}
+
+void MainWindow::openGraph() {
+    QString fileName =
+        QFileDialog::getOpenFileName(this, "Open graph", {}, graphFileFilter);
+    if (fileName.isEmpty()) {
+        return;
+    }
+
+    QFile file(fileName);
+    auto snapshot = file.open(QFile::ReadOnly)
+                        ? qnodes::GraphSnapshot::fromBinary(file.readAll())
+                        : nullptr;
+
+    if (!snapshot) {
+        statusBar()->showMessage("Cannot read " + fileName);
+        return;
+    }
+
+    closeTiledStore();
+    snapshot->instantiate(m_scene.get(), &createNode, {},
+                          qnodes::GraphSnapshot::KeepIds);
+}
+
+void MainWindow::compareWithSavedGraph() {
+    QString fileName = QFileDialog::getOpenFileName(
+        this, "Compare with saved graph", {}, graphFileFilter);
+    if (fileName.isEmpty()) {
+        return;
+    }
+
+    QFile file(fileName);
+    auto saved = file.open(QFile::ReadOnly)
+                     ? qnodes::GraphSnapshot::fromBinary(file.readAll())
+                     : nullptr;
+
+    if (!saved) {
+        statusBar()->showMessage("Cannot read " + fileName);
+        return;
+    }
+
+    auto current = qnodes::GraphSnapshot::capture(m_scene->nodes());
+    qnodes::GraphDiff diff = qnodes::diffGraphs(*saved, *current);
+    qnodes::showDiffOverlay(m_scene.get(), *current, diff);
+
+    statusBar()->showMessage(
+        QString("%1 node changes, %2 connection changes")
+            .arg(diff.nodes.size())
+            .arg(diff.connections.size()));
+}
+
+static const char *const storeFileFilter = "qnodes tiled stores (*.qntiles)";
+
+void MainWindow::exportTiledStore() {
+    QString fileName = QFileDialog::getSaveFileName(
+        this, "Export tiled store", {}, storeFileFilter);
+    if (fileName.isEmpty()) {
+        return;
+    }
+
+    auto snapshot = qnodes::GraphSnapshot::capture(m_scene->nodes());
+
+    qnodes::TileStoreBuilder builder;
+    for (const auto &node : snapshot->nodes()) {
+        builder.addNode(node.typeName, node.label, node.pos, node.state);
+    }
+
+    for (const auto &conn : snapshot->connections()) {
+        builder.addConnection(quint64(conn.sourceNode), conn.sourceSlot,
+                              quint64(conn.targetNode), conn.targetSlot);
+    }
+
+    if (!builder.save(fileName)) {
+        statusBar()->showMessage("Cannot write " + fileName);
+    }
+}
+
+void MainWindow::openTiledStore() {
+    QString fileName = QFileDialog::getOpenFileName(
+        this, "Open tiled store", {}, storeFileFilter);
+    if (fileName.isEmpty()) {
+        return;
+    }
+
+    auto store = std::make_unique<qnodes::TileStore>();
+    if (!store->open(fileName)) {
+        statusBar()->showMessage("Cannot read " + fileName);
+        return;
+    }
+
+    closeTiledStore();
+    m_tileStore = std::move(store);
+
+    m_pager = new qnodes::TilePager(m_scene.get(), m_tileStore.get(),
+                                    &createNode, m_scene.get());
+    connect(m_pager, &qnodes::TilePager::tilesChanged, this, [&]() {
+        if (m_pager->summaryTileCount() > 0) {
+            statusBar()->showMessage(
+                QString("%1 nodes, zoomed out to %2 summaries")
+                    .arg(m_tileStore->nodeCount())
+                    .arg(m_pager->summaryTileCount()));
+            return;
+        }
+
+        statusBar()->showMessage(
+            QString("%1 of %2 nodes in %3 tiles, %4 pooled")
+                .arg(m_pager->residentNodeCount())
+                .arg(m_tileStore->nodeCount())
+                .arg(m_pager->residentTileCount())
+                .arg(m_pager->pooledNodeCount()));
+    });
+
+    m_pager->setView(m_view);
 }
 
-void MainWindow::showAddNodeMenu(const QPoint &pos) {
-    QMenu menu;
+void MainWindow::closeTiledStore() {
+    m_evaluator->cancel();
+    m_stream->stop();
 
-    auto nodeTypeList = DemoNode::getTypes();
-    for (const auto &type : nodeTypeList) {
-        QAction *action = menu.addAction(type.name);
+    delete m_pager;
+    m_pager = nullptr;
 
-        QPixmap pm(8, 8);
-        pm.fill(type.color);
-        action->setIcon(QIcon(pm));
+    m_scene->clear();
+    m_scene->setSceneRect({});
+    m_tileStore.reset();
+}
 
-        connect(action, &QAction::triggered, [&]() {
-            DemoNode *node = type.factoryFn();
-            m_scene->addItem(node);
-            node->setPos(m_view->mapToScene(pos));
-        });
+void MainWindow::copySelection() {
+    auto snapshot = qnodes::GraphSnapshot::capture(selectedNodes());
+    if (!snapshot->isEmpty()) {
+        QApplication::clipboard()->setMimeData(snapshot->toMimeData());
     }
+}
+
+void MainWindow::paste(
+    const std::shared_ptr<const qnodes::GraphSnapshot> &snapshot) {
+    if (!snapshot || snapshot->isEmpty()) {
+        return;
+    }
+
+    std::vector<qnodes::Node *> nodes =
+        snapshot->instantiate(m_scene.get(), &createNode, {24.0, 24.0});
+
+    m_scene->clearSelection();
+    for (qnodes::Node *node : nodes) {
+        node->setSelected(true);
+    }
+
+    statusBar()->showMessage(QString("Pasted %1 nodes").arg(nodes.size()));
+}
+
+static QString formatValue(const QVariant &value) {
+    if (value.userType() == QMetaType::QVector3D) {
+        QVector3D v = value.value<QVector3D>();
+        return QString("(%1, %2, %3)").arg(v.x()).arg(v.y()).arg(v.z());
+    }
+
+    return value.isValid() ? value.toString() : QString("n/a");
+}
+
+void MainWindow::find() {
+    bool ok = false;
+    QString query = QInputDialog::getText(this, "Find", "Nodes matching:",
+                                          QLineEdit::Normal, {}, &ok);
+    if (!ok || query.isEmpty()) {
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    std::vector<qnodes::SearchIndex::Match> matches = m_search->search(query);
+    double ms = timer.nsecsElapsed() / 1e6;
+
+    m_searchResults.clear();
+    for (const auto &match : matches) {
+        m_searchResults.push_back(match.node);
+    }
+    m_searchPos = 0;
+
+    qnodes::SearchIndex::reveal(m_view, m_searchResults);
+    statusBar()->showMessage(
+        QString("%1 matches in %2 ms (index: %3 nodes, %4 terms, %5 KiB)")
+            .arg(matches.size())
+            .arg(ms, 0, 'f', 2)
+            .arg(m_search->nodeCount())
+            .arg(m_search->termCount())
+            .arg(m_search->memoryUsage() / 1024));
+}
+
+void MainWindow::findNext() {
+    if (m_searchResults.empty()) {
+        find();
+        return;
+    }
+
+    m_searchPos = (m_searchPos + 1) % m_searchResults.size();
+    qnodes::Node *node = m_searchResults[m_searchPos];
+    qnodes::SearchIndex::reveal(m_view, {node});
+    statusBar()->showMessage(QString("Match %1 of %2: %3")
+                                 .arg(m_searchPos + 1)
+                                 .arg(m_searchResults.size())
+                                 .arg(node->label()));
+}
 
-    menu.exec(m_view->mapToGlobal(pos));
+void MainWindow::showEvaluationResults() {
+    QString message = QString("Computed %1 nodes, %2 from cache")
+                          .arg(m_evaluator->computedCount())
+                          .arg(m_evaluator->cachedCount());
+
+    for (qnodes::Node *node : selectedNodes()) {
+        QStringList values;
+        for (const QVariant &value : m_evaluator->outputs(node)) {
+            values.append(formatValue(value));
+        }
+
+        message += QString(" | %1: %2").arg(node->label(), values.join(", "));
+    }
+
+    statusBar()->showMessage(message);
+}
+
+void MainWindow::showProcessResults() {
+    QString message =
+        QString("Evaluated in worker processes, %1 failed")
+            .arg(m_processExecutor->failedPartitionCount());
+
+    for (qnodes::Node *node : selectedNodes()) {
+        QStringList values;
+        for (const QVariant &value : m_processExecutor->outputs(node)) {
+            values.append(formatValue(value));
+        }
+
+        message += QString(" | %1 (partition %2): %3")
+                       .arg(node->label())
+                       .arg(m_processExecutor->partitionOf(node))
+                       .arg(values.join(", "));
+    }
+
+    statusBar()->showMessage(message);
+}
+
+void MainWindow::showMemoryUsage() {
+    using qnodes::MemoryUsage;
+
+    const MemoryUsage process = qnodes::MemoryStats::snapshot();
+    const MemoryUsage scene = qnodes::sceneMemory(m_scene.get(), m_evaluator);
+
+    auto kib = [](qint64 bytes) {
+        return QString::number(bytes / 1024.0, 'f', 1) + " KiB";
+    };
+
+    QString text = "Category: scene / all scenes and caches\n";
+    for (int i = 0; i < MemoryUsage::CategoryCount; ++i) {
+        auto category = MemoryUsage::Category(i);
+        QString name = QString::fromLatin1(MemoryUsage::categoryName(category));
+        text += QString("%1: %2 in %3 / %4 in %5\n")
+                    .arg(name)
+                    .arg(kib(scene[category].bytes))
+                    .arg(scene[category].count)
+                    .arg(kib(process[category].bytes))
+                    .arg(process[category].count);
+    }
+
+    text += QString("Total: %1 / %2\n\nLargest nodes:\n")
+                .arg(kib(scene.totalBytes()))
+                .arg(kib(process.totalBytes()));
+
+    std::vector<qnodes::NodeMemory> nodes =
+        qnodes::nodeMemory(m_scene.get(), m_evaluator);
+    for (size_t i = 0; i < std::min<size_t>(nodes.size(), 10); ++i) {
+        text += QString("%1: %2\n")
+                    .arg(nodes[i].node->label())
+                    .arg(kib(nodes[i].usage.totalBytes()));
+    }
+
+    QMessageBox::information(this, "Memory usage", text);
+}
+
+void MainWindow::runStream() {
+    if (m_stream->isRunning()) {
+        m_stream->stop();
+        statusBar()->showMessage("Stream stopped");
+        return;
+    }
+
+    m_streamTimer.start();
+    if (!m_stream->start()) {
+        statusBar()->showMessage("Nothing to stream");
+    }
+}
+
+void MainWindow::toggleProbes() {
+    int attached = 0;
+    for (QGraphicsItem *item : m_scene->selectedItems()) {
+        qnodes::Connection *conn = dynamic_cast<qnodes::Connection *>(item);
+        if (!conn) {
+            continue;
+        }
+
+        if (m_probes->isProbed(conn)) {
+            m_probes->detach(conn);
+        } else {
+            m_probes->attach(conn);
+            ++attached;
+        }
+    }
+
+    if (attached && m_stream->isRunning()) {
+        statusBar()->showMessage("Restart the stream to sample new probes");
+    }
+}
+
+void MainWindow::showNodePalette(const QPointF &scenePos,
+                                 qnodes::Slot *slot) {
+    m_paletteScenePos = scenePos;
+    m_palette->popup(m_view->mapToGlobal(m_view->mapFromScene(scenePos)),
+                     slot);
+}
+
+void MainWindow::addNodeFromPalette(const QByteArray &id) {
+    qnodes::Node *node = createNode(id);
+    if (!node) {
+        return;
+    }
+
+    m_scene->addItem(node);
+    node->setPos(m_paletteScenePos);
+
+    // Finish the connection that was dropped to open the palette
+    qnodes::Slot *source = m_palette->filterSlot();
+    if (!source) {
+        return;
+    }
+
+    const auto &ports = qnodes::PortTypeRegistry::global();
+    for (int i = 0; i < node->slotCount(qnodes::Slot::Input); ++i) {
+        qnodes::Slot *input = node->slot(qnodes::Slot::Input, i);
+        if (ports.canConnect(source->portType(), input->acceptedTypes())) {
+            auto conn = new qnodes::Connection(source);
+            conn->setTargetSlot(input);
+            m_scene->addItem(conn);
+            break;
+        }
+    }
 }
 
 void MainWindow::setDefaultStyle() {
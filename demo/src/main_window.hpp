@@ -1,23 +1,81 @@
 #ifndef MAIN_WINDOW_HPP_INCLUDED
 #define MAIN_WINDOW_HPP_INCLUDED
 
-#include <QGraphicsScene>
-#include <QGraphicsView>
+#include "graph_view.hpp"
+#include <QElapsedTimer>
 #include <QMainWindow>
 #include <memory>
+#include <qnodes/evaluator.hpp>
+#include <qnodes/layout.hpp>
+#include <qnodes/memory_stats.hpp>
 #include <qnodes/node.hpp>
+#include <qnodes/node_palette.hpp>
+#include <qnodes/probe.hpp>
+#include <qnodes/process_executor.hpp>
+#include <qnodes/profile_overlay.hpp>
+#include <qnodes/profiler.hpp>
+#include <qnodes/result_cache.hpp>
+#include <qnodes/router.hpp>
+#include <qnodes/scene.hpp>
+#include <qnodes/search_index.hpp>
+#include <qnodes/snapshot.hpp>
+#include <qnodes/stream.hpp>
+#include <qnodes/tile_pager.hpp>
+#include <qnodes/tile_store.hpp>
+#include <vector>
 
 class MainWindow : public QMainWindow {
 public:
     explicit MainWindow(QWidget *parent = nullptr);
 
 private:
-    std::unique_ptr<QGraphicsScene> m_scene;
-    QGraphicsView *m_view;
+    // Outlives the scene, which reports its nodes to it when destroyed
+    qnodes::Profiler m_profiler;
+    std::unique_ptr<qnodes::Scene> m_scene;
+    GraphView *m_view;
+    qnodes::GraphLayout *m_layout;
+    qnodes::ConnectionRouter *m_router;
+    qnodes::ResultCache m_resultCache;
+    qnodes::ProfileOverlay *m_profileOverlay;
+    qnodes::Evaluator *m_evaluator;
+    qnodes::ProcessExecutor *m_processExecutor;
+    qnodes::StreamExecutor *m_stream;
+    QElapsedTimer m_streamTimer;
+    qnodes::ProbeMonitor *m_probes;
+    std::unique_ptr<qnodes::TileStore> m_tileStore;
+    qnodes::TilePager *m_pager = nullptr;
+    qnodes::NodePalette *m_palette;
+    qnodes::SearchIndex *m_search;
+    std::vector<qnodes::Node *> m_searchResults;
+    size_t m_searchPos = 0;
+    QPointF m_paletteScenePos;
 
     void initMenuBar();
 
-    void showAddNodeMenu(const QPoint &pos);
+    std::vector<qnodes::Node *> selectedNodes() const;
+
+    void saveGraph();
+    void openGraph();
+    void compareWithSavedGraph();
+
+    void exportTiledStore();
+    void openTiledStore();
+    void closeTiledStore();
+
+    void copySelection();
+    void paste(const std::shared_ptr<const qnodes::GraphSnapshot> &snapshot);
+
+    void find();
+    void findNext();
+
+    void showEvaluationResults();
+    void showProcessResults();
+    void showMemoryUsage();
+    void runStream();
+    void toggleProbes();
+
+    void showNodePalette(const QPointF &scenePos, qnodes::Slot *slot);
+    void addNodeFromPalette(const QByteArray &id);
 
     void setDefaultStyle();
     void setStyleFromFile(const QString &file);
@@ -0,0 +1,116 @@
+#include "demo_nodes.hpp"
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <cstdio>
+#include <qnodes/layout.hpp>
+#include <qnodes/node_type.hpp>
+#include <qnodes/render.hpp>
+#include <qnodes/scene.hpp>
+#include <qnodes/snapshot.hpp>
+
+// Renders a saved graph to PNG or SVG without a display, e.g.
+//   qnodes_render --scale 2 graph.qnodes graph.png
+
+static qnodes::Node *createNode(const QByteArray &id) {
+    return qnodes::NodeTypeRegistry::global().create(id);
+}
+
+static void arrange(const std::vector<qnodes::Node *> &nodes) {
+    qnodes::LayoutGraph graph = qnodes::LayoutGraph::fromNodes(nodes);
+    std::vector<QPointF> positions = qnodes::layeredLayout(graph);
+
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        nodes[i]->setPos(positions[i]);
+    }
+}
+
+int main(int argc, char **argv) {
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Renders a qnodes graph to PNG or SVG.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("input", "Graph saved by the demo.");
+    parser.addPositionalArgument("output", "Image file; .svg writes SVG.");
+
+    QCommandLineOption scaleOption("scale", "Scale factor.", "factor", "1");
+    QCommandLineOption bandOption(
+        "min-band-height", "Fewest rows rendered by one thread.", "pixels",
+        "256");
+    QCommandLineOption threadsOption(
+        "threads", "Rendering threads, 0 for one per core.", "count", "0");
+    QCommandLineOption backgroundOption("background", "Background colour.",
+                                        "color", "transparent");
+    QCommandLineOption noLayoutOption("no-layout",
+                                      "Keep the saved node positions.");
+
+    parser.addOptions({scaleOption, bandOption, threadsOption,
+                       backgroundOption, noLayoutOption});
+    parser.process(app);
+
+    const QStringList args = parser.positionalArguments();
+    if (args.size() != 2) {
+        parser.showHelp(1);
+    }
+
+    QFile file(args[0]);
+    if (!file.open(QFile::ReadOnly)) {
+        std::fprintf(stderr, "cannot open %s\n", qPrintable(args[0]));
+        return 1;
+    }
+
+    auto snapshot = qnodes::GraphSnapshot::fromBinary(file.readAll());
+    if (!snapshot) {
+        std::fprintf(stderr, "%s is not a qnodes graph\n", qPrintable(args[0]));
+        return 1;
+    }
+
+    qnodes::Scene scene;
+    scene.setPalette(app.palette());
+
+    std::vector<qnodes::Node *> nodes =
+        snapshot->instantiate(&scene, &createNode, {},
+                              qnodes::GraphSnapshot::KeepIds);
+
+    if (!parser.isSet(noLayoutOption)) {
+        arrange(nodes);
+    }
+
+    qnodes::RenderOptions options;
+    options.scale = parser.value(scaleOption).toDouble();
+    options.minBandHeight = parser.value(bandOption).toInt();
+    options.threadCount = parser.value(threadsOption).toInt();
+    options.background = QColor(parser.value(backgroundOption));
+
+    if (options.scale <= 0.0) {
+        std::fprintf(stderr, "invalid scale\n");
+        return 1;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    bool ok = false;
+    if (QFileInfo(args[1]).suffix().compare("svg", Qt::CaseInsensitive) == 0) {
+        ok = qnodes::renderSvg(&scene, args[1], options);
+    } else {
+        QImage image = qnodes::renderImage(&scene, options);
+        ok = !image.isNull() && image.save(args[1]);
+    }
+
+    if (!ok) {
+        std::fprintf(stderr, "cannot write %s\n", qPrintable(args[1]));
+        return 1;
+    }
+
+    std::printf("rendered %d nodes in %lld ms\n", int(nodes.size()),
+                static_cast<long long>(timer.elapsed()));
+    return 0;
+}
@@ -0,0 +1,20 @@
+#include "demo_nodes.hpp"
+#include <QApplication>
+#include <qnodes/node_type.hpp>
+#include <qnodes/process_executor.hpp>
+
+// Evaluates one partition of a graph for the demo's process executor.
+// Started by the executor, not meant to be run by hand.
+
+static qnodes::Node *createNode(const QByteArray &id) {
+    return qnodes::NodeTypeRegistry::global().create(id);
+}
+
+int main(int argc, char **argv) {
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication app(argc, argv);
+    return qnodes::runProcessWorker(app.arguments().mid(1), &createNode);
+}
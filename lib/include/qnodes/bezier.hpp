@@ -2,6 +2,7 @@
 #define QNODES_BEZIER_HPP_INCLUDED
 
 #include <QRectF>
+#include <algorithm>
 
 namespace qnodes {
 
@@ -20,6 +21,14 @@ public:
 
     QPointF closestPointTo(const QPointF &pos) const;
 
+    QPointF pointAt(qreal t) const;
+
+    // Tight bounds of the curve, not of the control polygon.
+    QRectF bounds() const;
+
+    bool intersects(const QRectF &rect) const;
+    bool intersectsSegment(const QPointF &a, const QPointF &b) const;
+
 private:
     QPointF m_pts[3];
 };
@@ -29,6 +38,26 @@ inline qreal squaredDistance(const QPointF &p0, const QPointF &p1) {
     return QPointF::dotProduct(v, v);
 }
 
+inline qreal squaredDistanceToSegment(const QPointF &pos, const QPointF &a,
+                                      const QPointF &b) {
+    const QPointF ab = b - a;
+    const qreal len2 = QPointF::dotProduct(ab, ab);
+
+    qreal t = 0.0;
+    if (len2 > 0.0) {
+        t = QPointF::dotProduct(pos - a, ab) / len2;
+        t = std::min<qreal>(1.0, std::max<qreal>(0.0, t));
+    }
+
+    return squaredDistance(pos, a + ab * t);
+}
+
+bool segmentsIntersect(const QPointF &a, const QPointF &b, const QPointF &c,
+                       const QPointF &d);
+
+bool segmentIntersectsRect(const QPointF &a, const QPointF &b,
+                           const QRectF &rect);
+
 } // namespace qnodes
 
 #endif // QNODES_BEZIER_HPP_INCLUDED
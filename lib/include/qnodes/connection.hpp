@@ -1,10 +1,15 @@
 #ifndef QNODES_CONNECTION_HPP_INCLUDED
 #define QNODES_CONNECTION_HPP_INCLUDED
 
+#include <QColor>
 #include <QGraphicsObject>
+#include <QPolygonF>
+#include <memory>
+#include <qnodes/memory_stats.hpp>
 
 namespace qnodes {
 
+class Probe;
 class Slot;
 
 class Connection : public QGraphicsObject {
@@ -12,6 +17,7 @@ class Connection : public QGraphicsObject {
 
 public:
     static const double width;
+    static const double routeCornerRadius;
 
     explicit Connection(Slot *source);
     Connection(const Connection &) = delete;
@@ -26,8 +32,33 @@ public:
     void setTargetPos(const QPointF &pos);
     QPointF targetPos() const;
 
+    void setRoute(const QPolygonF &route);
+    QPolygonF route() const;
+    bool hasRoute() const;
+
+    // Outline drawn under the connection. Invalid means none.
+    void setOverlayColor(const QColor &color);
+    QColor overlayColor() const;
+
+    // Multiplies the drawn width, e.g. to show data volume.
+    void setWidthScale(double scale);
+    double widthScale() const;
+
+    // Values sampled while the graph runs, drawn as a sparkline above the
+    // middle of the connection. Shared with the executors writing to it.
+    void setProbe(std::shared_ptr<Probe> probe);
+    std::shared_ptr<Probe> probe() const;
+
+    MemoryUsage memoryUsage() const;
+
     bool contains(const QPointF &pos) const override;
 
+    // Exact tests against the curve or route, in scene coordinates. The
+    // contains modes require the whole connection to be inside.
+    bool intersects(const QRectF &sceneRect, Qt::ItemSelectionMode mode) const;
+    bool intersects(const QPolygonF &scenePolygon,
+                    Qt::ItemSelectionMode mode) const;
+
     QRectF boundingRect() const override;
     QPainterPath shape() const override;
 
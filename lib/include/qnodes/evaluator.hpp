@@ -0,0 +1,67 @@
+#ifndef QNODES_EVALUATOR_HPP_INCLUDED
+#define QNODES_EVALUATOR_HPP_INCLUDED
+
+#include <QObject>
+#include <QVariant>
+
+namespace qnodes {
+
+class Node;
+class Profiler;
+class ResultCache;
+class Scene;
+class Slot;
+
+class Evaluator : public QObject {
+    Q_OBJECT
+
+public:
+    static const int pollInterval;
+
+    explicit Evaluator(Scene *scene, QObject *parent = nullptr);
+    Evaluator(const Evaluator &) = delete;
+    Evaluator(Evaluator &&) = delete;
+    ~Evaluator();
+
+    Scene *scene() const;
+
+    // The cache is not owned and may be shared between evaluators.
+    void setCache(ResultCache *cache);
+    ResultCache *cache() const;
+
+    // Not owned. Records the time and output size of every computed node;
+    // for asynchronous jobs the time is measured until they are collected.
+    void setProfiler(Profiler *profiler);
+    Profiler *profiler() const;
+
+    // Returns false if some nodes could not be evaluated because they are
+    // part of a cycle.
+    bool evaluate();
+
+    // Runs computeAsync() on every node whose inputs are ready and returns
+    // immediately. Finished futures are collected on the GUI thread every
+    // pollInterval ms, one batch per tick; evaluated() is emitted at the end.
+    void evaluateAsync();
+    void cancel();
+    bool isRunning() const;
+
+    QVariantList outputs(const Node *node) const;
+    QVariant value(const Slot *outputSlot) const;
+
+    // Estimated bytes of the outputs kept for the node.
+    qint64 outputMemory(const Node *node) const;
+
+    int computedCount() const;
+    int cachedCount() const;
+
+signals:
+    void evaluated();
+
+private:
+    struct Impl;
+    Impl *m_impl;
+};
+
+} // namespace qnodes
+
+#endif // QNODES_EVALUATOR_HPP_INCLUDED
@@ -0,0 +1,89 @@
+#ifndef QNODES_GRAPH_DIFF_HPP_INCLUDED
+#define QNODES_GRAPH_DIFF_HPP_INCLUDED
+
+#include <QString>
+#include <memory>
+#include <qnodes/snapshot.hpp>
+#include <vector>
+
+namespace qnodes {
+
+class Scene;
+
+struct NodeChange {
+    enum Flag {
+        Added = 0x01,
+        Removed = 0x02,
+        Moved = 0x04,
+        Relabeled = 0x08,
+        StateChanged = 0x10,
+        SlotsChanged = 0x20,
+        TypeChanged = 0x40
+    };
+
+    int flags;
+    int before; // index in the old graph, or -1
+    int after;  // index in the new graph, or -1
+};
+
+// Node IDs are those of the graph the connection is in: the old one for
+// removed connections, the new one for added ones.
+struct ConnectionChange {
+    bool added;
+    quint64 sourceId;
+    int sourceSlot;
+    quint64 targetId;
+    int targetSlot;
+};
+
+struct GraphDiff {
+    std::vector<NodeChange> nodes;
+    std::vector<ConnectionChange> connections;
+
+    bool isEmpty() const;
+};
+
+// For every node of the old graph, the index of the matching node in the
+// new one, or -1. Nodes are matched by ID first; the rest by type, label
+// and state, then by type and label, preferring the closest position.
+std::vector<int> matchNodes(const GraphSnapshot &before,
+                            const GraphSnapshot &after);
+
+GraphDiff diffGraphs(const GraphSnapshot &before, const GraphSnapshot &after);
+
+struct MergeConflict {
+    enum Kind {
+        BothChanged,
+        BothMoved,
+        ChangedAndRemoved,
+        ConnectionToRemovedNode,
+        InputRewired
+    };
+
+    Kind kind;
+    quint64 nodeId;
+    QString description;
+};
+
+struct MergeResult {
+    std::shared_ptr<const GraphSnapshot> graph;
+    std::vector<MergeConflict> conflicts;
+};
+
+// Three-way merge of two versions of a common base. Where both sides made
+// different changes to the same thing, ours wins and a conflict is listed,
+// including a node moved to different positions on both sides (BothMoved,
+// which callers may treat as benign); a node changed on one side and
+// removed on the other is kept.
+MergeResult mergeGraphs(const GraphSnapshot &base, const GraphSnapshot &ours,
+                        const GraphSnapshot &theirs);
+
+// Colours the nodes and connections of a scene showing the new graph by
+// how they changed. Removed items are not in the scene and are not shown.
+void showDiffOverlay(Scene *scene, const GraphSnapshot &after,
+                     const GraphDiff &diff);
+void clearDiffOverlay(Scene *scene);
+
+} // namespace qnodes
+
+#endif // QNODES_GRAPH_DIFF_HPP_INCLUDED
@@ -0,0 +1,63 @@
+#ifndef QNODES_GRAPH_GENERATOR_HPP_INCLUDED
+#define QNODES_GRAPH_GENERATOR_HPP_INCLUDED
+
+#include <QPointF>
+#include <QtGlobal>
+#include <vector>
+
+class QGraphicsScene;
+
+namespace qnodes {
+
+class Node;
+
+struct GeneratorOptions {
+    quint32 seed = 1;
+    int nodeCount = 1000;
+    int depth = 10; // layers; connections only go to later layers
+
+    // Slot counts per node; nodes in the first layer have no inputs.
+    int minInputs = 1;
+    int maxInputs = 3;
+    int minOutputs = 1;
+    int maxOutputs = 2;
+
+    double connectProbability = 0.9; // chance that an input is connected
+    int maxFanOut = 4;               // connections per output slot
+    int maxLayerSpan = 2;            // how many layers a connection may skip
+
+    double columnSpacing = 220.0;
+    double rowSpacing = 140.0;
+};
+
+// Description of a random layered graph. The same options always give the
+// same graph, on every platform.
+struct GeneratedGraph {
+    struct NodeSpec {
+        int layer;
+        int inputs;
+        int outputs;
+        QPointF pos;
+    };
+
+    struct Edge {
+        int sourceNode;
+        int sourceSlot;
+        int targetNode;
+        int targetSlot;
+    };
+
+    std::vector<NodeSpec> nodes;
+    std::vector<Edge> edges;
+};
+
+GeneratedGraph generateGraph(const GeneratorOptions &options = {});
+
+// Adds plain nodes with labelled slots, and their connections, to the
+// scene. Returns the nodes in the order of the description.
+std::vector<Node *> instantiateGraph(QGraphicsScene *scene,
+                                     const GeneratedGraph &graph);
+
+} // namespace qnodes
+
+#endif // QNODES_GRAPH_GENERATOR_HPP_INCLUDED
@@ -0,0 +1,42 @@
+#ifndef QNODES_GROUP_NODE_HPP_INCLUDED
+#define QNODES_GROUP_NODE_HPP_INCLUDED
+
+#include <qnodes/node.hpp>
+#include <vector>
+
+namespace qnodes {
+
+// A collapsed subgraph. Members and the connections between them are taken
+// out of the scene entirely and owned by the group; connections crossing
+// the group boundary are re-attached to proxy slots on the group.
+class GroupNode : public Node {
+    Q_OBJECT
+
+public:
+    // Returns nullptr unless all nodes are in the same scene.
+    static GroupNode *collapse(const std::vector<Node *> &nodes);
+
+    GroupNode(const GroupNode &) = delete;
+    GroupNode(GroupNode &&) = delete;
+    ~GroupNode();
+
+    // Puts the members and their connections back into the scene, offset by
+    // how far the group was moved, and deletes the group later.
+    std::vector<Node *> expand();
+
+    std::vector<Node *> members() const;
+
+    // Mapping between proxy slots on the group and member slots.
+    Slot *innerSlot(const Slot *proxy) const;
+    Slot *outerSlot(const Slot *member) const;
+
+private:
+    struct Impl;
+    Impl *m_impl;
+
+    GroupNode();
+};
+
+} // namespace qnodes
+
+#endif // QNODES_GROUP_NODE_HPP_INCLUDED
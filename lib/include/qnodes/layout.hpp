@@ -0,0 +1,72 @@
+#ifndef QNODES_LAYOUT_HPP_INCLUDED
+#define QNODES_LAYOUT_HPP_INCLUDED
+
+#include <QObject>
+#include <QPointF>
+#include <QSizeF>
+#include <vector>
+
+namespace qnodes {
+
+class Node;
+
+struct LayoutGraph {
+    struct Edge {
+        int source;
+        int target;
+        double sourcePortY;
+        double targetPortY;
+    };
+
+    std::vector<QSizeF> sizes;
+    std::vector<QPointF> positions;
+    std::vector<bool> movable; // empty means every node is movable
+    std::vector<Edge> edges;
+
+    static LayoutGraph fromNodes(const std::vector<Node *> &nodes);
+};
+
+struct LayoutOptions {
+    double layerSpacing = 80.0;
+    double nodeSpacing = 30.0;
+    int orderingSweeps = 12;
+    int placementPasses = 8;
+};
+
+// Positions for every node; fixed nodes keep theirs. Fixed nodes connected
+// to movable ones are laid out with them, so that the movable nodes are
+// layered and ordered to fit in, and the result is moved clear of all
+// fixed nodes.
+std::vector<QPointF> layeredLayout(const LayoutGraph &graph,
+                                   const LayoutOptions &options = {});
+
+class GraphLayout : public QObject {
+    Q_OBJECT
+
+public:
+    explicit GraphLayout(QObject *parent = nullptr);
+    GraphLayout(const GraphLayout &) = delete;
+    GraphLayout(GraphLayout &&) = delete;
+    ~GraphLayout();
+
+    void setOptions(const LayoutOptions &options);
+    LayoutOptions options() const;
+
+    bool isRunning() const;
+    void waitForFinished();
+
+    void layout(const std::vector<Node *> &nodes);
+    void layout(const std::vector<Node *> &nodes,
+                const std::vector<Node *> &region);
+
+signals:
+    void finished();
+
+private:
+    struct Impl;
+    Impl *m_impl;
+};
+
+} // namespace qnodes
+
+#endif // QNODES_LAYOUT_HPP_INCLUDED
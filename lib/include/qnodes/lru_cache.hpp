@@ -0,0 +1,104 @@
+#ifndef QNODES_LRU_CACHE_HPP_INCLUDED
+#define QNODES_LRU_CACHE_HPP_INCLUDED
+
+#include <QtGlobal>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace qnodes {
+
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class LruCache {
+public:
+    explicit LruCache(qint64 budget = 0) : m_budget(budget) {}
+    LruCache(const LruCache &) = delete;
+
+    LruCache &operator=(const LruCache &) = delete;
+
+    void setBudget(qint64 budget) {
+        m_budget = budget;
+        evict();
+    }
+
+    qint64 budget() const { return m_budget; }
+    qint64 cost() const { return m_cost; }
+    size_t size() const { return m_map.size(); }
+
+    // Returns nullptr on a miss; a hit moves the entry to the front.
+    Value *find(const Key &key) {
+        auto it = m_map.find(key);
+        if (it == m_map.end()) {
+            return nullptr;
+        }
+
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+        return &it->second->value;
+    }
+
+    bool contains(const Key &key) const {
+        return m_map.find(key) != m_map.end();
+    }
+
+    // Entries more expensive than the whole budget are rejected.
+    bool insert(const Key &key, Value value, qint64 cost) {
+        remove(key);
+
+        if (cost > m_budget) {
+            return false;
+        }
+
+        m_entries.push_front(Entry{key, std::move(value), cost});
+        m_map.emplace(key, m_entries.begin());
+        m_cost += cost;
+
+        evict();
+        return contains(key);
+    }
+
+    bool remove(const Key &key) {
+        auto it = m_map.find(key);
+        if (it == m_map.end()) {
+            return false;
+        }
+
+        m_cost -= it->second->cost;
+        m_entries.erase(it->second);
+        m_map.erase(it);
+        return true;
+    }
+
+    void clear() {
+        m_entries.clear();
+        m_map.clear();
+        m_cost = 0;
+    }
+
+private:
+    struct Entry {
+        Key key;
+        Value value;
+        qint64 cost;
+    };
+
+    using EntryList = std::list<Entry>;
+
+    EntryList m_entries;
+    std::unordered_map<Key, typename EntryList::iterator, Hash> m_map;
+    qint64 m_budget;
+    qint64 m_cost = 0;
+
+    void evict() {
+        while ((m_cost > m_budget) && !m_entries.empty()) {
+            const Entry &last = m_entries.back();
+            m_cost -= last.cost;
+            m_map.erase(last.key);
+            m_entries.pop_back();
+        }
+    }
+};
+
+} // namespace qnodes
+
+#endif // QNODES_LRU_CACHE_HPP_INCLUDED
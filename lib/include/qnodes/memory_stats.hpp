@@ -0,0 +1,112 @@
+#ifndef QNODES_MEMORY_STATS_HPP_INCLUDED
+#define QNODES_MEMORY_STATS_HPP_INCLUDED
+
+#include <QtGlobal>
+#include <vector>
+
+class QGraphicsWidget;
+class QPolygonF;
+class QStaticText;
+
+namespace qnodes {
+
+class Evaluator;
+class Node;
+class Scene;
+
+// Objects and bytes per category. Sizes are estimates: Qt's private data
+// is included by rough constants and allocator overhead is left out.
+struct MemoryUsage {
+    enum Category {
+        NodeItems,
+        SlotItems,
+        ConnectionItems,
+        ImplBlocks,
+        StaticText,
+        Paths, // connection routes
+        ContentWidgets,
+        EvaluationBuffers, // evaluator outputs and result caches
+        CachedTiles,
+        CategoryCount
+    };
+
+    struct Entry {
+        qint64 count = 0;
+        qint64 bytes = 0;
+    };
+
+    Entry entries[CategoryCount];
+
+    static const char *categoryName(Category category);
+
+    Entry &operator[](Category category) { return entries[category]; }
+    const Entry &operator[](Category category) const {
+        return entries[category];
+    }
+
+    qint64 totalBytes() const;
+
+    MemoryUsage &operator+=(const MemoryUsage &other);
+};
+
+// Process-wide totals, kept up to date by the accounts of all items and
+// caches. Reading them is cheap and safe from any thread.
+class MemoryStats {
+public:
+    // Rough size of the private data Qt keeps for a QGraphicsObject, and
+    // for a QWidget embedded in a proxy.
+    static const qint64 objectOverhead;
+    static const qint64 widgetOverhead;
+
+    static MemoryUsage snapshot();
+
+    static qint64 estimateSize(const QStaticText &text);
+    static qint64 estimateSize(const QPolygonF &polygon);
+
+    // The widget, its child items and any widgets embedded through
+    // QGraphicsProxyWidget.
+    static qint64 estimateSize(const QGraphicsWidget *widget);
+
+private:
+    friend class MemoryAccount;
+
+    static void add(MemoryUsage::Category category, qint64 count,
+                    qint64 bytes);
+};
+
+// What one object holds, per category. Changes go to the process totals
+// right away, and whatever is left is taken out when the account is
+// destroyed. Not thread-safe by itself.
+class MemoryAccount {
+public:
+    MemoryAccount() = default;
+    MemoryAccount(const MemoryAccount &) = delete;
+    MemoryAccount(MemoryAccount &&) = delete;
+    ~MemoryAccount();
+
+    // Replaces what the object holds in the category.
+    void set(MemoryUsage::Category category, qint64 count, qint64 bytes);
+
+    const MemoryUsage &usage() const { return m_usage; }
+
+private:
+    MemoryUsage m_usage;
+};
+
+struct NodeMemory {
+    Node *node;
+    MemoryUsage usage;
+};
+
+// Per-node breakdown, largest first: what each node owns plus the
+// connections into its inputs, so that every connection is counted once.
+// Evaluation outputs are included when an evaluator is given.
+std::vector<NodeMemory> nodeMemory(Scene *scene,
+                                   const Evaluator *evaluator = nullptr);
+
+// Sum of nodeMemory() over the scene.
+MemoryUsage sceneMemory(Scene *scene, const Evaluator *evaluator = nullptr);
+
+} // namespace qnodes
+
+#endif // QNODES_MEMORY_STATS_HPP_INCLUDED
@@ -2,9 +2,15 @@
 #define QNODES_NODE_HPP_INCLUDED
 
 #include "slot.hpp"
+#include <QColor>
+#include <QFuture>
+#include <QStringList>
+#include <qnodes/memory_stats.hpp>
 
 namespace qnodes {
 
+class StreamProcessor;
+
 class Node : public QGraphicsObject {
     Q_OBJECT
 
@@ -12,6 +18,8 @@ public:
     static const double borderWidth;
     static const double cornerRadius;
 
+    enum EvaluationState { Idle, Pending, Running, Done, Failed };
+
     explicit Node(QGraphicsItem *parent = nullptr);
     Node(const Node &) = delete;
     Node(Node &&) = delete;
@@ -20,12 +28,23 @@ public:
     void setLabel(const QString &label);
     QString label() const;
 
+    // Free-form key/value pairs for the application, e.g. tags or notes.
+    // Setting an empty value removes the key.
+    void setMetadata(const QString &key, const QString &value);
+    QString metadata(const QString &key) const;
+    QStringList metadataKeys() const;
+
     void resize(const QSizeF &size);
     QSizeF size() const;
 
     void setBackgroundBrush(const QBrush &brush);
     QBrush backgroundBrush() const;
 
+    // Views draw the body from the shared pixmap cache; rendering without
+    // a widget, e.g. for export, always paints it directly.
+    void setBodyCacheEnabled(bool enabled);
+    bool isBodyCacheEnabled() const;
+
     Slot *addSlot(std::unique_ptr<Slot> slot);
     Slot *addSlot(Slot::Type type, const QString &label);
 
@@ -33,11 +52,65 @@ public:
     Slot *slot(Slot::Type type, int index);
     Slot *slotAt(const QPointF &pos);
 
+    int slotCount(Slot::Type type) const;
+    int slotIndex(const Slot *slot) const;
+
     QPointF slotPos(Slot::Type type, int idx) const;
 
     void setContent(QGraphicsWidget *content);
     QGraphicsWidget *content();
 
+    // What the node holds, including its slots and content. The content
+    // is estimated when it is set.
+    MemoryUsage memoryUsage() const;
+
+    // Evaluation: one output value per output slot, in slot order. Pure
+    // nodes depend only on their inputs and parameterHash(), which lets
+    // their results be memoized.
+    virtual QVariantList compute(const QVariantList &inputs);
+    virtual bool isPure() const;
+    virtual quint64 parameterHash() const;
+
+    // Long-running nodes override this and report progress through the
+    // future. The default runs compute() and returns a finished future.
+    virtual QFuture<QVariantList> computeAsync(const QVariantList &inputs);
+
+    void setEvaluationState(EvaluationState state);
+    EvaluationState evaluationState() const;
+
+    // Streaming mode: nodes that return a processor become pipeline stages.
+    virtual std::unique_ptr<StreamProcessor> createStreamProcessor();
+
+    // Copy and paste: nodes with an empty type name cannot be copied. The
+    // state holds whatever the constructor does not set up, e.g. editor
+    // values, and may be shared between pasted copies.
+    virtual QByteArray typeName() const;
+    virtual QByteArray saveState() const;
+    virtual void restoreState(const QByteArray &state);
+
+    // Placeholders are drawn and can end connections, but are not part of
+    // the graph: Scene leaves them out of nodes(), so they are not counted,
+    // evaluated or saved. E.g. stand-ins for paged-out nodes.
+    virtual bool isPlaceholder() const;
+
+    // Random on construction; kept by saved graphs so that versions of a
+    // graph can be matched node by node.
+    void setId(quint64 id);
+    quint64 id() const;
+
+    // Outline drawn over the node, e.g. to mark changes. Invalid means none.
+    void setOverlayColor(const QColor &color);
+    QColor overlayColor() const;
+
+    // Translucent fill over the body, e.g. for profiling heatmaps. Invalid
+    // means none.
+    void setTintColor(const QColor &color);
+    QColor tintColor() const;
+
+    // Progress in [0, 1], or negative if unknown.
+    void setProgress(double progress);
+    double progress() const;
+
     QRectF boundingRect() const override;
     QPainterPath shape() const override;
 
@@ -45,6 +118,8 @@ public:
                QWidget *widget = nullptr) override;
 
 signals:
+    void labelChanged(const QString &label);
+    void metadataChanged(const QString &key);
     void sizeChanged(const QSizeF &new_size);
     void contextMenuRequested(const QPoint &screenPos);
 
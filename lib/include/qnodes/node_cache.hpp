@@ -0,0 +1,68 @@
+#ifndef QNODES_NODE_CACHE_HPP_INCLUDED
+#define QNODES_NODE_CACHE_HPP_INCLUDED
+
+#include <QFont>
+#include <QPixmap>
+#include <qnodes/lru_cache.hpp>
+#include <qnodes/memory_stats.hpp>
+
+namespace qnodes {
+
+class Node;
+
+class NodeCache {
+public:
+    struct Tile {
+        QPixmap pixmap;
+        quint64 serial = 0;
+        qint64 paletteKey = 0;
+        QFont font;
+    };
+
+    // Zoom buckets are quarter octaves of the device scale (bucket 0 is 1:1).
+    static const int minBucket;
+    static const int maxBucket;
+    static const int maxTileExtent;
+
+    explicit NodeCache(qint64 budget = 64 * 1024 * 1024);
+    NodeCache(const NodeCache &) = delete;
+    NodeCache(NodeCache &&) = delete;
+
+    static NodeCache &global();
+
+    static int bucketForScale(qreal scale);
+    static qreal bucketScale(int bucket);
+
+    void setMemoryBudget(qint64 bytes);
+    qint64 memoryBudget() const;
+    qint64 memoryUsage() const;
+    int tileCount() const;
+
+    const Tile *find(const Node *node, int bucket);
+    bool insert(const Node *node, int bucket, Tile tile);
+    void remove(const Node *node, int bucket);
+    void clear();
+
+private:
+    struct Key {
+        const Node *node;
+        int bucket;
+
+        bool operator==(const Key &other) const {
+            return (node == other.node) && (bucket == other.bucket);
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key &key) const;
+    };
+
+    LruCache<Key, Tile, KeyHash> m_tiles;
+    MemoryAccount m_memory;
+
+    void updateMemory();
+};
+
+} // namespace qnodes
+
+#endif // QNODES_NODE_CACHE_HPP_INCLUDED
@@ -0,0 +1,42 @@
+#ifndef QNODES_NODE_PALETTE_HPP_INCLUDED
+#define QNODES_NODE_PALETTE_HPP_INCLUDED
+
+#include <QWidget>
+#include <qnodes/node_type.hpp>
+
+namespace qnodes {
+
+class Slot;
+
+// Type-ahead popup for creating nodes, backed by a NodeTypeRegistry.
+class NodePalette : public QWidget {
+    Q_OBJECT
+
+public:
+    static const int maxResults;
+
+    explicit NodePalette(
+        const NodeTypeRegistry &registry = NodeTypeRegistry::global(),
+        QWidget *parent = nullptr);
+    NodePalette(const NodePalette &) = delete;
+    NodePalette(NodePalette &&) = delete;
+    ~NodePalette();
+
+    // Only types that can be connected to the slot are offered, if given.
+    void popup(const QPoint &globalPos, Slot *slot = nullptr);
+    Slot *filterSlot() const;
+
+signals:
+    void typeChosen(const QByteArray &id);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    struct Impl;
+    Impl *m_impl;
+};
+
+} // namespace qnodes
+
+#endif // QNODES_NODE_PALETTE_HPP_INCLUDED
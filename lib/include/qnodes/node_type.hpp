@@ -0,0 +1,82 @@
+#ifndef QNODES_NODE_TYPE_HPP_INCLUDED
+#define QNODES_NODE_TYPE_HPP_INCLUDED
+
+#include <QByteArray>
+#include <QColor>
+#include <QHash>
+#include <QString>
+#include <functional>
+#include <qnodes/port_type.hpp>
+#include <unordered_map>
+#include <vector>
+
+namespace qnodes {
+
+class Node;
+class Slot;
+
+struct NodeTypeInfo {
+    QByteArray id;
+    QString name;
+    QString category;
+    QColor color;
+
+    // Port signature, so that compatibility can be checked without
+    // creating a node: accepted types per input, type per output.
+    std::vector<PortTypeMask> inputs;
+    std::vector<PortTypeId> outputs;
+
+    std::function<Node *()> factory;
+};
+
+// Node types known to the application, with a trigram index over names and
+// categories for type-ahead search. The index is extended as types are
+// registered, so searching never rebuilds it.
+class NodeTypeRegistry {
+public:
+    static NodeTypeRegistry &global();
+
+    NodeTypeRegistry();
+    NodeTypeRegistry(const NodeTypeRegistry &) = delete;
+    NodeTypeRegistry(NodeTypeRegistry &&) = delete;
+
+    // Returns the index of the type, or -1 if the ID is already taken.
+    int registerType(NodeTypeInfo info);
+
+    int typeCount() const;
+    const NodeTypeInfo &type(int index) const;
+    int indexOf(const QByteArray &id) const;
+
+    std::vector<QString> categories() const;
+
+    Node *create(const QByteArray &id) const;
+
+    // Types that can be connected to the slot: ones with a compatible input
+    // for an output slot, and the other way round.
+    bool isCompatible(int index, const Slot *slot) const;
+
+    // Best matches first. Typos are tolerated through trigram overlap; an
+    // empty query lists the types in registration order.
+    std::vector<int> search(const QString &query, const Slot *slot = nullptr,
+                            int limit = 50) const;
+
+private:
+    struct Entry {
+        NodeTypeInfo info;
+        QString key; // lowercase name and category
+        PortTypeMask inputMask;
+    };
+
+    std::vector<Entry> m_types;
+    QHash<QByteArray, int> m_ids;
+    std::unordered_map<quint64, std::vector<int>> m_trigrams;
+};
+
+// Registers a type with the global registry during static initialization.
+struct NodeTypeRegistrar {
+    explicit NodeTypeRegistrar(NodeTypeInfo info);
+};
+
+} // namespace qnodes
+
+#endif // QNODES_NODE_TYPE_HPP_INCLUDED
@@ -0,0 +1,40 @@
+#ifndef QNODES_OVERVIEW_HPP_INCLUDED
+#define QNODES_OVERVIEW_HPP_INCLUDED
+
+#include <QWidget>
+
+class QGraphicsView;
+
+namespace qnodes {
+
+class Overview : public QWidget {
+    Q_OBJECT
+
+public:
+    static const int rasterSize;
+    static const int refreshInterval;
+
+    explicit Overview(QWidget *parent = nullptr);
+    Overview(const Overview &) = delete;
+    Overview(Overview &&) = delete;
+    ~Overview();
+
+    void setView(QGraphicsView *view);
+    QGraphicsView *view() const;
+
+    QSize sizeHint() const override;
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void changeEvent(QEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+
+private:
+    struct Impl;
+    Impl *m_impl;
+};
+
+} // namespace qnodes
+
+#endif // QNODES_OVERVIEW_HPP_INCLUDED
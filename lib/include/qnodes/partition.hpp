@@ -0,0 +1,40 @@
+#ifndef QNODES_PARTITION_HPP_INCLUDED
+#define QNODES_PARTITION_HPP_INCLUDED
+
+#include <vector>
+
+namespace qnodes {
+
+class Node;
+
+struct PartitionGraph {
+    struct Edge {
+        int a;
+        int b;
+    };
+
+    int nodeCount = 0;
+    std::vector<Edge> edges; // undirected; parallel edges add up
+
+    // One edge per connection between two of the given nodes.
+    static PartitionGraph fromNodes(const std::vector<Node *> &nodes);
+};
+
+struct PartitionOptions {
+    int partitions = 2;
+    double imbalance = 0.1; // allowed deviation from an even split
+    int refinementPasses = 8;
+};
+
+// Splits the nodes into parts of roughly equal size with few edges between
+// them: recursive bisection, each grown breadth-first and then refined
+// with Fiduccia-Mattheyses passes. Returns the part of every node.
+std::vector<int> partitionGraph(const PartitionGraph &graph,
+                                const PartitionOptions &options = {});
+
+// Number of edges between different parts.
+int cutSize(const PartitionGraph &graph, const std::vector<int> &parts);
+
+} // namespace qnodes
+
+#endif // QNODES_PARTITION_HPP_INCLUDED
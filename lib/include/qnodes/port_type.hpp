@@ -0,0 +1,60 @@
+#ifndef QNODES_PORT_TYPE_HPP_INCLUDED
+#define QNODES_PORT_TYPE_HPP_INCLUDED
+
+#include <QByteArray>
+#include <QHash>
+#include <QMetaType>
+#include <vector>
+
+namespace qnodes {
+
+using PortTypeId = int;
+using PortTypeMask = quint64;
+
+// Assigns small integer IDs to port types, so that compatibility checks are
+// a single mask test. Conversions are stored as one mask per source type.
+// The registry is meant to be used from the GUI thread.
+class PortTypeRegistry {
+public:
+    static const PortTypeId anyType;
+    static const PortTypeId invalidType;
+    static const int maxTypes;
+
+    static PortTypeRegistry &global();
+
+    PortTypeRegistry();
+    PortTypeRegistry(const PortTypeRegistry &) = delete;
+    PortTypeRegistry(PortTypeRegistry &&) = delete;
+
+    // Returns the existing ID if the name is already registered, or
+    // invalidType once maxTypes are. Slots of an invalid type cannot be
+    // connected.
+    PortTypeId registerType(const QByteArray &name);
+    PortTypeId typeId(const QByteArray &name) const;
+    QByteArray typeName(PortTypeId id) const;
+    int typeCount() const;
+
+    void addConversion(PortTypeId from, PortTypeId to);
+
+    static PortTypeMask maskOf(PortTypeId id);
+
+    // Types a value of the given type can be connected to, including itself.
+    PortTypeMask convertibleTo(PortTypeId from) const;
+
+    bool canConnect(PortTypeId from, PortTypeMask accepted) const;
+
+private:
+    QHash<QByteArray, PortTypeId> m_ids;
+    std::vector<QByteArray> m_names;
+    std::vector<PortTypeMask> m_conversions;
+};
+
+template <typename T> PortTypeId portTypeId() {
+    static const PortTypeId id = PortTypeRegistry::global().registerType(
+        QMetaType::typeName(qMetaTypeId<T>()));
+    return id;
+}
+
+} // namespace qnodes
+
+#endif // QNODES_PORT_TYPE_HPP_INCLUDED
@@ -0,0 +1,100 @@
+#ifndef QNODES_PROBE_HPP_INCLUDED
+#define QNODES_PROBE_HPP_INCLUDED
+
+#include <QObject>
+#include <QVariantList>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace qnodes {
+
+class Connection;
+class Node;
+class Scene;
+
+// Latest values that went through a connection. Writers never wait: every
+// sample goes into a fixed ring, overwriting the oldest, and the summary is
+// updated with atomics. Any number of threads may write at the same time
+// while the GUI thread reads.
+class Probe {
+public:
+    static const int capacity; // samples kept for the sparkline
+    static const int samplesPerBlock;
+
+    struct Summary {
+        double current = 0.0;
+        double min = 0.0;
+        double max = 0.0;
+        qint64 count = 0; // ring entries written since the last clear()
+    };
+
+    Probe();
+    Probe(const Probe &) = delete;
+    Probe(Probe &&) = delete;
+    ~Probe();
+
+    // NaN is ignored.
+    void write(double value);
+
+    // A block of stream samples: all of them count towards the summary,
+    // but only samplesPerBlock evenly spaced ones go into the ring.
+    void write(const float *values, int count);
+
+    // Numeric outputs of the node go to the probes of the connections
+    // leaving the matching output slots. GUI thread only.
+    static void sampleOutputs(Node *node, const QVariantList &outputs);
+
+    Summary summary() const;
+
+    // The samples in the ring, oldest first.
+    void read(std::vector<double> *samples) const;
+
+    // Grows with every write; cheap to poll for changes.
+    quint64 writeCount() const;
+
+    void clear();
+
+private:
+    std::unique_ptr<std::atomic<double>[]> m_ring;
+    std::atomic<quint64> m_written{0};
+    std::atomic<quint64> m_cleared{0};
+    std::atomic<double> m_current{0.0};
+    std::atomic<double> m_min;
+    std::atomic<double> m_max;
+
+    void push(double value);
+    void include(double value);
+};
+
+// Attaches probes to connections and repaints the probed connections at
+// display rate, and only those that received samples since the last
+// refresh. The timer only runs while something is probed.
+class ProbeMonitor : public QObject {
+    Q_OBJECT
+
+public:
+    static const int refreshInterval; // ms
+
+    explicit ProbeMonitor(Scene *scene, QObject *parent = nullptr);
+    ProbeMonitor(const ProbeMonitor &) = delete;
+    ProbeMonitor(ProbeMonitor &&) = delete;
+    ~ProbeMonitor();
+
+    // Returns the connection's probe, creating one if needed. A running
+    // stream only picks up probes attached before it started.
+    std::shared_ptr<Probe> attach(Connection *connection);
+    void detach(Connection *connection);
+    void clear();
+
+    bool isProbed(const Connection *connection) const;
+    std::vector<Connection *> probedConnections() const;
+
+private:
+    struct Impl;
+    Impl *m_impl;
+};
+
+} // namespace qnodes
+
+#endif // QNODES_PROBE_HPP_INCLUDED
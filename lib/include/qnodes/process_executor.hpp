@@ -0,0 +1,83 @@
+#ifndef QNODES_PROCESS_EXECUTOR_HPP_INCLUDED
+#define QNODES_PROCESS_EXECUTOR_HPP_INCLUDED
+
+#include <QObject>
+#include <QStringList>
+#include <QVariant>
+#include <qnodes/snapshot.hpp>
+
+namespace qnodes {
+
+class Node;
+class Scene;
+class Slot;
+
+// Evaluates a graph in worker processes, so that a crashing node takes
+// down only its own worker. Nodes are split with partitionGraph(); values
+// crossing partitions go through a SharedRing per connection, while a
+// local socket carries the control messages. Every evaluation starts
+// fresh workers, which run runProcessWorker().
+//
+// A worker that dies, hangs or cannot load its partition fails the nodes
+// of its partition; nodes downstream of them are not evaluated, everything
+// else still is. Nodes without a type name, such as collapsed groups,
+// cannot be sent to a worker and are left out.
+class ProcessExecutor : public QObject {
+    Q_OBJECT
+
+public:
+    static const qint64 defaultRingSize;
+    static const int killTimeout;
+    static const int defaultWorkerTimeout;
+
+    ProcessExecutor(Scene *scene, const QString &workerProgram,
+                    QObject *parent = nullptr);
+    ProcessExecutor(const ProcessExecutor &) = delete;
+    ProcessExecutor(ProcessExecutor &&) = delete;
+    ~ProcessExecutor();
+
+    Scene *scene() const;
+    QString workerProgram() const;
+
+    void setPartitionCount(int count);
+    int partitionCount() const;
+
+    // Capacity of each shared ring; larger values are streamed through.
+    void setRingSize(qint64 bytes);
+    qint64 ringSize() const;
+
+    // A worker that sends nothing for this long, in milliseconds, is
+    // killed and its partition fails; 0 waits forever.
+    void setWorkerTimeout(int msecs);
+    int workerTimeout() const;
+
+    // Returns false if a run is in progress, there is nothing to evaluate
+    // or the shared memory cannot be set up.
+    bool evaluate();
+    void cancel();
+    bool isRunning() const;
+
+    // Results of the last run.
+    int partitionOf(const Node *node) const;
+    QVariantList outputs(const Node *node) const;
+    QVariant value(const Slot *outputSlot) const;
+    int failedPartitionCount() const;
+
+signals:
+    void partitionFailed(int partition, const QString &reason);
+    void evaluated();
+
+private:
+    struct Impl;
+    Impl *m_impl;
+};
+
+// Body of a worker process, given the arguments the executor started it
+// with. Needs a QApplication, since nodes are graphics items, and returns
+// once the executor disconnects.
+int runProcessWorker(const QStringList &arguments,
+                     const GraphSnapshot::NodeFactory &factory);
+
+} // namespace qnodes
+
+#endif // QNODES_PROCESS_EXECUTOR_HPP_INCLUDED
@@ -0,0 +1,49 @@
+#ifndef QNODES_PROFILE_OVERLAY_HPP_INCLUDED
+#define QNODES_PROFILE_OVERLAY_HPP_INCLUDED
+
+#include <QObject>
+
+namespace qnodes {
+
+class Profiler;
+class Scene;
+
+// Heatmap of a profiler's statistics: nodes are tinted by the chosen metric
+// relative to the hottest node, connections are widened by the bytes that
+// went through them. Updates at a fixed low rate, so that the overlay does
+// not take time away from what is being measured.
+class ProfileOverlay : public QObject {
+    Q_OBJECT
+
+public:
+    static const int updateInterval;
+    static const double maxWidthScale;
+
+    enum Metric { TotalTime, MaxTime, CallCount, Memory };
+
+    // Neither the scene nor the profiler is owned.
+    ProfileOverlay(Scene *scene, Profiler *profiler,
+                   QObject *parent = nullptr);
+    ProfileOverlay(const ProfileOverlay &) = delete;
+    ProfileOverlay(ProfileOverlay &&) = delete;
+    ~ProfileOverlay();
+
+    void setMetric(Metric metric);
+    Metric metric() const;
+
+    // Starts or stops the periodic updates; disabling removes the overlay.
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+
+    // Collects the profiler's samples and repaints right away.
+    void update();
+    void clear();
+
+private:
+    struct Impl;
+    Impl *m_impl;
+};
+
+} // namespace qnodes
+
+#endif // QNODES_PROFILE_OVERLAY_HPP_INCLUDED
@@ -0,0 +1,63 @@
+#ifndef QNODES_PROFILER_HPP_INCLUDED
+#define QNODES_PROFILER_HPP_INCLUDED
+
+#include <QtGlobal>
+#include <vector>
+
+namespace qnodes {
+
+class Node;
+
+// Per-node execution statistics. Samples are written to a lock-free buffer
+// owned by the recording thread and only summed up by collect(), so that
+// recording costs a clock read and a ring buffer push. The buffer of a
+// thread that exits is handed to the next thread that starts recording.
+class Profiler {
+public:
+    // Samples each thread can buffer between two calls to collect(); more
+    // are dropped and counted.
+    static const size_t bufferCapacity;
+
+    struct NodeStats {
+        qint64 calls = 0;
+        qint64 totalTime = 0; // ns
+        qint64 maxTime = 0;   // ns
+        qint64 memory = 0;    // bytes produced by the last call
+        qint64 peakMemory = 0;
+        std::vector<qint64> outputBytes; // per output slot, summed
+    };
+
+    Profiler();
+    Profiler(const Profiler &) = delete;
+    Profiler(Profiler &&) = delete;
+    ~Profiler();
+
+    // Recording is a no-op while disabled.
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+
+    // May be called from any thread, but not concurrently with the
+    // destructor.
+    void record(const Node *node, qint64 nanoseconds, qint64 memory);
+    void recordOutput(const Node *node, int output, qint64 bytes);
+
+    // Moves buffered samples into the statistics. Must always be called
+    // from the same thread, normally the GUI thread.
+    void collect();
+
+    NodeStats stats(const Node *node) const;
+    std::vector<const Node *> profiledNodes() const;
+
+    void forget(const Node *node);
+    void reset();
+
+    qint64 droppedCount() const;
+
+private:
+    struct Impl;
+    Impl *m_impl;
+};
+
+} // namespace qnodes
+
+#endif // QNODES_PROFILER_HPP_INCLUDED
@@ -0,0 +1,35 @@
+#ifndef QNODES_RENDER_HPP_INCLUDED
+#define QNODES_RENDER_HPP_INCLUDED
+
+#include <QColor>
+#include <QImage>
+#include <QRectF>
+#include <QString>
+
+class QGraphicsScene;
+
+namespace qnodes {
+
+struct RenderOptions {
+    double scale = 1.0;
+    double margin = 20.0;
+    int minBandHeight = 256; // pixels; smaller images use fewer threads
+    int threadCount = 0; // 0 means QThread::idealThreadCount()
+    QColor background = Qt::transparent;
+};
+
+// Bounds of all items, with the margin added.
+QRectF renderBounds(QGraphicsScene *scene, const RenderOptions &options = {});
+
+// The scene is painted once into a recording on the calling thread, which
+// is then replayed into one horizontal band of the image per worker
+// thread. Replaying pixmaps off the GUI thread needs a platform with
+// threaded pixmaps, like offscreen or xcb; use a single thread on others.
+QImage renderImage(QGraphicsScene *scene, const RenderOptions &options = {});
+
+bool renderSvg(QGraphicsScene *scene, const QString &fileName,
+               const RenderOptions &options = {});
+
+} // namespace qnodes
+
+#endif // QNODES_RENDER_HPP_INCLUDED
@@ -0,0 +1,76 @@
+#ifndef QNODES_RESULT_CACHE_HPP_INCLUDED
+#define QNODES_RESULT_CACHE_HPP_INCLUDED
+
+#include <QVariant>
+#include <functional>
+#include <qnodes/lru_cache.hpp>
+#include <qnodes/memory_stats.hpp>
+
+namespace qnodes {
+
+class Node;
+
+class ResultCache {
+public:
+    using Hasher = std::function<quint64(const QVariant &)>;
+
+    // What a cached result depends on. The full key is kept with the entry
+    // and compared on lookup, so two evaluations whose hashes collide never
+    // share a result.
+    struct Key {
+        quint64 hash = 0;
+        size_t nodeType = 0;
+        quint64 parameters = 0;
+        QVariantList inputs;
+
+        bool operator==(const Key &other) const;
+        bool operator!=(const Key &other) const { return !(*this == other); }
+    };
+
+    explicit ResultCache(qint64 budget = 64 * 1024 * 1024);
+    ResultCache(const ResultCache &) = delete;
+    ResultCache(ResultCache &&) = delete;
+
+    // Returns false if an input cannot be hashed, in which case the
+    // evaluation is not cached.
+    static bool makeKey(const Node &node, const QVariantList &inputs,
+                        Key *key);
+
+    // Values of custom types, and of built-in types without a hash of their
+    // own, are only hashable once a hasher is registered for their type.
+    static void registerHasher(int userType, Hasher hasher);
+    static bool isHashable(const QVariant &value);
+    static quint64 hashValue(const QVariant &value);
+
+    static qint64 estimateSize(const QVariant &value);
+
+    void setMemoryBudget(qint64 bytes);
+    qint64 memoryBudget() const;
+    qint64 memoryUsage() const;
+    int entryCount() const;
+
+    bool lookup(const Key &key, QVariantList *outputs);
+    void insert(const Key &key, const QVariantList &outputs);
+    void clear();
+
+    qint64 hitCount() const;
+    qint64 missCount() const;
+
+private:
+    struct Entry {
+        Key key;
+        QVariantList outputs;
+    };
+
+    // A key whose hash collides with a cached one replaces it.
+    LruCache<quint64, Entry> m_entries;
+    qint64 m_hits = 0;
+    qint64 m_misses = 0;
+    MemoryAccount m_memory;
+
+    void updateMemory();
+};
+
+} // namespace qnodes
+
+#endif // QNODES_RESULT_CACHE_HPP_INCLUDED
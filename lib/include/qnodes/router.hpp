@@ -0,0 +1,51 @@
+#ifndef QNODES_ROUTER_HPP_INCLUDED
+#define QNODES_ROUTER_HPP_INCLUDED
+
+#include <QObject>
+#include <QPolygonF>
+#include <qnodes/spatial_index.hpp>
+
+namespace qnodes {
+
+class Scene;
+
+struct RouterOptions {
+    double margin = 8.0;
+    double stub = 20.0;
+    double bendPenalty = 40.0;
+    double searchMargin = 150.0;
+    int backgroundThreshold = 64;
+};
+
+QPolygonF routeOrthogonal(const SpatialIndex &obstacles, const QPointF &source,
+                          const QPointF &target,
+                          const RouterOptions &options = {});
+
+class ConnectionRouter : public QObject {
+    Q_OBJECT
+
+public:
+    explicit ConnectionRouter(Scene *scene, QObject *parent = nullptr);
+    ConnectionRouter(const ConnectionRouter &) = delete;
+    ConnectionRouter(ConnectionRouter &&) = delete;
+    ~ConnectionRouter();
+
+    void setOptions(const RouterOptions &options);
+    RouterOptions options() const;
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+
+    void rerouteAll();
+
+signals:
+    void routesUpdated();
+
+private:
+    struct Impl;
+    Impl *m_impl;
+};
+
+} // namespace qnodes
+
+#endif // QNODES_ROUTER_HPP_INCLUDED
@@ -0,0 +1,82 @@
+#ifndef QNODES_SCENE_HPP_INCLUDED
+#define QNODES_SCENE_HPP_INCLUDED
+
+#include <QGraphicsScene>
+#include <qnodes/spatial_index.hpp>
+#include <vector>
+
+namespace qnodes {
+
+class Connection;
+class Node;
+class Slot;
+
+class Scene : public QGraphicsScene {
+    Q_OBJECT
+
+public:
+    explicit Scene(QObject *parent = nullptr);
+    Scene(const Scene &) = delete;
+    Scene(Scene &&) = delete;
+    ~Scene();
+
+    std::vector<Node *> nodes() const;
+    std::vector<Connection *> connections() const;
+
+    bool containsNode(const Node *node) const;
+    bool containsConnection(const Connection *connection) const;
+
+    const SpatialIndex &nodeIndex() const;
+    const SpatialIndex &connectionIndex() const;
+
+    // Rubber-band and lasso selection of nodes and connections. Candidates
+    // come from the spatial indexes and only those get exact tests. The
+    // selection is changed in one batch with a single selectionChanged().
+    void selectInRect(const QRectF &rect,
+                      Qt::ItemSelectionMode mode = Qt::IntersectsItemShape,
+                      Qt::ItemSelectionOperation operation =
+                          Qt::ReplaceSelection);
+    void selectInPolygon(const QPolygonF &polygon,
+                         Qt::ItemSelectionMode mode = Qt::IntersectsItemShape,
+                         Qt::ItemSelectionOperation operation =
+                             Qt::ReplaceSelection);
+
+    // Same batching, for nodes found by other means, e.g. a search.
+    void selectNodes(const std::vector<Node *> &nodes,
+                     Qt::ItemSelectionOperation operation =
+                         Qt::ReplaceSelection);
+
+signals:
+    void nodeAdded(qnodes::Node *node);
+    void nodeRemoved(qnodes::Node *node);
+    void nodeGeometryChanged(qnodes::Node *node);
+    void nodeAppearanceChanged(qnodes::Node *node); // e.g. background brush
+
+    void connectionAdded(qnodes::Connection *connection);
+    void connectionRemoved(qnodes::Connection *connection);
+    void connectionGeometryChanged(qnodes::Connection *connection);
+
+    // A connection dragged out of the slot was released without reaching
+    // another slot.
+    void connectionDropped(qnodes::Slot *source, const QPointF &scenePos);
+
+private:
+    friend class Connection;
+    friend class Node;
+
+    struct Impl;
+    Impl *m_impl;
+
+    void registerNode(Node *node);
+    void unregisterNode(Node *node);
+    void updateNodeGeometry(Node *node);
+    void updateNodeAppearance(Node *node);
+
+    void updateConnection(Connection *connection);
+    void unregisterConnection(Connection *connection);
+    void updateConnectionGeometry(Connection *connection);
+};
+
+} // namespace qnodes
+
+#endif // QNODES_SCENE_HPP_INCLUDED
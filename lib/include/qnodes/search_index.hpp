@@ -0,0 +1,64 @@
+#ifndef QNODES_SEARCH_INDEX_HPP_INCLUDED
+#define QNODES_SEARCH_INDEX_HPP_INCLUDED
+
+#include <QObject>
+#include <QString>
+#include <vector>
+
+class QGraphicsView;
+
+namespace qnodes {
+
+class Node;
+class Scene;
+
+// Inverted index over the text of the nodes in a scene: node labels, slot
+// labels, slot tooltips and port type names, and node metadata. It follows
+// nodeAdded/nodeRemoved and the label and metadata change signals; other
+// changes, such as new tooltips, need a refresh().
+class SearchIndex : public QObject {
+    Q_OBJECT
+
+public:
+    enum Field {
+        NodeLabel = 0x1,
+        SlotLabel = 0x2,
+        SlotType = 0x4, // tooltips and port type names
+        Metadata = 0x8,
+        AllFields = 0xf
+    };
+
+    struct Match {
+        Node *node;
+        double score;
+        int fields; // where the query matched
+    };
+
+    explicit SearchIndex(Scene *scene, QObject *parent = nullptr);
+    SearchIndex(const SearchIndex &) = delete;
+    SearchIndex(SearchIndex &&) = delete;
+    ~SearchIndex();
+
+    // Every word of the query has to match the start of a word in one of
+    // the fields. Matches are ranked by field, by how rare the words are
+    // and by whether they matched whole words; best first.
+    std::vector<Match> search(const QString &query, int limit = 100,
+                              int fields = AllFields) const;
+
+    void refresh(Node *node);
+
+    int nodeCount() const;
+    int termCount() const;
+    qint64 memoryUsage() const; // estimated bytes
+
+    // Selects the nodes and centres the view on the first one.
+    static void reveal(QGraphicsView *view, const std::vector<Node *> &nodes);
+
+private:
+    struct Impl;
+    Impl *m_impl;
+};
+
+} // namespace qnodes
+
+#endif // QNODES_SEARCH_INDEX_HPP_INCLUDED
@@ -0,0 +1,41 @@
+#ifndef QNODES_SHARED_RING_HPP_INCLUDED
+#define QNODES_SHARED_RING_HPP_INCLUDED
+
+#include <QString>
+
+namespace qnodes {
+
+// Byte ring buffer in a QSharedMemory segment, for one producer and one
+// consumer that may be in different processes. Reads and writes never
+// block; they transfer as much as fits and return the byte count.
+class SharedRing {
+public:
+    SharedRing();
+    SharedRing(const SharedRing &) = delete;
+    SharedRing(SharedRing &&) = delete;
+    ~SharedRing();
+
+    // Creates a new segment, failing if the key is in use.
+    bool create(const QString &key, qint64 capacity);
+    bool attach(const QString &key);
+    void detach();
+    bool isAttached() const;
+    QString errorString() const;
+
+    qint64 capacity() const;
+    qint64 bytesAvailable() const;
+    qint64 freeSpace() const;
+
+    // Return -1, as does bytesAvailable(), if the indices in the segment
+    // are inconsistent; the ring should then be treated as closed.
+    qint64 write(const char *data, qint64 size);
+    qint64 read(char *data, qint64 maxSize);
+
+private:
+    struct Impl;
+    Impl *m_impl;
+};
+
+} // namespace qnodes
+
+#endif // QNODES_SHARED_RING_HPP_INCLUDED
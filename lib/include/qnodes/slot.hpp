@@ -2,6 +2,9 @@
 #define QNODES_SLOT_HPP_INCLUDED
 
 #include <QGraphicsObject>
+#include <qnodes/memory_stats.hpp>
+#include <qnodes/port_type.hpp>
+#include <vector>
 
 namespace qnodes {
 
@@ -13,6 +16,7 @@ class Slot : public QGraphicsObject {
 
 public:
     static const double slotRadius;
+    static const double snapRadius;
 
     enum Type { Input, Output };
 
@@ -28,6 +32,17 @@ public:
     void setLabel(const QString &label);
     QString label() const;
 
+    MemoryUsage memoryUsage() const;
+
+    // Sets the type and makes it the only accepted one.
+    void setPortType(PortTypeId type);
+    PortTypeId portType() const;
+
+    void setAcceptedTypes(PortTypeMask types);
+    PortTypeMask acceptedTypes() const;
+
+    std::vector<Connection *> connections() const;
+
     QRectF boundingRect() const override;
     QPainterPath shape() const override;
 
@@ -50,8 +65,13 @@ protected:
     virtual bool acceptConnectionFrom(const Slot *src) const;
 
 private:
+    friend class Connection;
+
     struct Impl;
     Impl *m_impl;
+
+    void attachConnection(Connection *connection);
+    void detachConnection(Connection *connection);
 };
 
 } // namespace qnodes
@@ -0,0 +1,97 @@
+#ifndef QNODES_SNAPSHOT_HPP_INCLUDED
+#define QNODES_SNAPSHOT_HPP_INCLUDED
+
+#include <QByteArray>
+#include <QPointF>
+#include <QRectF>
+#include <QString>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class QGraphicsScene;
+class QMimeData;
+
+namespace qnodes {
+
+class Node;
+
+// Immutable copy of a subgraph, used for copy, paste and duplication.
+// Connections are stored as indices into the node list, so only those
+// between copied nodes are kept. Pasting within the process shares the
+// snapshot, including the nodes' state buffers, instead of decoding it.
+class GraphSnapshot : public std::enable_shared_from_this<GraphSnapshot> {
+public:
+    struct NodeRecord {
+        QByteArray typeName;
+        QString label;
+        QPointF pos;
+        QByteArray state;
+        quint64 id;
+        quint64 slotSignature; // hash of slot directions, labels and types
+    };
+
+    struct ConnectionRecord {
+        int sourceNode;
+        int sourceSlot;
+        int targetNode;
+        int targetSlot;
+    };
+
+    // Creates an empty node of the given type, or returns nullptr.
+    using NodeFactory = std::function<Node *(const QByteArray &typeName)>;
+
+    // Pasted copies get new IDs; loading a saved graph keeps them.
+    enum IdMode { NewIds, KeepIds };
+
+    static const char *const mimeType;
+
+    static std::shared_ptr<const GraphSnapshot>
+    capture(const std::vector<Node *> &nodes);
+
+    // Returns nullptr if the data is not a valid snapshot.
+    static std::shared_ptr<const GraphSnapshot>
+    fromBinary(const QByteArray &data);
+    static std::shared_ptr<const GraphSnapshot>
+    fromMimeData(const QMimeData *mime);
+
+    static std::shared_ptr<const GraphSnapshot>
+    fromRecords(std::vector<NodeRecord> nodes,
+                std::vector<ConnectionRecord> connections);
+
+    static quint64 slotSignature(Node *node);
+
+    GraphSnapshot(const GraphSnapshot &) = delete;
+    GraphSnapshot(GraphSnapshot &&) = delete;
+
+    QByteArray toBinary() const;
+
+    // The binary form is only produced when another application asks for
+    // it; the caller owns the returned object.
+    QMimeData *toMimeData() const;
+
+    const std::vector<NodeRecord> &nodes() const;
+    const std::vector<ConnectionRecord> &connections() const;
+    bool isEmpty() const;
+
+    // Bounds of the copied node positions.
+    QRectF bounds() const;
+
+    // Creates the nodes and connections, moved by the offset. Each item is
+    // set up completely before it is added, so that the scene registers it
+    // once. Nodes the factory cannot create are skipped.
+    std::vector<Node *> instantiate(QGraphicsScene *scene,
+                                    const NodeFactory &factory,
+                                    const QPointF &offset = {},
+                                    IdMode idMode = NewIds) const;
+
+private:
+    std::vector<NodeRecord> m_nodes;
+    std::vector<ConnectionRecord> m_connections;
+
+    GraphSnapshot() = default;
+};
+
+} // namespace qnodes
+
+#endif // QNODES_SNAPSHOT_HPP_INCLUDED
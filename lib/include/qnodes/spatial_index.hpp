@@ -0,0 +1,67 @@
+#ifndef QNODES_SPATIAL_INDEX_HPP_INCLUDED
+#define QNODES_SPATIAL_INDEX_HPP_INCLUDED
+
+#include <QRectF>
+#include <unordered_map>
+#include <vector>
+
+namespace qnodes {
+
+class SpatialIndex {
+public:
+    explicit SpatialIndex(qreal cellSize = 256.0);
+    SpatialIndex(const SpatialIndex &) = default;
+    SpatialIndex(SpatialIndex &&) = default;
+
+    SpatialIndex &operator=(const SpatialIndex &) = default;
+    SpatialIndex &operator=(SpatialIndex &&) = default;
+
+    qreal cellSize() const;
+
+    void insert(quintptr id, const QRectF &rect);
+    bool remove(quintptr id);
+    void clear();
+
+    bool contains(quintptr id) const;
+    QRectF rect(quintptr id) const;
+    size_t size() const;
+
+    std::vector<quintptr> query(const QRectF &area) const;
+
+    template <typename Fn> void forEach(Fn fn) const {
+        for (const auto &entry : m_rects) {
+            fn(entry.first, entry.second);
+        }
+    }
+
+private:
+    struct CellRange {
+        int x0, y0, x1, y1;
+
+        qint64 count() const {
+            return qint64(x1 - x0 + 1) * qint64(y1 - y0 + 1);
+        }
+    };
+
+    static const qint64 maxCellsPerItem;
+
+    qreal m_cellSize;
+    std::unordered_map<quintptr, QRectF> m_rects;
+    std::unordered_map<quint64, std::vector<quintptr>> m_cells;
+    std::vector<quintptr> m_oversized;
+
+    CellRange cellRange(const QRectF &rect) const;
+    static quint64 cellKey(int x, int y);
+
+    void link(quintptr id, const QRectF &rect);
+    void unlink(quintptr id, const QRectF &rect);
+};
+
+inline bool rectsOverlap(const QRectF &a, const QRectF &b) {
+    return (a.left() <= b.right()) && (b.left() <= a.right()) &&
+           (a.top() <= b.bottom()) && (b.top() <= a.bottom());
+}
+
+} // namespace qnodes
+
+#endif // QNODES_SPATIAL_INDEX_HPP_INCLUDED
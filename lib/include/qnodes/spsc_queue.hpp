@@ -0,0 +1,74 @@
+#ifndef QNODES_SPSC_QUEUE_HPP_INCLUDED
+#define QNODES_SPSC_QUEUE_HPP_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace qnodes {
+
+// Bounded single-producer/single-consumer ring buffer. push() may only be
+// called from one thread and pop() from one (possibly other) thread.
+template <typename T> class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity)
+        : m_capacity(capacity), m_mask(roundUp(capacity) - 1),
+          m_buffer(new T[m_mask + 1]) {}
+
+    SpscQueue(const SpscQueue &) = delete;
+    SpscQueue &operator=(const SpscQueue &) = delete;
+
+    size_t capacity() const { return m_capacity; }
+
+    size_t size() const {
+        size_t head = m_head.load(std::memory_order_acquire);
+        return m_tail.load(std::memory_order_acquire) - head;
+    }
+
+    bool empty() const { return size() == 0; }
+    bool full() const { return size() >= m_capacity; }
+
+    bool push(const T &value) {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) >= m_capacity) {
+            return false;
+        }
+
+        m_buffer[tail & m_mask] = value;
+        m_tail.store(tail + 1, std::memory_order_seq_cst);
+        return true;
+    }
+
+    bool pop(T *value) {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        *value = m_buffer[head & m_mask];
+        m_head.store(head + 1, std::memory_order_seq_cst);
+        return true;
+    }
+
+private:
+    static size_t roundUp(size_t n) {
+        size_t p = 1;
+        while (p < n) {
+            p <<= 1;
+        }
+
+        return p;
+    }
+
+    const size_t m_capacity;
+    const size_t m_mask;
+    std::unique_ptr<T[]> m_buffer;
+
+    // Producer and consumer indices live on separate cache lines.
+    alignas(64) std::atomic<size_t> m_head{0};
+    alignas(64) std::atomic<size_t> m_tail{0};
+};
+
+} // namespace qnodes
+
+#endif // QNODES_SPSC_QUEUE_HPP_INCLUDED
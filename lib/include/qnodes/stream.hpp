@@ -0,0 +1,97 @@
+#ifndef QNODES_STREAM_HPP_INCLUDED
+#define QNODES_STREAM_HPP_INCLUDED
+
+#include <QObject>
+#include <atomic>
+#include <vector>
+
+namespace qnodes {
+
+class ChunkPool;
+class Profiler;
+class Scene;
+
+// Fixed-capacity block of samples. Chunks are owned by the executor's pool
+// and recycled once every consumer has released them.
+class Chunk {
+public:
+    Chunk() = default;
+    Chunk(const Chunk &) = delete;
+    Chunk &operator=(const Chunk &) = delete;
+
+    float *data() { return m_data; }
+    const float *data() const { return m_data; }
+
+    int size() const { return m_size; }
+    void setSize(int size) { m_size = qBound(0, size, m_capacity); }
+
+    int capacity() const { return m_capacity; }
+
+private:
+    friend class ChunkPool;
+
+    float *m_data = nullptr;
+    int m_size = 0;
+    int m_capacity = 0;
+    std::atomic<int> m_refs{0};
+};
+
+// One pipeline stage. process() runs on a pool thread, but never
+// concurrently for the same processor, so it must not touch graphics
+// items. A stage with inputs runs while at least one of them has data;
+// inputs that are not connected, or whose upstream stage has finished and
+// been drained, are passed as nullptr. It finishes once all its inputs
+// are in that state.
+class StreamProcessor {
+public:
+    virtual ~StreamProcessor();
+
+    // Returns false when there is no more data, e.g. at the end of a
+    // source. The outputs of that call are dropped and the stage finishes.
+    virtual bool process(const std::vector<const Chunk *> &inputs,
+                         const std::vector<Chunk *> &outputs) = 0;
+};
+
+class StreamExecutor : public QObject {
+    Q_OBJECT
+
+public:
+    static const int maxBatch;
+
+    explicit StreamExecutor(Scene *scene, QObject *parent = nullptr);
+    StreamExecutor(const StreamExecutor &) = delete;
+    StreamExecutor(StreamExecutor &&) = delete;
+    ~StreamExecutor();
+
+    void setChunkSize(int samples);
+    int chunkSize() const;
+
+    void setQueueCapacity(int chunks);
+    int queueCapacity() const;
+
+    // Not owned. Records the time of every process() call and the bytes
+    // written to each output, from the pool threads. Takes effect on the
+    // next start().
+    void setProfiler(Profiler *profiler);
+    Profiler *profiler() const;
+
+    // Builds a stage for every node that returns a stream processor; edges
+    // between stages become bounded queues. Returns false if there is
+    // nothing to run or a stream is already running.
+    bool start();
+    void stop();
+    bool isRunning() const;
+
+    qint64 processedChunks() const;
+
+signals:
+    void finished();
+
+private:
+    struct Impl;
+    Impl *m_impl;
+};
+
+} // namespace qnodes
+
+#endif // QNODES_STREAM_HPP_INCLUDED
@@ -0,0 +1,71 @@
+#ifndef QNODES_TILE_PAGER_HPP_INCLUDED
+#define QNODES_TILE_PAGER_HPP_INCLUDED
+
+#include <QObject>
+#include <QRectF>
+#include <qnodes/snapshot.hpp>
+#include <qnodes/tile_store.hpp>
+
+class QGraphicsView;
+
+namespace qnodes {
+
+class Node;
+class Scene;
+
+// Shows a TileStore in a scene by materializing only the tiles near the
+// viewport, at most maxResidentTiles of them; the least recently wanted
+// tile is evicted first. When the view is zoomed out below summaryScale,
+// or shows more tiles than that, it shows at most maxSummaryCells boxes
+// instead, each with the node count of a square of tiles. Nodes of evicted
+// tiles are reset and kept in a bounded pool per type for reuse.
+// Connections to nodes that are not materialized end at small placeholder
+// nodes placed where the other node is stored.
+//
+// The store is read-only, so edits to materialized nodes are lost when
+// their tile is evicted.
+class TilePager : public QObject {
+    Q_OBJECT
+
+public:
+    static const int refreshInterval;
+    static const int maxPooledNodes;
+    static const int maxResidentTiles;
+    static const int maxSummaryCells;
+    static const double summaryScale;
+
+    TilePager(Scene *scene, const TileStore *store,
+              GraphSnapshot::NodeFactory factory, QObject *parent = nullptr);
+    TilePager(const TilePager &) = delete;
+    TilePager(TilePager &&) = delete;
+    ~TilePager();
+
+    void setView(QGraphicsView *view);
+    QGraphicsView *view() const;
+
+    // Tiles up to this many tiles away from the viewport are materialized.
+    void setMargin(int tiles);
+    int margin() const;
+
+    // For use without a view; setView() overrides it on the next scroll.
+    void setViewport(const QRectF &sceneRect);
+
+    int residentTileCount() const;
+    int residentNodeCount() const;
+    int pooledNodeCount() const;
+    // Summary boxes shown, each for one or more tiles.
+    int summaryTileCount() const;
+
+    Node *node(StoredNodeId id) const;
+
+signals:
+    void tilesChanged();
+
+private:
+    struct Impl;
+    Impl *m_impl;
+};
+
+} // namespace qnodes
+
+#endif // QNODES_TILE_PAGER_HPP_INCLUDED
@@ -0,0 +1,124 @@
+#ifndef QNODES_TILE_STORE_HPP_INCLUDED
+#define QNODES_TILE_STORE_HPP_INCLUDED
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QPoint>
+#include <QPointF>
+#include <QRectF>
+#include <QString>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace qnodes {
+
+using TileKey = quint64;
+using StoredNodeId = quint64;
+
+struct StoredNode {
+    StoredNodeId id;
+    QByteArray typeName;
+    QString label;
+    QPointF pos;
+    QByteArray state; // refers to the mapped file, valid while it is open
+};
+
+struct StoredEdge {
+    StoredNodeId source;
+    int sourceSlot;
+    StoredNodeId target;
+    int targetSlot;
+};
+
+// Read-only graph file, partitioned into square tiles by node position. The
+// file is memory-mapped, so only the pages of the tiles that are actually
+// read take up memory. Edges are listed in the tiles of both end nodes.
+class TileStore {
+public:
+    TileStore();
+    TileStore(const TileStore &) = delete;
+    TileStore(TileStore &&) = delete;
+    ~TileStore();
+
+    bool open(const QString &fileName);
+    void close();
+    bool isOpen() const;
+
+    double tileSize() const;
+    QRectF bounds() const;
+    quint64 nodeCount() const;
+    quint64 edgeCount() const;
+
+    static TileKey tileKey(int x, int y);
+    static QPoint tileIndex(TileKey key);
+
+    // Non-empty tiles overlapping the area.
+    std::vector<TileKey> tilesIn(const QRectF &area) const;
+    // The same without collecting them; stops and returns false as soon
+    // as visit() does.
+    bool forEachTileIn(const QRectF &area,
+                       const std::function<bool(TileKey)> &visit) const;
+    QRectF tileRect(TileKey key) const;
+
+    std::vector<StoredNodeId> tileNodes(TileKey key) const;
+    int tileNodeCount(TileKey key) const;
+    std::vector<StoredEdge> tileEdges(TileKey key) const;
+
+    StoredNode node(StoredNodeId id) const;
+    QPointF nodePos(StoredNodeId id) const;
+    TileKey nodeTile(StoredNodeId id) const;
+
+private:
+    struct Header;
+    struct TileRecord;
+    struct NodeRecord;
+    struct EdgeRecord;
+    struct BlobRef;
+
+    friend class TileStoreBuilder;
+
+    QFile m_file;
+    const uchar *m_data = nullptr;
+    const Header *m_header = nullptr;
+    std::unordered_map<TileKey, quint64> m_tiles;
+
+    template <typename T> const T *records(quint64 offset) const;
+    QByteArray blob(const BlobRef &ref) const;
+};
+
+// Collects a graph and writes it in the TileStore format. Only compact
+// records are kept in memory, not items.
+class TileStoreBuilder {
+public:
+    explicit TileStoreBuilder(double tileSize = 1024.0);
+    TileStoreBuilder(const TileStoreBuilder &) = delete;
+    TileStoreBuilder(TileStoreBuilder &&) = delete;
+
+    // Returns the index used to refer to the node in addConnection().
+    quint64 addNode(const QByteArray &typeName, const QString &label,
+                    const QPointF &pos, const QByteArray &state = {});
+    void addConnection(quint64 source, int sourceSlot, quint64 target,
+                       int targetSlot);
+
+    bool save(const QString &fileName) const;
+
+private:
+    struct PendingNode {
+        quint32 type;
+        QPointF pos;
+        QByteArray label;
+        QByteArray state;
+    };
+
+    double m_tileSize;
+    std::vector<QByteArray> m_typeNames;
+    QHash<QByteArray, quint32> m_typeIds;
+    std::vector<PendingNode> m_nodes;
+    std::vector<StoredEdge> m_edges;
+};
+
+} // namespace qnodes
+
+#endif // QNODES_TILE_STORE_HPP_INCLUDED
@@ -0,0 +1,36 @@
+#ifndef QNODES_TYPED_SLOT_HPP_INCLUDED
+#define QNODES_TYPED_SLOT_HPP_INCLUDED
+
+#include <qnodes/connection.hpp>
+#include <qnodes/port_type.hpp>
+#include <qnodes/slot.hpp>
+
+namespace qnodes {
+
+// Slot whose port type is that of T. Values are still passed to compute()
+// as QVariants.
+template <typename T> class TypedSlot : public Slot {
+public:
+    TypedSlot(Type type, const QString &label) : Slot(type, label) {
+        setPortType(portTypeId<T>());
+    }
+};
+
+// Connects two slots of the same type; mismatched types do not compile.
+// Both slots must already be in the same scene.
+template <typename T>
+Connection *connectSlots(TypedSlot<T> *output, TypedSlot<T> *input) {
+    if (!output->scene() || (output->slotType() != Slot::Output) ||
+        (input->slotType() != Slot::Input)) {
+        return nullptr;
+    }
+
+    Connection *conn = new Connection(output);
+    output->scene()->addItem(conn);
+    conn->setTargetSlot(input);
+    return conn;
+}
+
+} // namespace qnodes
+
+#endif // QNODES_TYPED_SLOT_HPP_INCLUDED
@@ -1,7 +1,42 @@
+#include <cmath>
 #include <qnodes/bezier.hpp>
 
 namespace qnodes {
 
+// Roots of a*t^2 + b*t + c = 0 that lie in [0, 1]
+static int unitRoots(qreal a, qreal b, qreal c, qreal roots[2]) {
+    const qreal eps = 1e-12;
+    int count = 0;
+
+    auto add = [&](qreal t) {
+        if ((t >= -eps) && (t <= 1.0 + eps)) {
+            roots[count++] = std::min<qreal>(1.0, std::max<qreal>(0.0, t));
+        }
+    };
+
+    if (std::abs(a) < eps) {
+        if (std::abs(b) >= eps) {
+            add(-c / b);
+        }
+
+        return count;
+    }
+
+    qreal disc = b * b - 4.0 * a * c;
+    if (disc < 0.0) {
+        return 0;
+    }
+
+    qreal sq = std::sqrt(disc);
+    add((-b - sq) / (2.0 * a));
+    add((-b + sq) / (2.0 * a));
+    return count;
+}
+
+static qreal cross(const QPointF &a, const QPointF &b) {
+    return a.x() * b.y() - a.y() * b.x();
+}
+
 QuadBezier::QuadBezier(const QPointF &p0, const QPointF &p1,
                        const QPointF &p2) {
     set(p0, p1, p2);
@@ -20,6 +55,106 @@ QPointF QuadBezier::point(int index) const {
 
 QPointF QuadBezier::endPoint() const { return m_pts[2]; }
 
+QPointF QuadBezier::pointAt(qreal t) const {
+    qreal u = 1.0 - t;
+    return m_pts[0] * (u * u) + m_pts[1] * (2.0 * u * t) + m_pts[2] * (t * t);
+}
+
+QRectF QuadBezier::bounds() const {
+    qreal x0 = std::min(m_pts[0].x(), m_pts[2].x());
+    qreal x1 = std::max(m_pts[0].x(), m_pts[2].x());
+    qreal y0 = std::min(m_pts[0].y(), m_pts[2].y());
+    qreal y1 = std::max(m_pts[0].y(), m_pts[2].y());
+
+    // Extremes are where the derivative of a coordinate vanishes
+    QPointF denom = m_pts[0] - m_pts[1] * 2.0 + m_pts[2];
+
+    if (denom.x() != 0.0) {
+        qreal t = (m_pts[0].x() - m_pts[1].x()) / denom.x();
+        if ((t > 0.0) && (t < 1.0)) {
+            qreal x = pointAt(t).x();
+            x0 = std::min(x0, x);
+            x1 = std::max(x1, x);
+        }
+    }
+
+    if (denom.y() != 0.0) {
+        qreal t = (m_pts[0].y() - m_pts[1].y()) / denom.y();
+        if ((t > 0.0) && (t < 1.0)) {
+            qreal y = pointAt(t).y();
+            y0 = std::min(y0, y);
+            y1 = std::max(y1, y);
+        }
+    }
+
+    return QRectF(QPointF(x0, y0), QPointF(x1, y1));
+}
+
+bool QuadBezier::intersects(const QRectF &rect) const {
+    if (rect.contains(m_pts[0]) || rect.contains(m_pts[2])) {
+        return true;
+    }
+
+    QRectF b = bounds();
+    if ((b.right() < rect.left()) || (rect.right() < b.left()) ||
+        (b.bottom() < rect.top()) || (rect.bottom() < b.top())) {
+        return false;
+    }
+
+    // Both ends are outside, so the curve has to cross an edge
+    const QPointF a = m_pts[0] - m_pts[1] * 2.0 + m_pts[2];
+    const QPointF bb = (m_pts[1] - m_pts[0]) * 2.0;
+    const QPointF c = m_pts[0];
+    qreal roots[2];
+
+    for (qreal x : {rect.left(), rect.right()}) {
+        int n = unitRoots(a.x(), bb.x(), c.x() - x, roots);
+        for (int i = 0; i < n; ++i) {
+            qreal y = pointAt(roots[i]).y();
+            if ((y >= rect.top()) && (y <= rect.bottom())) {
+                return true;
+            }
+        }
+    }
+
+    for (qreal y : {rect.top(), rect.bottom()}) {
+        int n = unitRoots(a.y(), bb.y(), c.y() - y, roots);
+        for (int i = 0; i < n; ++i) {
+            qreal x = pointAt(roots[i]).x();
+            if ((x >= rect.left()) && (x <= rect.right())) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+bool QuadBezier::intersectsSegment(const QPointF &a, const QPointF &b) const {
+    const QPointF d = b - a;
+    const qreal len2 = QPointF::dotProduct(d, d);
+    if (len2 <= 0.0) {
+        return false;
+    }
+
+    // Signed distances from the segment's line are a quadratic in t
+    qreal v0 = cross(d, m_pts[0] - a);
+    qreal v1 = cross(d, m_pts[1] - a);
+    qreal v2 = cross(d, m_pts[2] - a);
+
+    qreal roots[2];
+    int n = unitRoots(v0 - 2.0 * v1 + v2, 2.0 * (v1 - v0), v0, roots);
+
+    for (int i = 0; i < n; ++i) {
+        qreal u = QPointF::dotProduct(pointAt(roots[i]) - a, d) / len2;
+        if ((u >= 0.0) && (u <= 1.0)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 QPointF QuadBezier::closestPointTo(const QPointF &pos) const {
     const QPointF c = m_pts[0];
     const QPointF b = (m_pts[1] - m_pts[0]) * 2.0;
@@ -56,4 +191,48 @@ QPointF QuadBezier::closestPointTo(const QPointF &pos) const {
     return computePos(tMid);
 }
 
+bool segmentsIntersect(const QPointF &a, const QPointF &b, const QPointF &c,
+                       const QPointF &d) {
+    qreal d1 = cross(b - a, c - a);
+    qreal d2 = cross(b - a, d - a);
+    qreal d3 = cross(d - c, a - c);
+    qreal d4 = cross(d - c, b - c);
+
+    if ((((d1 > 0.0) && (d2 < 0.0)) || ((d1 < 0.0) && (d2 > 0.0))) &&
+        (((d3 > 0.0) && (d4 < 0.0)) || ((d3 < 0.0) && (d4 > 0.0)))) {
+        return true;
+    }
+
+    // Touching or collinear cases
+    auto onSegment = [](const QPointF &p, const QPointF &q, const QPointF &r) {
+        return (std::min(p.x(), q.x()) <= r.x()) &&
+               (r.x() <= std::max(p.x(), q.x())) &&
+               (std::min(p.y(), q.y()) <= r.y()) &&
+               (r.y() <= std::max(p.y(), q.y()));
+    };
+
+    return ((d1 == 0.0) && onSegment(a, b, c)) ||
+           ((d2 == 0.0) && onSegment(a, b, d)) ||
+           ((d3 == 0.0) && onSegment(c, d, a)) ||
+           ((d4 == 0.0) && onSegment(c, d, b));
+}
+
+bool segmentIntersectsRect(const QPointF &a, const QPointF &b,
+                           const QRectF &rect) {
+    if (rect.contains(a) || rect.contains(b)) {
+        return true;
+    }
+
+    const QPointF corners[] = {rect.topLeft(), rect.topRight(),
+                               rect.bottomRight(), rect.bottomLeft()};
+
+    for (int i = 0; i < 4; ++i) {
+        if (segmentsIntersect(a, b, corners[i], corners[(i + 1) % 4])) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 } // namespace qnodes
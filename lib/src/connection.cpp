@@ -2,9 +2,15 @@
 #include <QKeyEvent>
 #include <QPainter>
 #include <QPalette>
+#include <algorithm>
+#include <cmath>
 #include <qnodes/bezier.hpp>
 #include <qnodes/connection.hpp>
+#include <qnodes/memory_stats.hpp>
+#include <qnodes/probe.hpp>
+#include <qnodes/scene.hpp>
 #include <qnodes/slot.hpp>
+#include <qnodes/spatial_index.hpp>
 
 namespace qnodes {
 
@@ -13,7 +19,36 @@ static QRectF rectFromPoints(const QPointF &a, const QPointF &b) {
             QPointF(std::max(a.x(), b.x()), std::max(a.y(), b.y()))};
 }
 
+static QPainterPath roundedPolyline(const QPolygonF &pts, double radius) {
+    QPainterPath path(pts.first());
+
+    for (int i = 1; i + 1 < pts.size(); ++i) {
+        QPointF toPrev = pts[i - 1] - pts[i];
+        QPointF toNext = pts[i + 1] - pts[i];
+
+        double prevLen = std::hypot(toPrev.x(), toPrev.y());
+        double nextLen = std::hypot(toNext.x(), toNext.y());
+        double r = std::min(radius, std::min(prevLen, nextLen) / 2.0);
+
+        if (r <= 0.0) {
+            path.lineTo(pts[i]);
+            continue;
+        }
+
+        path.lineTo(pts[i] + toPrev * (r / prevLen));
+        path.quadTo(pts[i], pts[i] + toNext * (r / nextLen));
+    }
+
+    path.lineTo(pts.last());
+    return path;
+}
+
 const double Connection::width = 2.0;
+const double Connection::routeCornerRadius = 6.0;
+
+// Sparkline of a probe, above the middle of the connection
+static const QSizeF probeSize(120.0, 40.0);
+static const double probeGap = 6.0;
 
 struct Connection::Impl {
     Connection &self;
@@ -22,8 +57,105 @@ struct Connection::Impl {
     Slot *targetSlot = nullptr;
     QPointF targetPos;
     QuadBezier curve[2];
+    QPolygonF route;
+    QPointF lastStart;
+    QPointF lastEnd;
+    QColor overlayColor;
+    double widthScale = 1.0;
+    std::shared_ptr<Probe> probe;
+    std::vector<double> probeSamples; // reused by every repaint
+    MemoryAccount memory;
+
+    Impl(Connection &self, Slot *source) : self(self), sourceSlot(source) {
+        memory.set(MemoryUsage::ConnectionItems, 1,
+                   qint64(sizeof(Connection)) + MemoryStats::objectOverhead);
+        memory.set(MemoryUsage::ImplBlocks, 1, qint64(sizeof(Impl)));
+    }
+
+    void updateRouteMemory() {
+        memory.set(MemoryUsage::Paths, route.isEmpty() ? 0 : 1,
+                   route.isEmpty() ? 0 : MemoryStats::estimateSize(route));
+    }
+
+    Scene *graphScene() const { return qobject_cast<Scene *>(self.scene()); }
+
+    void notifyGeometryChanged() {
+        if (Scene *scene = graphScene()) {
+            scene->updateConnectionGeometry(&self);
+        }
+    }
+
+    void clearRoute() {
+        if (!route.isEmpty()) {
+            self.prepareGeometryChange();
+            route.clear();
+            updateRouteMemory();
+        }
+    }
+
+    QPointF endPoint() const {
+        return route.isEmpty() ? curve[1].endPoint() : route.last();
+    }
+
+    QRectF probeRect() const {
+        QPointF middle =
+            route.isEmpty() ? curve[0].endPoint() : route[route.size() / 2];
+        return QRectF(middle.x() - probeSize.width() / 2.0,
+                      middle.y() - probeGap - probeSize.height(),
+                      probeSize.width(), probeSize.height());
+    }
+
+    void paintProbe(QPainter *painter, const QPalette &plt) {
+        QRectF box = probeRect();
+        QColor background = plt.color(QPalette::Base);
+        background.setAlphaF(0.85);
+
+        painter->setPen(QPen(plt.color(QPalette::Mid), 1.0));
+        painter->setBrush(background);
+        painter->drawRoundedRect(box, 3.0, 3.0);
+
+        Probe::Summary summary = probe->summary();
+        probe->read(&probeSamples);
+        if ((summary.count == 0) || probeSamples.empty()) {
+            return;
+        }
+
+        QFont font = painter->font();
+        font.setPixelSize(9);
+        painter->setFont(font);
+        painter->setPen(plt.color(QPalette::Text));
+
+        QRectF text = box.adjusted(3.0, 1.0, -3.0, 0.0);
+        text.setHeight(11.0);
+        painter->drawText(text, Qt::AlignLeft | Qt::AlignVCenter,
+                          QString::number(summary.current, 'g', 4));
+        painter->drawText(text, Qt::AlignRight | Qt::AlignVCenter,
+                          QString("%1 .. %2")
+                              .arg(summary.min, 0, 'g', 3)
+                              .arg(summary.max, 0, 'g', 3));
+
+        // Scaled to the samples shown, not to the all-time range
+        auto range = std::minmax_element(probeSamples.begin(),
+                                         probeSamples.end());
+        double low = *range.first;
+        double span = std::max(*range.second - low, 1e-12);
+
+        QRectF plot = box.adjusted(3.0, 14.0, -3.0, -3.0);
+        double step = plot.width() / double(Probe::capacity - 1);
+
+        QPolygonF line;
+        line.reserve(int(probeSamples.size()));
+        double x = plot.right() - step * double(probeSamples.size() - 1);
+        for (double value : probeSamples) {
+            double y = plot.bottom() - (value - low) / span * plot.height();
+            line.append(QPointF(x, y));
+            x += step;
+        }
 
-    Impl(Connection &self, Slot *source) : self(self), sourceSlot(source) {}
+        painter->setPen(QPen(plt.color(QPalette::Highlight), 1.0));
+        painter->setBrush(Qt::NoBrush);
+        painter->drawPolyline(line);
+    }
 
     void sourcePosChanged() {
         self.setPos(sourceSlot->scenePos());
@@ -52,6 +184,60 @@ struct Connection::Impl {
 
         curve[0].set({}, {tPos.x() * 0.25, 0.0}, midPos);
         curve[1].set(midPos, {tPos.x() * 0.75, tPos.y()}, tPos);
+
+        updateEnds(self.pos(), self.pos() + tPos);
+    }
+
+    // The router and the overview follow connectionGeometryChanged, so a
+    // move of either end is reported, also when only the source node moves.
+    void updateEnds(const QPointF &start, const QPointF &end) {
+        if ((start != lastStart) || (end != lastEnd)) {
+            lastStart = start;
+            lastEnd = end;
+            notifyGeometryChanged();
+        }
+    }
+
+    static bool containsMode(Qt::ItemSelectionMode mode) {
+        return (mode == Qt::ContainsItemShape) ||
+               (mode == Qt::ContainsItemBoundingRect);
+    }
+
+    QRectF localBounds() const {
+        if (!route.isEmpty()) {
+            return route.boundingRect();
+        }
+
+        return curve[0].bounds() | curve[1].bounds();
+    }
+
+    bool crossesEdge(const QPointF &a, const QPointF &b) const {
+        if (!route.isEmpty()) {
+            for (int i = 0; i + 1 < route.size(); ++i) {
+                if (segmentsIntersect(route[i], route[i + 1], a, b)) {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        return curve[0].intersectsSegment(a, b) ||
+               curve[1].intersectsSegment(a, b);
+    }
+
+    bool touches(const QRectF &rect) const {
+        if (!route.isEmpty()) {
+            for (int i = 0; i + 1 < route.size(); ++i) {
+                if (segmentIntersectsRect(route[i], route[i + 1], rect)) {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        return curve[0].intersects(rect) || curve[1].intersects(rect);
     }
 };
 
@@ -59,6 +245,8 @@ Connection::Connection(Slot *source) : m_impl(new Impl(*this, source)) {
     setFlag(ItemIsSelectable);
     setFlag(ItemIsFocusable);
 
+    source->attachConnection(this);
+
     connect(source, &Slot::scenePosChanged, this,
             [this]() { m_impl->sourcePosChanged(); });
     connect(source, &Slot::destroyed, this,
@@ -67,20 +255,38 @@ Connection::Connection(Slot *source) : m_impl(new Impl(*this, source)) {
     m_impl->sourcePosChanged();
 }
 
-Connection::~Connection() { delete m_impl; }
+Connection::~Connection() {
+    if (Scene *scene = m_impl->graphScene()) {
+        scene->unregisterConnection(this);
+    }
+
+    if (m_impl->sourceSlot) {
+        m_impl->sourceSlot->detachConnection(this);
+    }
+
+    if (m_impl->targetSlot) {
+        m_impl->targetSlot->detachConnection(this);
+    }
+
+    delete m_impl;
+}
 
 Slot *Connection::sourceSlot() const { return m_impl->sourceSlot; }
 
 void Connection::setTargetSlot(Slot *target) {
     prepareGeometryChange();
+    m_impl->route.clear();
+    m_impl->updateRouteMemory();
 
     if (m_impl->targetSlot) {
         m_impl->targetSlot->disconnect(this);
+        m_impl->targetSlot->detachConnection(this);
     }
 
     m_impl->targetSlot = target;
 
     if (m_impl->targetSlot) {
+        m_impl->targetSlot->attachConnection(this);
         m_impl->targetPos = targetPos();
 
         connect(m_impl->targetSlot, &Slot::scenePosChanged, this,
@@ -90,6 +296,10 @@ void Connection::setTargetSlot(Slot *target) {
     }
 
     m_impl->updateCurve();
+
+    if (Scene *scene = m_impl->graphScene()) {
+        scene->updateConnection(this);
+    }
 }
 
 Slot *Connection::targetSlot() const { return m_impl->targetSlot; }
@@ -97,6 +307,8 @@ Slot *Connection::targetSlot() const { return m_impl->targetSlot; }
 void Connection::setTargetPos(const QPointF &pos) {
     if (!m_impl->targetSlot) {
         prepareGeometryChange();
+        m_impl->route.clear();
+        m_impl->updateRouteMemory();
         m_impl->targetPos = pos;
         m_impl->updateCurve();
     }
@@ -110,7 +322,77 @@ QPointF Connection::targetPos() const {
     }
 }
 
+void Connection::setRoute(const QPolygonF &route) {
+    prepareGeometryChange();
+
+    if (route.size() < 2) {
+        m_impl->route.clear();
+    } else {
+        m_impl->route = mapFromScene(route);
+    }
+
+    m_impl->updateRouteMemory();
+    update();
+    m_impl->notifyGeometryChanged();
+}
+
+QPolygonF Connection::route() const { return mapToScene(m_impl->route); }
+
+bool Connection::hasRoute() const { return !m_impl->route.isEmpty(); }
+
+void Connection::setOverlayColor(const QColor &color) {
+    if (m_impl->overlayColor != color) {
+        m_impl->overlayColor = color;
+        update();
+    }
+}
+
+QColor Connection::overlayColor() const { return m_impl->overlayColor; }
+
+void Connection::setWidthScale(double scale) {
+    scale = std::max(scale, 0.1);
+    if (m_impl->widthScale != scale) {
+        prepareGeometryChange();
+        m_impl->widthScale = scale;
+    }
+}
+
+double Connection::widthScale() const { return m_impl->widthScale; }
+
+void Connection::setProbe(std::shared_ptr<Probe> probe) {
+    if (m_impl->probe == probe) {
+        return;
+    }
+
+    prepareGeometryChange();
+    m_impl->probe = std::move(probe);
+    if (!m_impl->probe) {
+        m_impl->probeSamples = std::vector<double>();
+    }
+
+    update();
+    m_impl->notifyGeometryChanged();
+}
+
+std::shared_ptr<Probe> Connection::probe() const { return m_impl->probe; }
+
+MemoryUsage Connection::memoryUsage() const {
+    return m_impl->memory.usage();
+}
+
 bool Connection::contains(const QPointF &pos) const {
+    const QPolygonF &route = m_impl->route;
+    if (!route.isEmpty()) {
+        for (int i = 0; i + 1 < route.size(); ++i) {
+            if (squaredDistanceToSegment(pos, route[i], route[i + 1]) <=
+                (width * width)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
     for (const auto &c : m_impl->curve) {
         QPointF cp = c.closestPointTo(pos);
         if (squaredDistance(pos, cp) <= (width * width)) {
@@ -121,14 +403,73 @@ bool Connection::contains(const QPointF &pos) const {
     return false;
 }
 
+bool Connection::intersects(const QRectF &sceneRect,
+                            Qt::ItemSelectionMode mode) const {
+    QRectF rect = sceneRect.translated(-pos());
+
+    if (Impl::containsMode(mode)) {
+        // QRectF::contains() rejects the zero-height bounds of a straight
+        // connection
+        QRectF b = m_impl->localBounds();
+        return (b.left() >= rect.left()) && (b.right() <= rect.right()) &&
+               (b.top() >= rect.top()) && (b.bottom() <= rect.bottom());
+    }
+
+    return m_impl->touches(rect);
+}
+
+bool Connection::intersects(const QPolygonF &scenePolygon,
+                            Qt::ItemSelectionMode mode) const {
+    if (scenePolygon.size() < 3) {
+        return false;
+    }
+
+    QPolygonF polygon = scenePolygon.translated(-pos());
+    if (!rectsOverlap(polygon.boundingRect(), m_impl->localBounds())) {
+        return false;
+    }
+
+    // Either the connection crosses the outline, or it lies entirely on one
+    // side of it, in which case its start point tells which one
+    bool crossing = false;
+    for (int i = 0; (i < polygon.size()) && !crossing; ++i) {
+        crossing = m_impl->crossesEdge(polygon[i],
+                                       polygon[(i + 1) % polygon.size()]);
+    }
+
+    QPointF start = m_impl->route.isEmpty() ? QPointF() : m_impl->route.first();
+    bool startInside = polygon.containsPoint(start, Qt::OddEvenFill);
+
+    if (Impl::containsMode(mode)) {
+        return startInside && !crossing;
+    }
+
+    return startInside || crossing;
+}
+
 QRectF Connection::boundingRect() const {
-    double m = width;
+    double m = width * m_impl->widthScale;
 
-    QPointF ep = m_impl->curve[1].endPoint();
-    return rectFromPoints({}, ep).marginsAdded({m, m, m, m});
+    QRectF bounds;
+    if (!m_impl->route.isEmpty()) {
+        bounds = m_impl->route.boundingRect().marginsAdded({m, m, m, m});
+    } else {
+        QPointF ep = m_impl->curve[1].endPoint();
+        bounds = rectFromPoints({}, ep).marginsAdded({m, m, m, m});
+    }
+
+    if (m_impl->probe) {
+        bounds |= m_impl->probeRect().adjusted(-1.0, -1.0, 1.0, 1.0);
+    }
+
+    return bounds;
 }
 
 QPainterPath Connection::shape() const {
+    if (!m_impl->route.isEmpty()) {
+        return roundedPolyline(m_impl->route, routeCornerRadius);
+    }
+
     QPainterPath path;
 
     for (const auto &c : m_impl->curve) {
@@ -146,28 +487,48 @@ void Connection::paint(QPainter *painter,
 
     QPalette plt = scene()->palette();
     double handleR = Slot::slotRadius * 0.5;
+    double penWidth = width * m_impl->widthScale;
 
     QPainterPath path = shape();
 
-    if (isSelected()) {
-        painter->setPen(QPen(plt.color(QPalette::Highlight), width * 2.0));
+    if (isSelected() || m_impl->overlayColor.isValid()) {
+        QColor outline = isSelected() ? plt.color(QPalette::Highlight)
+                                      : m_impl->overlayColor;
+        painter->setPen(QPen(outline, penWidth * 2.0));
         painter->drawPath(path);
-        painter->drawEllipse(m_impl->curve[1].endPoint(), handleR, handleR);
+        painter->drawEllipse(m_impl->endPoint(), handleR, handleR);
     }
 
     QColor color = plt.color(isSelected() ? QPalette::HighlightedText
                                           : QPalette::WindowText);
 
-    painter->setPen(QPen(color, width));
+    painter->setPen(QPen(color, penWidth));
     painter->drawPath(path);
 
     painter->setBrush(color);
-    painter->drawEllipse(m_impl->curve[1].endPoint(), handleR, handleR);
+    painter->drawEllipse(m_impl->endPoint(), handleR, handleR);
+
+    if (m_impl->probe) {
+        m_impl->paintProbe(painter, plt);
+    }
 }
 
 QVariant Connection::itemChange(GraphicsItemChange change,
                                 const QVariant &value) {
+    if (change == ItemSceneChange) {
+        if (Scene *scene = m_impl->graphScene()) {
+            scene->unregisterConnection(this);
+        }
+    }
+
     m_impl->updateCurve();
+
+    if (change == ItemSceneHasChanged) {
+        if (Scene *scene = m_impl->graphScene()) {
+            scene->updateConnection(this);
+        }
+    }
+
     return QGraphicsObject::itemChange(change, value);
 }
 
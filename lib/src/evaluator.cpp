@@ -0,0 +1,529 @@
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QTimer>
+#include <algorithm>
+#include <qnodes/connection.hpp>
+#include <qnodes/evaluator.hpp>
+#include <qnodes/group_node.hpp>
+#include <qnodes/memory_stats.hpp>
+#include <qnodes/node.hpp>
+#include <qnodes/probe.hpp>
+#include <qnodes/profiler.hpp>
+#include <qnodes/result_cache.hpp>
+#include <qnodes/scene.hpp>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace qnodes {
+
+const int Evaluator::pollInterval = 16;
+
+struct Evaluator::Impl {
+    struct Input {
+        Node *source = nullptr;
+        int outputIndex = -1;
+    };
+
+    struct Job {
+        QFuture<QVariantList> future;
+        ResultCache::Key key;
+        bool cacheable;
+        QElapsedTimer timer;
+    };
+
+    Evaluator &self;
+    QPointer<Scene> scene;
+    ResultCache *cache = nullptr;
+    Profiler *profiler = nullptr;
+
+    std::unordered_map<const Node *, QVariantList> results;
+    std::unordered_map<const Node *, qint64> resultBytes;
+    qint64 totalResultBytes = 0;
+    MemoryAccount memory;
+    int computed = 0;
+    int cached = 0;
+
+    // State of the current run
+    std::vector<Node *> nodeList;
+    std::unordered_map<Node *, std::vector<Input>> inputs;
+    std::unordered_map<Node *, int> pending;
+    std::unordered_map<Node *, std::vector<Node *>> dependents;
+    std::vector<Node *> ready;
+    std::unordered_map<Node *, Job> jobs;
+    size_t numEvaluated = 0;
+
+    QTimer pollTimer;
+
+    explicit Impl(Evaluator &self) : self(self) {
+        pollTimer.setInterval(pollInterval);
+    }
+
+    // Members of collapsed groups, mapped to the group that holds them.
+    std::unordered_map<const Node *, GroupNode *> groupOf;
+
+    // Collapsed groups are evaluated as the subgraph they contain.
+    void addFlattened(Node *node) {
+        if (GroupNode *group = qobject_cast<GroupNode *>(node)) {
+            for (Node *member : group->members()) {
+                groupOf[member] = group;
+                addFlattened(member);
+            }
+        } else {
+            nodeList.push_back(node);
+        }
+    }
+
+    // Maps proxy outputs of collapsed groups to the member slot behind them.
+    static Slot *resolveOutput(Slot *source) {
+        while (source) {
+            GroupNode *group = qobject_cast<GroupNode *>(source->node());
+            if (!group) {
+                break;
+            }
+
+            source = group->innerSlot(source);
+        }
+
+        return source;
+    }
+
+    // Only the first connection of an input slot is used. Inputs of group
+    // members whose connection crosses the group boundary are attached to
+    // the group's proxy slot instead.
+    Slot *findSource(Node *node, Slot *input) const {
+        while (input) {
+            for (Connection *conn : input->connections()) {
+                Slot *source = resolveOutput(conn->sourceSlot());
+                if ((conn->targetSlot() == input) && source &&
+                    (source->slotType() == Slot::Output)) {
+                    return source;
+                }
+            }
+
+            auto it = groupOf.find(node);
+            if (it == groupOf.end()) {
+                break;
+            }
+
+            input = it->second->outerSlot(input);
+            node = it->second;
+        }
+
+        return nullptr;
+    }
+
+    std::vector<Input>
+    gatherInputs(Node *node, const std::unordered_set<Node *> &nodes) const {
+        std::vector<Input> inputs(
+            static_cast<size_t>(node->slotCount(Slot::Input)));
+
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            Slot *slot = node->slot(Slot::Input, static_cast<int>(i));
+            Slot *source = findSource(node, slot);
+
+            Node *sourceNode = source ? source->node() : nullptr;
+            if (sourceNode && nodes.count(sourceNode)) {
+                inputs[i] = Input{sourceNode, sourceNode->slotIndex(source)};
+            }
+        }
+
+        return inputs;
+    }
+
+    QVariant resultOf(const Input &input) const {
+        if (!input.source) {
+            return {};
+        }
+
+        auto it = results.find(input.source);
+        if ((it == results.end()) || (input.outputIndex < 0) ||
+            (input.outputIndex >= it->second.size())) {
+            return {};
+        }
+
+        return it->second.at(input.outputIndex);
+    }
+
+    QVariantList inputValues(Node *node) const {
+        QVariantList values;
+        for (const auto &input : inputs.at(node)) {
+            values.append(resultOf(input));
+        }
+
+        return values;
+    }
+
+    void reset() {
+        nodeList.clear();
+        groupOf.clear();
+        inputs.clear();
+        pending.clear();
+        dependents.clear();
+        ready.clear();
+        jobs.clear();
+        numEvaluated = 0;
+    }
+
+    void setResult(Node *node, const QVariantList &outputs) {
+        qint64 bytes = 64; // list and map entry
+        for (const QVariant &value : outputs) {
+            bytes += ResultCache::estimateSize(value);
+        }
+
+        qint64 &entry = resultBytes[node];
+        totalResultBytes += bytes - entry;
+        entry = bytes;
+
+        results[node] = outputs;
+        updateMemory();
+    }
+
+    void eraseResult(const Node *node) {
+        auto it = resultBytes.find(node);
+        if (it != resultBytes.end()) {
+            totalResultBytes -= it->second;
+            resultBytes.erase(it);
+        }
+
+        results.erase(node);
+        updateMemory();
+    }
+
+    void clearResults() {
+        results.clear();
+        resultBytes.clear();
+        totalResultBytes = 0;
+        updateMemory();
+    }
+
+    void updateMemory() {
+        memory.set(MemoryUsage::EvaluationBuffers, qint64(results.size()),
+                   totalResultBytes);
+    }
+
+    void prepare() {
+        reset();
+        clearResults();
+        computed = 0;
+        cached = 0;
+
+        if (!scene) {
+            return;
+        }
+
+        for (Node *node : scene->nodes()) {
+            addFlattened(node);
+        }
+
+        std::unordered_set<Node *> nodes(nodeList.begin(), nodeList.end());
+
+        for (Node *node : nodeList) {
+            auto &nodeInputs = inputs[node];
+            nodeInputs = gatherInputs(node, nodes);
+
+            int &count = pending[node];
+            for (const auto &input : nodeInputs) {
+                if (input.source) {
+                    dependents[input.source].push_back(node);
+                    ++count;
+                }
+            }
+        }
+
+        // Kahn's algorithm; nodes left with pending inputs are on a cycle.
+        for (Node *node : nodeList) {
+            if (pending[node] == 0) {
+                ready.push_back(node);
+            }
+        }
+    }
+
+    void complete(Node *node, const QVariantList &outputs) {
+        setResult(node, outputs);
+        Probe::sampleOutputs(node, outputs);
+        node->setEvaluationState(Node::Done);
+        ++numEvaluated;
+
+        for (Node *dependent : dependents[node]) {
+            if (--pending[dependent] == 0) {
+                ready.push_back(dependent);
+            }
+        }
+    }
+
+    void profile(Node *node, qint64 nanoseconds,
+                 const QVariantList &outputs) const {
+        qint64 total = 0;
+        for (int i = 0; i < outputs.size(); ++i) {
+            qint64 bytes = ResultCache::estimateSize(outputs.at(i));
+            profiler->recordOutput(node, i, bytes);
+            total += bytes;
+        }
+
+        profiler->record(node, nanoseconds, total);
+    }
+
+    // Sets *cacheable when the result may be stored under *key.
+    bool lookupCached(Node *node, const QVariantList &values,
+                      ResultCache::Key *key, bool *cacheable,
+                      QVariantList *outputs) {
+        *cacheable = cache && node->isPure() &&
+                     ResultCache::makeKey(*node, values, key);
+        if (!*cacheable || !cache->lookup(*key, outputs)) {
+            return false;
+        }
+
+        ++cached;
+        return true;
+    }
+
+    void runSync() {
+        while (!ready.empty()) {
+            Node *node = ready.back();
+            ready.pop_back();
+
+            QVariantList values = inputValues(node);
+            QVariantList outputs;
+            ResultCache::Key key;
+            bool cacheable = false;
+
+            if (!lookupCached(node, values, &key, &cacheable, &outputs)) {
+                ++computed;
+
+                QElapsedTimer timer;
+                timer.start();
+                outputs = node->compute(values);
+
+                if (profiler) {
+                    profile(node, timer.nsecsElapsed(), outputs);
+                }
+
+                if (cacheable) {
+                    cache->insert(key, outputs);
+                }
+            }
+
+            complete(node, outputs);
+        }
+    }
+
+    void finishJob(Node *node, const Job &job) {
+        if (job.future.isCanceled() || (job.future.resultCount() == 0)) {
+            node->setEvaluationState(Node::Failed);
+            return;
+        }
+
+        QVariantList outputs = job.future.result();
+        if (profiler) {
+            profile(node, job.timer.nsecsElapsed(), outputs);
+        }
+
+        if (job.cacheable && cache) {
+            cache->insert(job.key, outputs);
+        }
+
+        complete(node, outputs);
+    }
+
+    void startReady() {
+        while (!ready.empty()) {
+            Node *node = ready.back();
+            ready.pop_back();
+
+            QVariantList values = inputValues(node);
+            QVariantList outputs;
+            Job job{{}, {}, false, {}};
+
+            if (lookupCached(node, values, &job.key, &job.cacheable,
+                             &outputs)) {
+                complete(node, outputs);
+                continue;
+            }
+
+            ++computed;
+            job.timer.start();
+            job.future = node->computeAsync(values);
+
+            if (job.future.isFinished()) {
+                finishJob(node, job);
+            } else {
+                node->setEvaluationState(Node::Running);
+                jobs.emplace(node, job);
+            }
+        }
+    }
+
+    void poll() {
+        std::vector<std::pair<Node *, Job>> finished;
+
+        for (auto it = jobs.begin(); it != jobs.end();) {
+            const QFuture<QVariantList> &future = it->second.future;
+
+            if (future.isFinished()) {
+                finished.emplace_back(it->first, it->second);
+                it = jobs.erase(it);
+                continue;
+            }
+
+            int range = future.progressMaximum() - future.progressMinimum();
+            if (range > 0) {
+                it->first->setProgress(
+                    double(future.progressValue() - future.progressMinimum()) /
+                    range);
+            }
+
+            ++it;
+        }
+
+        for (const auto &entry : finished) {
+            finishJob(entry.first, entry.second);
+        }
+
+        startReady();
+        finishIfIdle();
+    }
+
+    void finishIfIdle() {
+        if (!jobs.empty() || !ready.empty()) {
+            return;
+        }
+
+        pollTimer.stop();
+
+        // Nodes downstream of a failure or on a cycle never ran.
+        for (Node *node : nodeList) {
+            if (node->evaluationState() == Node::Pending) {
+                node->setEvaluationState(Node::Idle);
+            }
+        }
+
+        reset();
+        emit self.evaluated();
+    }
+
+    void cancel() {
+        pollTimer.stop();
+
+        for (auto &entry : jobs) {
+            entry.second.future.cancel();
+        }
+
+        for (Node *node : nodeList) {
+            if (node->evaluationState() != Node::Done) {
+                node->setEvaluationState(Node::Idle);
+            }
+        }
+
+        reset();
+    }
+
+    void forgetNode(Node *node) {
+        if (GroupNode *group = qobject_cast<GroupNode *>(node)) {
+            for (Node *member : group->members()) {
+                forgetNode(member);
+            }
+        }
+
+        eraseResult(node);
+
+        if (pollTimer.isActive()) {
+            // The graph changed under the running evaluation
+            nodeList.erase(std::remove(nodeList.begin(), nodeList.end(), node),
+                           nodeList.end());
+            cancel();
+        }
+    }
+};
+
+Evaluator::Evaluator(Scene *scene, QObject *parent)
+    : QObject(parent), m_impl(new Impl(*this)) {
+    m_impl->scene = scene;
+
+    connect(&m_impl->pollTimer, &QTimer::timeout, this,
+            [this]() { m_impl->poll(); });
+
+    if (scene) {
+        connect(scene, &Scene::nodeRemoved, this,
+                [this](Node *node) { m_impl->forgetNode(node); });
+    }
+}
+
+Evaluator::~Evaluator() {
+    m_impl->cancel();
+    delete m_impl;
+}
+
+Scene *Evaluator::scene() const { return m_impl->scene; }
+
+void Evaluator::setCache(ResultCache *cache) { m_impl->cache = cache; }
+
+ResultCache *Evaluator::cache() const { return m_impl->cache; }
+
+void Evaluator::setProfiler(Profiler *profiler) {
+    m_impl->profiler = profiler;
+}
+
+Profiler *Evaluator::profiler() const { return m_impl->profiler; }
+
+bool Evaluator::evaluate() {
+    m_impl->cancel();
+    m_impl->prepare();
+    m_impl->runSync();
+
+    bool complete = (m_impl->numEvaluated == m_impl->nodeList.size());
+    m_impl->reset();
+
+    emit evaluated();
+    return complete;
+}
+
+void Evaluator::evaluateAsync() {
+    m_impl->cancel();
+    m_impl->prepare();
+
+    for (Node *node : m_impl->nodeList) {
+        node->setEvaluationState(Node::Pending);
+    }
+
+    m_impl->startReady();
+
+    if (!m_impl->jobs.empty()) {
+        m_impl->pollTimer.start();
+    } else {
+        m_impl->finishIfIdle();
+    }
+}
+
+void Evaluator::cancel() { m_impl->cancel(); }
+
+bool Evaluator::isRunning() const { return m_impl->pollTimer.isActive(); }
+
+QVariantList Evaluator::outputs(const Node *node) const {
+    auto it = m_impl->results.find(node);
+    return (it != m_impl->results.end()) ? it->second : QVariantList();
+}
+
+qint64 Evaluator::outputMemory(const Node *node) const {
+    auto it = m_impl->resultBytes.find(node);
+    return (it != m_impl->resultBytes.end()) ? it->second : 0;
+}
+
+QVariant Evaluator::value(const Slot *outputSlot) const {
+    outputSlot = Impl::resolveOutput(const_cast<Slot *>(outputSlot));
+    if (!outputSlot) {
+        return {};
+    }
+
+    Node *node = outputSlot->node();
+    if (!node) {
+        return {};
+    }
+
+    return m_impl->resultOf(Impl::Input{node, node->slotIndex(outputSlot)});
+}
+
+int Evaluator::computedCount() const { return m_impl->computed; }
+
+int Evaluator::cachedCount() const { return m_impl->cached; }
+
+} // namespace qnodes
@@ -0,0 +1,567 @@
+#include <QColor>
+#include <algorithm>
+#include <qnodes/connection.hpp>
+#include <qnodes/graph_diff.hpp>
+#include <qnodes/node.hpp>
+#include <qnodes/scene.hpp>
+#include <qnodes/slot.hpp>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace qnodes {
+
+using NodeRecord = GraphSnapshot::NodeRecord;
+using ConnectionRecord = GraphSnapshot::ConnectionRecord;
+
+namespace {
+
+struct EdgeKey {
+    quint64 source;
+    quint64 target;
+    int sourceSlot;
+    int targetSlot;
+
+    bool operator==(const EdgeKey &other) const {
+        return (source == other.source) && (target == other.target) &&
+               (sourceSlot == other.sourceSlot) &&
+               (targetSlot == other.targetSlot);
+    }
+};
+
+struct EdgeKeyHash {
+    size_t operator()(const EdgeKey &key) const {
+        quint64 h = key.source * 0x9e3779b97f4a7c15ull;
+        h ^= key.target + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+        h ^= quint64(quint32(key.sourceSlot)) << 32;
+        h ^= quint64(quint32(key.targetSlot));
+        return static_cast<size_t>(h);
+    }
+};
+
+using EdgeSet = std::unordered_set<EdgeKey, EdgeKeyHash>;
+
+} // namespace
+
+// Candidates are looked at up to this many per node, so that thousands of
+// identical nodes do not make matching quadratic.
+static const size_t maxCandidates = 64;
+
+static quint64 contentKey(const NodeRecord &record, bool withState) {
+    uint h = qHash(record.typeName);
+    h = qHash(record.label, h);
+    if (withState) {
+        h = qHash(record.state, h);
+    }
+
+    return (quint64(h) << 1) | (withState ? 1 : 0);
+}
+
+// What contentKey hashes, compared in full so that a collision never
+// matches unrelated nodes
+static bool sameContent(const NodeRecord &a, const NodeRecord &b,
+                        bool withState) {
+    return (a.typeName == b.typeName) && (a.label == b.label) &&
+           (!withState || (a.state == b.state));
+}
+
+static bool samePos(const QPointF &a, const QPointF &b) {
+    QPointF d = a - b;
+    return QPointF::dotProduct(d, d) < 1e-4;
+}
+
+static int changeFlags(const NodeRecord &a, const NodeRecord &b) {
+    int flags = 0;
+    if (a.typeName != b.typeName) {
+        flags |= NodeChange::TypeChanged;
+    }
+    if (a.slotSignature != b.slotSignature) {
+        flags |= NodeChange::SlotsChanged;
+    }
+    if (a.label != b.label) {
+        flags |= NodeChange::Relabeled;
+    }
+    if (a.state != b.state) {
+        flags |= NodeChange::StateChanged;
+    }
+    if (!samePos(a.pos, b.pos)) {
+        flags |= NodeChange::Moved;
+    }
+
+    return flags;
+}
+
+// Node IDs of both graphs in terms of the old one, so that connections can
+// be compared as sets
+static std::vector<quint64> canonicalIds(const GraphSnapshot &before,
+                                         const GraphSnapshot &after,
+                                         const std::vector<int> &match) {
+    std::vector<quint64> ids(after.nodes().size());
+    for (size_t i = 0; i < ids.size(); ++i) {
+        ids[i] = after.nodes()[i].id;
+    }
+
+    for (size_t i = 0; i < match.size(); ++i) {
+        if (match[i] >= 0) {
+            ids[size_t(match[i])] = before.nodes()[i].id;
+        }
+    }
+
+    return ids;
+}
+
+static std::vector<quint64> ownIds(const GraphSnapshot &graph) {
+    std::vector<quint64> ids;
+    ids.reserve(graph.nodes().size());
+    for (const NodeRecord &record : graph.nodes()) {
+        ids.push_back(record.id);
+    }
+
+    return ids;
+}
+
+// Snapshots read from files are not checked for dangling node indices
+static bool isValid(const GraphSnapshot &graph, const ConnectionRecord &c) {
+    size_t count = graph.nodes().size();
+    return (c.sourceNode >= 0) && (size_t(c.sourceNode) < count) &&
+           (c.targetNode >= 0) && (size_t(c.targetNode) < count);
+}
+
+static EdgeSet edgeSet(const GraphSnapshot &graph,
+                       const std::vector<quint64> &ids) {
+    EdgeSet edges;
+    edges.reserve(graph.connections().size());
+
+    for (const ConnectionRecord &c : graph.connections()) {
+        if (!isValid(graph, c)) {
+            continue;
+        }
+
+        edges.insert(EdgeKey{ids[size_t(c.sourceNode)],
+                             ids[size_t(c.targetNode)], c.sourceSlot,
+                             c.targetSlot});
+    }
+
+    return edges;
+}
+
+static QString idString(quint64 id) {
+    return QString("%1").arg(id, 16, 16, QChar('0'));
+}
+
+bool GraphDiff::isEmpty() const { return nodes.empty() && connections.empty(); }
+
+std::vector<int> matchNodes(const GraphSnapshot &before,
+                            const GraphSnapshot &after) {
+    const auto &oldNodes = before.nodes();
+    const auto &newNodes = after.nodes();
+
+    std::vector<int> match(oldNodes.size(), -1);
+    std::vector<bool> used(newNodes.size(), false);
+
+    std::unordered_map<quint64, int> byId;
+    byId.reserve(newNodes.size());
+    for (size_t i = 0; i < newNodes.size(); ++i) {
+        byId.emplace(newNodes[i].id, int(i));
+    }
+
+    for (size_t i = 0; i < oldNodes.size(); ++i) {
+        auto it = byId.find(oldNodes[i].id);
+        if ((it != byId.end()) && !used[size_t(it->second)]) {
+            match[i] = it->second;
+            used[size_t(it->second)] = true;
+        }
+    }
+
+    // Fallback for nodes whose IDs did not survive, e.g. after being
+    // recreated: first by content, then by type and label alone
+    for (bool withState : {true, false}) {
+        std::unordered_map<quint64, std::vector<int>> buckets;
+        for (size_t i = 0; i < newNodes.size(); ++i) {
+            if (!used[i]) {
+                buckets[contentKey(newNodes[i], withState)].push_back(int(i));
+            }
+        }
+
+        if (buckets.empty()) {
+            break;
+        }
+
+        for (size_t i = 0; i < oldNodes.size(); ++i) {
+            if (match[i] >= 0) {
+                continue;
+            }
+
+            auto bucket = buckets.find(contentKey(oldNodes[i], withState));
+            if (bucket == buckets.end()) {
+                continue;
+            }
+
+            std::vector<int> &candidates = bucket->second;
+            size_t best = candidates.size();
+            double bestDist = 0.0;
+
+            for (size_t k = 0; k < std::min(candidates.size(), maxCandidates);
+                 ++k) {
+                const NodeRecord &other = newNodes[size_t(candidates[k])];
+                if (!sameContent(other, oldNodes[i], withState)) {
+                    continue; // hash collision
+                }
+
+                QPointF d = other.pos - oldNodes[i].pos;
+                double dist = QPointF::dotProduct(d, d);
+                if ((best == candidates.size()) || (dist < bestDist)) {
+                    best = k;
+                    bestDist = dist;
+                }
+            }
+
+            if (best < candidates.size()) {
+                match[i] = candidates[best];
+                used[size_t(candidates[best])] = true;
+                candidates[best] = candidates.back();
+                candidates.pop_back();
+            }
+        }
+    }
+
+    return match;
+}
+
+GraphDiff diffGraphs(const GraphSnapshot &before, const GraphSnapshot &after) {
+    GraphDiff diff;
+
+    const std::vector<int> match = matchNodes(before, after);
+    std::vector<bool> matched(after.nodes().size(), false);
+
+    for (size_t i = 0; i < match.size(); ++i) {
+        if (match[i] < 0) {
+            diff.nodes.push_back(NodeChange{NodeChange::Removed, int(i), -1});
+            continue;
+        }
+
+        matched[size_t(match[i])] = true;
+        int flags = changeFlags(before.nodes()[i],
+                                after.nodes()[size_t(match[i])]);
+        if (flags != 0) {
+            diff.nodes.push_back(NodeChange{flags, int(i), match[i]});
+        }
+    }
+
+    for (size_t i = 0; i < matched.size(); ++i) {
+        if (!matched[i]) {
+            diff.nodes.push_back(NodeChange{NodeChange::Added, -1, int(i)});
+        }
+    }
+
+    const std::vector<quint64> oldIds = ownIds(before);
+    const std::vector<quint64> newIds = canonicalIds(before, after, match);
+    const EdgeSet oldEdges = edgeSet(before, oldIds);
+    const EdgeSet newEdges = edgeSet(after, newIds);
+
+    for (const ConnectionRecord &c : before.connections()) {
+        if (!isValid(before, c)) {
+            continue;
+        }
+
+        EdgeKey key{oldIds[size_t(c.sourceNode)], oldIds[size_t(c.targetNode)],
+                    c.sourceSlot, c.targetSlot};
+        if (!newEdges.count(key)) {
+            diff.connections.push_back(ConnectionChange{
+                false, key.source, c.sourceSlot, key.target, c.targetSlot});
+        }
+    }
+
+    for (const ConnectionRecord &c : after.connections()) {
+        if (!isValid(after, c)) {
+            continue;
+        }
+
+        EdgeKey key{newIds[size_t(c.sourceNode)], newIds[size_t(c.targetNode)],
+                    c.sourceSlot, c.targetSlot};
+        if (!oldEdges.count(key)) {
+            diff.connections.push_back(ConnectionChange{
+                true, after.nodes()[size_t(c.sourceNode)].id, c.sourceSlot,
+                after.nodes()[size_t(c.targetNode)].id, c.targetSlot});
+        }
+    }
+
+    return diff;
+}
+
+template <typename T>
+static T mergeField(const T &base, const T &ours, const T &theirs,
+                    bool *conflict) {
+    if (ours == base) {
+        return theirs;
+    }
+
+    if ((theirs == base) || (theirs == ours)) {
+        return ours;
+    }
+
+    *conflict = true;
+    return ours;
+}
+
+MergeResult mergeGraphs(const GraphSnapshot &base, const GraphSnapshot &ours,
+                        const GraphSnapshot &theirs) {
+    MergeResult result;
+    std::vector<NodeRecord> nodes;
+
+    const std::vector<int> toOurs = matchNodes(base, ours);
+    const std::vector<int> toTheirs = matchNodes(base, theirs);
+
+    // Merged nodes by canonical ID: base IDs, or the side's own for nodes
+    // added on one side
+    std::unordered_map<quint64, int> mergedIndex;
+
+    auto add = [&](NodeRecord record, quint64 canonicalId) {
+        mergedIndex.emplace(canonicalId, int(nodes.size()));
+        record.id = canonicalId;
+        nodes.push_back(std::move(record));
+    };
+
+    auto conflict = [&](MergeConflict::Kind kind, quint64 id,
+                        const QString &what) {
+        result.conflicts.push_back(
+            MergeConflict{kind, id, QString("Node %1: %2").arg(idString(id),
+                                                                what)});
+    };
+
+    for (size_t i = 0; i < base.nodes().size(); ++i) {
+        const NodeRecord &b = base.nodes()[i];
+        const NodeRecord *o =
+            (toOurs[i] >= 0) ? &ours.nodes()[size_t(toOurs[i])] : nullptr;
+        const NodeRecord *t =
+            (toTheirs[i] >= 0) ? &theirs.nodes()[size_t(toTheirs[i])]
+                               : nullptr;
+
+        bool oursChanged = o && (changeFlags(b, *o) != 0);
+        bool theirsChanged = t && (changeFlags(b, *t) != 0);
+
+        if (!o || !t) {
+            const NodeRecord *kept = o ? o : t;
+            if (kept && (o ? oursChanged : theirsChanged)) {
+                conflict(MergeConflict::ChangedAndRemoved, b.id,
+                         "changed on one side and removed on the other");
+                add(*kept, b.id);
+            }
+
+            continue;
+        }
+
+        bool clash = false;
+        NodeRecord merged = b;
+
+        // Type and slots go together, they describe the same definition
+        auto definition = mergeField(
+            std::make_pair(b.typeName, b.slotSignature),
+            std::make_pair(o->typeName, o->slotSignature),
+            std::make_pair(t->typeName, t->slotSignature), &clash);
+        merged.typeName = definition.first;
+        merged.slotSignature = definition.second;
+
+        bool clashLabel = false;
+        merged.label = mergeField(b.label, o->label, t->label, &clashLabel);
+
+        bool clashState = false;
+        merged.state = mergeField(b.state, o->state, t->state, &clashState);
+
+        // Positions are compared with a tolerance
+        bool clashPos = false;
+        if (samePos(o->pos, b.pos)) {
+            merged.pos = t->pos;
+        } else {
+            merged.pos = o->pos;
+            clashPos = !samePos(t->pos, b.pos) && !samePos(t->pos, o->pos);
+        }
+
+        if (clash) {
+            conflict(MergeConflict::BothChanged, b.id,
+                     "type changed on both sides");
+        }
+        if (clashLabel) {
+            conflict(MergeConflict::BothChanged, b.id,
+                     "label changed on both sides");
+        }
+        if (clashState) {
+            conflict(MergeConflict::BothChanged, b.id,
+                     "parameters changed on both sides");
+        }
+        if (clashPos) {
+            conflict(MergeConflict::BothMoved, b.id,
+                     "moved to different positions on both sides");
+        }
+
+        add(merged, b.id);
+    }
+
+    // Nodes added on either side
+    std::vector<quint64> oursIds = ownIds(ours);
+    std::vector<quint64> theirsIds = ownIds(theirs);
+
+    for (int side = 0; side < 2; ++side) {
+        const GraphSnapshot &graph = (side == 0) ? ours : theirs;
+        const std::vector<int> &toSide = (side == 0) ? toOurs : toTheirs;
+        std::vector<quint64> &ids = (side == 0) ? oursIds : theirsIds;
+
+        std::vector<bool> matched(graph.nodes().size(), false);
+        for (size_t i = 0; i < toSide.size(); ++i) {
+            if (toSide[i] >= 0) {
+                matched[size_t(toSide[i])] = true;
+                ids[size_t(toSide[i])] = base.nodes()[i].id;
+            }
+        }
+
+        for (size_t i = 0; i < matched.size(); ++i) {
+            if (matched[i]) {
+                continue;
+            }
+
+            const NodeRecord &record = graph.nodes()[i];
+            if (mergedIndex.count(record.id)) {
+                // The same ID added on both sides
+                const NodeRecord &existing =
+                    nodes[size_t(mergedIndex[record.id])];
+                if (changeFlags(existing, record) != 0) {
+                    conflict(MergeConflict::BothChanged, record.id,
+                             "added differently on both sides");
+                }
+
+                continue;
+            }
+
+            add(record, record.id);
+        }
+    }
+
+    // Connections: kept on both sides, or added on either
+    const EdgeSet baseEdges = edgeSet(base, ownIds(base));
+    const EdgeSet oursEdges = edgeSet(ours, oursIds);
+    const EdgeSet theirsEdges = edgeSet(theirs, theirsIds);
+
+    std::vector<std::pair<EdgeKey, int>> edges; // key, side that added it
+    for (const EdgeKey &e : oursEdges) {
+        if (theirsEdges.count(e)) {
+            edges.emplace_back(e, baseEdges.count(e) ? -1 : 0);
+        } else if (!baseEdges.count(e)) {
+            edges.emplace_back(e, 0);
+        }
+    }
+
+    for (const EdgeKey &e : theirsEdges) {
+        if (!oursEdges.count(e) && !baseEdges.count(e)) {
+            edges.emplace_back(e, 1);
+        }
+    }
+
+    // An input rewired differently on both sides keeps our wiring
+    std::unordered_map<EdgeKey, bool, EdgeKeyHash> oursRewired;
+    for (const auto &entry : edges) {
+        if (entry.second == 0) {
+            oursRewired[EdgeKey{0, entry.first.target, 0,
+                                entry.first.targetSlot}] = true;
+        }
+    }
+
+    std::vector<ConnectionRecord> connections;
+    for (const auto &entry : edges) {
+        const EdgeKey &e = entry.first;
+        auto source = mergedIndex.find(e.source);
+        auto target = mergedIndex.find(e.target);
+
+        if ((source == mergedIndex.end()) || (target == mergedIndex.end())) {
+            if (entry.second >= 0) {
+                quint64 missing =
+                    (source == mergedIndex.end()) ? e.source : e.target;
+                conflict(MergeConflict::ConnectionToRemovedNode, missing,
+                         "connected on one side and removed on the other");
+            }
+
+            continue;
+        }
+
+        if ((entry.second == 1) &&
+            oursRewired.count(EdgeKey{0, e.target, 0, e.targetSlot})) {
+            conflict(MergeConflict::InputRewired, e.target,
+                     QString("input %1 rewired on both sides")
+                         .arg(e.targetSlot));
+            continue;
+        }
+
+        connections.push_back(ConnectionRecord{source->second, e.sourceSlot,
+                                               target->second, e.targetSlot});
+    }
+
+    result.graph =
+        GraphSnapshot::fromRecords(std::move(nodes), std::move(connections));
+    return result;
+}
+
+void showDiffOverlay(Scene *scene, const GraphSnapshot &after,
+                     const GraphDiff &diff) {
+    static const QColor addedColor(46, 204, 113);
+    static const QColor changedColor(241, 196, 15);
+    static const QColor movedColor(52, 152, 219);
+
+    clearDiffOverlay(scene);
+
+    std::unordered_map<quint64, Node *> byId;
+    for (Node *node : scene->nodes()) {
+        byId.emplace(node->id(), node);
+    }
+
+    for (const NodeChange &change : diff.nodes) {
+        if (change.after < 0) {
+            continue;
+        }
+
+        auto it = byId.find(after.nodes()[size_t(change.after)].id);
+        if (it == byId.end()) {
+            continue;
+        }
+
+        if (change.flags & NodeChange::Added) {
+            it->second->setOverlayColor(addedColor);
+        } else if (change.flags & ~NodeChange::Moved) {
+            it->second->setOverlayColor(changedColor);
+        } else {
+            it->second->setOverlayColor(movedColor);
+        }
+    }
+
+    EdgeSet added;
+    for (const ConnectionChange &change : diff.connections) {
+        if (change.added) {
+            added.insert(EdgeKey{change.sourceId, change.targetId,
+                                 change.sourceSlot, change.targetSlot});
+        }
+    }
+
+    for (Connection *conn : scene->connections()) {
+        Slot *source = conn->sourceSlot();
+        Slot *target = conn->targetSlot();
+        if (!source || !target || !source->node() || !target->node()) {
+            continue;
+        }
+
+        EdgeKey key{source->node()->id(), target->node()->id(),
+                    source->node()->slotIndex(source),
+                    target->node()->slotIndex(target)};
+        if (added.count(key)) {
+            conn->setOverlayColor(addedColor);
+        }
+    }
+}
+
+void clearDiffOverlay(Scene *scene) {
+    for (Node *node : scene->nodes()) {
+        node->setOverlayColor({});
+    }
+
+    for (Connection *conn : scene->connections()) {
+        conn->setOverlayColor({});
+    }
+}
+
+} // namespace qnodes
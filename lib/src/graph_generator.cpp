@@ -0,0 +1,126 @@
+#include <QGraphicsScene>
+#include <QRandomGenerator>
+#include <algorithm>
+#include <qnodes/connection.hpp>
+#include <qnodes/graph_generator.hpp>
+#include <qnodes/node.hpp>
+
+namespace qnodes {
+
+GeneratedGraph generateGraph(const GeneratorOptions &options) {
+    QRandomGenerator random(options.seed);
+    GeneratedGraph graph;
+
+    int nodeCount = std::max(0, options.nodeCount);
+    int depth = std::max(1, std::min(options.depth, std::max(1, nodeCount)));
+
+    auto between = [&random](int low, int high) {
+        low = std::max(0, low);
+        high = std::max(low, high);
+        return int(random.bounded(low, high + 1));
+    };
+
+    // Nodes are spread evenly over the layers, in layer order, so that
+    // every layer is a contiguous range of indices.
+    std::vector<int> layerBegin(size_t(depth) + 1, nodeCount);
+    graph.nodes.reserve(size_t(nodeCount));
+
+    for (int i = 0; i < nodeCount; ++i) {
+        int layer = int(qint64(i) * depth / nodeCount);
+        if (layerBegin[size_t(layer)] == nodeCount) {
+            layerBegin[size_t(layer)] = i;
+        }
+
+        int row = i - layerBegin[size_t(layer)];
+        GeneratedGraph::NodeSpec spec;
+        spec.layer = layer;
+        spec.inputs = (layer == 0)
+                          ? 0
+                          : between(options.minInputs, options.maxInputs);
+        spec.outputs = between(options.minOutputs, options.maxOutputs);
+        spec.pos = QPointF(layer * options.columnSpacing,
+                           row * options.rowSpacing);
+
+        graph.nodes.push_back(spec);
+    }
+
+    std::vector<std::vector<int>> fanOut(graph.nodes.size());
+    for (size_t i = 0; i < graph.nodes.size(); ++i) {
+        fanOut[i].assign(size_t(graph.nodes[i].outputs), 0);
+    }
+
+    // A few tries per input to find an output that is not full yet
+    const int attempts = 4;
+    int span = std::max(1, options.maxLayerSpan);
+
+    for (int target = 0; target < nodeCount; ++target) {
+        const GeneratedGraph::NodeSpec &spec = graph.nodes[size_t(target)];
+        int first = layerBegin[size_t(std::max(0, spec.layer - span))];
+        int last = layerBegin[size_t(spec.layer)];
+
+        for (int input = 0; input < spec.inputs; ++input) {
+            if ((first >= last) ||
+                (random.generateDouble() >= options.connectProbability)) {
+                continue;
+            }
+
+            for (int attempt = 0; attempt < attempts; ++attempt) {
+                int source = int(random.bounded(first, last));
+                std::vector<int> &counts = fanOut[size_t(source)];
+                if (counts.empty()) {
+                    continue;
+                }
+
+                int output = int(random.bounded(int(counts.size())));
+                if (counts[size_t(output)] >= options.maxFanOut) {
+                    continue;
+                }
+
+                ++counts[size_t(output)];
+                graph.edges.push_back(
+                    GeneratedGraph::Edge{source, output, target, input});
+                break;
+            }
+        }
+    }
+
+    return graph;
+}
+
+std::vector<Node *> instantiateGraph(QGraphicsScene *scene,
+                                     const GeneratedGraph &graph) {
+    std::vector<Node *> nodes;
+    nodes.reserve(graph.nodes.size());
+
+    for (size_t i = 0; i < graph.nodes.size(); ++i) {
+        const GeneratedGraph::NodeSpec &spec = graph.nodes[i];
+
+        Node *node = new Node();
+        node->setLabel(QString("Node %1").arg(i));
+        for (int j = 0; j < spec.inputs; ++j) {
+            node->addSlot(Slot::Input, QString("in %1").arg(j));
+        }
+        for (int j = 0; j < spec.outputs; ++j) {
+            node->addSlot(Slot::Output, QString("out %1").arg(j));
+        }
+
+        node->setPos(spec.pos);
+        scene->addItem(node);
+        nodes.push_back(node);
+    }
+
+    for (const GeneratedGraph::Edge &edge : graph.edges) {
+        Slot *source =
+            nodes[size_t(edge.sourceNode)]->slot(Slot::Output, edge.sourceSlot);
+        Slot *target =
+            nodes[size_t(edge.targetNode)]->slot(Slot::Input, edge.targetSlot);
+
+        Connection *conn = new Connection(source);
+        conn->setTargetSlot(target);
+        scene->addItem(conn);
+    }
+
+    return nodes;
+}
+
+} // namespace qnodes
@@ -0,0 +1,293 @@
+#include <QGraphicsScene>
+#include <QGraphicsWidget>
+#include <QImage>
+#include <QPainter>
+#include <algorithm>
+#include <qnodes/connection.hpp>
+#include <qnodes/group_node.hpp>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace qnodes {
+
+// Thumbnail of the members, rendered once when the group is collapsed so
+// that painting the group does not depend on its size.
+class GroupPreview : public QGraphicsWidget {
+public:
+    explicit GroupPreview(const QImage &image) : m_image(image) {
+        setMinimumSize(image.size());
+    }
+
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
+               QWidget *widget = nullptr) override {
+        ((void)option);
+        ((void)widget);
+
+        QRectF r = rect();
+        double scale = std::min(r.width() / m_image.width(),
+                                r.height() / m_image.height());
+        QSizeF size(m_image.width() * scale, m_image.height() * scale);
+
+        painter->drawImage(
+            QRectF(r.center() - QPointF(size.width(), size.height()) / 2.0,
+                   size),
+            m_image);
+    }
+
+private:
+    QImage m_image;
+};
+
+struct GroupNode::Impl {
+    struct Boundary {
+        Slot *external;
+        Slot *member;
+        Slot *proxy;
+    };
+
+    GroupNode &self;
+    std::vector<Node *> members;
+    std::vector<Connection *> internal;
+    std::unordered_map<const Slot *, Slot *> innerOf;
+    std::unordered_map<const Slot *, Slot *> outerOf;
+    QPointF anchor;
+    bool expanded = false;
+
+    explicit Impl(GroupNode &self) : self(self) {}
+
+    Slot *proxyFor(Slot *member) {
+        auto it = outerOf.find(member);
+        if (it != outerOf.end()) {
+            return it->second;
+        }
+
+        QString label = member->label();
+        if (Node *node = member->node()) {
+            label = node->label() + ": " + label;
+        }
+
+        Slot *proxy = self.addSlot(member->slotType(), label);
+        proxy->setPortType(member->portType());
+        proxy->setAcceptedTypes(member->acceptedTypes());
+        proxy->setToolTip(member->toolTip());
+
+        outerOf.emplace(member, proxy);
+        innerOf.emplace(proxy, member);
+        return proxy;
+    }
+
+    static Connection *reconnect(QGraphicsScene *scene, Slot *source,
+                                 Slot *target) {
+        Connection *conn = new Connection(source);
+        scene->addItem(conn);
+        conn->setTargetSlot(target);
+        return conn;
+    }
+
+    // Connects the outside end of the boundary to a proxy or member slot
+    static void connectAcross(QGraphicsScene *scene, const Boundary &boundary,
+                              Slot *inside) {
+        if (inside->slotType() == Slot::Input) {
+            reconnect(scene, boundary.external, inside);
+        } else {
+            reconnect(scene, inside, boundary.external);
+        }
+    }
+
+    static QImage renderPreview(const std::vector<Node *> &nodes,
+                                const QRectF &bounds) {
+        const double maxExtent = 120.0;
+        double scale = maxExtent / std::max(bounds.width(), bounds.height());
+
+        QSize size(std::max(8, qRound(bounds.width() * scale)),
+                   std::max(8, qRound(bounds.height() * scale)));
+
+        QImage image(size, QImage::Format_ARGB32_Premultiplied);
+        image.fill(Qt::transparent);
+
+        QPainter painter(&image);
+        painter.scale(scale, scale);
+        painter.translate(-bounds.topLeft());
+        painter.setPen(Qt::NoPen);
+
+        for (Node *node : nodes) {
+            QBrush brush = node->backgroundBrush();
+            painter.setBrush(brush.style() != Qt::NoBrush ? brush
+                                                          : QBrush(Qt::gray));
+            painter.drawRect(node->sceneBoundingRect());
+        }
+
+        return image;
+    }
+};
+
+GroupNode::GroupNode() : m_impl(new Impl(*this)) {
+    setBackgroundBrush(QColor(127, 140, 141));
+    setBodyCacheEnabled(true);
+}
+
+GroupNode::~GroupNode() {
+    // Leave the scene while the members still exist, so that listeners
+    // of Scene::nodeRemoved can still look at them.
+    if (scene()) {
+        scene()->removeItem(this);
+    }
+
+    if (!m_impl->expanded) {
+        for (Connection *conn : m_impl->internal) {
+            delete conn;
+        }
+
+        for (Node *node : m_impl->members) {
+            delete node;
+        }
+    }
+
+    delete m_impl;
+}
+
+GroupNode *GroupNode::collapse(const std::vector<Node *> &nodes) {
+    if (nodes.empty() || !nodes.front()->scene()) {
+        return nullptr;
+    }
+
+    QGraphicsScene *scene = nodes.front()->scene();
+    std::unordered_set<Node *> memberSet;
+    QRectF bounds;
+
+    for (Node *node : nodes) {
+        if (node->scene() != scene) {
+            return nullptr;
+        }
+
+        memberSet.insert(node);
+        bounds |= node->sceneBoundingRect();
+    }
+
+    GroupNode *group = new GroupNode();
+    Impl &impl = *group->m_impl;
+    impl.members = nodes;
+
+    // Classify every connection touching a member
+    std::unordered_set<Connection *> seen;
+    std::vector<Connection *> crossing;
+    std::vector<Impl::Boundary> boundaries;
+
+    for (Node *node : nodes) {
+        for (Slot::Type type : {Slot::Input, Slot::Output}) {
+            for (int i = 0; i < node->slotCount(type); ++i) {
+                for (Connection *conn : node->slot(type, i)->connections()) {
+                    if (!seen.insert(conn).second) {
+                        continue;
+                    }
+
+                    // Being dragged, or an end already destroyed
+                    Slot *source = conn->sourceSlot();
+                    Slot *target = conn->targetSlot();
+                    if (!source || !target || !source->node() ||
+                        !target->node()) {
+                        continue;
+                    }
+
+                    bool sourceInside = memberSet.count(source->node()) != 0;
+                    bool targetInside = memberSet.count(target->node()) != 0;
+
+                    if (sourceInside && targetInside) {
+                        impl.internal.push_back(conn);
+                        continue;
+                    }
+
+                    Slot *member = targetInside ? target : source;
+                    Slot *external = targetInside ? source : target;
+
+                    Slot *proxy = impl.proxyFor(member);
+                    boundaries.push_back(
+                        Impl::Boundary{external, member, proxy});
+                    crossing.push_back(conn);
+                }
+            }
+        }
+    }
+
+    for (Connection *conn : crossing) {
+        delete conn;
+    }
+
+    for (Connection *conn : impl.internal) {
+        scene->removeItem(conn);
+    }
+
+    for (Node *node : nodes) {
+        node->setSelected(false);
+        scene->removeItem(node);
+    }
+
+    group->setLabel(QString("Group (%1 nodes)").arg(nodes.size()));
+    group->setContent(new GroupPreview(Impl::renderPreview(nodes, bounds)));
+
+    scene->addItem(group);
+    group->setPos(bounds.topLeft());
+    impl.anchor = group->pos();
+
+    for (const auto &boundary : boundaries) {
+        Impl::connectAcross(scene, boundary, boundary.proxy);
+    }
+
+    return group;
+}
+
+std::vector<Node *> GroupNode::expand() {
+    QGraphicsScene *scene = this->scene();
+    if (!scene || m_impl->expanded) {
+        return {};
+    }
+
+    // The proxy slots may have been connected and disconnected while the
+    // group was collapsed, so what crosses the boundary now is taken from
+    // them rather than from the state at collapse time.
+    std::vector<Impl::Boundary> boundaries;
+    for (const auto &entry : m_impl->innerOf) {
+        for (Connection *conn : entry.first->connections()) {
+            Slot *proxy = const_cast<Slot *>(entry.first);
+            Slot *external = (conn->targetSlot() == proxy) ? conn->sourceSlot()
+                                                           : conn->targetSlot();
+            boundaries.push_back(Impl::Boundary{external, entry.second, proxy});
+            delete conn;
+        }
+    }
+
+    for (Connection *conn : m_impl->internal) {
+        scene->addItem(conn);
+    }
+
+    QPointF offset = pos() - m_impl->anchor;
+    for (Node *node : m_impl->members) {
+        scene->addItem(node);
+        node->moveBy(offset.x(), offset.y());
+    }
+
+    for (const auto &boundary : boundaries) {
+        Impl::connectAcross(scene, boundary, boundary.member);
+    }
+
+    m_impl->expanded = true;
+
+    scene->removeItem(this);
+    deleteLater();
+
+    return m_impl->members;
+}
+
+std::vector<Node *> GroupNode::members() const { return m_impl->members; }
+
+Slot *GroupNode::innerSlot(const Slot *proxy) const {
+    auto it = m_impl->innerOf.find(proxy);
+    return (it != m_impl->innerOf.end()) ? it->second : nullptr;
+}
+
+Slot *GroupNode::outerSlot(const Slot *member) const {
+    auto it = m_impl->outerOf.find(member);
+    return (it != m_impl->outerOf.end()) ? it->second : nullptr;
+}
+
+} // namespace qnodes
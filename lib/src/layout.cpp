@@ -0,0 +1,778 @@
+#include <QFutureWatcher>
+#include <QPointer>
+#include <QRectF>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <qnodes/connection.hpp>
+#include <qnodes/layout.hpp>
+#include <qnodes/node.hpp>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace qnodes {
+
+namespace {
+
+struct Segment {
+    int from;
+    int to;
+    double fromPort;
+    double toPort;
+};
+
+struct LayerGraph {
+    std::vector<int> layer;
+    std::vector<double> width;
+    std::vector<double> height;
+    std::vector<double> y;
+    std::vector<Segment> segments;
+    std::vector<std::vector<int>> in;
+    std::vector<std::vector<int>> out;
+    std::vector<std::vector<int>> layers;
+    std::vector<int> pos;
+
+    int addVertex(int vertexLayer, double w, double h, double initialY) {
+        layer.push_back(vertexLayer);
+        width.push_back(w);
+        height.push_back(h);
+        y.push_back(initialY);
+        in.emplace_back();
+        out.emplace_back();
+        return static_cast<int>(layer.size()) - 1;
+    }
+
+    void addSegment(const Segment &seg) {
+        int idx = static_cast<int>(segments.size());
+        segments.push_back(seg);
+        out[seg.from].push_back(idx);
+        in[seg.to].push_back(idx);
+    }
+
+    double portKey(int v, double port) const {
+        // Keeps ports of the same vertex ordered without crossing into the
+        // next vertex's range.
+        return pos[v] + port / (height[v] + 1.0);
+    }
+};
+
+// Merge-sort inversion count, O(k log k)
+qint64 countInversions(std::vector<double> &keys, std::vector<double> &tmp,
+                       size_t begin, size_t end) {
+    if (end - begin < 2) {
+        return 0;
+    }
+
+    size_t mid = (begin + end) / 2;
+    qint64 count = countInversions(keys, tmp, begin, mid) +
+                   countInversions(keys, tmp, mid, end);
+
+    size_t i = begin, j = mid, k = begin;
+    while ((i < mid) && (j < end)) {
+        if (keys[j] < keys[i]) {
+            count += static_cast<qint64>(mid - i);
+            tmp[k++] = keys[j++];
+        } else {
+            tmp[k++] = keys[i++];
+        }
+    }
+
+    while (i < mid) {
+        tmp[k++] = keys[i++];
+    }
+
+    while (j < end) {
+        tmp[k++] = keys[j++];
+    }
+
+    std::copy(tmp.begin() + begin, tmp.begin() + end, keys.begin() + begin);
+    return count;
+}
+
+qint64 countCrossings(const LayerGraph &g,
+                      const std::vector<std::vector<int>> &layerSegments) {
+    qint64 total = 0;
+    std::vector<std::pair<double, double>> pairs;
+    std::vector<double> keys, tmp;
+
+    for (const auto &segs : layerSegments) {
+        pairs.clear();
+        for (int si : segs) {
+            const Segment &seg = g.segments[si];
+            pairs.emplace_back(g.portKey(seg.from, seg.fromPort),
+                               g.portKey(seg.to, seg.toPort));
+        }
+
+        std::sort(pairs.begin(), pairs.end());
+
+        keys.resize(pairs.size());
+        tmp.resize(pairs.size());
+        for (size_t i = 0; i < pairs.size(); ++i) {
+            keys[i] = pairs[i].second;
+        }
+
+        total += countInversions(keys, tmp, 0, keys.size());
+    }
+
+    return total;
+}
+
+void sortByBarycenter(LayerGraph &g, std::vector<int> &layerVertices,
+                      bool usePredecessors) {
+    std::vector<std::pair<double, int>> keyed;
+    keyed.reserve(layerVertices.size());
+
+    for (int v : layerVertices) {
+        const auto &segs = usePredecessors ? g.in[v] : g.out[v];
+
+        double key = g.pos[v];
+        if (!segs.empty()) {
+            double sum = 0.0;
+            for (int si : segs) {
+                const Segment &seg = g.segments[si];
+                sum += usePredecessors ? g.portKey(seg.from, seg.fromPort)
+                                       : g.portKey(seg.to, seg.toPort);
+            }
+            key = sum / segs.size();
+        }
+
+        keyed.emplace_back(key, v);
+    }
+
+    std::stable_sort(keyed.begin(), keyed.end(),
+                     [](const std::pair<double, int> &a,
+                        const std::pair<double, int> &b) {
+                         return a.first < b.first;
+                     });
+
+    for (size_t i = 0; i < keyed.size(); ++i) {
+        layerVertices[i] = keyed[i].second;
+        g.pos[keyed[i].second] = static_cast<int>(i);
+    }
+}
+
+// Pool-adjacent-violators: least-squares fit of a non-decreasing sequence.
+void isotonicRegression(std::vector<double> &values) {
+    std::vector<double> sums;
+    std::vector<int> counts;
+
+    for (double v : values) {
+        sums.push_back(v);
+        counts.push_back(1);
+
+        while (sums.size() > 1) {
+            size_t last = sums.size() - 1;
+            if (sums[last - 1] / counts[last - 1] <=
+                sums[last] / counts[last]) {
+                break;
+            }
+
+            sums[last - 1] += sums[last];
+            counts[last - 1] += counts[last];
+            sums.pop_back();
+            counts.pop_back();
+        }
+    }
+
+    size_t idx = 0;
+    for (size_t block = 0; block < sums.size(); ++block) {
+        double mean = sums[block] / counts[block];
+        for (int i = 0; i < counts[block]; ++i) {
+            values[idx++] = mean;
+        }
+    }
+}
+
+void placeLayer(LayerGraph &g, const std::vector<int> &layerVertices,
+                const std::vector<double> &desired, double nodeSpacing) {
+    std::vector<double> offsets(layerVertices.size());
+    std::vector<double> values(layerVertices.size());
+
+    double offset = 0.0;
+    for (size_t i = 0; i < layerVertices.size(); ++i) {
+        int v = layerVertices[i];
+        if (i > 0) {
+            int prev = layerVertices[i - 1];
+            bool real = (g.height[prev] > 0.0) && (g.height[v] > 0.0);
+            offset += g.height[prev] + (real ? nodeSpacing : nodeSpacing / 2);
+        }
+
+        offsets[i] = offset;
+        values[i] = desired[i] - offset;
+    }
+
+    isotonicRegression(values);
+
+    for (size_t i = 0; i < layerVertices.size(); ++i) {
+        g.y[layerVertices[i]] = values[i] + offsets[i];
+    }
+}
+
+void alignLayer(LayerGraph &g, const std::vector<int> &layerVertices,
+                bool usePredecessors, double nodeSpacing) {
+    std::vector<double> desired;
+    desired.reserve(layerVertices.size());
+
+    for (int v : layerVertices) {
+        const auto &segs = usePredecessors ? g.in[v] : g.out[v];
+
+        double target = g.y[v];
+        if (!segs.empty()) {
+            double sum = 0.0;
+            for (int si : segs) {
+                const Segment &seg = g.segments[si];
+                if (usePredecessors) {
+                    sum += g.y[seg.from] + seg.fromPort - seg.toPort;
+                } else {
+                    sum += g.y[seg.to] + seg.toPort - seg.fromPort;
+                }
+            }
+            target = sum / segs.size();
+        }
+
+        desired.push_back(target);
+    }
+
+    placeLayer(g, layerVertices, desired, nodeSpacing);
+}
+
+// Vertical shift, in one direction, that moves the rects clear of the
+// obstacles.
+double clearance(const std::vector<QRectF> &rects,
+                 const std::vector<QRectF> &obstacles, double spacing,
+                 bool down) {
+    double dy = 0.0;
+
+    // Every step moves past at least one obstacle
+    for (size_t step = 0; step <= obstacles.size(); ++step) {
+        double needed = 0.0;
+        for (const QRectF &rect : rects) {
+            QRectF moved = rect.translated(0.0, dy);
+            for (const QRectF &obstacle : obstacles) {
+                QRectF grown =
+                    obstacle.adjusted(-spacing, -spacing, spacing, spacing);
+                if (!moved.intersects(grown)) {
+                    continue;
+                }
+
+                needed = std::max(needed, down ? grown.bottom() - moved.top()
+                                               : moved.bottom() - grown.top());
+            }
+        }
+
+        if (needed <= 0.0) {
+            break;
+        }
+
+        dy += down ? needed : -needed;
+    }
+
+    return dy;
+}
+
+} // namespace
+
+LayoutGraph LayoutGraph::fromNodes(const std::vector<Node *> &nodes) {
+    LayoutGraph graph;
+
+    std::unordered_map<const Node *, int> indices;
+    for (Node *node : nodes) {
+        indices.emplace(node, static_cast<int>(graph.sizes.size()));
+        graph.sizes.push_back(node->size());
+        graph.positions.push_back(node->pos());
+    }
+
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        Node *node = nodes[i];
+        int numOutputs = node->slotCount(Slot::Output);
+
+        for (int outIdx = 0; outIdx < numOutputs; ++outIdx) {
+            Slot *slot = node->slot(Slot::Output, outIdx);
+
+            for (Connection *conn : slot->connections()) {
+                if (conn->sourceSlot() != slot) {
+                    continue;
+                }
+
+                Slot *target = conn->targetSlot();
+                auto it = indices.find(target->node());
+                if (it == indices.end()) {
+                    continue;
+                }
+
+                graph.edges.push_back({static_cast<int>(i), it->second,
+                                       slot->pos().y(), target->pos().y()});
+            }
+        }
+    }
+
+    return graph;
+}
+
+std::vector<QPointF> layeredLayout(const LayoutGraph &graph,
+                                   const LayoutOptions &options) {
+    const int numNodes = static_cast<int>(graph.sizes.size());
+
+    std::vector<QPointF> result = graph.positions;
+    result.resize(static_cast<size_t>(numNodes));
+
+    auto isMovable = [&](int i) {
+        return graph.movable.empty() || graph.movable[static_cast<size_t>(i)];
+    };
+
+    // 1) Collect movable nodes, in left-to-right order of their current
+    // position so that cycle breaking keeps the existing flow direction
+    std::vector<int> global;
+    for (int i = 0; i < numNodes; ++i) {
+        if (isMovable(i)) {
+            global.push_back(i);
+        }
+    }
+
+    std::stable_sort(global.begin(), global.end(), [&](int a, int b) {
+        return result[a].x() < result[b].x();
+    });
+
+    const int n = static_cast<int>(global.size());
+    if (n == 0) {
+        return result;
+    }
+
+    std::vector<int> local(static_cast<size_t>(numNodes), -1);
+    for (int i = 0; i < n; ++i) {
+        local[global[i]] = i;
+    }
+
+    // Fixed neighbours of movable nodes are pinned: they keep their
+    // position, but take part in ordering and placement. Those feeding
+    // the movable nodes form a layer on the left, the others one on the
+    // right.
+    std::vector<char> pinnedLeft;
+    for (const auto &e : graph.edges) {
+        bool fromFixed = (local[e.source] < 0) && (local[e.target] >= 0);
+        bool toFixed = (local[e.source] >= 0) && (local[e.target] < 0);
+        if (!fromFixed && !toFixed) {
+            continue;
+        }
+
+        int fixed = fromFixed ? e.source : e.target;
+        if (local[fixed] == -1) {
+            local[fixed] = n + static_cast<int>(pinnedLeft.size());
+            global.push_back(fixed);
+            pinnedLeft.push_back(0);
+        }
+
+        if (fromFixed) {
+            pinnedLeft[size_t(local[fixed] - n)] = 1;
+        }
+    }
+
+    const int total = static_cast<int>(global.size());
+    const bool hasLeft =
+        std::find(pinnedLeft.begin(), pinnedLeft.end(), 1) != pinnedLeft.end();
+    const bool hasRight =
+        std::find(pinnedLeft.begin(), pinnedLeft.end(), 0) != pinnedLeft.end();
+
+    std::vector<Segment> edges;
+    std::vector<Segment> anchors;
+    for (const auto &e : graph.edges) {
+        int a = local[e.source], b = local[e.target];
+        if ((a < 0) || (b < 0) || (a == b) || ((a >= n) && (b >= n))) {
+            continue;
+        }
+
+        if ((a < n) && (b < n)) {
+            edges.push_back({a, b, e.sourcePortY, e.targetPortY});
+        } else if ((a >= n) == bool(pinnedLeft[size_t(std::max(a, b) - n)])) {
+            // Into the region from the left, or out of it to the right;
+            // edges back to the left layer are left out
+            anchors.push_back({a, b, e.sourcePortY, e.targetPortY});
+        }
+    }
+
+    // 2) Break cycles by reversing DFS back edges
+    {
+        std::vector<std::vector<int>> outEdges(n);
+        for (size_t ei = 0; ei < edges.size(); ++ei) {
+            outEdges[edges[ei].from].push_back(static_cast<int>(ei));
+        }
+
+        std::vector<char> state(n, 0);
+        std::vector<char> reversed(edges.size(), 0);
+        std::vector<std::pair<int, size_t>> stack;
+
+        for (int root = 0; root < n; ++root) {
+            if (state[root]) {
+                continue;
+            }
+
+            state[root] = 1;
+            stack.emplace_back(root, 0);
+
+            while (!stack.empty()) {
+                int v = stack.back().first;
+                size_t &next = stack.back().second;
+
+                if (next < outEdges[v].size()) {
+                    int ei = outEdges[v][next++];
+                    int w = edges[ei].to;
+
+                    if (state[w] == 1) {
+                        reversed[ei] = 1;
+                    } else if (state[w] == 0) {
+                        state[w] = 1;
+                        stack.emplace_back(w, 0);
+                    }
+                } else {
+                    state[v] = 2;
+                    stack.pop_back();
+                }
+            }
+        }
+
+        for (size_t ei = 0; ei < edges.size(); ++ei) {
+            if (reversed[ei]) {
+                Segment &e = edges[ei];
+                e = {e.to, e.from, e.toPort, e.fromPort};
+            }
+        }
+    }
+
+    // 3) Longest-path layering, then pull sources next to their
+    // successors. The left pinned layer comes first, the right one last.
+    const int firstLayer = hasLeft ? 1 : 0;
+    std::vector<int> layer(total, firstLayer);
+    std::vector<int> topo;
+    {
+        std::vector<std::vector<int>> succ(n), pred(n);
+        std::vector<int> inDegree(n, 0);
+        std::vector<char> anchored(n, 0);
+        for (const auto &e : edges) {
+            succ[e.from].push_back(e.to);
+            pred[e.to].push_back(e.from);
+            ++inDegree[e.to];
+        }
+
+        for (const auto &e : anchors) {
+            if (e.from >= n) {
+                anchored[e.to] = 1;
+            }
+        }
+
+        topo.reserve(n);
+        for (int v = 0; v < n; ++v) {
+            if (inDegree[v] == 0) {
+                topo.push_back(v);
+            }
+        }
+
+        for (size_t i = 0; i < topo.size(); ++i) {
+            int v = topo[i];
+            for (int w : succ[v]) {
+                layer[w] = std::max(layer[w], layer[v] + 1);
+                if (--inDegree[w] == 0) {
+                    topo.push_back(w);
+                }
+            }
+        }
+
+        for (auto it = topo.rbegin(); it != topo.rend(); ++it) {
+            int v = *it;
+            if (pred[v].empty() && !anchored[v] && !succ[v].empty()) {
+                int minLayer = std::numeric_limits<int>::max();
+                for (int w : succ[v]) {
+                    minLayer = std::min(minLayer, layer[w]);
+                }
+                layer[v] = minLayer - 1;
+            }
+        }
+    }
+
+    int numLayers = 1 + *std::max_element(layer.begin(), layer.begin() + n);
+    const int lastLayer = numLayers - 1;
+    if (hasRight) {
+        ++numLayers;
+    }
+
+    for (int v = n; v < total; ++v) {
+        layer[v] = pinnedLeft[size_t(v - n)] ? 0 : numLayers - 1;
+    }
+
+    std::vector<char> pinnedLayer(numLayers, 0);
+    pinnedLayer[0] = hasLeft;
+    pinnedLayer[numLayers - 1] = hasRight;
+
+    edges.insert(edges.end(), anchors.begin(), anchors.end());
+
+    // 4) Split long edges with dummy vertices
+    LayerGraph g;
+    for (int v = 0; v < total; ++v) {
+        const QSizeF &sz = graph.sizes[global[v]];
+        g.addVertex(layer[v], sz.width(), sz.height(), result[global[v]].y());
+    }
+
+    for (const auto &e : edges) {
+        int prev = e.from;
+        double prevPort = e.fromPort;
+
+        int span = layer[e.to] - layer[e.from];
+        double y0 = g.y[e.from] + e.fromPort;
+        double y1 = g.y[e.to] + e.toPort;
+
+        for (int l = layer[e.from] + 1; l < layer[e.to]; ++l) {
+            double t = double(l - layer[e.from]) / span;
+            int dummy = g.addVertex(l, 0.0, 0.0, y0 + (y1 - y0) * t);
+            g.addSegment({prev, dummy, prevPort, 0.0});
+            prev = dummy;
+            prevPort = 0.0;
+        }
+
+        g.addSegment({prev, e.to, prevPort, e.toPort});
+    }
+
+    // 5) Crossing minimization with layer-by-layer barycenter sweeps;
+    // pinned layers keep the order of their positions
+    const int numVertices = static_cast<int>(g.layer.size());
+
+    g.layers.resize(numLayers);
+    for (int v = 0; v < numVertices; ++v) {
+        g.layers[g.layer[v]].push_back(v);
+    }
+
+    g.pos.resize(numVertices);
+    for (auto &layerVertices : g.layers) {
+        std::stable_sort(layerVertices.begin(), layerVertices.end(),
+                         [&](int a, int b) { return g.y[a] < g.y[b]; });
+
+        for (size_t i = 0; i < layerVertices.size(); ++i) {
+            g.pos[layerVertices[i]] = static_cast<int>(i);
+        }
+    }
+
+    std::vector<std::vector<int>> layerSegments(numLayers);
+    for (size_t si = 0; si < g.segments.size(); ++si) {
+        layerSegments[g.layer[g.segments[si].from]].push_back(
+            static_cast<int>(si));
+    }
+
+    std::vector<std::vector<int>> bestLayers = g.layers;
+    qint64 bestCrossings = countCrossings(g, layerSegments);
+
+    for (int sweep = 0; (sweep < options.orderingSweeps) && (bestCrossings > 0);
+         ++sweep) {
+        for (int l = 1; l < numLayers; ++l) {
+            if (!pinnedLayer[l]) {
+                sortByBarycenter(g, g.layers[l], true);
+            }
+        }
+
+        for (int l = numLayers - 2; l >= 0; --l) {
+            if (!pinnedLayer[l]) {
+                sortByBarycenter(g, g.layers[l], false);
+            }
+        }
+
+        qint64 crossings = countCrossings(g, layerSegments);
+        if (crossings < bestCrossings) {
+            bestCrossings = crossings;
+            bestLayers = g.layers;
+        }
+    }
+
+    g.layers = bestLayers;
+    for (const auto &layerVertices : g.layers) {
+        for (size_t i = 0; i < layerVertices.size(); ++i) {
+            g.pos[layerVertices[i]] = static_cast<int>(i);
+        }
+    }
+
+    // 6) Horizontal coordinates from the widest vertex of each layer
+    std::vector<double> layerX(numLayers, 0.0);
+    std::vector<double> layerWidth(numLayers, 0.0);
+    {
+        double x = 0.0;
+        for (int l = 0; l < numLayers; ++l) {
+            layerX[l] = x;
+
+            for (int v : g.layers[l]) {
+                layerWidth[l] = std::max(layerWidth[l], g.width[v]);
+            }
+
+            x += layerWidth[l] + options.layerSpacing;
+        }
+    }
+
+    // 7) Vertical coordinates: stack every layer, then alternately align
+    // vertices with their predecessors' and successors' ports. Pinned
+    // vertices stay where they are.
+    QRectF oldBounds;
+    for (int v = 0; v < n; ++v) {
+        oldBounds |= QRectF(result[global[v]], QSizeF(1.0, 1.0));
+    }
+
+    const bool pinned = total > n;
+    for (int l = 0; l < numLayers; ++l) {
+        if (!pinnedLayer[l]) {
+            std::vector<double> desired(g.layers[l].size(),
+                                        pinned ? oldBounds.top() : 0.0);
+            placeLayer(g, g.layers[l], desired, options.nodeSpacing);
+        }
+    }
+
+    for (int pass = 0; pass < options.placementPasses; ++pass) {
+        for (int l = 1; l < numLayers; ++l) {
+            if (!pinnedLayer[l]) {
+                alignLayer(g, g.layers[l], true, options.nodeSpacing);
+            }
+        }
+
+        for (int l = numLayers - 2; l >= 0; --l) {
+            if (!pinnedLayer[l]) {
+                alignLayer(g, g.layers[l], false, options.nodeSpacing);
+            }
+        }
+    }
+
+    // 8) Next to the pinned nodes: right of those feeding the region, or
+    // else left of those it feeds. Without any, where the movable nodes
+    // used to be.
+    QRectF newBounds;
+    for (int v = 0; v < n; ++v) {
+        newBounds |= QRectF(QPointF(layerX[g.layer[v]], g.y[v]),
+                            QSizeF(1.0, 1.0));
+    }
+
+    QPointF shift = oldBounds.topLeft() - newBounds.topLeft();
+    if (pinned) {
+        shift.setY(0.0);
+
+        double left = std::numeric_limits<double>::lowest();
+        double right = std::numeric_limits<double>::max();
+        for (int v = n; v < total; ++v) {
+            const QPointF &pos = result[global[v]];
+            if (pinnedLeft[size_t(v - n)]) {
+                left = std::max(left, pos.x() + g.width[v]);
+            } else {
+                right = std::min(right, pos.x());
+            }
+        }
+
+        if (hasLeft) {
+            shift.setX(left + options.layerSpacing - layerX[firstLayer]);
+        } else {
+            shift.setX(right - options.layerSpacing - layerX[lastLayer] -
+                       layerWidth[lastLayer]);
+        }
+    }
+
+    std::vector<QRectF> rects;
+    for (int v = 0; v < n; ++v) {
+        QPointF pos = QPointF(layerX[g.layer[v]], g.y[v]) + shift;
+        rects.emplace_back(pos, graph.sizes[global[v]]);
+    }
+
+    // Then clear of the fixed nodes, by the smaller of the vertical moves
+    // up or down
+    if (n < numNodes) {
+        QRectF block;
+        for (const QRectF &rect : rects) {
+            block |= rect;
+        }
+
+        std::vector<QRectF> obstacles;
+        for (int i = 0; i < numNodes; ++i) {
+            QRectF rect(result[i], graph.sizes[i]);
+            if (!isMovable(i) &&
+                (rect.right() + options.nodeSpacing > block.left()) &&
+                (rect.left() - options.nodeSpacing < block.right())) {
+                obstacles.push_back(rect);
+            }
+        }
+
+        double down = clearance(rects, obstacles, options.nodeSpacing, true);
+        double up = clearance(rects, obstacles, options.nodeSpacing, false);
+        shift.ry() += (std::abs(up) < down) ? up : down;
+    }
+
+    for (int v = 0; v < n; ++v) {
+        result[global[v]] = QPointF(layerX[g.layer[v]], g.y[v]) + shift;
+    }
+
+    return result;
+}
+
+struct GraphLayout::Impl {
+    GraphLayout &self;
+    LayoutOptions options;
+    std::vector<QPointer<Node>> nodes;
+    std::vector<bool> movable;
+    QFutureWatcher<std::vector<QPointF>> watcher;
+
+    explicit Impl(GraphLayout &self) : self(self) {}
+
+    void start(const std::vector<Node *> &nodeList, LayoutGraph graph) {
+        nodes.assign(nodeList.begin(), nodeList.end());
+        movable = graph.movable;
+
+        LayoutOptions opts = options;
+        watcher.setFuture(QtConcurrent::run(
+            [graph, opts]() { return layeredLayout(graph, opts); }));
+    }
+
+    void apply() {
+        std::vector<QPointF> positions = watcher.result();
+
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            bool isMovable = movable.empty() || movable[i];
+            if (nodes[i] && isMovable && (i < positions.size())) {
+                nodes[i]->setPos(positions[i]);
+            }
+        }
+
+        nodes.clear();
+        emit self.finished();
+    }
+};
+
+GraphLayout::GraphLayout(QObject *parent)
+    : QObject(parent), m_impl(new Impl(*this)) {
+    connect(&m_impl->watcher, &QFutureWatcherBase::finished, this,
+            [this]() { m_impl->apply(); });
+}
+
+GraphLayout::~GraphLayout() {
+    m_impl->watcher.disconnect(this);
+    m_impl->watcher.waitForFinished();
+    delete m_impl;
+}
+
+void GraphLayout::setOptions(const LayoutOptions &options) {
+    m_impl->options = options;
+}
+
+LayoutOptions GraphLayout::options() const { return m_impl->options; }
+
+bool GraphLayout::isRunning() const { return m_impl->watcher.isRunning(); }
+
+void GraphLayout::waitForFinished() { m_impl->watcher.waitForFinished(); }
+
+void GraphLayout::layout(const std::vector<Node *> &nodes) {
+    m_impl->start(nodes, LayoutGraph::fromNodes(nodes));
+}
+
+void GraphLayout::layout(const std::vector<Node *> &nodes,
+                         const std::vector<Node *> &region) {
+    std::unordered_set<const Node *> regionSet(region.begin(), region.end());
+
+    LayoutGraph graph = LayoutGraph::fromNodes(nodes);
+    graph.movable.resize(nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        graph.movable[i] = regionSet.count(nodes[i]) > 0;
+    }
+
+    m_impl->start(nodes, std::move(graph));
+}
+
+} // namespace qnodes
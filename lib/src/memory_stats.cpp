@@ -0,0 +1,197 @@
+#include <QGraphicsProxyWidget>
+#include <QPolygonF>
+#include <QStaticText>
+#include <QWidget>
+#include <algorithm>
+#include <atomic>
+#include <qnodes/connection.hpp>
+#include <qnodes/evaluator.hpp>
+#include <qnodes/memory_stats.hpp>
+#include <qnodes/node.hpp>
+#include <qnodes/scene.hpp>
+
+namespace qnodes {
+
+namespace {
+
+struct Totals {
+    std::atomic<qint64> count{0};
+    std::atomic<qint64> bytes{0};
+};
+
+Totals g_totals[MemoryUsage::CategoryCount];
+
+// Prepared static text keeps glyph indices and positions per character
+// next to the string itself.
+const qint64 staticTextOverhead = 128;
+const qint64 staticTextPerChar = 32;
+
+} // namespace
+
+const qint64 MemoryStats::objectOverhead = 320;
+const qint64 MemoryStats::widgetOverhead = 1024;
+
+const char *MemoryUsage::categoryName(Category category) {
+    switch (category) {
+    case NodeItems:
+        return "Nodes";
+    case SlotItems:
+        return "Slots";
+    case ConnectionItems:
+        return "Connections";
+    case ImplBlocks:
+        return "Private data";
+    case StaticText:
+        return "Static text";
+    case Paths:
+        return "Paths";
+    case ContentWidgets:
+        return "Content widgets";
+    case EvaluationBuffers:
+        return "Evaluation buffers";
+    case CachedTiles:
+        return "Cached tiles";
+    case CategoryCount:
+        break;
+    }
+
+    return "";
+}
+
+qint64 MemoryUsage::totalBytes() const {
+    qint64 bytes = 0;
+    for (const Entry &entry : entries) {
+        bytes += entry.bytes;
+    }
+
+    return bytes;
+}
+
+MemoryUsage &MemoryUsage::operator+=(const MemoryUsage &other) {
+    for (int i = 0; i < CategoryCount; ++i) {
+        entries[i].count += other.entries[i].count;
+        entries[i].bytes += other.entries[i].bytes;
+    }
+
+    return *this;
+}
+
+MemoryUsage MemoryStats::snapshot() {
+    MemoryUsage usage;
+    for (int i = 0; i < MemoryUsage::CategoryCount; ++i) {
+        usage.entries[i].count =
+            g_totals[i].count.load(std::memory_order_relaxed);
+        usage.entries[i].bytes =
+            g_totals[i].bytes.load(std::memory_order_relaxed);
+    }
+
+    return usage;
+}
+
+qint64 MemoryStats::estimateSize(const QStaticText &text) {
+    return qint64(sizeof(QStaticText)) + staticTextOverhead +
+           qint64(text.text().size()) * staticTextPerChar;
+}
+
+qint64 MemoryStats::estimateSize(const QPolygonF &polygon) {
+    return qint64(sizeof(QPolygonF)) +
+           qint64(polygon.capacity()) * qint64(sizeof(QPointF));
+}
+
+qint64 MemoryStats::estimateSize(const QGraphicsWidget *widget) {
+    if (!widget) {
+        return 0;
+    }
+
+    qint64 bytes = objectOverhead;
+
+    auto proxy = qobject_cast<const QGraphicsProxyWidget *>(widget);
+    if (proxy && proxy->widget()) {
+        bytes += widgetOverhead *
+                 (1 + proxy->widget()->findChildren<QWidget *>().size());
+    }
+
+    for (QGraphicsItem *child : widget->childItems()) {
+        if (child->isWidget()) {
+            bytes += estimateSize(static_cast<QGraphicsWidget *>(child));
+        } else {
+            bytes += objectOverhead;
+        }
+    }
+
+    return bytes;
+}
+
+void MemoryStats::add(MemoryUsage::Category category, qint64 count,
+                      qint64 bytes) {
+    g_totals[category].count.fetch_add(count, std::memory_order_relaxed);
+    g_totals[category].bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+MemoryAccount::~MemoryAccount() {
+    for (int i = 0; i < MemoryUsage::CategoryCount; ++i) {
+        set(MemoryUsage::Category(i), 0, 0);
+    }
+}
+
+void MemoryAccount::set(MemoryUsage::Category category, qint64 count,
+                        qint64 bytes) {
+    MemoryUsage::Entry &entry = m_usage[category];
+    if ((entry.count == count) && (entry.bytes == bytes)) {
+        return;
+    }
+
+    MemoryStats::add(category, count - entry.count, bytes - entry.bytes);
+    entry.count = count;
+    entry.bytes = bytes;
+}
+
+std::vector<NodeMemory> nodeMemory(Scene *scene,
+                                   const Evaluator *evaluator) {
+    std::vector<NodeMemory> result;
+    if (!scene) {
+        return result;
+    }
+
+    for (Node *node : scene->nodes()) {
+        NodeMemory entry{node, node->memoryUsage()};
+
+        for (int i = 0; i < node->slotCount(Slot::Input); ++i) {
+            Slot *input = node->slot(Slot::Input, i);
+            for (Connection *conn : input->connections()) {
+                if (conn->targetSlot() == input) {
+                    entry.usage += conn->memoryUsage();
+                }
+            }
+        }
+
+        if (evaluator) {
+            qint64 bytes = evaluator->outputMemory(node);
+            if (bytes > 0) {
+                MemoryUsage::Entry &buffers =
+                    entry.usage[MemoryUsage::EvaluationBuffers];
+                buffers.count += 1;
+                buffers.bytes += bytes;
+            }
+        }
+
+        result.push_back(entry);
+    }
+
+    std::sort(result.begin(), result.end(),
+              [](const NodeMemory &a, const NodeMemory &b) {
+                  return a.usage.totalBytes() > b.usage.totalBytes();
+              });
+    return result;
+}
+
+MemoryUsage sceneMemory(Scene *scene, const Evaluator *evaluator) {
+    MemoryUsage usage;
+    for (const NodeMemory &entry : nodeMemory(scene, evaluator)) {
+        usage += entry.usage;
+    }
+
+    return usage;
+}
+
+} // namespace qnodes
@@ -1,12 +1,23 @@
 #include <QCursor>
+#include <QFontMetricsF>
 #include <QGraphicsSceneContextMenuEvent>
 #include <QGraphicsView>
 #include <QGraphicsWidget>
+#include <QMap>
+#include <QPaintDevice>
 #include <QPainter>
+#include <QRandomGenerator>
+#include <QStaticText>
+#include <QStyleOptionGraphicsItem>
 #include <QWidget>
+#include <QtMath>
 #include <memory>
+#include <qnodes/memory_stats.hpp>
 #include <qnodes/node.hpp>
+#include <qnodes/node_cache.hpp>
+#include <qnodes/scene.hpp>
 #include <qnodes/slot.hpp>
+#include <qnodes/stream.hpp>
 #include <vector>
 
 namespace qnodes {
@@ -14,15 +25,245 @@ namespace qnodes {
 const double Node::borderWidth = 1.5;
 const double Node::cornerRadius = 10.0;
 
+static quint64 nextCacheSerial() {
+    static quint64 serial = 0;
+    return ++serial;
+}
+
 struct Node::Impl {
     Node &self;
     QString label;
+    QStaticText labelText;
+    QFont labelFont;
+    double labelAscent = 0.0;
+    double labelMaxWidth = -1.0;
+    bool labelDirty = true;
     QSizeF size = {100.0, 100.0};
     QBrush backgroundBrush;
     std::vector<std::unique_ptr<Slot>> slotList;
     std::unique_ptr<QGraphicsWidget> content;
+    bool bodyCacheEnabled = false;
+    quint64 cacheSerial = nextCacheSerial();
+    quint64 cachedBuckets = 0;
+    EvaluationState evaluationState = Idle;
+    double progress = -1.0;
+    quint64 id = QRandomGenerator::global()->generate64();
+    QColor overlayColor;
+    QColor tintColor;
+    QMap<QString, QString> metadata;
+    MemoryAccount memory;
+
+    explicit Impl(Node &self) : self(self) {
+        labelText.setTextFormat(Qt::PlainText);
+
+        memory.set(MemoryUsage::NodeItems, 1,
+                   qint64(sizeof(Node)) + MemoryStats::objectOverhead);
+        updateMemory();
+    }
+
+    // The block itself and the strings it holds
+    void updateMemory() {
+        qint64 bytes = qint64(sizeof(Impl)) + label.capacity() * 2 +
+                       qint64(slotList.capacity() * sizeof(slotList[0]));
+        for (auto it = metadata.cbegin(); it != metadata.cend(); ++it) {
+            bytes += 64 + (it.key().size() + it.value().size()) * 2;
+        }
+
+        memory.set(MemoryUsage::ImplBlocks, 1, bytes);
+    }
+
+    void invalidateBody() { cacheSerial = nextCacheSerial(); }
+
+    Scene *graphScene() const { return qobject_cast<Scene *>(self.scene()); }
+
+    void notifyGeometryChanged() {
+        if (Scene *scene = graphScene()) {
+            scene->updateNodeGeometry(&self);
+        }
+    }
+
+    void dropCachedTiles() {
+        NodeCache &cache = NodeCache::global();
+        for (int bucket = NodeCache::minBucket; cachedBuckets != 0; ++bucket) {
+            quint64 bit = quint64(1) << (bucket - NodeCache::minBucket);
+            if (cachedBuckets & bit) {
+                cache.remove(&self, bucket);
+                cachedBuckets &= ~bit;
+            }
+        }
+    }
+
+    void paintBody(QPainter *painter, const QPalette &plt) {
+        if (self.isSelected()) {
+            painter->setPen(QPen(plt.color(QPalette::Highlight), borderWidth));
+        } else {
+            painter->setPen(
+                QPen(plt.color(QPalette::WindowText), borderWidth));
+        }
+
+        if (backgroundBrush.style() != Qt::NoBrush) {
+            painter->setBrush(backgroundBrush);
+        } else {
+            painter->setBrush(plt.window());
+        }
+
+        painter->drawRoundedRect(QRectF({borderWidth, borderWidth}, size),
+                                 cornerRadius, cornerRadius);
+
+        painter->setPen(plt.color(QPalette::WindowText));
+        updateLabelText(painter->font());
+        painter->drawStaticText(labelPos(), labelText);
+    }
+
+    // Drawn on top of the (possibly cached) body, so state and progress
+    // changes never invalidate the body tiles.
+    void paintEvaluationState(QPainter *painter, const QPalette &plt) {
+        QRectF body({borderWidth, borderWidth}, size);
+
+        switch (evaluationState) {
+        case Idle:
+        case Done:
+            return;
+        case Pending:
+            painter->setPen(QPen(plt.color(QPalette::Mid), borderWidth,
+                                 Qt::DashLine));
+            painter->setBrush(Qt::NoBrush);
+            painter->drawRoundedRect(body, cornerRadius, cornerRadius);
+            return;
+        case Failed:
+            painter->setPen(QPen(QColor(231, 76, 60), borderWidth * 2.0));
+            painter->setBrush(Qt::NoBrush);
+            painter->drawRoundedRect(body, cornerRadius, cornerRadius);
+            return;
+        case Running:
+            break;
+        }
+
+        double barHeight = Slot::slotRadius * 0.75;
+        QRectF bar(body.left() + cornerRadius,
+                   body.bottom() - Slot::slotRadius - barHeight,
+                   std::max(0.0, body.width() - 2.0 * cornerRadius), barHeight);
+
+        painter->setPen(Qt::NoPen);
+        painter->setBrush(plt.color(QPalette::Mid));
+        painter->drawRect(bar);
+
+        QColor fill = plt.color(QPalette::Highlight);
+        if (progress < 0.0) {
+            fill.setAlphaF(0.5);
+        } else {
+            bar.setWidth(bar.width() * std::min(1.0, progress));
+        }
 
-    explicit Impl(Node &self) : self(self) {}
+        painter->setBrush(fill);
+        painter->drawRect(bar);
+    }
+
+    void paintTint(QPainter *painter) {
+        if (!tintColor.isValid()) {
+            return;
+        }
+
+        QRectF body({borderWidth, borderWidth}, size);
+        painter->setPen(Qt::NoPen);
+        painter->setBrush(tintColor);
+        painter->drawRoundedRect(body, cornerRadius, cornerRadius);
+    }
+
+    void paintOverlay(QPainter *painter) {
+        if (!overlayColor.isValid()) {
+            return;
+        }
+
+        QRectF body({borderWidth, borderWidth}, size);
+        painter->setPen(QPen(overlayColor, borderWidth * 2.0));
+        painter->setBrush(Qt::NoBrush);
+        painter->drawRoundedRect(body, cornerRadius, cornerRadius);
+    }
+
+    bool paintCached(QPainter *painter, const QPalette &plt) {
+        QPaintDevice *device = painter->device();
+        qreal dpr = device ? device->devicePixelRatioF() : 1.0;
+        qreal lod = QStyleOptionGraphicsItem::levelOfDetailFromTransform(
+            painter->worldTransform());
+
+        int bucket = NodeCache::bucketForScale(lod * dpr);
+        if ((bucket < NodeCache::minBucket) ||
+            (bucket > NodeCache::maxBucket)) {
+            return false;
+        }
+
+        QRectF br = self.boundingRect();
+        NodeCache &cache = NodeCache::global();
+
+        const NodeCache::Tile *tile = cache.find(&self, bucket);
+        if (!tile || (tile->serial != cacheSerial) ||
+            (tile->paletteKey != plt.cacheKey()) ||
+            (tile->font != painter->font())) {
+            qreal scale = NodeCache::bucketScale(bucket);
+            QSize pixelSize(qCeil(br.width() * scale),
+                            qCeil(br.height() * scale));
+
+            if (pixelSize.isEmpty() ||
+                (pixelSize.width() > NodeCache::maxTileExtent) ||
+                (pixelSize.height() > NodeCache::maxTileExtent)) {
+                return false;
+            }
+
+            NodeCache::Tile newTile;
+            newTile.pixmap = QPixmap(pixelSize);
+            newTile.pixmap.fill(Qt::transparent);
+            newTile.serial = cacheSerial;
+            newTile.paletteKey = plt.cacheKey();
+            newTile.font = painter->font();
+
+            {
+                QPainter tilePainter(&newTile.pixmap);
+                tilePainter.setRenderHints(painter->renderHints());
+                tilePainter.setFont(painter->font());
+                tilePainter.scale(scale, scale);
+                tilePainter.translate(-br.topLeft());
+                paintBody(&tilePainter, plt);
+            }
+
+            cachedBuckets |= quint64(1) << (bucket - NodeCache::minBucket);
+            if (!cache.insert(&self, bucket, std::move(newTile))) {
+                return false;
+            }
+
+            tile = cache.find(&self, bucket);
+        }
+
+        painter->drawPixmap(br, tile->pixmap, QRectF(tile->pixmap.rect()));
+        return true;
+    }
+
+    double computeLabelMaxWidth() const {
+        return std::max(0.0, size.width() - 2.0 * cornerRadius);
+    }
+
+    void updateLabelText(const QFont &font) {
+        double maxWidth = computeLabelMaxWidth();
+        if (!labelDirty && (labelFont == font) && (labelMaxWidth == maxWidth)) {
+            return;
+        }
+
+        QFontMetricsF metrics(font);
+        labelText.setText(metrics.elidedText(label, Qt::ElideRight, maxWidth));
+        labelText.prepare(QTransform(), font);
+        memory.set(MemoryUsage::StaticText, 1,
+                   MemoryStats::estimateSize(labelText));
+
+        labelFont = font;
+        labelAscent = metrics.ascent();
+        labelMaxWidth = maxWidth;
+        labelDirty = false;
+    }
+
+    QPointF labelPos() const {
+        return QPointF(cornerRadius + borderWidth,
+                       cornerRadius + borderWidth * 2.0 - labelAscent);
+    }
 
     QSizeF computeMinSize() const {
         // 1) Compute max number of in/out slots
@@ -61,6 +302,7 @@ struct Node::Impl {
 
     void updateLayout() {
         self.prepareGeometryChange();
+        invalidateBody();
 
         // 1) Compute min size and resize if needed
         QSizeF minSize = computeMinSize();
@@ -98,6 +340,8 @@ struct Node::Impl {
 
             content->setGeometry(contentGeom);
         }
+
+        notifyGeometryChanged();
     }
 
     double getSlotYPos(int index) const {
@@ -110,9 +354,17 @@ Node::Node(QGraphicsItem *parent)
     setFlag(ItemIsSelectable);
     setFlag(ItemIsFocusable);
     setFlag(ItemIsMovable);
+    setFlag(ItemSendsGeometryChanges);
 }
 
-Node::~Node() { delete m_impl; }
+Node::~Node() {
+    if (Scene *scene = m_impl->graphScene()) {
+        scene->unregisterNode(this);
+    }
+
+    m_impl->dropCachedTiles();
+    delete m_impl;
+}
 
 void Node::setLabel(const QString &label) {
     if (m_impl->label == label) {
@@ -120,11 +372,37 @@ void Node::setLabel(const QString &label) {
     }
 
     m_impl->label = label;
+    m_impl->labelDirty = true;
+    m_impl->invalidateBody();
+    m_impl->updateMemory();
     update();
+
+    emit labelChanged(label);
 }
 
 QString Node::label() const { return m_impl->label; }
 
+void Node::setMetadata(const QString &key, const QString &value) {
+    if (m_impl->metadata.value(key) == value) {
+        return;
+    }
+
+    if (value.isEmpty()) {
+        m_impl->metadata.remove(key);
+    } else {
+        m_impl->metadata.insert(key, value);
+    }
+
+    m_impl->updateMemory();
+    emit metadataChanged(key);
+}
+
+QString Node::metadata(const QString &key) const {
+    return m_impl->metadata.value(key);
+}
+
+QStringList Node::metadataKeys() const { return m_impl->metadata.keys(); }
+
 void Node::resize(const QSizeF &size) {
     if (m_impl->size != size) {
         m_impl->size = size;
@@ -136,12 +414,36 @@ void Node::resize(const QSizeF &size) {
 QSizeF Node::size() const { return m_impl->size; }
 
 void Node::setBackgroundBrush(const QBrush &brush) {
+    if (m_impl->backgroundBrush == brush) {
+        return;
+    }
+
     m_impl->backgroundBrush = brush;
+    m_impl->invalidateBody();
     update();
+
+    if (Scene *scene = m_impl->graphScene()) {
+        scene->updateNodeAppearance(this);
+    }
 }
 
 QBrush Node::backgroundBrush() const { return m_impl->backgroundBrush; }
 
+void Node::setBodyCacheEnabled(bool enabled) {
+    if (m_impl->bodyCacheEnabled == enabled) {
+        return;
+    }
+
+    m_impl->bodyCacheEnabled = enabled;
+    if (!enabled) {
+        m_impl->dropCachedTiles();
+    }
+
+    update();
+}
+
+bool Node::isBodyCacheEnabled() const { return m_impl->bodyCacheEnabled; }
+
 Slot *Node::addSlot(std::unique_ptr<Slot> slot) {
     Slot::Type type = slot->slotType();
 
@@ -158,6 +460,7 @@ Slot *Node::addSlot(std::unique_ptr<Slot> slot) {
     slot->setPos(slotPos(type, idx));
 
     m_impl->slotList.push_back(std::move(slot));
+    m_impl->updateMemory();
 
     m_impl->updateLayout();
 
@@ -194,6 +497,32 @@ Slot *Node::slot(Slot::Type type, int index) {
     return nullptr;
 }
 
+int Node::slotCount(Slot::Type type) const {
+    int count = 0;
+    for (const auto &slot : m_impl->slotList) {
+        if (slot->slotType() == type) {
+            ++count;
+        }
+    }
+
+    return count;
+}
+
+int Node::slotIndex(const Slot *slot) const {
+    int index = 0;
+    for (const auto &otherSlot : m_impl->slotList) {
+        if (otherSlot.get() == slot) {
+            return index;
+        }
+
+        if (otherSlot->slotType() == slot->slotType()) {
+            ++index;
+        }
+    }
+
+    return -1;
+}
+
 QPointF Node::slotPos(Slot::Type type, int idx) const {
     double x = (type == Slot::Input) ? 0.0 : m_impl->size.width();
     double y = m_impl->getSlotYPos(idx);
@@ -202,6 +531,8 @@ QPointF Node::slotPos(Slot::Type type, int idx) const {
 
 void Node::setContent(QGraphicsWidget *content) {
     m_impl->content.reset(content);
+    m_impl->memory.set(MemoryUsage::ContentWidgets, content ? 1 : 0,
+                       MemoryStats::estimateSize(content));
 
     if (m_impl->content) {
         m_impl->content->setParentItem(this);
@@ -211,6 +542,92 @@ void Node::setContent(QGraphicsWidget *content) {
 
 QGraphicsWidget *Node::content() { return m_impl->content.get(); }
 
+MemoryUsage Node::memoryUsage() const {
+    MemoryUsage usage = m_impl->memory.usage();
+    for (const auto &slot : m_impl->slotList) {
+        usage += slot->memoryUsage();
+    }
+
+    return usage;
+}
+
+QVariantList Node::compute(const QVariantList &inputs) {
+    ((void)inputs);
+    return {};
+}
+
+bool Node::isPure() const { return false; }
+
+quint64 Node::parameterHash() const { return 0; }
+
+QFuture<QVariantList> Node::computeAsync(const QVariantList &inputs) {
+    QFutureInterface<QVariantList> iface;
+    iface.reportStarted();
+
+    QVariantList outputs = compute(inputs);
+    iface.reportFinished(&outputs);
+
+    return iface.future();
+}
+
+std::unique_ptr<StreamProcessor> Node::createStreamProcessor() {
+    return nullptr;
+}
+
+QByteArray Node::typeName() const { return {}; }
+
+QByteArray Node::saveState() const { return {}; }
+
+void Node::restoreState(const QByteArray &state) { ((void)state); }
+
+bool Node::isPlaceholder() const { return false; }
+
+void Node::setId(quint64 id) { m_impl->id = id; }
+
+quint64 Node::id() const { return m_impl->id; }
+
+void Node::setOverlayColor(const QColor &color) {
+    if (m_impl->overlayColor != color) {
+        m_impl->overlayColor = color;
+        update();
+    }
+}
+
+QColor Node::overlayColor() const { return m_impl->overlayColor; }
+
+void Node::setTintColor(const QColor &color) {
+    if (m_impl->tintColor != color) {
+        m_impl->tintColor = color;
+        update();
+    }
+}
+
+QColor Node::tintColor() const { return m_impl->tintColor; }
+
+void Node::setEvaluationState(EvaluationState state) {
+    if (m_impl->evaluationState != state) {
+        m_impl->evaluationState = state;
+        m_impl->progress = -1.0;
+        update();
+    }
+}
+
+Node::EvaluationState Node::evaluationState() const {
+    return m_impl->evaluationState;
+}
+
+void Node::setProgress(double progress) {
+    if (m_impl->progress != progress) {
+        m_impl->progress = progress;
+
+        if (m_impl->evaluationState == Running) {
+            update();
+        }
+    }
+}
+
+double Node::progress() const { return m_impl->progress; }
+
 QRectF Node::boundingRect() const {
     double m = borderWidth;
 
@@ -228,7 +645,6 @@ QPainterPath Node::shape() const {
 void Node::paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
                  QWidget *widget) {
     ((void)option);
-    ((void)widget);
 
     QPalette plt = scene()->palette();
 
@@ -238,30 +654,36 @@ void Node::paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
         plt.setCurrentColorGroup(QPalette::Disabled);
     }
 
-    if (isSelected()) {
-        painter->setPen(QPen(plt.color(QPalette::Highlight), borderWidth));
-    } else {
-        painter->setPen(QPen(plt.color(QPalette::WindowText), borderWidth));
-    }
-
-    if (m_impl->backgroundBrush.style() != Qt::NoBrush) {
-        painter->setBrush(m_impl->backgroundBrush);
-    } else {
-        painter->setBrush(plt.window());
+    // Only views pass a widget. Everything else, like scene->render() for
+    // PNG or SVG export, paints directly so that output is not resampled
+    // from a tile made for the screen, and vectors stay vectors.
+    bool cached = m_impl->bodyCacheEnabled && widget &&
+                  m_impl->paintCached(painter, plt);
+    if (!cached) {
+        m_impl->paintBody(painter, plt);
     }
 
-    painter->drawRoundedRect(QRectF({borderWidth, borderWidth}, m_impl->size),
-                             cornerRadius, cornerRadius);
-
-    painter->setPen(plt.color(QPalette::WindowText));
-    QPointF text_pos(cornerRadius + borderWidth,
-                     cornerRadius + borderWidth * 2.0);
-    painter->drawText(text_pos, m_impl->label);
+    m_impl->paintTint(painter);
+    m_impl->paintEvaluationState(painter, plt);
+    m_impl->paintOverlay(painter);
 }
 
 QVariant Node::itemChange(GraphicsItemChange change, const QVariant &value) {
-    if (change == ItemSceneHasChanged) {
+    if (change == ItemSceneChange) {
+        if (Scene *scene = m_impl->graphScene()) {
+            scene->unregisterNode(this);
+        }
+    } else if (change == ItemSceneHasChanged) {
         m_impl->updateLayout();
+
+        if (Scene *scene = m_impl->graphScene()) {
+            scene->registerNode(this);
+        }
+    } else if (change == ItemPositionHasChanged) {
+        m_impl->notifyGeometryChanged();
+    } else if ((change == ItemSelectedHasChanged) ||
+               (change == ItemEnabledHasChanged)) {
+        m_impl->invalidateBody();
     }
 
     return QGraphicsObject::itemChange(change, value);
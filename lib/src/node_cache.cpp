@@ -0,0 +1,71 @@
+#include <cmath>
+#include <qnodes/node_cache.hpp>
+
+namespace qnodes {
+
+const int NodeCache::minBucket = -16;
+const int NodeCache::maxBucket = 12;
+const int NodeCache::maxTileExtent = 2048;
+
+NodeCache::NodeCache(qint64 budget) : m_tiles(budget) {}
+
+NodeCache &NodeCache::global() {
+    static NodeCache cache;
+    return cache;
+}
+
+int NodeCache::bucketForScale(qreal scale) {
+    if (scale <= 0.0) {
+        return minBucket - 1;
+    }
+
+    return qRound(std::log2(scale) * 4.0);
+}
+
+qreal NodeCache::bucketScale(int bucket) { return std::pow(2.0, bucket / 4.0); }
+
+void NodeCache::setMemoryBudget(qint64 bytes) {
+    m_tiles.setBudget(bytes);
+    updateMemory();
+}
+
+qint64 NodeCache::memoryBudget() const { return m_tiles.budget(); }
+
+qint64 NodeCache::memoryUsage() const { return m_tiles.cost(); }
+
+int NodeCache::tileCount() const { return static_cast<int>(m_tiles.size()); }
+
+const NodeCache::Tile *NodeCache::find(const Node *node, int bucket) {
+    return m_tiles.find(Key{node, bucket});
+}
+
+bool NodeCache::insert(const Node *node, int bucket, Tile tile) {
+    const QPixmap &pm = tile.pixmap;
+    qint64 cost = qint64(pm.width()) * pm.height() * pm.depth() / 8;
+    bool inserted = m_tiles.insert(Key{node, bucket}, std::move(tile), cost);
+    updateMemory();
+    return inserted;
+}
+
+void NodeCache::remove(const Node *node, int bucket) {
+    if (m_tiles.remove(Key{node, bucket})) {
+        updateMemory();
+    }
+}
+
+void NodeCache::clear() {
+    m_tiles.clear();
+    updateMemory();
+}
+
+void NodeCache::updateMemory() {
+    m_memory.set(MemoryUsage::CachedTiles, qint64(m_tiles.size()),
+                 m_tiles.cost());
+}
+
+size_t NodeCache::KeyHash::operator()(const Key &key) const {
+    return std::hash<const Node *>()(key.node) ^
+           (std::hash<int>()(key.bucket) * 0x9e3779b97f4a7c15ull);
+}
+
+} // namespace qnodes
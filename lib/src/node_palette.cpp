@@ -0,0 +1,124 @@
+#include <QKeyEvent>
+#include <QLineEdit>
+#include <QListWidget>
+#include <QPointer>
+#include <QVBoxLayout>
+#include <qnodes/node_palette.hpp>
+#include <qnodes/slot.hpp>
+
+namespace qnodes {
+
+const int NodePalette::maxResults = 50;
+
+struct NodePalette::Impl {
+    NodePalette &self;
+    const NodeTypeRegistry &registry;
+    QLineEdit *edit;
+    QListWidget *list;
+    QPointer<Slot> slot;
+
+    Impl(NodePalette &self, const NodeTypeRegistry &registry)
+        : self(self), registry(registry), edit(new QLineEdit()),
+          list(new QListWidget()) {}
+
+    static QIcon colorIcon(const QColor &color) {
+        QPixmap pm(8, 8);
+        pm.fill(color);
+        return QIcon(pm);
+    }
+
+    void updateResults() {
+        list->clear();
+
+        for (int index :
+             registry.search(edit->text(), slot.data(), maxResults)) {
+            const NodeTypeInfo &info = registry.type(index);
+
+            QString text = info.name;
+            if (!info.category.isEmpty()) {
+                text += QString(" (%1)").arg(info.category);
+            }
+
+            auto item = new QListWidgetItem(colorIcon(info.color), text);
+            item->setData(Qt::UserRole, info.id);
+            list->addItem(item);
+        }
+
+        list->setCurrentRow(0);
+    }
+
+    void moveCurrent(int delta) {
+        int count = list->count();
+        if (count > 0) {
+            list->setCurrentRow((list->currentRow() + delta + count) % count);
+        }
+    }
+
+    void choose(QListWidgetItem *item) {
+        if (!item) {
+            return;
+        }
+
+        QByteArray id = item->data(Qt::UserRole).toByteArray();
+        self.hide();
+        emit self.typeChosen(id);
+    }
+};
+
+NodePalette::NodePalette(const NodeTypeRegistry &registry, QWidget *parent)
+    : QWidget(parent, Qt::Popup), m_impl(new Impl(*this, registry)) {
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(2, 2, 2, 2);
+    layout->addWidget(m_impl->edit);
+    layout->addWidget(m_impl->list);
+
+    m_impl->edit->setPlaceholderText("Search node types");
+    m_impl->edit->installEventFilter(this);
+
+    connect(m_impl->edit, &QLineEdit::textChanged, this,
+            [this]() { m_impl->updateResults(); });
+    connect(m_impl->list, &QListWidget::itemActivated, this,
+            [this](QListWidgetItem *item) { m_impl->choose(item); });
+
+    resize(300, 320);
+}
+
+NodePalette::~NodePalette() { delete m_impl; }
+
+void NodePalette::popup(const QPoint &globalPos, Slot *slot) {
+    m_impl->slot = slot;
+    m_impl->edit->clear();
+    m_impl->updateResults();
+
+    move(globalPos);
+    show();
+    m_impl->edit->setFocus();
+}
+
+Slot *NodePalette::filterSlot() const { return m_impl->slot; }
+
+bool NodePalette::eventFilter(QObject *watched, QEvent *event) {
+    if ((watched == m_impl->edit) && (event->type() == QEvent::KeyPress)) {
+        switch (static_cast<QKeyEvent *>(event)->key()) {
+        case Qt::Key_Up:
+            m_impl->moveCurrent(-1);
+            return true;
+        case Qt::Key_Down:
+            m_impl->moveCurrent(1);
+            return true;
+        case Qt::Key_Return:
+        case Qt::Key_Enter:
+            m_impl->choose(m_impl->list->currentItem());
+            return true;
+        case Qt::Key_Escape:
+            hide();
+            return true;
+        default:
+            break;
+        }
+    }
+
+    return QWidget::eventFilter(watched, event);
+}
+
+} // namespace qnodes
@@ -0,0 +1,227 @@
+#include <algorithm>
+#include <qnodes/node_type.hpp>
+#include <qnodes/slot.hpp>
+#include <set>
+
+namespace qnodes {
+
+static quint64 trigramKey(const QString &s, int i) {
+    return (quint64(s[i].unicode()) << 32) |
+           (quint64(s[i + 1].unicode()) << 16) | quint64(s[i + 2].unicode());
+}
+
+static std::vector<quint64> trigrams(const QString &text) {
+    const QString padded = "  " + text + " ";
+
+    std::vector<quint64> result;
+    for (int i = 0; i + 2 < padded.size(); ++i) {
+        result.push_back(trigramKey(padded, i));
+    }
+
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+// Subsequence match with bonuses for runs and word starts; negative if the
+// query is not a subsequence of the text.
+static int fuzzyScore(const QString &query, const QString &text) {
+    int score = 0;
+    int run = 0;
+    int pos = 0;
+
+    for (QChar c : query) {
+        bool found = false;
+
+        while (pos < text.size()) {
+            bool wordStart = (pos == 0) || !text[pos - 1].isLetterOrNumber();
+            bool consecutive = (run > 0);
+
+            if (text[pos++] == c) {
+                score += 1;
+                if (wordStart) {
+                    score += 8;
+                }
+                if (consecutive) {
+                    score += 5;
+                }
+
+                ++run;
+                found = true;
+                break;
+            }
+
+            run = 0;
+        }
+
+        if (!found) {
+            return -1;
+        }
+    }
+
+    if (text.startsWith(query)) {
+        score += 20;
+    }
+
+    return score;
+}
+
+NodeTypeRegistry &NodeTypeRegistry::global() {
+    static NodeTypeRegistry registry;
+    return registry;
+}
+
+NodeTypeRegistry::NodeTypeRegistry() = default;
+
+int NodeTypeRegistry::registerType(NodeTypeInfo info) {
+    if (m_ids.contains(info.id)) {
+        return -1;
+    }
+
+    const int index = typeCount();
+
+    Entry entry;
+    entry.key = (info.name + ' ' + info.category).toLower();
+    entry.inputMask = 0;
+    for (PortTypeMask mask : info.inputs) {
+        entry.inputMask |= mask;
+    }
+
+    for (quint64 gram : trigrams(entry.key)) {
+        m_trigrams[gram].push_back(index);
+    }
+
+    m_ids.insert(info.id, index);
+    entry.info = std::move(info);
+    m_types.push_back(std::move(entry));
+
+    return index;
+}
+
+int NodeTypeRegistry::typeCount() const {
+    return static_cast<int>(m_types.size());
+}
+
+const NodeTypeInfo &NodeTypeRegistry::type(int index) const {
+    return m_types[static_cast<size_t>(index)].info;
+}
+
+int NodeTypeRegistry::indexOf(const QByteArray &id) const {
+    return m_ids.value(id, -1);
+}
+
+std::vector<QString> NodeTypeRegistry::categories() const {
+    std::set<QString> names;
+    for (const Entry &entry : m_types) {
+        names.insert(entry.info.category);
+    }
+
+    return std::vector<QString>(names.begin(), names.end());
+}
+
+Node *NodeTypeRegistry::create(const QByteArray &id) const {
+    int index = indexOf(id);
+    if ((index < 0) || !type(index).factory) {
+        return nullptr;
+    }
+
+    return type(index).factory();
+}
+
+bool NodeTypeRegistry::isCompatible(int index, const Slot *slot) const {
+    if (!slot) {
+        return true;
+    }
+
+    const Entry &entry = m_types[static_cast<size_t>(index)];
+    const PortTypeRegistry &ports = PortTypeRegistry::global();
+
+    if (slot->slotType() == Slot::Output) {
+        // The union of the accepted types stands for all inputs
+        return !entry.info.inputs.empty() &&
+               ports.canConnect(slot->portType(), entry.inputMask);
+    }
+
+    for (PortTypeId output : entry.info.outputs) {
+        if (ports.canConnect(output, slot->acceptedTypes())) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+std::vector<int> NodeTypeRegistry::search(const QString &query,
+                                          const Slot *slot, int limit) const {
+    const QString q = query.trimmed().toLower();
+    std::vector<std::pair<int, int>> scored; // score, index
+
+    if (q.isEmpty()) {
+        for (int i = 0; i < typeCount(); ++i) {
+            if (isCompatible(i, slot)) {
+                scored.emplace_back(0, i);
+            }
+        }
+    } else if (q.size() < 3) {
+        // Too short for trigrams, and cheap enough to scan
+        for (int i = 0; i < typeCount(); ++i) {
+            int score = fuzzyScore(q, m_types[size_t(i)].key);
+            if ((score >= 0) && isCompatible(i, slot)) {
+                scored.emplace_back(score, i);
+            }
+        }
+    } else {
+        const std::vector<quint64> grams = trigrams(q);
+        std::unordered_map<int, int> hits;
+
+        for (quint64 gram : grams) {
+            auto it = m_trigrams.find(gram);
+            if (it != m_trigrams.end()) {
+                for (int index : it->second) {
+                    ++hits[index];
+                }
+            }
+        }
+
+        // Half of the trigrams have to match, which allows for a typo or two
+        const int needed = std::max<int>(1, int(grams.size() + 1) / 2);
+
+        for (const auto &hit : hits) {
+            if ((hit.second < needed) || !isCompatible(hit.first, slot)) {
+                continue;
+            }
+
+            int score = 50 * hit.second / int(grams.size());
+            int fuzzy = fuzzyScore(q, m_types[size_t(hit.first)].key);
+            if (fuzzy >= 0) {
+                score += 100 + fuzzy;
+            }
+
+            scored.emplace_back(score, hit.first);
+        }
+    }
+
+    auto better = [](const std::pair<int, int> &a,
+                     const std::pair<int, int> &b) {
+        return (a.first != b.first) ? (a.first > b.first)
+                                    : (a.second < b.second);
+    };
+
+    size_t count = std::min(scored.size(), size_t(std::max(0, limit)));
+    std::partial_sort(scored.begin(), scored.begin() + count, scored.end(),
+                      better);
+
+    std::vector<int> result;
+    result.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        result.push_back(scored[i].second);
+    }
+
+    return result;
+}
+
+NodeTypeRegistrar::NodeTypeRegistrar(NodeTypeInfo info) {
+    NodeTypeRegistry::global().registerType(std::move(info));
+}
+
+} // namespace qnodes
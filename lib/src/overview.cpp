@@ -0,0 +1,420 @@
+#include <QGraphicsView>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QPointer>
+#include <QScrollBar>
+#include <QTimer>
+#include <cmath>
+#include <qnodes/connection.hpp>
+#include <qnodes/node.hpp>
+#include <qnodes/overview.hpp>
+#include <qnodes/scene.hpp>
+#include <unordered_map>
+
+namespace qnodes {
+
+const int Overview::rasterSize = 256;
+const int Overview::refreshInterval = 33;
+
+struct Overview::Impl {
+    struct NodeEntry {
+        QRectF rect;
+        QRgb color;
+    };
+
+    struct EdgeEntry {
+        QPointF a;
+        QPointF b;
+    };
+
+    Overview &self;
+    QPointer<QGraphicsView> view;
+    QPointer<Scene> scene;
+    std::vector<QMetaObject::Connection> connections;
+
+    // Summary: per-cell colour sums and node counts, plus an edge density
+    // raster. Both have a fixed size, so painting never depends on the
+    // number of items in the scene.
+    QRectF bounds;
+    std::vector<qint32> red, green, blue, nodeCount, edgeCount;
+    std::unordered_map<Node *, NodeEntry> nodes;
+    std::unordered_map<Connection *, EdgeEntry> edges;
+
+    QImage image;
+    bool imageDirty = true;
+    QTimer refreshTimer;
+
+    explicit Impl(Overview &self) : self(self) {
+        const size_t numCells = size_t(rasterSize) * rasterSize;
+        red.assign(numCells, 0);
+        green.assign(numCells, 0);
+        blue.assign(numCells, 0);
+        nodeCount.assign(numCells, 0);
+        edgeCount.assign(numCells, 0);
+
+        refreshTimer.setSingleShot(true);
+        refreshTimer.setInterval(refreshInterval);
+    }
+
+    void scheduleRefresh() {
+        imageDirty = true;
+        if (!refreshTimer.isActive()) {
+            refreshTimer.start();
+        }
+    }
+
+    QPointF toCell(const QPointF &pos) const {
+        double scale = rasterSize / bounds.width();
+        return (pos - bounds.topLeft()) * scale;
+    }
+
+    static int clampCell(double v) {
+        return std::max(0, std::min(rasterSize - 1, static_cast<int>(v)));
+    }
+
+    void rasterizeNode(const NodeEntry &entry, int sign) {
+        QPointF tl = toCell(entry.rect.topLeft());
+        QPointF br = toCell(entry.rect.bottomRight());
+
+        int x0 = clampCell(tl.x()), x1 = clampCell(br.x());
+        int y0 = clampCell(tl.y()), y1 = clampCell(br.y());
+
+        for (int y = y0; y <= y1; ++y) {
+            for (int x = x0; x <= x1; ++x) {
+                size_t idx = size_t(y) * rasterSize + x;
+                red[idx] += sign * qRed(entry.color);
+                green[idx] += sign * qGreen(entry.color);
+                blue[idx] += sign * qBlue(entry.color);
+                nodeCount[idx] += sign;
+            }
+        }
+    }
+
+    void rasterizeEdge(const EdgeEntry &entry, int sign) {
+        QPointF a = toCell(entry.a);
+        QPointF b = toCell(entry.b);
+
+        int steps = static_cast<int>(std::ceil(
+            std::max(std::abs(b.x() - a.x()), std::abs(b.y() - a.y()))));
+        steps = std::max(1, std::min(steps, 2 * rasterSize));
+
+        int lastIdx = -1;
+        for (int i = 0; i <= steps; ++i) {
+            QPointF p = a + (b - a) * (double(i) / steps);
+            int idx = clampCell(p.y()) * rasterSize + clampCell(p.x());
+            if (idx != lastIdx) {
+                edgeCount[static_cast<size_t>(idx)] += sign;
+                lastIdx = idx;
+            }
+        }
+    }
+
+    bool inBounds(const QRectF &rect) const {
+        return bounds.isValid() && bounds.contains(rect);
+    }
+
+    void rebuild() {
+        QRectF itemBounds;
+        for (const auto &entry : nodes) {
+            itemBounds |= entry.second.rect;
+        }
+
+        double side = std::max(100.0, std::max(itemBounds.width(),
+                                               itemBounds.height()) * 1.5);
+        QPointF center = itemBounds.isValid() ? itemBounds.center() : QPointF();
+        bounds = QRectF(center - QPointF(side, side) / 2.0, QSizeF(side, side));
+
+        std::fill(red.begin(), red.end(), 0);
+        std::fill(green.begin(), green.end(), 0);
+        std::fill(blue.begin(), blue.end(), 0);
+        std::fill(nodeCount.begin(), nodeCount.end(), 0);
+        std::fill(edgeCount.begin(), edgeCount.end(), 0);
+
+        for (const auto &entry : nodes) {
+            rasterizeNode(entry.second, 1);
+        }
+
+        for (const auto &entry : edges) {
+            rasterizeEdge(entry.second, 1);
+        }
+
+        scheduleRefresh();
+    }
+
+    QRgb nodeColor(Node *node) const {
+        QBrush brush = node->backgroundBrush();
+        if (brush.style() != Qt::NoBrush) {
+            return brush.color().rgb();
+        }
+
+        return self.palette().color(QPalette::Window).rgb();
+    }
+
+    void updateNode(Node *node) {
+        NodeEntry entry{node->sceneBoundingRect(), nodeColor(node)};
+
+        auto it = nodes.find(node);
+        if (it != nodes.end()) {
+            rasterizeNode(it->second, -1);
+            it->second = entry;
+        } else {
+            nodes.emplace(node, entry);
+        }
+
+        if (inBounds(entry.rect)) {
+            rasterizeNode(entry, 1);
+            scheduleRefresh();
+        } else {
+            rebuild();
+        }
+    }
+
+    // Nodes without a brush take their colour from the palette
+    void recolor() {
+        for (auto &entry : nodes) {
+            entry.second.color = nodeColor(entry.first);
+        }
+
+        rebuild();
+    }
+
+    void removeNode(Node *node) {
+        auto it = nodes.find(node);
+        if (it != nodes.end()) {
+            rasterizeNode(it->second, -1);
+            nodes.erase(it);
+            scheduleRefresh();
+        }
+    }
+
+    void updateEdge(Connection *conn) {
+        if (!conn->sourceSlot() || !conn->targetSlot()) {
+            return;
+        }
+
+        EdgeEntry entry{conn->sourceSlot()->scenePos(),
+                        conn->targetSlot()->scenePos()};
+
+        auto it = edges.find(conn);
+        if (it != edges.end()) {
+            rasterizeEdge(it->second, -1);
+            it->second = entry;
+        } else {
+            edges.emplace(conn, entry);
+        }
+
+        rasterizeEdge(entry, 1);
+        scheduleRefresh();
+    }
+
+    void removeEdge(Connection *conn) {
+        auto it = edges.find(conn);
+        if (it != edges.end()) {
+            rasterizeEdge(it->second, -1);
+            edges.erase(it);
+            scheduleRefresh();
+        }
+    }
+
+    void updateImage() {
+        if (!imageDirty) {
+            return;
+        }
+
+        if (image.isNull()) {
+            image = QImage(rasterSize, rasterSize,
+                           QImage::Format_ARGB32_Premultiplied);
+        }
+
+        QColor edgeColor = self.palette().color(QPalette::WindowText);
+
+        for (int y = 0; y < rasterSize; ++y) {
+            QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(y));
+
+            for (int x = 0; x < rasterSize; ++x) {
+                size_t idx = size_t(y) * rasterSize + x;
+
+                if (nodeCount[idx] > 0) {
+                    int n = nodeCount[idx];
+                    line[x] = qRgb(red[idx] / n, green[idx] / n,
+                                   blue[idx] / n);
+                } else if (edgeCount[idx] > 0) {
+                    double density = std::log2(1.0 + edgeCount[idx]);
+                    int alpha = std::min(255, 48 + static_cast<int>(
+                                                       48.0 * density));
+                    line[x] = qPremultiply(qRgba(edgeColor.red(),
+                                                 edgeColor.green(),
+                                                 edgeColor.blue(), alpha));
+                } else {
+                    line[x] = 0;
+                }
+            }
+        }
+
+        imageDirty = false;
+    }
+
+    QRectF targetRect() const {
+        double side = std::min(self.width(), self.height());
+        return QRectF((self.width() - side) / 2.0,
+                      (self.height() - side) / 2.0, side, side);
+    }
+
+    QPointF sceneToWidget(const QPointF &pos) const {
+        QRectF target = targetRect();
+        return target.topLeft() +
+               (pos - bounds.topLeft()) * (target.width() / bounds.width());
+    }
+
+    QPointF widgetToScene(const QPointF &pos) const {
+        QRectF target = targetRect();
+        return bounds.topLeft() +
+               (pos - target.topLeft()) * (bounds.width() / target.width());
+    }
+
+    void detach() {
+        for (const auto &c : connections) {
+            QObject::disconnect(c);
+        }
+
+        connections.clear();
+        nodes.clear();
+        edges.clear();
+    }
+
+    void attach() {
+        if (!scene) {
+            rebuild();
+            return;
+        }
+
+        for (Node *node : scene->nodes()) {
+            nodes.emplace(node, NodeEntry{node->sceneBoundingRect(),
+                                          nodeColor(node)});
+        }
+
+        for (Connection *conn : scene->connections()) {
+            if (conn->sourceSlot() && conn->targetSlot()) {
+                edges.emplace(conn,
+                              EdgeEntry{conn->sourceSlot()->scenePos(),
+                                        conn->targetSlot()->scenePos()});
+            }
+        }
+
+        rebuild();
+
+        Scene *s = scene;
+        auto nodeChanged = [this](Node *n) { updateNode(n); };
+        auto nodeRemoved = [this](Node *n) { removeNode(n); };
+        auto edgeChanged = [this](Connection *c) { updateEdge(c); };
+        auto edgeRemoved = [this](Connection *c) { removeEdge(c); };
+
+        connections.push_back(
+            QObject::connect(s, &Scene::nodeAdded, &self, nodeChanged));
+        connections.push_back(QObject::connect(s, &Scene::nodeGeometryChanged,
+                                               &self, nodeChanged));
+        connections.push_back(QObject::connect(
+            s, &Scene::nodeAppearanceChanged, &self, nodeChanged));
+        connections.push_back(
+            QObject::connect(s, &Scene::nodeRemoved, &self, nodeRemoved));
+        connections.push_back(QObject::connect(s, &Scene::connectionAdded,
+                                               &self, edgeChanged));
+        connections.push_back(QObject::connect(
+            s, &Scene::connectionGeometryChanged, &self, edgeChanged));
+        connections.push_back(QObject::connect(s, &Scene::connectionRemoved,
+                                               &self, edgeRemoved));
+
+        QGraphicsView *v = view;
+        auto viewChanged = [this]() { self.update(); };
+        for (QScrollBar *bar :
+             {v->horizontalScrollBar(), v->verticalScrollBar()}) {
+            connections.push_back(QObject::connect(
+                bar, &QScrollBar::valueChanged, &self, viewChanged));
+            connections.push_back(QObject::connect(
+                bar, &QScrollBar::rangeChanged, &self, viewChanged));
+        }
+    }
+
+    void centerViewAt(const QPoint &pos) {
+        if (view && bounds.isValid()) {
+            view->centerOn(widgetToScene(pos));
+        }
+    }
+};
+
+Overview::Overview(QWidget *parent)
+    : QWidget(parent), m_impl(new Impl(*this)) {
+    connect(&m_impl->refreshTimer, &QTimer::timeout, this,
+            [this]() { update(); });
+}
+
+Overview::~Overview() {
+    m_impl->detach();
+    delete m_impl;
+}
+
+void Overview::setView(QGraphicsView *view) {
+    m_impl->detach();
+
+    m_impl->view = view;
+    m_impl->scene = view ? qobject_cast<Scene *>(view->scene()) : nullptr;
+
+    m_impl->attach();
+    update();
+}
+
+QGraphicsView *Overview::view() const { return m_impl->view; }
+
+QSize Overview::sizeHint() const { return QSize(200, 200); }
+
+void Overview::paintEvent(QPaintEvent *event) {
+    ((void)event);
+
+    QPainter painter(this);
+    painter.fillRect(rect(), palette().color(QPalette::Base));
+
+    if (!m_impl->scene || !m_impl->bounds.isValid()) {
+        return;
+    }
+
+    m_impl->updateImage();
+
+    QRectF target = m_impl->targetRect();
+    painter.setRenderHint(QPainter::SmoothPixmapTransform);
+    painter.drawImage(target, m_impl->image);
+
+    if (m_impl->view) {
+        QWidget *viewport = m_impl->view->viewport();
+        QRectF visible =
+            m_impl->view->mapToScene(viewport->rect()).boundingRect();
+
+        QRectF frame(m_impl->sceneToWidget(visible.topLeft()),
+                     m_impl->sceneToWidget(visible.bottomRight()));
+
+        painter.setPen(QPen(palette().color(QPalette::Highlight), 1.5));
+        painter.setBrush(Qt::NoBrush);
+        painter.drawRect(frame.intersected(target));
+    }
+}
+
+void Overview::changeEvent(QEvent *event) {
+    if (event->type() == QEvent::PaletteChange) {
+        m_impl->recolor();
+    }
+
+    QWidget::changeEvent(event);
+}
+
+void Overview::mousePressEvent(QMouseEvent *event) {
+    if (event->button() == Qt::LeftButton) {
+        m_impl->centerViewAt(event->pos());
+    }
+}
+
+void Overview::mouseMoveEvent(QMouseEvent *event) {
+    if (event->buttons() & Qt::LeftButton) {
+        m_impl->centerViewAt(event->pos());
+    }
+}
+
+} // namespace qnodes
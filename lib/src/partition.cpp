@@ -0,0 +1,280 @@
+#include <algorithm>
+#include <cmath>
+#include <qnodes/connection.hpp>
+#include <qnodes/node.hpp>
+#include <qnodes/partition.hpp>
+#include <queue>
+#include <unordered_map>
+
+namespace qnodes {
+
+namespace {
+
+// Subgraph being bisected, in local indices. Parallel edges appear as
+// repeated neighbours, so that they weigh more.
+struct SubGraph {
+    std::vector<int> vertices; // global index of every local vertex
+    std::vector<std::vector<int>> adjacent;
+
+    int size() const { return static_cast<int>(vertices.size()); }
+};
+
+SubGraph makeSubGraph(const std::vector<std::vector<int>> &adjacency,
+                      const std::vector<int> &vertices,
+                      std::vector<int> &localOf) {
+    SubGraph graph;
+    graph.vertices = vertices;
+    graph.adjacent.resize(vertices.size());
+
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        localOf[size_t(vertices[i])] = static_cast<int>(i);
+    }
+
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        for (int neighbour : adjacency[size_t(vertices[i])]) {
+            int local = localOf[size_t(neighbour)];
+            if (local >= 0) {
+                graph.adjacent[i].push_back(local);
+            }
+        }
+    }
+
+    for (int v : vertices) {
+        localOf[size_t(v)] = -1;
+    }
+
+    return graph;
+}
+
+// Breadth-first order from start, continuing with the remaining components.
+std::vector<int> bfsOrder(const SubGraph &graph, int start) {
+    std::vector<int> order;
+    std::vector<bool> seen(size_t(graph.size()), false);
+    order.reserve(size_t(graph.size()));
+
+    for (int root = start, next = 0; root >= 0;) {
+        size_t head = order.size();
+        seen[size_t(root)] = true;
+        order.push_back(root);
+
+        while (head < order.size()) {
+            int v = order[head++];
+            for (int u : graph.adjacent[size_t(v)]) {
+                if (!seen[size_t(u)]) {
+                    seen[size_t(u)] = true;
+                    order.push_back(u);
+                }
+            }
+        }
+
+        while ((next < graph.size()) && seen[size_t(next)]) {
+            ++next;
+        }
+        root = (next < graph.size()) ? next : -1;
+    }
+
+    return order;
+}
+
+// Grows side 0 breadth-first from a vertex far from the others, which
+// tends to give a compact part with a short boundary.
+std::vector<char> growBisection(const SubGraph &graph, int target) {
+    int start = bfsOrder(graph, 0).back();
+    std::vector<int> order = bfsOrder(graph, start);
+
+    std::vector<char> side(size_t(graph.size()), 1);
+    for (int i = 0; i < target; ++i) {
+        side[size_t(order[size_t(i)])] = 0;
+    }
+
+    return side;
+}
+
+// Fiduccia-Mattheyses: moves every vertex once, best gain first, and keeps
+// the best prefix of the moves. Side 0 is kept between lo and hi vertices.
+void refine(const SubGraph &graph, std::vector<char> &side, int lo, int hi,
+            int passes) {
+    const size_t n = size_t(graph.size());
+    std::vector<int> gain(n);
+    std::vector<char> locked(n);
+
+    for (int pass = 0; pass < passes; ++pass) {
+        int count0 = 0;
+        std::priority_queue<std::pair<int, int>> heap;
+
+        for (size_t v = 0; v < n; ++v) {
+            gain[v] = 0;
+            for (int u : graph.adjacent[v]) {
+                gain[v] += (side[size_t(u)] != side[v]) ? 1 : -1;
+            }
+
+            locked[v] = 0;
+            count0 += (side[v] == 0) ? 1 : 0;
+            heap.emplace(gain[v], int(v));
+        }
+
+        std::vector<int> moves;
+        std::vector<std::pair<int, int>> deferred;
+        int total = 0, best = 0;
+        size_t bestMoves = 0;
+
+        while (!heap.empty()) {
+            std::pair<int, int> top = heap.top();
+            heap.pop();
+
+            size_t v = size_t(top.second);
+            if (locked[v] || (top.first != gain[v])) {
+                continue; // stale entry
+            }
+
+            int newCount0 = count0 + ((side[v] == 0) ? -1 : 1);
+            if ((newCount0 < lo) || (newCount0 > hi)) {
+                deferred.push_back(top);
+                continue;
+            }
+
+            side[v] ^= 1;
+            locked[v] = 1;
+            count0 = newCount0;
+            total += gain[v];
+            moves.push_back(int(v));
+
+            for (int u : graph.adjacent[v]) {
+                if (!locked[size_t(u)]) {
+                    gain[size_t(u)] += (side[size_t(u)] == side[v]) ? -2 : 2;
+                    heap.emplace(gain[size_t(u)], u);
+                }
+            }
+
+            // The balance may allow them now
+            for (const auto &entry : deferred) {
+                heap.push(entry);
+            }
+            deferred.clear();
+
+            if (total > best) {
+                best = total;
+                bestMoves = moves.size();
+            }
+        }
+
+        for (size_t i = moves.size(); i > bestMoves; --i) {
+            side[size_t(moves[i - 1])] ^= 1;
+        }
+
+        if (best <= 0) {
+            break;
+        }
+    }
+}
+
+void bisect(const std::vector<std::vector<int>> &adjacency,
+            const std::vector<int> &vertices, int firstPart, int parts,
+            const PartitionOptions &options, std::vector<int> &result,
+            std::vector<int> &localOf) {
+    const int n = static_cast<int>(vertices.size());
+    if ((parts <= 1) || (n <= 1)) {
+        for (int v : vertices) {
+            result[size_t(v)] = firstPart;
+        }
+        return;
+    }
+
+    int parts0 = parts / 2;
+    int target = int(std::lround(double(n) * parts0 / parts));
+    target = std::max(1, std::min(n - 1, target));
+
+    double slack = target * std::max(0.0, options.imbalance);
+    int lo = std::max(1, int(std::floor(target - slack)));
+    int hi = std::min(n - 1, int(std::ceil(target + slack)));
+
+    SubGraph graph = makeSubGraph(adjacency, vertices, localOf);
+    std::vector<char> side = growBisection(graph, target);
+    refine(graph, side, lo, hi, options.refinementPasses);
+
+    std::vector<int> halves[2];
+    for (int i = 0; i < n; ++i) {
+        halves[side[size_t(i)] ? 1 : 0].push_back(vertices[size_t(i)]);
+    }
+
+    bisect(adjacency, halves[0], firstPart, parts0, options, result, localOf);
+    bisect(adjacency, halves[1], firstPart + parts0, parts - parts0, options,
+           result, localOf);
+}
+
+} // namespace
+
+PartitionGraph PartitionGraph::fromNodes(const std::vector<Node *> &nodes) {
+    PartitionGraph graph;
+    graph.nodeCount = static_cast<int>(nodes.size());
+
+    std::unordered_map<const Node *, int> indices;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        indices.emplace(nodes[i], static_cast<int>(i));
+    }
+
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        Node *node = nodes[i];
+
+        for (int input = 0; input < node->slotCount(Slot::Input); ++input) {
+            Slot *slot = node->slot(Slot::Input, input);
+
+            for (Connection *conn : slot->connections()) {
+                Slot *source = conn->sourceSlot();
+                if ((conn->targetSlot() != slot) || !source) {
+                    continue;
+                }
+
+                auto it = indices.find(source->node());
+                if (it != indices.end()) {
+                    graph.edges.push_back({it->second, static_cast<int>(i)});
+                }
+            }
+        }
+    }
+
+    return graph;
+}
+
+std::vector<int> partitionGraph(const PartitionGraph &graph,
+                                const PartitionOptions &options) {
+    const size_t n = size_t(std::max(0, graph.nodeCount));
+    std::vector<std::vector<int>> adjacency(n);
+
+    for (const auto &edge : graph.edges) {
+        if ((edge.a == edge.b) || (edge.a < 0) || (edge.b < 0) ||
+            (size_t(edge.a) >= n) || (size_t(edge.b) >= n)) {
+            continue;
+        }
+
+        adjacency[size_t(edge.a)].push_back(edge.b);
+        adjacency[size_t(edge.b)].push_back(edge.a);
+    }
+
+    std::vector<int> vertices(n);
+    for (size_t i = 0; i < n; ++i) {
+        vertices[i] = static_cast<int>(i);
+    }
+
+    std::vector<int> result(n, 0);
+    std::vector<int> localOf(n, -1);
+    bisect(adjacency, vertices, 0, std::max(1, options.partitions), options,
+           result, localOf);
+
+    return result;
+}
+
+int cutSize(const PartitionGraph &graph, const std::vector<int> &parts) {
+    int cut = 0;
+    for (const auto &edge : graph.edges) {
+        size_t a = size_t(edge.a), b = size_t(edge.b);
+        if ((a < parts.size()) && (b < parts.size()) &&
+            (parts[a] != parts[b])) {
+            ++cut;
+        }
+    }
+
+    return cut;
+}
+
+} // namespace qnodes
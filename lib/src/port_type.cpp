@@ -0,0 +1,86 @@
+#include <qnodes/port_type.hpp>
+
+namespace qnodes {
+
+const PortTypeId PortTypeRegistry::anyType = 0;
+const PortTypeId PortTypeRegistry::invalidType = -1;
+const int PortTypeRegistry::maxTypes = 64;
+
+PortTypeRegistry &PortTypeRegistry::global() {
+    static PortTypeRegistry registry;
+    return registry;
+}
+
+PortTypeRegistry::PortTypeRegistry() { registerType("any"); }
+
+PortTypeId PortTypeRegistry::registerType(const QByteArray &name) {
+    auto it = m_ids.constFind(name);
+    if (it != m_ids.constEnd()) {
+        return it.value();
+    }
+
+    if (typeCount() >= maxTypes) {
+        qWarning("qnodes: too many port types, '%s' cannot be connected",
+                 name.constData());
+        return invalidType;
+    }
+
+    PortTypeId id = typeCount();
+    m_ids.insert(name, id);
+    m_names.push_back(name);
+    m_conversions.push_back(maskOf(id));
+    return id;
+}
+
+PortTypeId PortTypeRegistry::typeId(const QByteArray &name) const {
+    return m_ids.value(name, invalidType);
+}
+
+QByteArray PortTypeRegistry::typeName(PortTypeId id) const {
+    if ((id < 0) || (id >= typeCount())) {
+        return {};
+    }
+
+    return m_names[static_cast<size_t>(id)];
+}
+
+int PortTypeRegistry::typeCount() const {
+    return static_cast<int>(m_names.size());
+}
+
+void PortTypeRegistry::addConversion(PortTypeId from, PortTypeId to) {
+    if ((from >= 0) && (from < typeCount())) {
+        m_conversions[static_cast<size_t>(from)] |= maskOf(to);
+    }
+}
+
+PortTypeMask PortTypeRegistry::maskOf(PortTypeId id) {
+    if ((id < 0) || (id >= maxTypes)) {
+        return 0;
+    }
+
+    return PortTypeMask(1) << id;
+}
+
+PortTypeMask PortTypeRegistry::convertibleTo(PortTypeId from) const {
+    if ((from < 0) || (from >= typeCount())) {
+        return 0;
+    }
+
+    return m_conversions[static_cast<size_t>(from)];
+}
+
+bool PortTypeRegistry::canConnect(PortTypeId from,
+                                  PortTypeMask accepted) const {
+    if ((from < 0) || (from >= typeCount())) {
+        return false;
+    }
+
+    if ((from == anyType) || (accepted & maskOf(anyType))) {
+        return true;
+    }
+
+    return (convertibleTo(from) & accepted) != 0;
+}
+
+} // namespace qnodes
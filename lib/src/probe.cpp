@@ -0,0 +1,251 @@
+#include <QPointer>
+#include <QTimer>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <qnodes/connection.hpp>
+#include <qnodes/node.hpp>
+#include <qnodes/probe.hpp>
+#include <qnodes/scene.hpp>
+#include <unordered_map>
+
+namespace qnodes {
+
+const int Probe::capacity = 256;
+const int Probe::samplesPerBlock = 8;
+const int ProbeMonitor::refreshInterval = 33;
+
+static const quint64 ringMask = quint64(Probe::capacity) - 1;
+
+Probe::Probe() : m_ring(new std::atomic<double>[size_t(capacity)]) {
+    for (int i = 0; i < capacity; ++i) {
+        m_ring[size_t(i)].store(0.0, std::memory_order_relaxed);
+    }
+
+    clear();
+}
+
+Probe::~Probe() = default;
+
+void Probe::write(double value) {
+    if (std::isnan(value)) {
+        return;
+    }
+
+    include(value);
+    push(value);
+}
+
+void Probe::write(const float *values, int count) {
+    if (count <= 0) {
+        return;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        if (!std::isnan(values[i])) {
+            include(values[i]);
+        }
+    }
+
+    int picks = std::min(count, samplesPerBlock);
+    for (int i = 1; i <= picks; ++i) {
+        float value = values[qint64(i) * count / picks - 1];
+        if (!std::isnan(value)) {
+            push(value);
+        }
+    }
+}
+
+void Probe::sampleOutputs(Node *node, const QVariantList &outputs) {
+    int count = std::min(outputs.size(), node->slotCount(Slot::Output));
+
+    for (int i = 0; i < count; ++i) {
+        Slot *slot = node->slot(Slot::Output, i);
+        for (Connection *conn : slot->connections()) {
+            std::shared_ptr<Probe> probe = conn->probe();
+            if (!probe || (conn->sourceSlot() != slot)) {
+                continue;
+            }
+
+            bool ok = false;
+            double value = outputs[i].toDouble(&ok);
+            if (ok) {
+                probe->write(value);
+            }
+        }
+    }
+}
+
+Probe::Summary Probe::summary() const {
+    Summary summary;
+    summary.count = qint64(m_written.load(std::memory_order_acquire) -
+                           m_cleared.load(std::memory_order_acquire));
+    if (summary.count > 0) {
+        summary.current = m_current.load(std::memory_order_relaxed);
+        summary.min = m_min.load(std::memory_order_relaxed);
+        summary.max = m_max.load(std::memory_order_relaxed);
+    }
+
+    return summary;
+}
+
+void Probe::read(std::vector<double> *samples) const {
+    const quint64 size = quint64(capacity);
+    samples->clear();
+
+    quint64 end = m_written.load(std::memory_order_acquire);
+    quint64 begin = std::max(m_cleared.load(std::memory_order_acquire),
+                             (end > size) ? end - size : 0);
+
+    for (quint64 i = begin; i < end; ++i) {
+        samples->push_back(
+            m_ring[i & ringMask].load(std::memory_order_relaxed));
+    }
+
+    // Writers may have lapped the oldest entries while they were read
+    quint64 now = m_written.load(std::memory_order_acquire);
+    quint64 oldest = (now > size) ? now - size : 0;
+    if (oldest > begin) {
+        auto stale = qint64(std::min<quint64>(oldest - begin, samples->size()));
+        samples->erase(samples->begin(), samples->begin() + stale);
+    }
+}
+
+quint64 Probe::writeCount() const {
+    return m_written.load(std::memory_order_acquire);
+}
+
+void Probe::clear() {
+    m_min.store(std::numeric_limits<double>::infinity(),
+                std::memory_order_relaxed);
+    m_max.store(-std::numeric_limits<double>::infinity(),
+                std::memory_order_relaxed);
+    m_cleared.store(m_written.load(std::memory_order_acquire),
+                    std::memory_order_release);
+}
+
+// The index is claimed before the value is stored, so a reader racing with
+// a writer may see the previous value of that entry for one refresh.
+void Probe::push(double value) {
+    quint64 index = m_written.fetch_add(1, std::memory_order_acq_rel);
+    m_ring[index & ringMask].store(value, std::memory_order_relaxed);
+    m_current.store(value, std::memory_order_relaxed);
+}
+
+void Probe::include(double value) {
+    double low = m_min.load(std::memory_order_relaxed);
+    while ((value < low) && !m_min.compare_exchange_weak(
+                                low, value, std::memory_order_relaxed)) {
+    }
+
+    double high = m_max.load(std::memory_order_relaxed);
+    while ((value > high) && !m_max.compare_exchange_weak(
+                                 high, value, std::memory_order_relaxed)) {
+    }
+}
+
+struct ProbeMonitor::Impl {
+    ProbeMonitor &self;
+    QPointer<Scene> scene;
+    QTimer timer;
+
+    // Write count at the last repaint
+    std::unordered_map<Connection *, quint64> probed;
+
+    explicit Impl(ProbeMonitor &self) : self(self) {
+        timer.setInterval(refreshInterval);
+    }
+
+    void refresh() {
+        for (auto &entry : probed) {
+            std::shared_ptr<Probe> probe = entry.first->probe();
+            quint64 written = probe ? probe->writeCount() : 0;
+            if (written != entry.second) {
+                entry.second = written;
+                entry.first->update();
+            }
+        }
+    }
+
+    void track(Connection *connection) {
+        std::shared_ptr<Probe> probe = connection->probe();
+        if (probe && probed.emplace(connection, probe->writeCount()).second) {
+            timer.start();
+        }
+    }
+
+    void forget(Connection *connection) {
+        probed.erase(connection);
+        if (probed.empty()) {
+            timer.stop();
+        }
+    }
+};
+
+ProbeMonitor::ProbeMonitor(Scene *scene, QObject *parent)
+    : QObject(parent), m_impl(new Impl(*this)) {
+    m_impl->scene = scene;
+
+    connect(&m_impl->timer, &QTimer::timeout, this,
+            [this]() { m_impl->refresh(); });
+
+    // Probed connections that leave the scene, e.g. into a collapsed
+    // group, keep their probe and are tracked again when they come back.
+    if (scene) {
+        for (Connection *conn : scene->connections()) {
+            m_impl->track(conn);
+        }
+
+        connect(scene, &Scene::connectionAdded, this,
+                [this](Connection *conn) { m_impl->track(conn); });
+        connect(scene, &Scene::connectionRemoved, this,
+                [this](Connection *conn) { m_impl->forget(conn); });
+    }
+}
+
+ProbeMonitor::~ProbeMonitor() {
+    clear();
+    delete m_impl;
+}
+
+std::shared_ptr<Probe> ProbeMonitor::attach(Connection *connection) {
+    std::shared_ptr<Probe> probe = connection->probe();
+    if (!probe) {
+        probe = std::make_shared<Probe>();
+        connection->setProbe(probe);
+    }
+
+    m_impl->track(connection);
+    return probe;
+}
+
+void ProbeMonitor::detach(Connection *connection) {
+    if (m_impl->probed.count(connection)) {
+        connection->setProbe(nullptr);
+        m_impl->forget(connection);
+    }
+}
+
+void ProbeMonitor::clear() {
+    for (const auto &entry : m_impl->probed) {
+        entry.first->setProbe(nullptr);
+    }
+
+    m_impl->probed.clear();
+    m_impl->timer.stop();
+}
+
+bool ProbeMonitor::isProbed(const Connection *connection) const {
+    return m_impl->probed.count(const_cast<Connection *>(connection)) != 0;
+}
+
+std::vector<Connection *> ProbeMonitor::probedConnections() const {
+    std::vector<Connection *> connections;
+    for (const auto &entry : m_impl->probed) {
+        connections.push_back(entry.first);
+    }
+
+    return connections;
+}
+
+} // namespace qnodes
@@ -0,0 +1,1165 @@
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QEventLoop>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QPointer>
+#include <QProcess>
+#include <QTimer>
+#include <QtEndian>
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <qnodes/connection.hpp>
+#include <qnodes/node.hpp>
+#include <qnodes/partition.hpp>
+#include <qnodes/probe.hpp>
+#include <qnodes/process_executor.hpp>
+#include <qnodes/scene.hpp>
+#include <qnodes/shared_ring.hpp>
+#include <tuple>
+#include <unordered_map>
+
+namespace qnodes {
+
+const qint64 ProcessExecutor::defaultRingSize = 1024 * 1024;
+const int ProcessExecutor::killTimeout = 2000;
+const int ProcessExecutor::defaultWorkerTimeout = 30000;
+
+namespace {
+
+// Control messages; each is a QByteArray starting with the type.
+enum MessageType : quint8 {
+    Hello,         // worker: partition
+    Load,          // executor: snapshot, ring key prefix, bindings
+    Run,           // executor
+    DataReady,     // either way: channel
+    SpaceReady,    // either way: channel
+    ChannelClosed, // either way: channel
+    Result,        // worker: node ID, outputs
+    Finished,      // worker
+    Error          // worker: reason; its partition cannot be evaluated
+};
+
+// A node slot fed by, or feeding, a cross-partition channel
+struct Binding {
+    quint64 node;
+    qint32 slot;
+    qint32 channel;
+};
+
+QDataStream &operator<<(QDataStream &out, const Binding &binding) {
+    return out << binding.node << binding.slot << binding.channel;
+}
+
+QDataStream &operator>>(QDataStream &in, Binding &binding) {
+    return in >> binding.node >> binding.slot >> binding.channel;
+}
+
+QDataStream &operator<<(QDataStream &out,
+                        const std::vector<Binding> &bindings) {
+    out << quint32(bindings.size());
+    for (const Binding &binding : bindings) {
+        out << binding;
+    }
+
+    return out;
+}
+
+QDataStream &operator>>(QDataStream &in, std::vector<Binding> &bindings) {
+    quint32 count = 0;
+    in >> count;
+
+    bindings.clear();
+    for (quint32 i = 0; (i < count) && (in.status() == QDataStream::Ok);
+         ++i) {
+        Binding binding{};
+        in >> binding;
+        bindings.push_back(binding);
+    }
+
+    return in;
+}
+
+template <typename... Args>
+QByteArray message(MessageType type, const Args &... args) {
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << quint8(type);
+
+    ((void)std::initializer_list<int>{((void)(out << args), 0)...});
+    return data;
+}
+
+void sendMessage(QLocalSocket *socket, const QByteArray &data) {
+    QDataStream out(socket);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << data;
+}
+
+std::vector<QByteArray> receiveMessages(QLocalSocket *socket) {
+    std::vector<QByteArray> messages;
+    QDataStream in(socket);
+    in.setVersion(QDataStream::Qt_5_0);
+
+    for (;;) {
+        in.startTransaction();
+
+        QByteArray data;
+        in >> data;
+        if (!in.commitTransaction()) {
+            break;
+        }
+
+        messages.push_back(data);
+    }
+
+    return messages;
+}
+
+QString ringKey(const QString &prefix, int channel) {
+    return prefix + QString::number(channel);
+}
+
+// Values in a ring are framed by a little-endian 32-bit length.
+QByteArray encodeValue(const QVariant &value) {
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << value;
+
+    QByteArray frame(4, '\0');
+    qToLittleEndian<quint32>(quint32(payload.size()), frame.data());
+    return frame + payload;
+}
+
+bool decodeValue(QByteArray &buffer, QVariant *value) {
+    if (buffer.size() < 4) {
+        return false;
+    }
+
+    quint32 size = qFromLittleEndian<quint32>(buffer.constData());
+    if (quint64(buffer.size()) < 4 + quint64(size)) {
+        return false;
+    }
+
+    QDataStream in(buffer.mid(4, int(size)));
+    in.setVersion(QDataStream::Qt_5_0);
+    in >> *value;
+
+    buffer.remove(0, 4 + int(size));
+    return true;
+}
+
+} // namespace
+
+struct ProcessExecutor::Impl {
+    struct Channel {
+        int producer;
+        int consumer;
+        std::unique_ptr<SharedRing> ring;
+    };
+
+    struct Worker {
+        enum State { Starting, Running, Finished, Failed };
+
+        std::vector<Node *> nodes;
+        std::vector<Binding> inputs;
+        std::vector<Binding> outputs;
+        QProcess *process = nullptr;
+        QLocalSocket *socket = nullptr;
+        QTimer *timer = nullptr; // restarted by every message from it
+        std::vector<QByteArray> queued; // sent once the worker connects
+        State state = Starting;
+    };
+
+    ProcessExecutor &self;
+    QPointer<Scene> scene;
+    QString program;
+    int partitionCount = 2;
+    qint64 ringSize = defaultRingSize;
+    int workerTimeout = defaultWorkerTimeout;
+
+    QLocalServer *server = nullptr;
+    QString ringPrefix;
+    std::vector<Worker> workers;
+    std::vector<Channel> channels;
+    std::unordered_map<quint64, Node *> nodeById;
+    bool running = false;
+
+    // Results of the last run
+    std::unordered_map<const Node *, int> partitionOf;
+    std::unordered_map<const Node *, QVariantList> results;
+    int failed = 0;
+
+    explicit Impl(ProcessExecutor &self) : self(self) {}
+
+    std::vector<Node *> collectNodes() const {
+        std::vector<Node *> nodes;
+        for (Node *node : scene->nodes()) {
+            if (!node->typeName().isEmpty()) {
+                nodes.push_back(node);
+            }
+        }
+
+        return nodes;
+    }
+
+    // One channel per output and consuming partition, so that a value is
+    // sent to each partition once.
+    void bindChannels(const std::vector<Node *> &nodes) {
+        std::map<std::tuple<const Node *, int, int>, int> channelOf;
+
+        for (Node *node : nodes) {
+            int target = partitionOf.at(node);
+
+            for (int i = 0; i < node->slotCount(Slot::Input); ++i) {
+                Slot *input = node->slot(Slot::Input, i);
+
+                // Only the first connection of an input slot is used.
+                for (Connection *conn : input->connections()) {
+                    Slot *source = conn->sourceSlot();
+                    if ((conn->targetSlot() != input) || !source) {
+                        continue;
+                    }
+
+                    auto it = partitionOf.find(source->node());
+                    if ((it == partitionOf.end()) || (it->second == target)) {
+                        break;
+                    }
+
+                    int output = source->node()->slotIndex(source);
+                    auto key = std::make_tuple(source->node(), output, target);
+                    auto channel = channelOf.find(key);
+
+                    if (channel == channelOf.end()) {
+                        int index = static_cast<int>(channels.size());
+                        channel = channelOf.emplace(key, index).first;
+                        channels.push_back(Channel{it->second, target, {}});
+                        workers[size_t(it->second)].outputs.push_back(
+                            Binding{source->node()->id(), output, index});
+                    }
+
+                    workers[size_t(target)].inputs.push_back(
+                        Binding{node->id(), i, channel->second});
+                    break;
+                }
+            }
+        }
+    }
+
+    bool createRings() {
+        for (size_t i = 0; i < channels.size(); ++i) {
+            channels[i].ring.reset(new SharedRing());
+            if (!channels[i].ring->create(ringKey(ringPrefix, int(i)),
+                                          ringSize)) {
+                qWarning("qnodes: cannot create shared memory: %s",
+                         qPrintable(channels[i].ring->errorString()));
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void startWorker(int partition) {
+        Worker &worker = workers[size_t(partition)];
+
+        worker.process = new QProcess(&self);
+        worker.process->setProcessChannelMode(QProcess::ForwardedChannels);
+
+        QObject::connect(
+            worker.process,
+            QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+            &self, [this, partition](int code, QProcess::ExitStatus status) {
+                workerExited(partition,
+                             (status == QProcess::CrashExit)
+                                 ? QString("worker crashed")
+                                 : QString("worker exited with code %1")
+                                       .arg(code));
+            });
+        QObject::connect(worker.process, &QProcess::errorOccurred, &self,
+                         [this, partition](QProcess::ProcessError error) {
+                             if (error == QProcess::FailedToStart) {
+                                 workerExited(partition,
+                                              "worker failed to start");
+                             }
+                         });
+
+        if (workerTimeout > 0) {
+            worker.timer = new QTimer(&self);
+            worker.timer->setSingleShot(true);
+            QObject::connect(worker.timer, &QTimer::timeout, &self,
+                             [this, partition]() {
+                                 failWorker(partition,
+                                            QString("worker timed out after "
+                                                    "%1 ms")
+                                                .arg(workerTimeout));
+                             });
+            worker.timer->start(workerTimeout);
+        }
+
+        worker.process->start(program, {server->serverName(),
+                                        QString::number(partition)});
+    }
+
+    bool start() {
+        std::vector<Node *> nodes = collectNodes();
+        if (nodes.empty()) {
+            return false;
+        }
+
+        PartitionOptions options;
+        options.partitions =
+            std::max(1, std::min(partitionCount, int(nodes.size())));
+        std::vector<int> parts =
+            partitionGraph(PartitionGraph::fromNodes(nodes), options);
+
+        workers.resize(size_t(options.partitions));
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            partitionOf.emplace(nodes[i], parts[i]);
+            workers[size_t(parts[i])].nodes.push_back(nodes[i]);
+            nodeById.emplace(nodes[i]->id(), nodes[i]);
+        }
+
+        bindChannels(nodes);
+
+        static int serverCount = 0;
+        QString name = QString("qnodes-%1-%2")
+                           .arg(QCoreApplication::applicationPid())
+                           .arg(++serverCount);
+
+        server = new QLocalServer(&self);
+        QLocalServer::removeServer(name);
+        if (!server->listen(name)) {
+            qWarning("qnodes: cannot listen on %s: %s", qPrintable(name),
+                     qPrintable(server->errorString()));
+            return false;
+        }
+
+        QObject::connect(server, &QLocalServer::newConnection, &self,
+                         [this]() { acceptWorkers(); });
+
+        ringPrefix = name + "-";
+        if (!createRings()) {
+            return false;
+        }
+
+        for (Node *node : nodes) {
+            node->setEvaluationState(Node::Pending);
+        }
+
+        running = true;
+
+        for (size_t i = 0; i < workers.size(); ++i) {
+            if (workers[i].nodes.empty()) {
+                workers[i].state = Worker::Finished;
+            } else {
+                startWorker(int(i));
+            }
+        }
+
+        return true;
+    }
+
+    void acceptWorkers() {
+        while (QLocalSocket *socket = server->nextPendingConnection()) {
+            QObject::connect(socket, &QLocalSocket::readyRead, &self,
+                             [this, socket]() { receive(socket); });
+        }
+    }
+
+    void send(int partition, const QByteArray &data) {
+        Worker &worker = workers[size_t(partition)];
+        if ((worker.state == Worker::Finished) ||
+            (worker.state == Worker::Failed)) {
+            return;
+        }
+
+        if (worker.socket) {
+            sendMessage(worker.socket, data);
+        } else {
+            worker.queued.push_back(data);
+        }
+    }
+
+    int partitionOfSocket(QLocalSocket *socket) const {
+        for (size_t i = 0; i < workers.size(); ++i) {
+            if (workers[i].socket == socket) {
+                return int(i);
+            }
+        }
+
+        return -1;
+    }
+
+    void receive(QLocalSocket *socket) {
+        for (const QByteArray &data : receiveMessages(socket)) {
+            if (!running) {
+                return;
+            }
+
+            QDataStream in(data);
+            in.setVersion(QDataStream::Qt_5_0);
+
+            quint8 type = 0;
+            in >> type;
+
+            if (type == Hello) {
+                qint32 partition = -1;
+                in >> partition;
+                hello(socket, partition);
+                continue;
+            }
+
+            int partition = partitionOfSocket(socket);
+            if (partition < 0) {
+                continue;
+            }
+
+            if (QTimer *timer = workers[size_t(partition)].timer) {
+                timer->start();
+            }
+
+            handle(partition, type, in);
+        }
+    }
+
+    void hello(QLocalSocket *socket, int partition) {
+        if ((partition < 0) || (partition >= int(workers.size())) ||
+            workers[size_t(partition)].socket) {
+            socket->abort();
+            return;
+        }
+
+        Worker &worker = workers[size_t(partition)];
+        worker.socket = socket;
+        worker.state = Worker::Running;
+        if (worker.timer) {
+            worker.timer->start();
+        }
+
+        QByteArray snapshot = GraphSnapshot::capture(worker.nodes)->toBinary();
+        sendMessage(socket, message(Load, snapshot, ringPrefix, worker.inputs,
+                                    worker.outputs));
+        sendMessage(socket, message(Run));
+
+        for (const QByteArray &data : worker.queued) {
+            sendMessage(socket, data);
+        }
+        worker.queued.clear();
+    }
+
+    void handle(int partition, quint8 type, QDataStream &in) {
+        qint32 channel = -1;
+
+        switch (type) {
+        case DataReady:
+        case SpaceReady:
+        case ChannelClosed: {
+            in >> channel;
+            if ((channel < 0) || (channel >= int(channels.size()))) {
+                return;
+            }
+
+            // Forwarded to the other end of the channel
+            const Channel &c = channels[size_t(channel)];
+            int other = (c.producer == partition) ? c.consumer : c.producer;
+            send(other, message(MessageType(type), channel));
+            return;
+        }
+        case Result: {
+            quint64 id = 0;
+            QVariantList outputs;
+            in >> id >> outputs;
+
+            auto it = nodeById.find(id);
+            if ((it != nodeById.end()) &&
+                (partitionOf.at(it->second) == partition)) {
+                results[it->second] = outputs;
+                Probe::sampleOutputs(it->second, outputs);
+                it->second->setEvaluationState(Node::Done);
+            }
+            return;
+        }
+        case Finished:
+            workers[size_t(partition)].state = Worker::Finished;
+            if (QTimer *timer = workers[size_t(partition)].timer) {
+                timer->stop();
+            }
+
+            finishIfDone();
+            return;
+        case Error: {
+            QString reason;
+            in >> reason;
+            failWorker(partition, reason);
+            return;
+        }
+        default:
+            return;
+        }
+    }
+
+    void workerExited(int partition, const QString &reason) {
+        if (!running) {
+            return;
+        }
+
+        Worker &worker = workers[size_t(partition)];
+        if ((worker.state == Worker::Finished) ||
+            (worker.state == Worker::Failed)) {
+            return;
+        }
+
+        worker.state = Worker::Failed;
+        worker.queued.clear();
+        ++failed;
+
+        if (worker.timer) {
+            worker.timer->stop();
+        }
+
+        for (Node *node : worker.nodes) {
+            if (node->evaluationState() != Node::Done) {
+                node->setEvaluationState(Node::Failed);
+            }
+        }
+
+        // Consumers stop waiting for its values, producers stop writing
+        // for it.
+        for (size_t i = 0; i < channels.size(); ++i) {
+            const Channel &c = channels[i];
+            if (c.producer == partition) {
+                send(c.consumer, message(ChannelClosed, qint32(i)));
+            } else if (c.consumer == partition) {
+                send(c.producer, message(ChannelClosed, qint32(i)));
+            }
+        }
+
+        emit self.partitionFailed(partition, reason);
+        finishIfDone();
+    }
+
+    // For a worker that is still running but cannot finish; it is killed
+    // before anything else, since failing it may end the run.
+    void failWorker(int partition, const QString &reason) {
+        if (QProcess *process = workers[size_t(partition)].process) {
+            process->kill();
+        }
+
+        workerExited(partition, reason);
+    }
+
+    void finishIfDone() {
+        for (const Worker &worker : workers) {
+            if ((worker.state == Worker::Starting) ||
+                (worker.state == Worker::Running)) {
+                return;
+            }
+        }
+
+        stop();
+        emit self.evaluated();
+    }
+
+    // Workers quit when the executor disconnects; those that do not are
+    // killed after a while.
+    void stop() {
+        running = false;
+
+        for (Worker &worker : workers) {
+            for (Node *node : worker.nodes) {
+                Node::EvaluationState state = node->evaluationState();
+                if ((state == Node::Pending) || (state == Node::Running)) {
+                    node->setEvaluationState(Node::Idle);
+                }
+            }
+
+            if (QProcess *process = worker.process) {
+                QObject::disconnect(process, nullptr, &self, nullptr);
+                QObject::connect(
+                    process,
+                    QOverload<int, QProcess::ExitStatus>::of(
+                        &QProcess::finished),
+                    process, &QObject::deleteLater);
+                QTimer::singleShot(killTimeout, process, &QProcess::kill);
+            }
+
+            if (worker.socket) {
+                QObject::disconnect(worker.socket, nullptr, &self, nullptr);
+                worker.socket->disconnectFromServer();
+            }
+
+            // May be called from the timer's timeout handler
+            if (worker.timer) {
+                worker.timer->stop();
+                worker.timer->deleteLater();
+            }
+        }
+
+        if (server) {
+            // May be called from a socket's readyRead handler
+            server->close();
+            server->deleteLater();
+            server = nullptr;
+        }
+
+        workers.clear();
+        channels.clear();
+        nodeById.clear();
+    }
+
+    void reset() {
+        partitionOf.clear();
+        results.clear();
+        failed = 0;
+    }
+};
+
+ProcessExecutor::ProcessExecutor(Scene *scene, const QString &workerProgram,
+                                 QObject *parent)
+    : QObject(parent), m_impl(new Impl(*this)) {
+    m_impl->scene = scene;
+    m_impl->program = workerProgram;
+
+    if (scene) {
+        connect(scene, &Scene::nodeRemoved, this, [this](Node *node) {
+            if (m_impl->running && m_impl->partitionOf.count(node)) {
+                cancel();
+            }
+
+            m_impl->partitionOf.erase(node);
+            m_impl->results.erase(node);
+        });
+    }
+}
+
+ProcessExecutor::~ProcessExecutor() {
+    cancel();
+    delete m_impl;
+}
+
+Scene *ProcessExecutor::scene() const { return m_impl->scene; }
+
+QString ProcessExecutor::workerProgram() const { return m_impl->program; }
+
+void ProcessExecutor::setPartitionCount(int count) {
+    m_impl->partitionCount = std::max(1, count);
+}
+
+int ProcessExecutor::partitionCount() const { return m_impl->partitionCount; }
+
+void ProcessExecutor::setRingSize(qint64 bytes) {
+    // QSharedMemory sizes are ints
+    m_impl->ringSize = qBound<qint64>(64, bytes, 1 << 30);
+}
+
+qint64 ProcessExecutor::ringSize() const { return m_impl->ringSize; }
+
+void ProcessExecutor::setWorkerTimeout(int msecs) {
+    m_impl->workerTimeout = std::max(0, msecs);
+}
+
+int ProcessExecutor::workerTimeout() const { return m_impl->workerTimeout; }
+
+bool ProcessExecutor::evaluate() {
+    if (m_impl->running || !m_impl->scene) {
+        return false;
+    }
+
+    m_impl->reset();
+    if (!m_impl->start()) {
+        m_impl->stop();
+        m_impl->reset();
+        return false;
+    }
+
+    return true;
+}
+
+void ProcessExecutor::cancel() {
+    if (!m_impl->running) {
+        return;
+    }
+
+    for (const auto &worker : m_impl->workers) {
+        if (worker.process) {
+            worker.process->kill();
+        }
+    }
+
+    m_impl->stop();
+}
+
+bool ProcessExecutor::isRunning() const { return m_impl->running; }
+
+int ProcessExecutor::partitionOf(const Node *node) const {
+    auto it = m_impl->partitionOf.find(node);
+    return (it != m_impl->partitionOf.end()) ? it->second : -1;
+}
+
+QVariantList ProcessExecutor::outputs(const Node *node) const {
+    auto it = m_impl->results.find(node);
+    return (it != m_impl->results.end()) ? it->second : QVariantList();
+}
+
+QVariant ProcessExecutor::value(const Slot *outputSlot) const {
+    Node *node = outputSlot ? outputSlot->node() : nullptr;
+    if (!node) {
+        return {};
+    }
+
+    return outputs(node).value(node->slotIndex(outputSlot));
+}
+
+int ProcessExecutor::failedPartitionCount() const { return m_impl->failed; }
+
+namespace {
+
+// The worker side: evaluates its partition as inputs arrive and streams
+// outputs into the rings of the partitions that need them.
+class WorkerSession {
+public:
+    WorkerSession(int partition, const GraphSnapshot::NodeFactory &factory)
+        : m_partition(partition), m_factory(factory) {}
+
+    bool connectTo(const QString &serverName) {
+        m_socket.connectToServer(serverName);
+        if (!m_socket.waitForConnected(ProcessExecutor::killTimeout)) {
+            return false;
+        }
+
+        QObject::connect(&m_socket, &QLocalSocket::readyRead, &m_socket,
+                         [this]() { receive(); });
+        QObject::connect(&m_socket, &QLocalSocket::disconnected, &m_loop,
+                         &QEventLoop::quit);
+
+        sendMessage(&m_socket, message(Hello, qint32(m_partition)));
+        return true;
+    }
+
+    int exec() { return m_loop.exec(); }
+
+private:
+    struct Source {
+        Node *node = nullptr; // local source
+        int output = -1;
+        int channel = -1;
+    };
+
+    struct NodeState {
+        std::vector<Source> sources;
+        QVariantList inputs;
+        int pending = 0;
+        bool done = false;
+        std::vector<std::pair<Node *, int>> dependents; // node, input
+        std::vector<std::pair<int, int>> channels;      // output, channel
+    };
+
+    struct InChannel {
+        SharedRing ring;
+        QByteArray buffer;
+        std::vector<std::pair<Node *, int>> consumers;
+        bool received = false;
+        bool closed = false;
+    };
+
+    struct OutChannel {
+        SharedRing ring;
+        QByteArray pending;
+        int offset = 0;
+        bool closed = false;
+    };
+
+    int m_partition;
+    GraphSnapshot::NodeFactory m_factory;
+    QLocalSocket m_socket;
+    QEventLoop m_loop;
+    Scene m_scene;
+
+    std::vector<Node *> m_nodes;
+    std::unordered_map<Node *, NodeState> m_state;
+    std::unordered_map<int, std::unique_ptr<InChannel>> m_in;
+    std::unordered_map<int, std::unique_ptr<OutChannel>> m_out;
+    std::vector<Node *> m_ready;
+    bool m_loaded = false;
+    bool m_finished = false;
+
+    void send(const QByteArray &data) { sendMessage(&m_socket, data); }
+
+    // The executor fails the whole partition and closes its channels;
+    // nothing is evaluated here after that.
+    void fail(const QString &reason) {
+        m_ready.clear();
+        m_in.clear();
+        m_out.clear();
+        m_finished = true;
+        send(message(Error, reason));
+    }
+
+    void receive() {
+        for (const QByteArray &data : receiveMessages(&m_socket)) {
+            QDataStream in(data);
+            in.setVersion(QDataStream::Qt_5_0);
+
+            quint8 type = 0;
+            qint32 channel = -1;
+            in >> type;
+
+            switch (type) {
+            case Load:
+                load(in);
+                break;
+            case Run:
+                run();
+                break;
+            case DataReady:
+                in >> channel;
+                readChannel(channel);
+                break;
+            case SpaceReady:
+                in >> channel;
+                flushChannel(channel);
+                break;
+            case ChannelClosed:
+                in >> channel;
+                closeChannel(channel);
+                break;
+            default:
+                break;
+            }
+        }
+
+        finishIfDone();
+    }
+
+    void load(QDataStream &in) {
+        QByteArray snapshotData;
+        QString ringPrefix;
+        std::vector<Binding> inputs, outputs;
+        in >> snapshotData >> ringPrefix >> inputs >> outputs;
+
+        m_loaded = true;
+
+        auto snapshot = GraphSnapshot::fromBinary(snapshotData);
+        if (!snapshot) {
+            fail("invalid graph snapshot");
+            return;
+        }
+
+        m_nodes = snapshot->instantiate(&m_scene, m_factory, {},
+                                        GraphSnapshot::KeepIds);
+        if (m_nodes.size() != snapshot->nodes().size()) {
+            fail("cannot create all nodes of the partition");
+            return;
+        }
+
+        std::unordered_map<quint64, Node *> byId;
+        for (Node *node : m_nodes) {
+            byId.emplace(node->id(), node);
+            NodeState &state = m_state[node];
+            state.sources.resize(size_t(node->slotCount(Slot::Input)));
+            state.inputs.reserve(int(state.sources.size()));
+            for (size_t i = 0; i < state.sources.size(); ++i) {
+                state.inputs.append(QVariant());
+            }
+        }
+
+        for (const Binding &binding : inputs) {
+            auto it = byId.find(binding.node);
+            if ((it == byId.end()) || (binding.slot < 0) ||
+                (size_t(binding.slot) >= m_state[it->second].sources.size())) {
+                fail("invalid input binding");
+                return;
+            }
+
+            std::unique_ptr<InChannel> &channel = m_in[binding.channel];
+            if (!channel) {
+                channel.reset(new InChannel());
+                channel->ring.attach(ringKey(ringPrefix, binding.channel));
+            }
+
+            channel->consumers.emplace_back(it->second, binding.slot);
+            m_state[it->second].sources.at(size_t(binding.slot)).channel =
+                binding.channel;
+        }
+
+        for (const Binding &binding : outputs) {
+            auto it = byId.find(binding.node);
+            if (it == byId.end()) {
+                fail("invalid output binding");
+                return;
+            }
+
+            std::unique_ptr<OutChannel> &channel = m_out[binding.channel];
+            if (!channel) {
+                channel.reset(new OutChannel());
+                channel->ring.attach(ringKey(ringPrefix, binding.channel));
+            }
+
+            m_state[it->second].channels.emplace_back(binding.slot,
+                                                      binding.channel);
+        }
+
+        for (Node *node : m_nodes) {
+            NodeState &state = m_state[node];
+
+            for (size_t i = 0; i < state.sources.size(); ++i) {
+                Source &source = state.sources[i];
+                if (source.channel < 0) {
+                    findLocalSource(node, int(i), &source);
+                }
+
+                if (source.node) {
+                    m_state[source.node].dependents.emplace_back(node, int(i));
+                }
+
+                if (source.node || (source.channel >= 0)) {
+                    ++state.pending;
+                }
+            }
+
+            if (state.pending == 0) {
+                m_ready.push_back(node);
+            }
+        }
+
+        // Rings that could not be attached count as closed, on both ends
+        std::vector<int> detached;
+        for (const auto &entry : m_in) {
+            if (!entry.second->ring.isAttached()) {
+                detached.push_back(entry.first);
+            }
+        }
+
+        for (const auto &entry : m_out) {
+            if (!entry.second->ring.isAttached()) {
+                detached.push_back(entry.first);
+            }
+        }
+
+        for (int index : detached) {
+            abandonChannel(index);
+        }
+    }
+
+    void findLocalSource(Node *node, int input, Source *source) const {
+        Slot *slot = node->slot(Slot::Input, input);
+
+        for (Connection *conn : slot->connections()) {
+            Slot *sourceSlot = conn->sourceSlot();
+            if ((conn->targetSlot() == slot) && sourceSlot &&
+                m_state.count(sourceSlot->node())) {
+                source->node = sourceSlot->node();
+                source->output = sourceSlot->node()->slotIndex(sourceSlot);
+                return;
+            }
+        }
+    }
+
+    void deliver(Node *node, int input, const QVariant &value) {
+        NodeState &state = m_state[node];
+        if (state.done) {
+            return;
+        }
+
+        state.inputs[input] = value;
+        if (--state.pending == 0) {
+            m_ready.push_back(node);
+        }
+    }
+
+    void run() {
+        while (!m_ready.empty()) {
+            Node *node = m_ready.back();
+            m_ready.pop_back();
+
+            NodeState &state = m_state[node];
+            if (state.done) {
+                continue;
+            }
+
+            QVariantList outputs = node->compute(state.inputs);
+            state.done = true;
+            send(message(Result, node->id(), outputs));
+
+            for (const auto &entry : state.channels) {
+                OutChannel &channel = *m_out[entry.second];
+                if (!channel.closed) {
+                    channel.pending += encodeValue(outputs.value(entry.first));
+                    flushChannel(entry.second);
+                }
+            }
+
+            for (const auto &dependent : state.dependents) {
+                const Source &source = m_state[dependent.first]
+                                           .sources[size_t(dependent.second)];
+                deliver(dependent.first, dependent.second,
+                        outputs.value(source.output));
+            }
+        }
+    }
+
+    // Marks a node and everything downstream of it as done without
+    // computing it.
+    void skip(Node *node) {
+        std::vector<Node *> stack{node};
+
+        while (!stack.empty()) {
+            Node *current = stack.back();
+            stack.pop_back();
+
+            NodeState &state = m_state[current];
+            if (state.done) {
+                continue;
+            }
+
+            state.done = true;
+            for (const auto &entry : state.channels) {
+                OutChannel &channel = *m_out[entry.second];
+                if (!channel.closed) {
+                    channel.closed = true;
+                    send(message(ChannelClosed, qint32(entry.second)));
+                }
+            }
+
+            for (const auto &dependent : state.dependents) {
+                stack.push_back(dependent.first);
+            }
+        }
+    }
+
+    void readChannel(int index) {
+        auto it = m_in.find(index);
+        if ((it == m_in.end()) || it->second->closed) {
+            return;
+        }
+
+        InChannel &channel = *it->second;
+        qint64 available = channel.ring.bytesAvailable();
+        if (available < 0) {
+            abandonChannel(index);
+            return;
+        } else if (available == 0) {
+            return;
+        }
+
+        int size = channel.buffer.size();
+        channel.buffer.resize(size + int(available));
+        qint64 read =
+            channel.ring.read(channel.buffer.data() + size, available);
+        if (read < 0) {
+            abandonChannel(index);
+            return;
+        }
+
+        channel.buffer.resize(size + int(read));
+        send(message(SpaceReady, qint32(index)));
+
+        QVariant value;
+        if (!channel.received && decodeValue(channel.buffer, &value)) {
+            channel.received = true;
+            for (const auto &consumer : channel.consumers) {
+                deliver(consumer.first, consumer.second, value);
+            }
+
+            run();
+        }
+    }
+
+    void flushChannel(int index) {
+        auto it = m_out.find(index);
+        if ((it == m_out.end()) || it->second->closed) {
+            return;
+        }
+
+        OutChannel &channel = *it->second;
+        qint64 written = channel.ring.write(
+            channel.pending.constData() + channel.offset,
+            channel.pending.size() - channel.offset);
+
+        if (written < 0) {
+            abandonChannel(index);
+        } else if (written > 0) {
+            channel.offset += int(written);
+            if (channel.offset == channel.pending.size()) {
+                channel.pending.clear();
+                channel.offset = 0;
+            }
+
+            send(message(DataReady, qint32(index)));
+        }
+    }
+
+    void closeChannel(int index) {
+        auto out = m_out.find(index);
+        if (out != m_out.end()) {
+            out->second->closed = true;
+            out->second->pending.clear();
+        }
+
+        auto in = m_in.find(index);
+        if ((in == m_in.end()) || in->second->closed) {
+            return;
+        }
+
+        in->second->closed = true;
+        if (!in->second->received) {
+            for (const auto &consumer : in->second->consumers) {
+                skip(consumer.first);
+            }
+        }
+    }
+
+    // Closes a channel this side cannot use and tells the other end.
+    void abandonChannel(int index) {
+        closeChannel(index);
+        send(message(ChannelClosed, qint32(index)));
+    }
+
+    void finishIfDone() {
+        if (m_finished || !m_loaded) {
+            return;
+        }
+
+        for (Node *node : m_nodes) {
+            if (!m_state[node].done) {
+                return;
+            }
+        }
+
+        for (const auto &entry : m_out) {
+            if (!entry.second->closed && !entry.second->pending.isEmpty()) {
+                return;
+            }
+        }
+
+        m_finished = true;
+        send(message(Finished));
+    }
+};
+
+} // namespace
+
+int runProcessWorker(const QStringList &arguments,
+                     const GraphSnapshot::NodeFactory &factory) {
+    bool ok = false;
+    int partition = arguments.value(1).toInt(&ok);
+    if ((arguments.size() < 2) || !ok) {
+        qWarning("qnodes: worker expects a server name and a partition");
+        return 2;
+    }
+
+    WorkerSession session(partition, factory);
+    if (!session.connectTo(arguments.at(0))) {
+        qWarning("qnodes: worker cannot connect to %s",
+                 qPrintable(arguments.at(0)));
+        return 1;
+    }
+
+    return session.exec();
+}
+
+} // namespace qnodes
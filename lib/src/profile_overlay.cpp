@@ -0,0 +1,197 @@
+#include <QColor>
+#include <QPointer>
+#include <QTimer>
+#include <algorithm>
+#include <qnodes/connection.hpp>
+#include <qnodes/group_node.hpp>
+#include <qnodes/profile_overlay.hpp>
+#include <qnodes/profiler.hpp>
+#include <qnodes/scene.hpp>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace qnodes {
+
+const int ProfileOverlay::updateInterval = 250;
+const double ProfileOverlay::maxWidthScale = 4.0;
+
+struct ProfileOverlay::Impl {
+    ProfileOverlay &self;
+    QPointer<Scene> scene;
+    Profiler *profiler;
+    Metric metric = TotalTime;
+    QTimer timer;
+
+    // Nodes whose destruction makes the profiler forget them
+    std::unordered_set<const Node *> watched;
+
+    Impl(ProfileOverlay &self, Scene *scene, Profiler *profiler)
+        : self(self), scene(scene), profiler(profiler) {
+        timer.setInterval(updateInterval);
+    }
+
+    void watch(Node *node) {
+        if (!watched.insert(node).second) {
+            return;
+        }
+
+        QObject::connect(node, &QObject::destroyed, &self,
+                         [this, node]() {
+                             watched.erase(node);
+                             profiler->forget(node);
+                         });
+    }
+
+    qint64 valueOf(const Profiler::NodeStats &stats) const {
+        switch (metric) {
+        case TotalTime:
+            return stats.totalTime;
+        case MaxTime:
+            return stats.maxTime;
+        case CallCount:
+            return stats.calls;
+        case Memory:
+            return stats.peakMemory;
+        }
+
+        return 0;
+    }
+
+    // Collapsed groups show the sum of their members.
+    qint64 valueOf(const Node *node) const {
+        if (const GroupNode *group = qobject_cast<const GroupNode *>(node)) {
+            qint64 sum = 0;
+            for (Node *member : group->members()) {
+                sum += valueOf(member);
+            }
+
+            return sum;
+        }
+
+        return valueOf(profiler->stats(node));
+    }
+
+    qint64 bytesThrough(Slot *source) const {
+        while (GroupNode *group = qobject_cast<GroupNode *>(
+                   source ? source->node() : nullptr)) {
+            source = group->innerSlot(source);
+        }
+
+        if (!source || !source->node()) {
+            return 0;
+        }
+
+        Profiler::NodeStats stats = profiler->stats(source->node());
+        size_t output = static_cast<size_t>(source->node()->slotIndex(source));
+        return (output < stats.outputBytes.size()) ? stats.outputBytes[output]
+                                                   : 0;
+    }
+
+    // Yellow for cool nodes through to red for the hottest one.
+    static QColor heatColor(double t) {
+        QColor color = QColor::fromHsvF((1.0 - t) * (1.0 / 6.0), 0.9, 1.0);
+        color.setAlphaF(0.15 + 0.5 * t);
+        return color;
+    }
+
+    void update() {
+        if (!scene) {
+            return;
+        }
+
+        profiler->collect();
+
+        std::vector<Node *> nodes = scene->nodes();
+        std::vector<qint64> values(nodes.size());
+        qint64 maxValue = 0;
+
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            watch(nodes[i]);
+            if (GroupNode *group = qobject_cast<GroupNode *>(nodes[i])) {
+                for (Node *member : group->members()) {
+                    watch(member);
+                }
+            }
+
+            values[i] = valueOf(nodes[i]);
+            maxValue = std::max(maxValue, values[i]);
+        }
+
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            nodes[i]->setTintColor(
+                (values[i] > 0)
+                    ? heatColor(double(values[i]) / double(maxValue))
+                    : QColor());
+        }
+
+        std::vector<Connection *> connections = scene->connections();
+        std::vector<qint64> bytes(connections.size());
+        qint64 maxBytes = 0;
+
+        for (size_t i = 0; i < connections.size(); ++i) {
+            bytes[i] = bytesThrough(connections[i]->sourceSlot());
+            maxBytes = std::max(maxBytes, bytes[i]);
+        }
+
+        for (size_t i = 0; i < connections.size(); ++i) {
+            double t = (maxBytes > 0) ? double(bytes[i]) / double(maxBytes)
+                                      : 0.0;
+            connections[i]->setWidthScale(1.0 + (maxWidthScale - 1.0) * t);
+        }
+    }
+
+    void clear() {
+        if (!scene) {
+            return;
+        }
+
+        for (Node *node : scene->nodes()) {
+            node->setTintColor({});
+        }
+
+        for (Connection *conn : scene->connections()) {
+            conn->setWidthScale(1.0);
+        }
+    }
+};
+
+ProfileOverlay::ProfileOverlay(Scene *scene, Profiler *profiler,
+                               QObject *parent)
+    : QObject(parent), m_impl(new Impl(*this, scene, profiler)) {
+    connect(&m_impl->timer, &QTimer::timeout, this,
+            [this]() { m_impl->update(); });
+}
+
+ProfileOverlay::~ProfileOverlay() {
+    m_impl->clear();
+    delete m_impl;
+}
+
+void ProfileOverlay::setMetric(Metric metric) {
+    m_impl->metric = metric;
+    if (isEnabled()) {
+        m_impl->update();
+    }
+}
+
+ProfileOverlay::Metric ProfileOverlay::metric() const {
+    return m_impl->metric;
+}
+
+void ProfileOverlay::setEnabled(bool enabled) {
+    if (enabled) {
+        m_impl->update();
+        m_impl->timer.start();
+    } else {
+        m_impl->timer.stop();
+        m_impl->clear();
+    }
+}
+
+bool ProfileOverlay::isEnabled() const { return m_impl->timer.isActive(); }
+
+void ProfileOverlay::update() { m_impl->update(); }
+
+void ProfileOverlay::clear() { m_impl->clear(); }
+
+} // namespace qnodes
@@ -0,0 +1,201 @@
+#include <QMutex>
+#include <QMutexLocker>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <qnodes/profiler.hpp>
+#include <qnodes/spsc_queue.hpp>
+#include <unordered_map>
+
+namespace qnodes {
+
+const size_t Profiler::bufferCapacity = 4096;
+
+namespace {
+
+struct Sample {
+    const Node *node;
+    int output; // -1 for a call
+    qint64 nanoseconds;
+    qint64 bytes;
+};
+
+// Written only by the thread it belongs to, read only by collect(). Once
+// released by an exiting thread, the next new thread takes it over.
+struct SampleBuffer {
+    SpscQueue<Sample> samples{Profiler::bufferCapacity};
+    std::atomic<bool> orphaned{false};
+    std::atomic<bool> released{false};
+};
+
+struct ThreadEntry {
+    quint64 profiler;
+    std::shared_ptr<SampleBuffer> buffer;
+};
+
+struct ThreadBuffers {
+    std::vector<ThreadEntry> entries;
+
+    ~ThreadBuffers() {
+        for (const ThreadEntry &entry : entries) {
+            entry.buffer->released.store(true, std::memory_order_release);
+        }
+    }
+};
+
+// Profilers are identified by a serial rather than their address, so that
+// a new profiler at the address of a destroyed one is not confused with it.
+std::atomic<quint64> nextSerial{1};
+thread_local ThreadBuffers threadBuffers;
+
+} // namespace
+
+struct Profiler::Impl {
+    const quint64 serial = nextSerial.fetch_add(1);
+    std::atomic<bool> enabled{true};
+    std::atomic<qint64> dropped{0};
+
+    // Only taken when a thread records for the first time, and by collect()
+    QMutex mutex;
+    std::vector<std::shared_ptr<SampleBuffer>> buffers;
+
+    // A buffer released by an exited thread, or a new one. Samples left in
+    // a reused buffer are still collected; the exited thread's pushes are
+    // visible through the release flag.
+    std::shared_ptr<SampleBuffer> acquireBuffer() {
+        QMutexLocker lock(&mutex);
+        for (const auto &buffer : buffers) {
+            if (buffer->released.load(std::memory_order_acquire)) {
+                buffer->released.store(false, std::memory_order_relaxed);
+                return buffer;
+            }
+        }
+
+        buffers.push_back(std::make_shared<SampleBuffer>());
+        return buffers.back();
+    }
+
+    std::unordered_map<const Node *, NodeStats> stats;
+
+    SampleBuffer *threadBuffer() {
+        std::vector<ThreadEntry> &entries = threadBuffers.entries;
+        for (const ThreadEntry &entry : entries) {
+            if (entry.profiler == serial) {
+                return entry.buffer.get();
+            }
+        }
+
+        entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                     [](const ThreadEntry &entry) {
+                                         return entry.buffer->orphaned.load();
+                                     }),
+                      entries.end());
+
+        std::shared_ptr<SampleBuffer> buffer = acquireBuffer();
+        entries.push_back(ThreadEntry{serial, buffer});
+        return buffer.get();
+    }
+
+    void push(const Sample &sample) {
+        if (!enabled.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        if (!threadBuffer()->samples.push(sample)) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void apply(const Sample &sample) {
+        NodeStats &s = stats[sample.node];
+
+        if (sample.output < 0) {
+            ++s.calls;
+            s.totalTime += sample.nanoseconds;
+            s.maxTime = std::max(s.maxTime, sample.nanoseconds);
+            s.memory = sample.bytes;
+            s.peakMemory = std::max(s.peakMemory, sample.bytes);
+            return;
+        }
+
+        size_t output = static_cast<size_t>(sample.output);
+        if (s.outputBytes.size() <= output) {
+            s.outputBytes.resize(output + 1, 0);
+        }
+        s.outputBytes[output] += sample.bytes;
+    }
+};
+
+Profiler::Profiler() : m_impl(new Impl()) {}
+
+Profiler::~Profiler() {
+    // Threads drop their entry for this profiler the next time they need
+    // a new buffer.
+    for (const auto &buffer : m_impl->buffers) {
+        buffer->orphaned.store(true);
+    }
+
+    delete m_impl;
+}
+
+void Profiler::setEnabled(bool enabled) { m_impl->enabled.store(enabled); }
+
+bool Profiler::isEnabled() const { return m_impl->enabled.load(); }
+
+void Profiler::record(const Node *node, qint64 nanoseconds, qint64 memory) {
+    m_impl->push(Sample{node, -1, nanoseconds, memory});
+}
+
+void Profiler::recordOutput(const Node *node, int output, qint64 bytes) {
+    if (output >= 0) {
+        m_impl->push(Sample{node, output, 0, bytes});
+    }
+}
+
+void Profiler::collect() {
+    std::vector<std::shared_ptr<SampleBuffer>> buffers;
+    {
+        QMutexLocker lock(&m_impl->mutex);
+        buffers = m_impl->buffers;
+    }
+
+    for (const auto &buffer : buffers) {
+        // Bounded, so that a busy producer cannot keep this loop going
+        Sample sample;
+        for (size_t i = 0;
+             (i < bufferCapacity) && buffer->samples.pop(&sample); ++i) {
+            m_impl->apply(sample);
+        }
+    }
+}
+
+Profiler::NodeStats Profiler::stats(const Node *node) const {
+    auto it = m_impl->stats.find(node);
+    return (it != m_impl->stats.end()) ? it->second : NodeStats();
+}
+
+std::vector<const Node *> Profiler::profiledNodes() const {
+    std::vector<const Node *> nodes;
+    nodes.reserve(m_impl->stats.size());
+
+    for (const auto &entry : m_impl->stats) {
+        nodes.push_back(entry.first);
+    }
+
+    return nodes;
+}
+
+void Profiler::forget(const Node *node) {
+    collect();
+    m_impl->stats.erase(node);
+}
+
+void Profiler::reset() {
+    collect();
+    m_impl->stats.clear();
+    m_impl->dropped.store(0);
+}
+
+qint64 Profiler::droppedCount() const { return m_impl->dropped.load(); }
+
+} // namespace qnodes
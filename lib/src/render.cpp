@@ -0,0 +1,134 @@
+#include <QGraphicsScene>
+#include <QPainter>
+#include <QPicture>
+#include <QSvgGenerator>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <QtMath>
+#include <algorithm>
+#include <qnodes/render.hpp>
+
+namespace qnodes {
+
+static QSize imageSize(const QRectF &bounds, double scale) {
+    return QSize(std::max(1, qCeil(bounds.width() * scale)),
+                 std::max(1, qCeil(bounds.height() * scale)));
+}
+
+static const QPainter::RenderHints renderHints =
+    QPainter::Antialiasing | QPainter::TextAntialiasing |
+    QPainter::SmoothPixmapTransform;
+
+// Only const members of the image are used here, so that bands can run
+// concurrently; the pixels are written through the detached bits.
+static void renderBand(const QByteArray &recording, const QImage &image,
+                       uchar *pixels, const QRect &band) {
+    // Playing a picture moves its read position, so each band needs its own
+    QPicture picture;
+    picture.setData(recording.constData(), uint(recording.size()));
+
+    // Paints straight into the band's rows of the shared image
+    uchar *bits = pixels + band.y() * image.bytesPerLine();
+    QImage target(bits, band.width(), band.height(), image.bytesPerLine(),
+                  image.format());
+    target.setDotsPerMeterX(image.dotsPerMeterX());
+    target.setDotsPerMeterY(image.dotsPerMeterY());
+
+    QPainter painter(&target);
+    painter.setRenderHints(renderHints);
+    painter.translate(-band.topLeft());
+    painter.drawPicture(0, 0, picture);
+}
+
+QRectF renderBounds(QGraphicsScene *scene, const RenderOptions &options) {
+    double m = options.margin;
+    return scene->itemsBoundingRect().marginsAdded({m, m, m, m});
+}
+
+QImage renderImage(QGraphicsScene *scene, const RenderOptions &options) {
+    QRectF bounds = renderBounds(scene, options);
+    QSize size = imageSize(bounds, options.scale);
+
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    if (image.isNull()) {
+        return {};
+    }
+
+    image.fill(options.background);
+
+    QPicture picture;
+    {
+        QPainter painter(&picture);
+        painter.setRenderHints(renderHints);
+        scene->render(&painter, QRectF(QPointF(), size), bounds,
+                      Qt::IgnoreAspectRatio);
+    }
+
+    // Text is laid out for the recording's resolution
+    image.setDotsPerMeterX(qRound(picture.logicalDpiX() / 0.0254));
+    image.setDotsPerMeterY(qRound(picture.logicalDpiY() / 0.0254));
+
+    const QByteArray recording(picture.data(), int(picture.size()));
+
+    // Every band replays the whole recording, so there is one per thread
+    int threads = (options.threadCount > 0) ? options.threadCount
+                                            : QThread::idealThreadCount();
+    int minHeight = std::max(1, options.minBandHeight);
+    threads = std::max(1, std::min(threads, size.height() / minHeight));
+
+    int bandHeight = (size.height() + threads - 1) / threads;
+    std::vector<QRect> bands;
+    for (int y = 0; y < size.height(); y += bandHeight) {
+        bands.emplace_back(0, y, size.width(),
+                           std::min(bandHeight, size.height() - y));
+    }
+
+    uchar *pixels = image.bits();
+    const QImage &layout = image;
+
+    if (bands.size() == 1) {
+        renderBand(recording, layout, pixels, bands.front());
+        return image;
+    }
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(int(bands.size()));
+
+    for (const QRect &band : bands) {
+        QtConcurrent::run(&pool, [&recording, &layout, pixels, band]() {
+            renderBand(recording, layout, pixels, band);
+        });
+    }
+
+    pool.waitForDone();
+    return image;
+}
+
+bool renderSvg(QGraphicsScene *scene, const QString &fileName,
+               const RenderOptions &options) {
+    QRectF bounds = renderBounds(scene, options);
+    QSize size = imageSize(bounds, options.scale);
+
+    QSvgGenerator generator;
+    generator.setFileName(fileName);
+    generator.setSize(size);
+    generator.setViewBox(QRect(QPoint(), size));
+
+    QPainter painter;
+    if (!painter.begin(&generator)) {
+        return false;
+    }
+
+    if (options.background.alpha() > 0) {
+        painter.fillRect(QRect(QPoint(), size), options.background);
+    }
+
+    painter.setRenderHints(renderHints);
+    scene->render(&painter, QRectF(QPointF(), size), bounds,
+                  Qt::IgnoreAspectRatio);
+
+    return painter.end();
+}
+
+} // namespace qnodes
@@ -0,0 +1,229 @@
+#include <QReadWriteLock>
+#include <QVector2D>
+#include <QVector3D>
+#include <QVector4D>
+#include <functional>
+#include <qnodes/node.hpp>
+#include <qnodes/result_cache.hpp>
+#include <typeinfo>
+#include <unordered_map>
+
+namespace qnodes {
+
+static quint64 combineHash(quint64 seed, quint64 value) {
+    return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+}
+
+template <typename T> static quint64 hashFloats(const T &vec, int count) {
+    quint64 h = 0;
+    for (int i = 0; i < count; ++i) {
+        h = combineHash(h, std::hash<float>()(vec[i]));
+    }
+
+    return h;
+}
+
+namespace {
+
+struct HasherRegistry {
+    QReadWriteLock lock;
+    std::unordered_map<int, ResultCache::Hasher> hashers;
+};
+
+HasherRegistry &hasherRegistry() {
+    static HasherRegistry registry;
+    return registry;
+}
+
+ResultCache::Hasher findHasher(int userType) {
+    HasherRegistry &registry = hasherRegistry();
+    QReadLocker locker(&registry.lock);
+
+    auto it = registry.hashers.find(userType);
+    return (it != registry.hashers.end()) ? it->second
+                                          : ResultCache::Hasher();
+}
+
+} // namespace
+
+bool ResultCache::Key::operator==(const Key &other) const {
+    return (hash == other.hash) && (nodeType == other.nodeType) &&
+           (parameters == other.parameters) && (inputs == other.inputs);
+}
+
+ResultCache::ResultCache(qint64 budget) : m_entries(budget) {}
+
+bool ResultCache::makeKey(const Node &node, const QVariantList &inputs,
+                          Key *key) {
+    for (const QVariant &input : inputs) {
+        if (!isHashable(input)) {
+            return false;
+        }
+    }
+
+    key->nodeType = typeid(node).hash_code();
+    key->parameters = node.parameterHash();
+    key->inputs = inputs;
+
+    quint64 h = combineHash(key->nodeType, key->parameters);
+    for (const QVariant &input : inputs) {
+        h = combineHash(h, hashValue(input));
+    }
+
+    key->hash = h;
+    return true;
+}
+
+void ResultCache::registerHasher(int userType, Hasher hasher) {
+    HasherRegistry &registry = hasherRegistry();
+    QWriteLocker locker(&registry.lock);
+    registry.hashers[userType] = std::move(hasher);
+}
+
+bool ResultCache::isHashable(const QVariant &value) {
+    switch (value.userType()) {
+    case QMetaType::UnknownType:
+    case QMetaType::Bool:
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::LongLong:
+    case QMetaType::ULongLong:
+    case QMetaType::Float:
+    case QMetaType::Double:
+    case QMetaType::QString:
+    case QMetaType::QByteArray:
+    case QMetaType::QVector2D:
+    case QMetaType::QVector3D:
+    case QMetaType::QVector4D:
+        return true;
+    case QMetaType::QVariantList:
+        for (const QVariant &item : value.toList()) {
+            if (!isHashable(item)) {
+                return false;
+            }
+        }
+        return true;
+    default:
+        return bool(findHasher(value.userType()));
+    }
+}
+
+// Unhashable values only contribute their type; isHashable() keeps them
+// out of cache keys.
+quint64 ResultCache::hashValue(const QVariant &value) {
+    quint64 h = static_cast<quint64>(value.userType());
+
+    switch (value.userType()) {
+    case QMetaType::UnknownType:
+        return h;
+    case QMetaType::Bool:
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::LongLong:
+    case QMetaType::ULongLong:
+        return combineHash(h, value.toULongLong());
+    case QMetaType::Float:
+    case QMetaType::Double:
+        return combineHash(h, std::hash<double>()(value.toDouble()));
+    case QMetaType::QString:
+        return combineHash(h, qHash(value.toString()));
+    case QMetaType::QByteArray:
+        return combineHash(h, qHash(value.toByteArray()));
+    case QMetaType::QVector2D:
+        return combineHash(h, hashFloats(value.value<QVector2D>(), 2));
+    case QMetaType::QVector3D:
+        return combineHash(h, hashFloats(value.value<QVector3D>(), 3));
+    case QMetaType::QVector4D:
+        return combineHash(h, hashFloats(value.value<QVector4D>(), 4));
+    case QMetaType::QVariantList:
+        for (const QVariant &item : value.toList()) {
+            h = combineHash(h, hashValue(item));
+        }
+        return h;
+    default:
+        if (Hasher hasher = findHasher(value.userType())) {
+            return combineHash(h, hasher(value));
+        }
+        return h;
+    }
+}
+
+qint64 ResultCache::estimateSize(const QVariant &value) {
+    qint64 size = sizeof(QVariant);
+
+    switch (value.userType()) {
+    case QMetaType::QString:
+        size += value.toString().size() * qint64(sizeof(QChar));
+        break;
+    case QMetaType::QByteArray:
+        size += value.toByteArray().size();
+        break;
+    case QMetaType::QVariantList:
+        for (const QVariant &item : value.toList()) {
+            size += estimateSize(item);
+        }
+        break;
+    default:
+        if (value.userType() >= QMetaType::User) {
+            size += QMetaType::sizeOf(value.userType());
+        }
+        break;
+    }
+
+    return size;
+}
+
+void ResultCache::setMemoryBudget(qint64 bytes) {
+    m_entries.setBudget(bytes);
+    updateMemory();
+}
+
+qint64 ResultCache::memoryBudget() const { return m_entries.budget(); }
+
+qint64 ResultCache::memoryUsage() const { return m_entries.cost(); }
+
+int ResultCache::entryCount() const {
+    return static_cast<int>(m_entries.size());
+}
+
+bool ResultCache::lookup(const Key &key, QVariantList *outputs) {
+    const Entry *entry = m_entries.find(key.hash);
+    if (!entry || (entry->key != key)) {
+        ++m_misses;
+        return false;
+    }
+
+    ++m_hits;
+    *outputs = entry->outputs;
+    return true;
+}
+
+void ResultCache::insert(const Key &key, const QVariantList &outputs) {
+    qint64 cost = 128; // lists and bookkeeping overhead
+    for (const QVariant &value : key.inputs) {
+        cost += estimateSize(value);
+    }
+
+    for (const QVariant &value : outputs) {
+        cost += estimateSize(value);
+    }
+
+    m_entries.insert(key.hash, Entry{key, outputs}, cost);
+    updateMemory();
+}
+
+void ResultCache::clear() {
+    m_entries.clear();
+    updateMemory();
+}
+
+qint64 ResultCache::hitCount() const { return m_hits; }
+
+qint64 ResultCache::missCount() const { return m_misses; }
+
+void ResultCache::updateMemory() {
+    m_memory.set(MemoryUsage::EvaluationBuffers, qint64(m_entries.size()),
+                 m_entries.cost());
+}
+
+} // namespace qnodes
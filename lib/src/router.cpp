@@ -0,0 +1,537 @@
+#include <QFutureWatcher>
+#include <QPointer>
+#include <QTimer>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <qnodes/bezier.hpp>
+#include <qnodes/connection.hpp>
+#include <qnodes/node.hpp>
+#include <qnodes/router.hpp>
+#include <qnodes/scene.hpp>
+#include <qnodes/slot.hpp>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace qnodes {
+
+namespace {
+
+const double coordEpsilon = 1e-6;
+const int maxGridPoints = 1 << 20;
+
+void sortUnique(std::vector<double> &values) {
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end(),
+                             [](double a, double b) {
+                                 return std::abs(a - b) < coordEpsilon;
+                             }),
+                 values.end());
+}
+
+// Indices of the coordinates lying strictly inside (lo, hi)
+std::pair<int, int> openRange(const std::vector<double> &coords, double lo,
+                              double hi) {
+    auto first =
+        std::upper_bound(coords.begin(), coords.end(), lo + coordEpsilon);
+    auto last =
+        std::lower_bound(coords.begin(), coords.end(), hi - coordEpsilon);
+
+    return {static_cast<int>(first - coords.begin()),
+            static_cast<int>(last - coords.begin()) - 1};
+}
+
+int coordIndex(const std::vector<double> &coords, double value) {
+    auto it = std::lower_bound(coords.begin(), coords.end(),
+                               value - coordEpsilon);
+    return static_cast<int>(it - coords.begin());
+}
+
+QPolygonF simplify(const QPolygonF &pts) {
+    QPolygonF out;
+
+    for (const QPointF &p : pts) {
+        if (!out.isEmpty() && (squaredDistance(out.last(), p) < 1e-12)) {
+            continue;
+        }
+
+        while (out.size() >= 2) {
+            QPointF a = out[out.size() - 2];
+            QPointF b = out.last();
+
+            double cross = (b.x() - a.x()) * (p.y() - b.y()) -
+                           (b.y() - a.y()) * (p.x() - b.x());
+            if (std::abs(cross) > 1e-9) {
+                break;
+            }
+
+            out.removeLast();
+        }
+
+        out.append(p);
+    }
+
+    return out;
+}
+
+// A* over the orthogonal visibility grid spanned by the inflated obstacle
+// borders and the two stub points. States carry the heading so that bends
+// can be penalized.
+QPolygonF routeInArea(const SpatialIndex &obstacles, const QPointF &source,
+                      const QPointF &target, const RouterOptions &options,
+                      double searchMargin) {
+    const QPointF start = source + QPointF(options.stub, 0.0);
+    const QPointF goal = target - QPointF(options.stub, 0.0);
+    const double m = options.margin;
+
+    QRectF area = QRectF(start, goal).normalized().adjusted(
+        -searchMargin, -searchMargin, searchMargin, searchMargin);
+
+    std::vector<QRectF> rects;
+    for (quintptr id : obstacles.query(area)) {
+        rects.push_back(obstacles.rect(id).adjusted(-m, -m, m, m));
+    }
+
+    std::vector<double> xs = {area.left(), area.right(), start.x(), goal.x()};
+    std::vector<double> ys = {area.top(), area.bottom(), start.y(), goal.y()};
+
+    auto addCoord = [](std::vector<double> &coords, double v, double lo,
+                       double hi) {
+        if ((v > lo) && (v < hi)) {
+            coords.push_back(v);
+        }
+    };
+
+    for (const QRectF &r : rects) {
+        addCoord(xs, r.left(), area.left(), area.right());
+        addCoord(xs, r.right(), area.left(), area.right());
+        addCoord(ys, r.top(), area.top(), area.bottom());
+        addCoord(ys, r.bottom(), area.top(), area.bottom());
+    }
+
+    sortUnique(xs);
+    sortUnique(ys);
+
+    const int nx = static_cast<int>(xs.size());
+    const int ny = static_cast<int>(ys.size());
+    if (qint64(nx) * ny > maxGridPoints) {
+        return {};
+    }
+
+    auto pointIndex = [nx](int i, int j) { return j * nx + i; };
+
+    // blockedH[p]/blockedV[p] refer to the segment from p to its right/lower
+    // neighbour
+    std::vector<char> blockedPoint(nx * ny, 0);
+    std::vector<char> blockedH(nx * ny, 0);
+    std::vector<char> blockedV(nx * ny, 0);
+
+    for (const QRectF &r : rects) {
+        auto xr = openRange(xs, r.left(), r.right());
+        auto yr = openRange(ys, r.top(), r.bottom());
+
+        int hx0 = std::max(0, xr.first - 1);
+        int hx1 = std::min(nx - 2, xr.second);
+        int vy0 = std::max(0, yr.first - 1);
+        int vy1 = std::min(ny - 2, yr.second);
+
+        for (int j = yr.first; j <= yr.second; ++j) {
+            for (int i = xr.first; i <= xr.second; ++i) {
+                blockedPoint[pointIndex(i, j)] = 1;
+            }
+
+            for (int i = hx0; i <= hx1; ++i) {
+                blockedH[pointIndex(i, j)] = 1;
+            }
+        }
+
+        for (int i = xr.first; i <= xr.second; ++i) {
+            for (int j = vy0; j <= vy1; ++j) {
+                blockedV[pointIndex(i, j)] = 1;
+            }
+        }
+    }
+
+    const int startPoint =
+        pointIndex(coordIndex(xs, start.x()), coordIndex(ys, start.y()));
+    const int goalPoint =
+        pointIndex(coordIndex(xs, goal.x()), coordIndex(ys, goal.y()));
+
+    // Directions: 0 = +x, 1 = -x, 2 = +y, 3 = -y (d ^ 1 is the opposite)
+    const int dx[4] = {1, -1, 0, 0};
+    const int dy[4] = {0, 0, 1, -1};
+
+    auto heuristic = [&](int p) {
+        return std::abs(xs[p % nx] - goal.x()) +
+               std::abs(ys[p / nx] - goal.y());
+    };
+
+    const double inf = std::numeric_limits<double>::infinity();
+    const int numStates = nx * ny * 4;
+
+    std::vector<double> cost(numStates, inf);
+    std::vector<int> parent(numStates, -1);
+    std::vector<char> closed(numStates, 0);
+
+    using Entry = std::pair<double, int>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+
+    const int startState = startPoint * 4;
+    cost[startState] = 0.0;
+    open.push({heuristic(startPoint), startState});
+
+    int goalState = -1;
+    double bestCost = inf;
+
+    while (!open.empty()) {
+        Entry top = open.top();
+        open.pop();
+
+        if (top.first >= bestCost) {
+            break;
+        }
+
+        const int state = top.second;
+        if (closed[state]) {
+            continue;
+        }
+        closed[state] = 1;
+
+        const int p = state / 4;
+        const int dir = state % 4;
+        const double g = cost[state];
+
+        if (p == goalPoint) {
+            // The route must leave the goal heading into the target slot
+            double total = g + ((dir == 0) ? 0.0 : options.bendPenalty);
+            if (total < bestCost) {
+                bestCost = total;
+                goalState = state;
+            }
+            continue;
+        }
+
+        const int i = p % nx;
+        const int j = p / nx;
+
+        for (int d = 0; d < 4; ++d) {
+            if (d == (dir ^ 1)) {
+                continue;
+            }
+
+            int ni = i + dx[d];
+            int nj = j + dy[d];
+            if ((ni < 0) || (ni >= nx) || (nj < 0) || (nj >= ny)) {
+                continue;
+            }
+
+            int np = pointIndex(ni, nj);
+
+            bool free = (p == startPoint) || (np == goalPoint);
+            if (!free) {
+                bool segBlocked = (d == 0)   ? blockedH[p]
+                                  : (d == 1) ? blockedH[np]
+                                  : (d == 2) ? blockedV[p]
+                                             : blockedV[np];
+                if (segBlocked || blockedPoint[np]) {
+                    continue;
+                }
+            }
+
+            double step = std::abs(xs[ni] - xs[i]) + std::abs(ys[nj] - ys[j]);
+            if (d != dir) {
+                step += options.bendPenalty;
+            }
+
+            int ns = np * 4 + d;
+            if (g + step < cost[ns]) {
+                cost[ns] = g + step;
+                parent[ns] = state;
+                open.push({cost[ns] + heuristic(np), ns});
+            }
+        }
+    }
+
+    if (goalState < 0) {
+        return {};
+    }
+
+    QPolygonF path;
+    for (int s = goalState; s >= 0; s = parent[s]) {
+        int p = s / 4;
+        path.prepend(QPointF(xs[p % nx], ys[p / nx]));
+    }
+
+    path.prepend(source);
+    path.append(target);
+
+    return simplify(path);
+}
+
+struct RouteFunctor {
+    typedef QPolygonF result_type;
+
+    SpatialIndex obstacles;
+    RouterOptions options;
+
+    QPolygonF operator()(const std::pair<QPointF, QPointF> &endpoints) const {
+        return routeOrthogonal(obstacles, endpoints.first, endpoints.second,
+                               options);
+    }
+};
+
+} // namespace
+
+QPolygonF routeOrthogonal(const SpatialIndex &obstacles, const QPointF &source,
+                          const QPointF &target,
+                          const RouterOptions &options) {
+    QPolygonF route =
+        routeInArea(obstacles, source, target, options, options.searchMargin);
+
+    if (route.isEmpty()) {
+        route = routeInArea(obstacles, source, target, options,
+                            options.searchMargin * 4.0);
+    }
+
+    return route;
+}
+
+struct ConnectionRouter::Impl {
+    ConnectionRouter &self;
+    Scene *scene;
+    RouterOptions options;
+    bool enabled = false;
+
+    std::unordered_map<Node *, QRectF> nodeRects;
+    SpatialIndex routeIndex;
+    std::unordered_set<Connection *> dirty;
+    QTimer flushTimer;
+
+    QFutureWatcher<QPolygonF> watcher;
+    std::vector<QPointer<Connection>> runningJobs;
+
+    Impl(ConnectionRouter &self, Scene *scene) : self(self), scene(scene) {
+        flushTimer.setSingleShot(true);
+        flushTimer.setInterval(0);
+    }
+
+    void markDirty(Connection *connection) {
+        if (!scene->containsConnection(connection)) {
+            return;
+        }
+
+        dirty.insert(connection);
+        if (!flushTimer.isActive()) {
+            flushTimer.start();
+        }
+    }
+
+    void markAttached(Node *node) {
+        for (int i = 0; Slot *slot = node->slot(i); ++i) {
+            for (Connection *conn : slot->connections()) {
+                markDirty(conn);
+            }
+        }
+    }
+
+    void markCrossing(const QRectF &rect) {
+        for (quintptr id : routeIndex.query(rect)) {
+            markDirty(reinterpret_cast<Connection *>(id));
+        }
+    }
+
+    void nodeAdded(Node *node) {
+        QRectF rect = node->sceneBoundingRect();
+        nodeRects[node] = rect;
+        markCrossing(rect);
+        markAttached(node);
+    }
+
+    void nodeRemoved(Node *node) {
+        auto it = nodeRects.find(node);
+        if (it != nodeRects.end()) {
+            markCrossing(it->second);
+            nodeRects.erase(it);
+        }
+    }
+
+    void nodeMoved(Node *node) {
+        auto it = nodeRects.find(node);
+        if (it != nodeRects.end()) {
+            markCrossing(it->second);
+        }
+
+        nodeAdded(node);
+    }
+
+    void connectionRemoved(Connection *connection) {
+        dirty.erase(connection);
+        routeIndex.remove(reinterpret_cast<quintptr>(connection));
+    }
+
+    void apply(Connection *connection, const QPolygonF &route) {
+        connection->setRoute(route);
+        routeIndex.insert(reinterpret_cast<quintptr>(connection),
+                          connection->sceneBoundingRect());
+    }
+
+    void flush() {
+        if (!enabled || watcher.isRunning()) {
+            return;
+        }
+
+        std::vector<Connection *> batch;
+        std::vector<std::pair<QPointF, QPointF>> endpoints;
+
+        for (Connection *conn : dirty) {
+            Slot *source = conn->sourceSlot();
+            Slot *target = conn->targetSlot();
+            if (source && target) {
+                batch.push_back(conn);
+                endpoints.emplace_back(source->scenePos(), target->scenePos());
+            }
+        }
+
+        dirty.clear();
+
+        if (batch.empty()) {
+            return;
+        }
+
+        if (static_cast<int>(batch.size()) <= options.backgroundThreshold) {
+            for (size_t i = 0; i < batch.size(); ++i) {
+                apply(batch[i],
+                      routeOrthogonal(scene->nodeIndex(), endpoints[i].first,
+                                      endpoints[i].second, options));
+            }
+
+            emit self.routesUpdated();
+            return;
+        }
+
+        runningJobs.assign(batch.begin(), batch.end());
+        watcher.setFuture(QtConcurrent::mapped(
+            endpoints, RouteFunctor{scene->nodeIndex(), options}));
+    }
+
+    void backgroundFinished() {
+        // Cancelled when the router was disabled; it may have been enabled
+        // again since, with the connections marked dirty.
+        if (!enabled || watcher.isCanceled()) {
+            runningJobs.clear();
+            if (enabled && !dirty.empty()) {
+                flushTimer.start();
+            }
+
+            return;
+        }
+
+        QList<QPolygonF> routes = watcher.future().results();
+
+        for (int i = 0; i < routes.size(); ++i) {
+            Connection *conn = runningJobs[static_cast<size_t>(i)];
+            if (conn && scene->containsConnection(conn)) {
+                apply(conn, routes[i]);
+            }
+        }
+
+        runningJobs.clear();
+        emit self.routesUpdated();
+
+        if (!dirty.empty()) {
+            flushTimer.start();
+        }
+    }
+};
+
+ConnectionRouter::ConnectionRouter(Scene *scene, QObject *parent)
+    : QObject(parent), m_impl(new Impl(*this, scene)) {
+    connect(&m_impl->flushTimer, &QTimer::timeout, this,
+            [this]() { m_impl->flush(); });
+    connect(&m_impl->watcher, &QFutureWatcherBase::finished, this,
+            [this]() { m_impl->backgroundFinished(); });
+
+    connect(scene, &Scene::nodeAdded, this, [this](Node *node) {
+        if (m_impl->enabled) {
+            m_impl->nodeAdded(node);
+        }
+    });
+    connect(scene, &Scene::nodeRemoved, this, [this](Node *node) {
+        if (m_impl->enabled) {
+            m_impl->nodeRemoved(node);
+        }
+    });
+    connect(scene, &Scene::nodeGeometryChanged, this, [this](Node *node) {
+        if (m_impl->enabled) {
+            m_impl->nodeMoved(node);
+        }
+    });
+    connect(scene, &Scene::connectionAdded, this, [this](Connection *conn) {
+        if (m_impl->enabled) {
+            m_impl->markDirty(conn);
+        }
+    });
+    connect(scene, &Scene::connectionRemoved, this,
+            [this](Connection *conn) { m_impl->connectionRemoved(conn); });
+}
+
+ConnectionRouter::~ConnectionRouter() {
+    m_impl->watcher.disconnect(this);
+    m_impl->watcher.waitForFinished();
+    delete m_impl;
+}
+
+void ConnectionRouter::setOptions(const RouterOptions &options) {
+    m_impl->options = options;
+
+    if (m_impl->enabled) {
+        rerouteAll();
+    }
+}
+
+RouterOptions ConnectionRouter::options() const { return m_impl->options; }
+
+void ConnectionRouter::setEnabled(bool enabled) {
+    if (m_impl->enabled == enabled) {
+        return;
+    }
+
+    m_impl->enabled = enabled;
+
+    if (enabled) {
+        rerouteAll();
+        return;
+    }
+
+    m_impl->watcher.cancel();
+    m_impl->runningJobs.clear();
+    m_impl->dirty.clear();
+    m_impl->nodeRects.clear();
+    m_impl->routeIndex.clear();
+
+    for (Connection *conn : m_impl->scene->connections()) {
+        conn->setRoute({});
+    }
+}
+
+bool ConnectionRouter::isEnabled() const { return m_impl->enabled; }
+
+void ConnectionRouter::rerouteAll() {
+    if (!m_impl->enabled) {
+        return;
+    }
+
+    m_impl->nodeRects.clear();
+    for (Node *node : m_impl->scene->nodes()) {
+        m_impl->nodeRects[node] = node->sceneBoundingRect();
+    }
+
+    for (Connection *conn : m_impl->scene->connections()) {
+        m_impl->markDirty(conn);
+    }
+}
+
+} // namespace qnodes
@@ -0,0 +1,249 @@
+#include <qnodes/bezier.hpp>
+#include <qnodes/connection.hpp>
+#include <qnodes/node.hpp>
+#include <qnodes/scene.hpp>
+#include <unordered_set>
+
+namespace qnodes {
+
+static bool containsMode(Qt::ItemSelectionMode mode) {
+    return (mode == Qt::ContainsItemShape) ||
+           (mode == Qt::ContainsItemBoundingRect);
+}
+
+static bool rectInRect(const QRectF &inner, const QRectF &outer) {
+    return (inner.left() >= outer.left()) && (inner.right() <= outer.right()) &&
+           (inner.top() >= outer.top()) && (inner.bottom() <= outer.bottom());
+}
+
+static bool polygonCrossesRect(const QPolygonF &polygon, const QRectF &rect) {
+    for (int i = 0; i < polygon.size(); ++i) {
+        const QPointF &next = polygon[(i + 1) % polygon.size()];
+        if (segmentIntersectsRect(polygon[i], next, rect)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool nodeInPolygon(const QRectF &rect, const QPolygonF &polygon,
+                          Qt::ItemSelectionMode mode) {
+    bool crossing = polygonCrossesRect(polygon, rect);
+    bool cornerInside = polygon.containsPoint(rect.topLeft(), Qt::OddEvenFill);
+
+    if (containsMode(mode)) {
+        return cornerInside && !crossing;
+    }
+
+    // A lasso drawn entirely inside the node neither crosses it nor
+    // contains its corner
+    return cornerInside || crossing ||
+           (!polygon.isEmpty() && rect.contains(polygon.first()));
+}
+
+struct Scene::Impl {
+    Scene &self;
+
+    std::unordered_set<Node *> nodes;
+    std::unordered_set<Connection *> connections;
+    SpatialIndex nodeIndex;
+    SpatialIndex connectionIndex;
+
+    explicit Impl(Scene &self) : self(self) {}
+
+    static bool selectable(const QGraphicsItem *item) {
+        return item->isVisible() &&
+               (item->flags() & QGraphicsItem::ItemIsSelectable);
+    }
+
+    template <typename NodeTest, typename ConnectionTest>
+    void select(const QRectF &area, Qt::ItemSelectionOperation operation,
+                NodeTest nodeTest, ConnectionTest connectionTest) {
+        std::unordered_set<QGraphicsItem *> hits;
+
+        for (quintptr id : nodeIndex.query(area)) {
+            Node *node = reinterpret_cast<Node *>(id);
+            if (selectable(node) && nodeTest(node->sceneBoundingRect())) {
+                hits.insert(node);
+            }
+        }
+
+        for (quintptr id : connectionIndex.query(area)) {
+            Connection *conn = reinterpret_cast<Connection *>(id);
+            if (selectable(conn) && connectionTest(conn)) {
+                hits.insert(conn);
+            }
+        }
+
+        apply(hits, operation);
+    }
+
+    void apply(const std::unordered_set<QGraphicsItem *> &hits,
+               Qt::ItemSelectionOperation operation) {
+        bool changed = false;
+        bool blocked = self.blockSignals(true);
+
+        if (operation == Qt::ReplaceSelection) {
+            for (QGraphicsItem *item : self.selectedItems()) {
+                if (hits.count(item) == 0) {
+                    item->setSelected(false);
+                    changed = true;
+                }
+            }
+        }
+
+        for (QGraphicsItem *item : hits) {
+            if (!item->isSelected()) {
+                item->setSelected(true);
+                changed = true;
+            }
+        }
+
+        self.blockSignals(blocked);
+
+        if (changed) {
+            emit self.selectionChanged();
+        }
+    }
+};
+
+Scene::Scene(QObject *parent)
+    : QGraphicsScene(parent), m_impl(new Impl(*this)) {}
+
+Scene::~Scene() {
+    // Items unregister themselves while being deleted, so they have to go
+    // before the registry does
+    clear();
+    delete m_impl;
+}
+
+std::vector<Node *> Scene::nodes() const {
+    return std::vector<Node *>(m_impl->nodes.begin(), m_impl->nodes.end());
+}
+
+std::vector<Connection *> Scene::connections() const {
+    return std::vector<Connection *>(m_impl->connections.begin(),
+                                     m_impl->connections.end());
+}
+
+bool Scene::containsNode(const Node *node) const {
+    return m_impl->nodes.count(const_cast<Node *>(node)) > 0;
+}
+
+bool Scene::containsConnection(const Connection *connection) const {
+    return m_impl->connections.count(const_cast<Connection *>(connection)) > 0;
+}
+
+const SpatialIndex &Scene::nodeIndex() const { return m_impl->nodeIndex; }
+
+const SpatialIndex &Scene::connectionIndex() const {
+    return m_impl->connectionIndex;
+}
+
+void Scene::selectInRect(const QRectF &rect, Qt::ItemSelectionMode mode,
+                         Qt::ItemSelectionOperation operation) {
+    QRectF area = rect.normalized();
+
+    m_impl->select(
+        area, operation,
+        [&](const QRectF &nodeRect) {
+            return containsMode(mode) ? rectInRect(nodeRect, area)
+                                      : rectsOverlap(nodeRect, area);
+        },
+        [&](const Connection *conn) { return conn->intersects(area, mode); });
+}
+
+void Scene::selectInPolygon(const QPolygonF &polygon,
+                            Qt::ItemSelectionMode mode,
+                            Qt::ItemSelectionOperation operation) {
+    if (polygon.size() < 3) {
+        return;
+    }
+
+    m_impl->select(
+        polygon.boundingRect(), operation,
+        [&](const QRectF &nodeRect) {
+            return nodeInPolygon(nodeRect, polygon, mode);
+        },
+        [&](const Connection *conn) {
+            return conn->intersects(polygon, mode);
+        });
+}
+
+void Scene::selectNodes(const std::vector<Node *> &nodes,
+                        Qt::ItemSelectionOperation operation) {
+    std::unordered_set<QGraphicsItem *> hits;
+    for (Node *node : nodes) {
+        if (containsNode(node) && Impl::selectable(node)) {
+            hits.insert(node);
+        }
+    }
+
+    m_impl->apply(hits, operation);
+}
+
+void Scene::registerNode(Node *node) {
+    if (node->isPlaceholder()) {
+        return;
+    }
+
+    if (m_impl->nodes.insert(node).second) {
+        m_impl->nodeIndex.insert(reinterpret_cast<quintptr>(node),
+                                 node->sceneBoundingRect());
+        emit nodeAdded(node);
+    }
+}
+
+void Scene::unregisterNode(Node *node) {
+    if (m_impl->nodes.erase(node) > 0) {
+        m_impl->nodeIndex.remove(reinterpret_cast<quintptr>(node));
+        emit nodeRemoved(node);
+    }
+}
+
+void Scene::updateNodeGeometry(Node *node) {
+    if (m_impl->nodes.count(node) > 0) {
+        m_impl->nodeIndex.insert(reinterpret_cast<quintptr>(node),
+                                 node->sceneBoundingRect());
+        emit nodeGeometryChanged(node);
+    }
+}
+
+void Scene::updateNodeAppearance(Node *node) {
+    if (m_impl->nodes.count(node) > 0) {
+        emit nodeAppearanceChanged(node);
+    }
+}
+
+void Scene::updateConnection(Connection *connection) {
+    // Only finished connections are part of the graph; the one being
+    // dragged out of a slot is not
+    if (connection->targetSlot()) {
+        if (m_impl->connections.insert(connection).second) {
+            m_impl->connectionIndex.insert(
+                reinterpret_cast<quintptr>(connection),
+                connection->sceneBoundingRect());
+            emit connectionAdded(connection);
+        }
+    } else {
+        unregisterConnection(connection);
+    }
+}
+
+void Scene::unregisterConnection(Connection *connection) {
+    if (m_impl->connections.erase(connection) > 0) {
+        m_impl->connectionIndex.remove(reinterpret_cast<quintptr>(connection));
+        emit connectionRemoved(connection);
+    }
+}
+
+void Scene::updateConnectionGeometry(Connection *connection) {
+    if (m_impl->connections.count(connection) > 0) {
+        m_impl->connectionIndex.insert(reinterpret_cast<quintptr>(connection),
+                                       connection->sceneBoundingRect());
+        emit connectionGeometryChanged(connection);
+    }
+}
+
+} // namespace qnodes
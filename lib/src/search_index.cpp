@@ -0,0 +1,409 @@
+#include <QGraphicsView>
+#include <QHash>
+#include <QPointer>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <qnodes/node.hpp>
+#include <qnodes/port_type.hpp>
+#include <qnodes/scene.hpp>
+#include <qnodes/search_index.hpp>
+#include <unordered_map>
+
+namespace qnodes {
+
+namespace {
+
+struct Posting {
+    quint32 doc;
+    quint32 generation; // postings of older generations are stale
+    quint8 fields;
+};
+
+struct Term {
+    QString text;
+    std::vector<Posting> postings;
+};
+
+using TermFields = QHash<QString, quint8>;
+
+// Stale postings are dropped once they outnumber the live ones.
+const size_t minCompaction = 4096;
+
+// Words are runs of letters and digits, case folded. Words in camel case
+// are also indexed by their parts, so that "FloatNode" is found by "node".
+void tokenize(const QString &text, quint8 field, TermFields &tokens) {
+    auto addWord = [&](int begin, int end) {
+        if (end <= begin) {
+            return;
+        }
+
+        QString word = text.mid(begin, end - begin);
+        tokens[word.toCaseFolded()] |= field;
+
+        int part = begin;
+        for (int i = begin + 1; i < end; ++i) {
+            if (text[i].isUpper() && text[i - 1].isLower()) {
+                tokens[text.mid(part, i - part).toCaseFolded()] |= field;
+                part = i;
+            }
+        }
+
+        if (part > begin) {
+            tokens[text.mid(part, end - part).toCaseFolded()] |= field;
+        }
+    };
+
+    int begin = 0;
+    for (int i = 0; i < text.size(); ++i) {
+        if (!text[i].isLetterOrNumber()) {
+            addWord(begin, i);
+            begin = i + 1;
+        }
+    }
+
+    addWord(begin, text.size());
+}
+
+double fieldWeight(int fields) {
+    if (fields & SearchIndex::NodeLabel) {
+        return 4.0;
+    }
+    if (fields & SearchIndex::Metadata) {
+        return 2.0;
+    }
+    if (fields & SearchIndex::SlotLabel) {
+        return 1.5;
+    }
+    return 1.0;
+}
+
+} // namespace
+
+struct SearchIndex::Impl {
+    struct Doc {
+        Node *node = nullptr;
+        quint32 generation = 0;
+        size_t postingCount = 0;
+    };
+
+    struct Hit {
+        double score = 0.0;
+        int fields = 0;
+    };
+
+    SearchIndex &self;
+    QPointer<Scene> scene;
+
+    std::vector<Doc> docs;
+    std::vector<quint32> freeDocs;
+    std::unordered_map<const Node *, quint32> docOf;
+
+    std::map<QString, quint32> termIds; // sorted, for prefix queries
+    std::vector<Term> terms;
+    size_t livePostings = 0;
+    size_t stalePostings = 0;
+
+    explicit Impl(SearchIndex &self) : self(self) {}
+
+    static TermFields textOf(Node *node) {
+        TermFields tokens;
+        tokenize(node->label(), NodeLabel, tokens);
+
+        for (Slot::Type type : {Slot::Input, Slot::Output}) {
+            for (int i = 0; i < node->slotCount(type); ++i) {
+                Slot *slot = node->slot(type, i);
+                tokenize(slot->label(), SlotLabel, tokens);
+                tokenize(slot->toolTip(), SlotType, tokens);
+                tokenize(QString::fromLatin1(
+                             PortTypeRegistry::global().typeName(
+                                 slot->portType())),
+                         SlotType, tokens);
+            }
+        }
+
+        for (const QString &key : node->metadataKeys()) {
+            tokenize(key, Metadata, tokens);
+            tokenize(node->metadata(key), Metadata, tokens);
+        }
+
+        return tokens;
+    }
+
+    quint32 termId(const QString &text) {
+        auto it = termIds.find(text);
+        if (it != termIds.end()) {
+            return it->second;
+        }
+
+        quint32 id = quint32(terms.size());
+        termIds.emplace(text, id);
+        terms.push_back(Term{text, {}});
+        return id;
+    }
+
+    void unindex(Doc &doc) {
+        ++doc.generation;
+        stalePostings += doc.postingCount;
+        livePostings -= doc.postingCount;
+        doc.postingCount = 0;
+    }
+
+    void add(Node *node) {
+        if (docOf.count(node)) {
+            return;
+        }
+
+        quint32 id;
+        if (!freeDocs.empty()) {
+            id = freeDocs.back();
+            freeDocs.pop_back();
+        } else {
+            id = quint32(docs.size());
+            docs.emplace_back();
+        }
+
+        docs[id].node = node;
+        docOf.emplace(node, id);
+        update(id);
+
+        auto refresh = [this, node]() { self.refresh(node); };
+        QObject::connect(node, &Node::labelChanged, &self, refresh);
+        QObject::connect(node, &Node::metadataChanged, &self, refresh);
+
+        for (Slot::Type type : {Slot::Input, Slot::Output}) {
+            for (int i = 0; i < node->slotCount(type); ++i) {
+                QObject::connect(node->slot(type, i), &Slot::labelChanged,
+                                 &self, refresh);
+            }
+        }
+    }
+
+    void remove(Node *node) {
+        auto it = docOf.find(node);
+        if (it == docOf.end()) {
+            return;
+        }
+
+        QObject::disconnect(node, nullptr, &self, nullptr);
+        for (Slot::Type type : {Slot::Input, Slot::Output}) {
+            for (int i = 0; i < node->slotCount(type); ++i) {
+                QObject::disconnect(node->slot(type, i), nullptr, &self,
+                                    nullptr);
+            }
+        }
+
+        Doc &doc = docs[it->second];
+        unindex(doc);
+        doc.node = nullptr;
+        freeDocs.push_back(it->second);
+        docOf.erase(it);
+
+        compactIfNeeded();
+    }
+
+    void update(quint32 id) {
+        Doc &doc = docs[id];
+        unindex(doc);
+
+        TermFields tokens = textOf(doc.node);
+        for (auto it = tokens.cbegin(); it != tokens.cend(); ++it) {
+            terms[termId(it.key())].postings.push_back(
+                Posting{id, doc.generation, it.value()});
+        }
+
+        doc.postingCount = size_t(tokens.size());
+        livePostings += doc.postingCount;
+        compactIfNeeded();
+    }
+
+    bool isLive(const Posting &posting) const {
+        const Doc &doc = docs[posting.doc];
+        return doc.node && (doc.generation == posting.generation);
+    }
+
+    void compactIfNeeded() {
+        if ((stalePostings < minCompaction) ||
+            (stalePostings < livePostings)) {
+            return;
+        }
+
+        std::vector<Term> live;
+        termIds.clear();
+
+        for (Term &term : terms) {
+            term.postings.erase(
+                std::remove_if(
+                    term.postings.begin(), term.postings.end(),
+                    [this](const Posting &p) { return !isLive(p); }),
+                term.postings.end());
+
+            if (!term.postings.empty()) {
+                term.postings.shrink_to_fit();
+                termIds.emplace(term.text, quint32(live.size()));
+                live.push_back(std::move(term));
+            }
+        }
+
+        terms = std::move(live);
+        stalePostings = 0;
+    }
+
+    // Best hit per document for one word of the query
+    std::unordered_map<quint32, Hit> lookup(const QString &word,
+                                            int fields) const {
+        std::unordered_map<quint32, Hit> hits;
+        double docCount = double(std::max<size_t>(1, docOf.size()));
+
+        for (auto it = termIds.lower_bound(word);
+             (it != termIds.end()) && it->first.startsWith(word); ++it) {
+            const Term &term = terms[it->second];
+            double idf =
+                std::log(1.0 + docCount / double(term.postings.size()));
+            double exact = (it->first.size() == word.size()) ? 1.0 : 0.6;
+
+            for (const Posting &posting : term.postings) {
+                int matched = posting.fields & fields;
+                if (!matched || !isLive(posting)) {
+                    continue;
+                }
+
+                double score = fieldWeight(matched) * exact * idf;
+                Hit &hit = hits[posting.doc];
+                hit.score = std::max(hit.score, score);
+                hit.fields |= matched;
+            }
+        }
+
+        return hits;
+    }
+
+    qint64 memoryUsage() const {
+        // Rough per-entry overheads of the standard containers
+        const qint64 mapNode = 48, hashNode = 32;
+
+        qint64 bytes = qint64(docs.capacity() * sizeof(Doc)) +
+                       qint64(freeDocs.capacity() * sizeof(quint32)) +
+                       qint64(docOf.size()) * hashNode +
+                       qint64(docOf.bucket_count() * sizeof(void *)) +
+                       qint64(terms.capacity() * sizeof(Term));
+
+        for (const Term &term : terms) {
+            bytes += 2 * (qint64(term.text.capacity()) * 2 + 24) + mapNode +
+                     qint64(term.postings.capacity() * sizeof(Posting));
+        }
+
+        return bytes;
+    }
+};
+
+SearchIndex::SearchIndex(Scene *scene, QObject *parent)
+    : QObject(parent), m_impl(new Impl(*this)) {
+    m_impl->scene = scene;
+
+    if (scene) {
+        for (Node *node : scene->nodes()) {
+            m_impl->add(node);
+        }
+
+        connect(scene, &Scene::nodeAdded, this,
+                [this](Node *node) { m_impl->add(node); });
+        connect(scene, &Scene::nodeRemoved, this,
+                [this](Node *node) { m_impl->remove(node); });
+    }
+}
+
+SearchIndex::~SearchIndex() { delete m_impl; }
+
+std::vector<SearchIndex::Match>
+SearchIndex::search(const QString &query, int limit, int fields) const {
+    TermFields tokens;
+    tokenize(query, 0, tokens);
+    if (tokens.empty() || (limit <= 0)) {
+        return {};
+    }
+
+    // Every word has to match; the candidates only ever shrink.
+    std::unordered_map<quint32, Impl::Hit> hits;
+    bool first = true;
+
+    for (const QString &word : tokens.keys()) {
+        std::unordered_map<quint32, Impl::Hit> wordHits =
+            m_impl->lookup(word, fields);
+
+        if (first) {
+            hits = std::move(wordHits);
+            first = false;
+        } else {
+            for (auto it = hits.begin(); it != hits.end();) {
+                auto match = wordHits.find(it->first);
+                if (match == wordHits.end()) {
+                    it = hits.erase(it);
+                    continue;
+                }
+
+                it->second.score += match->second.score;
+                it->second.fields |= match->second.fields;
+                ++it;
+            }
+        }
+
+        if (hits.empty()) {
+            return {};
+        }
+    }
+
+    std::vector<Match> matches;
+    matches.reserve(hits.size());
+    for (const auto &hit : hits) {
+        matches.push_back(Match{m_impl->docs[hit.first].node,
+                                hit.second.score, hit.second.fields});
+    }
+
+    // Shorter labels first among equals: they match more of the query
+    auto better = [](const Match &a, const Match &b) {
+        if (a.score != b.score) {
+            return a.score > b.score;
+        }
+
+        return a.node->label().size() < b.node->label().size();
+    };
+
+    size_t count = std::min(matches.size(), size_t(limit));
+    std::partial_sort(matches.begin(), matches.begin() + count, matches.end(),
+                      better);
+    matches.resize(count);
+    return matches;
+}
+
+void SearchIndex::refresh(Node *node) {
+    auto it = m_impl->docOf.find(node);
+    if (it != m_impl->docOf.end()) {
+        m_impl->update(it->second);
+    } else if (m_impl->scene && m_impl->scene->containsNode(node)) {
+        m_impl->add(node);
+    }
+}
+
+int SearchIndex::nodeCount() const {
+    return static_cast<int>(m_impl->docOf.size());
+}
+
+int SearchIndex::termCount() const {
+    return static_cast<int>(m_impl->terms.size());
+}
+
+qint64 SearchIndex::memoryUsage() const { return m_impl->memoryUsage(); }
+
+void SearchIndex::reveal(QGraphicsView *view,
+                         const std::vector<Node *> &nodes) {
+    Scene *scene = qobject_cast<Scene *>(view->scene());
+    if (!scene || nodes.empty()) {
+        return;
+    }
+
+    scene->selectNodes(nodes);
+    view->centerOn(nodes.front());
+}
+
+} // namespace qnodes
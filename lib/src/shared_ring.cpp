@@ -0,0 +1,172 @@
+#include <QSharedMemory>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <new>
+#include <qnodes/shared_ring.hpp>
+
+namespace qnodes {
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2,
+              "shared ring indices must be lock-free to work across "
+              "processes");
+
+namespace {
+
+// Start of the segment; the data follows. Indices only ever grow, the
+// position in the data is the index modulo the capacity.
+struct RingHeader {
+    alignas(64) std::atomic<quint64> head; // next byte to read
+    alignas(64) std::atomic<quint64> tail; // next byte to write
+    alignas(64) quint64 capacity;
+};
+
+} // namespace
+
+struct SharedRing::Impl {
+    QSharedMemory memory;
+    RingHeader *header = nullptr;
+    char *data = nullptr;
+    quint64 capacity = 0; // kept here, the header may be overwritten
+
+    void map(quint64 size) {
+        header = static_cast<RingHeader *>(memory.data());
+        data = static_cast<char *>(memory.data()) + sizeof(RingHeader);
+        capacity = size;
+    }
+
+    // The other process may have corrupted the indices; they must never
+    // be more than the capacity apart.
+    bool load(quint64 *head, quint64 *tail) const {
+        *head = header->head.load(std::memory_order_acquire);
+        *tail = header->tail.load(std::memory_order_acquire);
+        return (*tail - *head) <= capacity;
+    }
+};
+
+SharedRing::SharedRing() : m_impl(new Impl()) {}
+
+SharedRing::~SharedRing() {
+    detach();
+    delete m_impl;
+}
+
+bool SharedRing::create(const QString &key, qint64 capacity) {
+    detach();
+    m_impl->memory.setKey(key);
+
+    if ((capacity <= 0) ||
+        !m_impl->memory.create(int(sizeof(RingHeader) + capacity))) {
+        return false;
+    }
+
+    m_impl->map(quint64(capacity));
+    RingHeader *header = new (m_impl->header) RingHeader();
+    header->head.store(0);
+    header->tail.store(0);
+    header->capacity = quint64(capacity);
+    return true;
+}
+
+bool SharedRing::attach(const QString &key) {
+    detach();
+    m_impl->memory.setKey(key);
+
+    if (!m_impl->memory.attach()) {
+        return false;
+    }
+
+    int size = m_impl->memory.size();
+    const RingHeader *header =
+        static_cast<const RingHeader *>(m_impl->memory.constData());
+
+    if ((size < int(sizeof(RingHeader))) || (header->capacity == 0) ||
+        (header->capacity > quint64(size) - sizeof(RingHeader))) {
+        m_impl->memory.detach();
+        return false;
+    }
+
+    m_impl->map(header->capacity);
+    return true;
+}
+
+void SharedRing::detach() {
+    if (m_impl->memory.isAttached()) {
+        m_impl->memory.detach();
+    }
+
+    m_impl->header = nullptr;
+    m_impl->data = nullptr;
+    m_impl->capacity = 0;
+}
+
+bool SharedRing::isAttached() const { return m_impl->header != nullptr; }
+
+QString SharedRing::errorString() const {
+    return m_impl->memory.errorString();
+}
+
+qint64 SharedRing::capacity() const { return qint64(m_impl->capacity); }
+
+qint64 SharedRing::bytesAvailable() const {
+    if (!m_impl->header) {
+        return 0;
+    }
+
+    quint64 head = 0, tail = 0;
+    return m_impl->load(&head, &tail) ? qint64(tail - head) : -1;
+}
+
+qint64 SharedRing::freeSpace() const {
+    qint64 available = bytesAvailable();
+    return (available >= 0) ? capacity() - available : 0;
+}
+
+qint64 SharedRing::write(const char *data, qint64 size) {
+    RingHeader *header = m_impl->header;
+    if (!header || (size <= 0)) {
+        return 0;
+    }
+
+    quint64 capacity = m_impl->capacity;
+    quint64 head = 0, tail = 0;
+    if (!m_impl->load(&head, &tail)) {
+        return -1;
+    }
+
+    quint64 count = std::min<quint64>(quint64(size), capacity - (tail - head));
+
+    // In at most two pieces, around the end of the buffer
+    quint64 offset = tail % capacity;
+    quint64 first = std::min(count, capacity - offset);
+    std::memcpy(m_impl->data + offset, data, first);
+    std::memcpy(m_impl->data, data + first, count - first);
+
+    header->tail.store(tail + count, std::memory_order_release);
+    return qint64(count);
+}
+
+qint64 SharedRing::read(char *data, qint64 maxSize) {
+    RingHeader *header = m_impl->header;
+    if (!header || (maxSize <= 0)) {
+        return 0;
+    }
+
+    quint64 capacity = m_impl->capacity;
+    quint64 head = 0, tail = 0;
+    if (!m_impl->load(&head, &tail)) {
+        return -1;
+    }
+
+    quint64 count = std::min<quint64>(quint64(maxSize), tail - head);
+
+    quint64 offset = head % capacity;
+    quint64 first = std::min(count, capacity - offset);
+    std::memcpy(data, m_impl->data + offset, first);
+    std::memcpy(data + first, m_impl->data, count - first);
+
+    header->head.store(head + count, std::memory_order_release);
+    return qint64(count);
+}
+
+} // namespace qnodes
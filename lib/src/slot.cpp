@@ -1,26 +1,59 @@
+#include <QApplication>
 #include <QCursor>
 #include <QGraphicsScene>
 #include <QGraphicsSceneMouseEvent>
+#include <QGraphicsView>
 #include <QPainter>
 #include <QPalette>
 #include <QStaticText>
+#include <algorithm>
 #include <qnodes/connection.hpp>
+#include <qnodes/memory_stats.hpp>
 #include <qnodes/node.hpp>
+#include <qnodes/scene.hpp>
 #include <qnodes/slot.hpp>
+#include <unordered_set>
 
 namespace qnodes {
 
 const double Slot::slotRadius = 6.0;
+const double Slot::snapRadius = 16.0;
+
+// The connection drag in progress, if any. The set of compatible targets
+// is computed once when the drag starts.
+struct DragState {
+    const Slot *source = nullptr;
+    std::unordered_set<const Slot *> compatible;
+    Slot *snapTarget = nullptr;
+};
+
+static DragState *g_drag = nullptr;
 
 struct Slot::Impl {
     Slot &self;
     Type type;
+    PortTypeId portType = PortTypeRegistry::anyType;
+    PortTypeMask acceptedTypes =
+        PortTypeRegistry::maskOf(PortTypeRegistry::anyType);
     QString label;
     QStaticText labelText;
     std::unique_ptr<Connection> newConnection;
+    bool dragMoved = false; // past the drag distance since the press
+    std::vector<Connection *> connections;
+    MemoryAccount memory;
 
     explicit Impl(Slot &self, Type type, const QString &label)
-        : self(self), type(type) {}
+        : self(self), type(type) {
+        memory.set(MemoryUsage::SlotItems, 1,
+                   qint64(sizeof(Slot)) + MemoryStats::objectOverhead);
+        updateMemory();
+    }
+
+    void updateMemory() {
+        memory.set(MemoryUsage::ImplBlocks, 1,
+                   qint64(sizeof(Impl)) + label.capacity() * 2 +
+                       qint64(connections.capacity() * sizeof(Connection *)));
+    }
 
     QPointF labelPos() const {
         if (type == Input) {
@@ -31,6 +64,160 @@ struct Slot::Impl {
         }
     }
 
+    Scene *graphScene() const { return qobject_cast<Scene *>(self.scene()); }
+
+    template <typename Fn> static void forEachInput(Node *node, Fn fn) {
+        for (int i = 0; i < node->slotCount(Input); ++i) {
+            fn(node->slot(Input, i));
+        }
+    }
+
+    // Nodes the source node depends on; connecting to any of them would
+    // close a cycle.
+    static std::unordered_set<Node *> upstreamOf(Node *node) {
+        std::unordered_set<Node *> visited{node};
+        std::vector<Node *> stack{node};
+
+        while (!stack.empty()) {
+            Node *current = stack.back();
+            stack.pop_back();
+
+            forEachInput(current, [&](Slot *input) {
+                for (Connection *conn : input->connections()) {
+                    Slot *source = conn->sourceSlot();
+                    Node *sourceNode = source ? source->node() : nullptr;
+                    if ((conn->targetSlot() == input) && sourceNode &&
+                        visited.insert(sourceNode).second) {
+                        stack.push_back(sourceNode);
+                    }
+                }
+            });
+        }
+
+        return visited;
+    }
+
+    void beginDrag() {
+        delete g_drag;
+        g_drag = new DragState;
+        g_drag->source = &self;
+
+        std::unordered_set<Node *> upstream;
+        if (Node *sourceNode = self.node()) {
+            upstream = upstreamOf(sourceNode);
+        }
+
+        auto addCompatible = [&](Node *node) {
+            if (upstream.count(node)) {
+                return;
+            }
+
+            forEachInput(node, [&](Slot *input) {
+                if (input->acceptConnectionFrom(&self)) {
+                    g_drag->compatible.insert(input);
+                }
+            });
+        };
+
+        if (Scene *scene = graphScene()) {
+            for (Node *node : scene->nodes()) {
+                addCompatible(node);
+            }
+        } else {
+            for (QGraphicsItem *item : self.scene()->items()) {
+                if (Node *node = dynamic_cast<Node *>(item)) {
+                    addCompatible(node);
+                }
+            }
+        }
+
+        updateVisibleTargets();
+    }
+
+    void endDrag() {
+        if (g_drag && (g_drag->source == &self)) {
+            updateVisibleTargets();
+            delete g_drag;
+            g_drag = nullptr;
+        }
+    }
+
+    // Only slots inside a view are repainted when highlighting changes.
+    void updateVisibleTargets() const {
+        QGraphicsScene *scene = self.scene();
+        if (!scene) {
+            return;
+        }
+
+        std::vector<QRectF> visibleRects;
+        for (QGraphicsView *view : scene->views()) {
+            visibleRects.push_back(
+                view->mapToScene(view->viewport()->rect()).boundingRect());
+        }
+
+        for (const Slot *slot : g_drag->compatible) {
+            QRectF rect = slot->sceneBoundingRect();
+            for (const QRectF &visible : visibleRects) {
+                if (visible.intersects(rect)) {
+                    const_cast<Slot *>(slot)->update();
+                    break;
+                }
+            }
+        }
+    }
+
+    // Nearest compatible slot within snapRadius. With a qnodes::Scene the
+    // lookup goes through the node index, so it does not depend on the
+    // number of items in the scene.
+    Slot *findSnapTarget(const QPointF &pos) const {
+        QRectF area(pos - QPointF(snapRadius, snapRadius),
+                    QSizeF(2.0 * snapRadius, 2.0 * snapRadius));
+
+        Slot *best = nullptr;
+        double bestDistance = snapRadius * snapRadius;
+
+        auto consider = [&](Slot *slot) {
+            if (!g_drag->compatible.count(slot)) {
+                return;
+            }
+
+            QPointF d = slot->scenePos() - pos;
+            double distance = d.x() * d.x() + d.y() * d.y();
+            if (distance <= bestDistance) {
+                best = slot;
+                bestDistance = distance;
+            }
+        };
+
+        if (Scene *scene = graphScene()) {
+            for (quintptr id : scene->nodeIndex().query(area)) {
+                forEachInput(reinterpret_cast<Node *>(id), consider);
+            }
+        } else {
+            for (QGraphicsItem *item : self.scene()->items(area)) {
+                if (Slot *slot = dynamic_cast<Slot *>(item)) {
+                    consider(slot);
+                }
+            }
+        }
+
+        return best;
+    }
+
+    void setSnapTarget(Slot *target) {
+        if (g_drag->snapTarget != target) {
+            if (g_drag->snapTarget) {
+                g_drag->snapTarget->update();
+            }
+
+            g_drag->snapTarget = target;
+
+            if (target) {
+                target->update();
+            }
+        }
+    }
+
     void setDefCursor() {
         if (type == Output) {
             self.setCursor(Qt::OpenHandCursor);
@@ -47,7 +234,25 @@ Slot::Slot(Type type, const QString &label)
     setFlag(ItemSendsScenePositionChanges);
 }
 
-Slot::~Slot() { delete m_impl; }
+Slot::~Slot() {
+    if (g_drag) {
+        if (g_drag->source == this) {
+            delete g_drag;
+            g_drag = nullptr;
+        } else {
+            g_drag->compatible.erase(this);
+            if (g_drag->snapTarget == this) {
+                g_drag->snapTarget = nullptr;
+            }
+        }
+    }
+
+    // A connection still being dragged detaches itself from this slot, so
+    // it has to go while the connection list is intact.
+    m_impl->newConnection.reset();
+
+    delete m_impl;
+}
 
 Node *Slot::node() const { return dynamic_cast<Node *>(parentItem()); }
 
@@ -57,6 +262,9 @@ void Slot::setLabel(const QString &label) {
     if (m_impl->label != label) {
         m_impl->label = label;
         m_impl->labelText.setText(m_impl->label);
+        m_impl->updateMemory();
+        m_impl->memory.set(MemoryUsage::StaticText, 1,
+                           MemoryStats::estimateSize(m_impl->labelText));
         emit labelChanged(label);
         update();
     }
@@ -64,6 +272,34 @@ void Slot::setLabel(const QString &label) {
 
 QString Slot::label() const { return m_impl->label; }
 
+MemoryUsage Slot::memoryUsage() const { return m_impl->memory.usage(); }
+
+void Slot::setPortType(PortTypeId type) {
+    m_impl->portType = type;
+    m_impl->acceptedTypes = PortTypeRegistry::maskOf(type);
+}
+
+PortTypeId Slot::portType() const { return m_impl->portType; }
+
+void Slot::setAcceptedTypes(PortTypeMask types) {
+    m_impl->acceptedTypes = types;
+}
+
+PortTypeMask Slot::acceptedTypes() const { return m_impl->acceptedTypes; }
+
+std::vector<Connection *> Slot::connections() const {
+    std::vector<Connection *> result;
+    result.reserve(m_impl->connections.size());
+
+    for (Connection *conn : m_impl->connections) {
+        if (conn->targetSlot()) {
+            result.push_back(conn);
+        }
+    }
+
+    return result;
+}
+
 QRectF Slot::boundingRect() const {
     double srm = slotRadius + 0.5; // slot radius with margin
     QRectF br(-srm, -srm, srm * 2.0, srm * 2.0);
@@ -88,8 +324,16 @@ void Slot::paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
 
     QPalette plt = scene()->palette();
 
-    painter->setPen(QPen(plt.color(QPalette::WindowText), 1.0));
-    painter->setBrush(plt.color(QPalette::Base));
+    if (g_drag && g_drag->compatible.count(this)) {
+        QColor highlight = plt.color(QPalette::Highlight);
+        bool snapped = (g_drag->snapTarget == this);
+
+        painter->setPen(QPen(highlight, 2.0));
+        painter->setBrush(snapped ? highlight : plt.color(QPalette::Base));
+    } else {
+        painter->setPen(QPen(plt.color(QPalette::WindowText), 1.0));
+        painter->setBrush(plt.color(QPalette::Base));
+    }
 
     painter->drawEllipse(QPointF(), slotRadius, slotRadius);
     painter->drawStaticText(m_impl->labelPos(), m_impl->labelText);
@@ -110,40 +354,70 @@ void Slot::mousePressEvent(QGraphicsSceneMouseEvent *event) {
 
     m_impl->newConnection = std::make_unique<Connection>(this);
     m_impl->newConnection->setTargetPos(event->scenePos());
+    m_impl->dragMoved = false;
     scene()->addItem(m_impl->newConnection.get());
 
+    m_impl->beginDrag();
     setCursor(Qt::ClosedHandCursor);
 }
 
 void Slot::mouseReleaseEvent(QGraphicsSceneMouseEvent *event) {
     Slot *targetSlot = nullptr;
 
-    QList<QGraphicsItem *> possibleTargets = scene()->items(event->scenePos());
-    for (QGraphicsItem *item : possibleTargets) {
-        Slot *slot = dynamic_cast<Slot *>(item);
-        if (slot && slot->acceptConnectionFrom(this)) {
-            targetSlot = slot;
-            break;
-        }
+    if (m_impl->newConnection && g_drag) {
+        targetSlot = m_impl->findSnapTarget(event->scenePos());
     }
 
+    // A click without a drag is not a drop on empty space
+    bool dropped = m_impl->newConnection && !targetSlot && m_impl->dragMoved;
+
     if (targetSlot && m_impl->newConnection) {
         m_impl->newConnection->setTargetSlot(targetSlot);
         emit connectionAdded(m_impl->newConnection.release());
     }
 
     m_impl->newConnection.reset();
+    m_impl->endDrag();
     m_impl->setDefCursor();
+
+    if (dropped) {
+        if (Scene *scene = m_impl->graphScene()) {
+            emit scene->connectionDropped(this, event->scenePos());
+        }
+    }
 }
 
 void Slot::mouseMoveEvent(QGraphicsSceneMouseEvent *event) {
-    if (m_impl->newConnection) {
-        m_impl->newConnection->setTargetPos(event->scenePos());
+    if (!m_impl->newConnection || !g_drag) {
+        return;
+    }
+
+    QPoint moved =
+        event->screenPos() - event->buttonDownScreenPos(Qt::LeftButton);
+    if (moved.manhattanLength() >= QApplication::startDragDistance()) {
+        m_impl->dragMoved = true;
     }
+
+    Slot *target = m_impl->findSnapTarget(event->scenePos());
+    m_impl->setSnapTarget(target);
+
+    m_impl->newConnection->setTargetPos(target ? target->scenePos()
+                                               : event->scenePos());
+}
+
+void Slot::attachConnection(Connection *connection) {
+    m_impl->connections.push_back(connection);
+    m_impl->updateMemory();
+}
+
+void Slot::detachConnection(Connection *connection) {
+    auto &list = m_impl->connections;
+    list.erase(std::remove(list.begin(), list.end(), connection), list.end());
+    m_impl->updateMemory();
 }
 
 bool Slot::acceptConnectionFrom(const Slot *other) const {
-    if (slotType() != Input) {
+    if ((slotType() != Input) || (other->slotType() != Output)) {
         return false;
     }
 
@@ -151,10 +425,13 @@ bool Slot::acceptConnectionFrom(const Slot *other) const {
         return false;
     }
 
-    auto items = other->childItems();
-    for (QGraphicsItem *item : items) {
-        Connection *conn = dynamic_cast<Connection *>(item);
-        if (conn && (conn->targetSlot() == this)) {
+    if (!PortTypeRegistry::global().canConnect(other->portType(),
+                                               acceptedTypes())) {
+        return false;
+    }
+
+    for (Connection *conn : other->m_impl->connections) {
+        if (conn->targetSlot() == this) {
             return false;
         }
     }
@@ -0,0 +1,307 @@
+#include <QDataStream>
+#include <QGraphicsScene>
+#include <QIODevice>
+#include <QMimeData>
+#include <QRandomGenerator>
+#include <QStringList>
+#include <algorithm>
+#include <qnodes/connection.hpp>
+#include <qnodes/node.hpp>
+#include <qnodes/snapshot.hpp>
+#include <unordered_map>
+
+namespace qnodes {
+
+static const quint32 snapshotMagic = 0x514e4753;
+static const quint32 snapshotVersion = 2;
+
+// Hands out the binary form only on request, and lets a paste in the same
+// process pick up the snapshot itself.
+class SnapshotMimeData : public QMimeData {
+public:
+    explicit SnapshotMimeData(std::shared_ptr<const GraphSnapshot> snapshot)
+        : snapshot(std::move(snapshot)) {}
+
+    QStringList formats() const override {
+        return {GraphSnapshot::mimeType};
+    }
+
+    bool hasFormat(const QString &mimeType) const override {
+        return mimeType == GraphSnapshot::mimeType;
+    }
+
+    const std::shared_ptr<const GraphSnapshot> snapshot;
+
+protected:
+    QVariant retrieveData(const QString &mimeType,
+                          QVariant::Type preferredType) const override {
+        ((void)preferredType);
+
+        if (mimeType != GraphSnapshot::mimeType) {
+            return {};
+        }
+
+        return snapshot->toBinary();
+    }
+};
+
+const char *const GraphSnapshot::mimeType = "application/x-qnodes-graph";
+
+std::shared_ptr<const GraphSnapshot>
+GraphSnapshot::capture(const std::vector<Node *> &nodes) {
+    std::shared_ptr<GraphSnapshot> snapshot(new GraphSnapshot());
+    std::unordered_map<const Node *, int> indexOf;
+
+    for (Node *node : nodes) {
+        QByteArray typeName = node->typeName();
+        if (typeName.isEmpty() || indexOf.count(node)) {
+            continue;
+        }
+
+        indexOf.emplace(node, static_cast<int>(snapshot->m_nodes.size()));
+        snapshot->m_nodes.push_back(
+            NodeRecord{typeName, node->label(), node->pos(),
+                       node->saveState(), node->id(), slotSignature(node)});
+    }
+
+    // Walking the inputs visits every internal connection exactly once
+    for (Node *node : nodes) {
+        auto target = indexOf.find(node);
+        if (target == indexOf.end()) {
+            continue;
+        }
+
+        for (int i = 0; i < node->slotCount(Slot::Input); ++i) {
+            Slot *input = node->slot(Slot::Input, i);
+
+            for (Connection *conn : input->connections()) {
+                Slot *sourceSlot = conn->sourceSlot();
+                if (!sourceSlot || (conn->targetSlot() != input)) {
+                    continue;
+                }
+
+                auto source = indexOf.find(sourceSlot->node());
+                if (source == indexOf.end()) {
+                    continue;
+                }
+
+                snapshot->m_connections.push_back(ConnectionRecord{
+                    source->second, source->first->slotIndex(sourceSlot),
+                    target->second, i});
+            }
+        }
+    }
+
+    return snapshot;
+}
+
+std::shared_ptr<const GraphSnapshot>
+GraphSnapshot::fromBinary(const QByteArray &data) {
+    QDataStream in(data);
+    in.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    in >> magic >> version;
+    if ((magic != snapshotMagic) || (version < 1) ||
+        (version > snapshotVersion)) {
+        return nullptr;
+    }
+
+    std::shared_ptr<GraphSnapshot> snapshot(new GraphSnapshot());
+
+    qint32 nodeCount = 0;
+    in >> nodeCount;
+    for (qint32 i = 0; (i < nodeCount) && (in.status() == QDataStream::Ok);
+         ++i) {
+        NodeRecord record{};
+        in >> record.typeName >> record.label >> record.pos >> record.state;
+
+        // Version 1 had no IDs; those graphs get new ones on load
+        if (version >= 2) {
+            in >> record.id >> record.slotSignature;
+        } else {
+            record.id = QRandomGenerator::global()->generate64();
+        }
+
+        snapshot->m_nodes.push_back(std::move(record));
+    }
+
+    qint32 connectionCount = 0;
+    in >> connectionCount;
+    for (qint32 i = 0;
+         (i < connectionCount) && (in.status() == QDataStream::Ok); ++i) {
+        qint32 values[4] = {};
+        in >> values[0] >> values[1] >> values[2] >> values[3];
+        snapshot->m_connections.push_back(
+            ConnectionRecord{values[0], values[1], values[2], values[3]});
+    }
+
+    if (in.status() != QDataStream::Ok) {
+        return nullptr;
+    }
+
+    return snapshot;
+}
+
+std::shared_ptr<const GraphSnapshot>
+GraphSnapshot::fromMimeData(const QMimeData *mime) {
+    if (!mime) {
+        return nullptr;
+    }
+
+    if (auto own = dynamic_cast<const SnapshotMimeData *>(mime)) {
+        return own->snapshot;
+    }
+
+    if (!mime->hasFormat(mimeType)) {
+        return nullptr;
+    }
+
+    return fromBinary(mime->data(mimeType));
+}
+
+std::shared_ptr<const GraphSnapshot>
+GraphSnapshot::fromRecords(std::vector<NodeRecord> nodes,
+                           std::vector<ConnectionRecord> connections) {
+    std::shared_ptr<GraphSnapshot> snapshot(new GraphSnapshot());
+    snapshot->m_nodes = std::move(nodes);
+    snapshot->m_connections = std::move(connections);
+    return snapshot;
+}
+
+quint64 GraphSnapshot::slotSignature(Node *node) {
+    const PortTypeRegistry &ports = PortTypeRegistry::global();
+    uint hash = 0;
+
+    for (Slot::Type type : {Slot::Input, Slot::Output}) {
+        for (int i = 0; i < node->slotCount(type); ++i) {
+            const Slot *slot = node->slot(type, i);
+            hash = qHash(int(type), hash);
+            hash = qHash(slot->label(), hash);
+            hash = qHash(ports.typeName(slot->portType()), hash);
+        }
+
+        // Keeps inputs and outputs apart when one side is empty
+        hash = qHash(node->slotCount(type), hash);
+    }
+
+    return hash;
+}
+
+QByteArray GraphSnapshot::toBinary() const {
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_0);
+
+    out << snapshotMagic << snapshotVersion;
+
+    out << static_cast<qint32>(m_nodes.size());
+    for (const NodeRecord &record : m_nodes) {
+        out << record.typeName << record.label << record.pos << record.state
+            << record.id << record.slotSignature;
+    }
+
+    out << static_cast<qint32>(m_connections.size());
+    for (const ConnectionRecord &record : m_connections) {
+        out << qint32(record.sourceNode) << qint32(record.sourceSlot)
+            << qint32(record.targetNode) << qint32(record.targetSlot);
+    }
+
+    return data;
+}
+
+QMimeData *GraphSnapshot::toMimeData() const {
+    return new SnapshotMimeData(shared_from_this());
+}
+
+const std::vector<GraphSnapshot::NodeRecord> &GraphSnapshot::nodes() const {
+    return m_nodes;
+}
+
+const std::vector<GraphSnapshot::ConnectionRecord> &
+GraphSnapshot::connections() const {
+    return m_connections;
+}
+
+bool GraphSnapshot::isEmpty() const { return m_nodes.empty(); }
+
+QRectF GraphSnapshot::bounds() const {
+    if (m_nodes.empty()) {
+        return {};
+    }
+
+    QPointF min = m_nodes.front().pos;
+    QPointF max = min;
+
+    for (const NodeRecord &record : m_nodes) {
+        min.setX(std::min(min.x(), record.pos.x()));
+        min.setY(std::min(min.y(), record.pos.y()));
+        max.setX(std::max(max.x(), record.pos.x()));
+        max.setY(std::max(max.y(), record.pos.y()));
+    }
+
+    return QRectF(min, max);
+}
+
+std::vector<Node *> GraphSnapshot::instantiate(QGraphicsScene *scene,
+                                               const NodeFactory &factory,
+                                               const QPointF &offset,
+                                               IdMode idMode) const {
+    std::vector<Node *> created(m_nodes.size(), nullptr);
+
+    for (size_t i = 0; i < m_nodes.size(); ++i) {
+        const NodeRecord &record = m_nodes[i];
+
+        Node *node = factory(record.typeName);
+        if (!node) {
+            continue;
+        }
+
+        node->restoreState(record.state);
+        node->setLabel(record.label);
+        if (idMode == KeepIds) {
+            node->setId(record.id);
+        }
+        node->setPos(record.pos + offset);
+        scene->addItem(node);
+
+        created[i] = node;
+    }
+
+    auto findSlot = [&](int node, Slot::Type type, int index) -> Slot * {
+        if ((node < 0) || (node >= static_cast<int>(created.size())) ||
+            !created[static_cast<size_t>(node)]) {
+            return nullptr;
+        }
+
+        return created[static_cast<size_t>(node)]->slot(type, index);
+    };
+
+    for (const ConnectionRecord &record : m_connections) {
+        Slot *source =
+            findSlot(record.sourceNode, Slot::Output, record.sourceSlot);
+        Slot *target =
+            findSlot(record.targetNode, Slot::Input, record.targetSlot);
+
+        if (!source || !target) {
+            continue;
+        }
+
+        Connection *conn = new Connection(source);
+        conn->setTargetSlot(target);
+        scene->addItem(conn);
+    }
+
+    std::vector<Node *> result;
+    result.reserve(created.size());
+    for (Node *node : created) {
+        if (node) {
+            result.push_back(node);
+        }
+    }
+
+    return result;
+}
+
+} // namespace qnodes
@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <cmath>
+#include <qnodes/spatial_index.hpp>
+
+namespace qnodes {
+
+const qint64 SpatialIndex::maxCellsPerItem = 1024;
+
+SpatialIndex::SpatialIndex(qreal cellSize) : m_cellSize(cellSize) {}
+
+qreal SpatialIndex::cellSize() const { return m_cellSize; }
+
+void SpatialIndex::insert(quintptr id, const QRectF &rect) {
+    QRectF r = rect.normalized();
+
+    auto it = m_rects.find(id);
+    if (it != m_rects.end()) {
+        unlink(id, it->second);
+        it->second = r;
+    } else {
+        m_rects.emplace(id, r);
+    }
+
+    link(id, r);
+}
+
+bool SpatialIndex::remove(quintptr id) {
+    auto it = m_rects.find(id);
+    if (it == m_rects.end()) {
+        return false;
+    }
+
+    unlink(id, it->second);
+    m_rects.erase(it);
+    return true;
+}
+
+void SpatialIndex::clear() {
+    m_rects.clear();
+    m_cells.clear();
+    m_oversized.clear();
+}
+
+bool SpatialIndex::contains(quintptr id) const {
+    return m_rects.find(id) != m_rects.end();
+}
+
+QRectF SpatialIndex::rect(quintptr id) const {
+    auto it = m_rects.find(id);
+    return (it != m_rects.end()) ? it->second : QRectF();
+}
+
+size_t SpatialIndex::size() const { return m_rects.size(); }
+
+std::vector<quintptr> SpatialIndex::query(const QRectF &area) const {
+    QRectF a = area.normalized();
+    std::vector<quintptr> result;
+
+    CellRange range = cellRange(a);
+    if (range.count() > qint64(m_rects.size())) {
+        // The area spans more cells than there are items, so testing every
+        // item is cheaper than visiting the cells
+        for (const auto &entry : m_rects) {
+            if (rectsOverlap(entry.second, a)) {
+                result.push_back(entry.first);
+            }
+        }
+
+        return result;
+    }
+
+    for (int y = range.y0; y <= range.y1; ++y) {
+        for (int x = range.x0; x <= range.x1; ++x) {
+            auto cell = m_cells.find(cellKey(x, y));
+            if (cell == m_cells.end()) {
+                continue;
+            }
+
+            for (quintptr id : cell->second) {
+                if (rectsOverlap(m_rects.at(id), a)) {
+                    result.push_back(id);
+                }
+            }
+        }
+    }
+
+    for (quintptr id : m_oversized) {
+        if (rectsOverlap(m_rects.at(id), a)) {
+            result.push_back(id);
+        }
+    }
+
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+SpatialIndex::CellRange SpatialIndex::cellRange(const QRectF &rect) const {
+    auto toCell = [this](qreal v) {
+        qreal c = std::floor(v / m_cellSize);
+        return static_cast<int>(std::max<qreal>(-1e9, std::min<qreal>(1e9, c)));
+    };
+
+    return {toCell(rect.left()), toCell(rect.top()), toCell(rect.right()),
+            toCell(rect.bottom())};
+}
+
+quint64 SpatialIndex::cellKey(int x, int y) {
+    return (quint64(quint32(x)) << 32) | quint64(quint32(y));
+}
+
+void SpatialIndex::link(quintptr id, const QRectF &rect) {
+    CellRange range = cellRange(rect);
+    if (range.count() > maxCellsPerItem) {
+        m_oversized.push_back(id);
+        return;
+    }
+
+    for (int y = range.y0; y <= range.y1; ++y) {
+        for (int x = range.x0; x <= range.x1; ++x) {
+            m_cells[cellKey(x, y)].push_back(id);
+        }
+    }
+}
+
+void SpatialIndex::unlink(quintptr id, const QRectF &rect) {
+    CellRange range = cellRange(rect);
+    if (range.count() > maxCellsPerItem) {
+        m_oversized.erase(
+            std::remove(m_oversized.begin(), m_oversized.end(), id),
+            m_oversized.end());
+        return;
+    }
+
+    for (int y = range.y0; y <= range.y1; ++y) {
+        for (int x = range.x0; x <= range.x1; ++x) {
+            auto cell = m_cells.find(cellKey(x, y));
+            if (cell == m_cells.end()) {
+                continue;
+            }
+
+            auto &ids = cell->second;
+            auto pos = std::find(ids.begin(), ids.end(), id);
+            if (pos != ids.end()) {
+                *pos = ids.back();
+                ids.pop_back();
+            }
+
+            if (ids.empty()) {
+                m_cells.erase(cell);
+            }
+        }
+    }
+}
+
+} // namespace qnodes
@@ -0,0 +1,570 @@
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QRunnable>
+#include <QThreadPool>
+#include <algorithm>
+#include <qnodes/connection.hpp>
+#include <qnodes/node.hpp>
+#include <qnodes/probe.hpp>
+#include <qnodes/profiler.hpp>
+#include <qnodes/scene.hpp>
+#include <qnodes/spsc_queue.hpp>
+#include <qnodes/stream.hpp>
+#include <unordered_map>
+
+namespace qnodes {
+
+StreamProcessor::~StreamProcessor() = default;
+
+// Preallocated chunks with a lock-free free list (bounded MPMC queue after
+// D. Vyukov): chunks are acquired by producers and released by consumers,
+// both on arbitrary pool threads.
+class ChunkPool {
+public:
+    ChunkPool(int chunkSize, size_t chunkCount)
+        : m_samples(size_t(chunkSize) * chunkCount),
+          m_chunks(new Chunk[chunkCount]), m_mask(roundUp(chunkCount) - 1),
+          m_cells(new Cell[m_mask + 1]) {
+        for (size_t i = 0; i <= m_mask; ++i) {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        for (size_t i = 0; i < chunkCount; ++i) {
+            Chunk &chunk = m_chunks[i];
+            chunk.m_data = m_samples.data() + i * size_t(chunkSize);
+            chunk.m_capacity = chunkSize;
+            push(&chunk);
+        }
+    }
+
+    ChunkPool(const ChunkPool &) = delete;
+    ChunkPool &operator=(const ChunkPool &) = delete;
+
+    Chunk *acquire() {
+        Chunk *chunk = nullptr;
+        if (pop(&chunk)) {
+            chunk->m_size = 0;
+        }
+
+        return chunk;
+    }
+
+    void retain(Chunk *chunk, int refs) {
+        chunk->m_refs.store(refs, std::memory_order_relaxed);
+    }
+
+    void release(Chunk *chunk) {
+        if (chunk->m_refs.fetch_sub(1, std::memory_order_acq_rel) <= 1) {
+            push(chunk);
+        }
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        Chunk *chunk;
+    };
+
+    std::vector<float> m_samples;
+    std::unique_ptr<Chunk[]> m_chunks;
+    const size_t m_mask;
+    std::unique_ptr<Cell[]> m_cells;
+    alignas(64) std::atomic<size_t> m_enqueuePos{0};
+    alignas(64) std::atomic<size_t> m_dequeuePos{0};
+
+    static size_t roundUp(size_t n) {
+        size_t p = 1;
+        while (p < n) {
+            p <<= 1;
+        }
+
+        return p;
+    }
+
+    bool push(Chunk *chunk) {
+        size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        Cell *cell;
+
+        for (;;) {
+            cell = &m_cells[pos & m_mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(seq - pos);
+
+            if (diff == 0) {
+                if (m_enqueuePos.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->chunk = chunk;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(Chunk **chunk) {
+        size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+        Cell *cell;
+
+        for (;;) {
+            cell = &m_cells[pos & m_mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(seq - (pos + 1));
+
+            if (diff == 0) {
+                if (m_dequeuePos.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        *chunk = cell->chunk;
+        cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+const int StreamExecutor::maxBatch = 16;
+
+using ChunkQueue = SpscQueue<Chunk *>;
+
+struct StreamExecutor::Impl {
+    struct Stage : QRunnable {
+        Impl &exec;
+        std::unique_ptr<StreamProcessor> processor;
+        const Node *node = nullptr;
+        Profiler *profiler = nullptr;
+
+        std::vector<ChunkQueue *> inputs;
+        std::vector<Stage *> inputStages; // nullptr if not connected
+        std::vector<std::vector<ChunkQueue *>> outputs;
+        std::vector<std::vector<std::shared_ptr<Probe>>> probes; // per output
+        std::vector<Stage *> upstream;
+        std::vector<Stage *> downstream;
+
+        // Reused on every call so the steady state does not allocate.
+        std::vector<const Chunk *> inChunks;
+        std::vector<Chunk *> outChunks;
+
+        std::atomic<bool> scheduled{false};
+        std::atomic<bool> finished{false};
+
+        Stage(Impl &exec, std::unique_ptr<StreamProcessor> processor)
+            : exec(exec), processor(std::move(processor)) {
+            setAutoDelete(false);
+        }
+
+        bool isSource() const { return inputs.empty(); }
+
+        // An input is closed once the stage feeding it has finished, and an
+        // unconnected one from the start. The stage is checked before the
+        // queue so that chunks pushed before it finished are not missed.
+        bool exhausted(size_t i) const {
+            Stage *stage = inputStages[i];
+            return (!stage || stage->finished.load()) &&
+                   (!inputs[i] || inputs[i]->empty());
+        }
+
+        // Every input has a chunk or is exhausted, and at least one has a
+        // chunk. Exhausted inputs are passed to process() as nullptr.
+        bool canRun() const {
+            if (exec.stopping.load() || finished.load()) {
+                return false;
+            }
+
+            bool available = isSource();
+            for (size_t i = 0; i < inputs.size(); ++i) {
+                if (inputs[i] && !inputs[i]->empty()) {
+                    available = true;
+                } else if (!exhausted(i)) {
+                    return false;
+                }
+            }
+
+            if (!available) {
+                return false;
+            }
+
+            // Backpressure: wait until every consumer has room.
+            for (const auto &queues : outputs) {
+                for (ChunkQueue *queue : queues) {
+                    if (queue->full()) {
+                        return false;
+                    }
+                }
+            }
+
+            return true;
+        }
+
+        bool canFinish() const {
+            if (finished.load() || isSource()) {
+                return false;
+            }
+
+            for (size_t i = 0; i < inputs.size(); ++i) {
+                if (!exhausted(i)) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        void schedule() {
+            if (!scheduled.exchange(true)) {
+                exec.pool.start(this);
+            }
+        }
+
+        void notifyNeighbours() {
+            for (Stage *stage : downstream) {
+                stage->schedule();
+            }
+
+            for (Stage *stage : upstream) {
+                stage->schedule();
+            }
+        }
+
+        bool step() {
+            for (size_t i = 0; i < inputs.size(); ++i) {
+                Chunk *chunk = nullptr;
+                if (inputs[i]) {
+                    inputs[i]->pop(&chunk);
+                }
+                inChunks[i] = chunk;
+            }
+
+            for (Chunk *&chunk : outChunks) {
+                chunk = exec.chunks->acquire();
+            }
+
+            QElapsedTimer timer;
+            if (profiler) {
+                timer.start();
+            }
+
+            bool more = processor->process(inChunks, outChunks);
+
+            if (profiler) {
+                qint64 total = 0;
+                for (size_t i = 0; more && (i < outChunks.size()); ++i) {
+                    qint64 bytes = outChunks[i]->size() * qint64(sizeof(float));
+                    profiler->recordOutput(node, static_cast<int>(i), bytes);
+                    total += bytes;
+                }
+
+                profiler->record(node, timer.nsecsElapsed(), total);
+            }
+
+            if (more) {
+                push();
+                exec.processed.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                // The processor had nothing left; what it wrote is dropped
+                for (Chunk *chunk : outChunks) {
+                    exec.chunks->retain(chunk, 1);
+                    exec.chunks->release(chunk);
+                }
+            }
+
+            for (const Chunk *chunk : inChunks) {
+                if (chunk) {
+                    exec.chunks->release(const_cast<Chunk *>(chunk));
+                }
+            }
+
+            return more;
+        }
+
+        void push() {
+            for (size_t i = 0; i < probes.size(); ++i) {
+                for (const std::shared_ptr<Probe> &probe : probes[i]) {
+                    probe->write(outChunks[i]->data(), outChunks[i]->size());
+                }
+            }
+
+            for (size_t i = 0; i < outputs.size(); ++i) {
+                Chunk *chunk = outChunks[i];
+                const auto &queues = outputs[i];
+
+                exec.chunks->retain(
+                    chunk, std::max(1, static_cast<int>(queues.size())));
+                if (queues.empty()) {
+                    exec.chunks->release(chunk);
+                }
+
+                for (ChunkQueue *queue : queues) {
+                    queue->push(chunk);
+                }
+            }
+        }
+
+        void run() override {
+            for (int i = 0; (i < maxBatch) && canRun(); ++i) {
+                if (!step()) {
+                    finish();
+                    break;
+                }
+
+                notifyNeighbours();
+            }
+
+            scheduled.store(false);
+
+            // Re-check after clearing the flag so that a wake-up sent while
+            // this run was finishing is not lost.
+            if (canFinish()) {
+                finish();
+            } else if (canRun()) {
+                schedule();
+            }
+        }
+
+        void finish() {
+            if (!finished.exchange(true)) {
+                for (Stage *stage : downstream) {
+                    stage->schedule();
+                }
+
+                exec.stageFinished();
+            }
+        }
+    };
+
+    StreamExecutor &self;
+    QPointer<Scene> scene;
+    int chunkSize = 1024;
+    int queueCapacity = 8;
+    Profiler *profiler = nullptr;
+
+    QThreadPool pool;
+    std::unique_ptr<ChunkPool> chunks;
+    std::vector<std::unique_ptr<ChunkQueue>> queues;
+    std::vector<std::unique_ptr<Stage>> stages;
+
+    std::atomic<bool> stopping{false};
+    std::atomic<int> activeStages{0};
+    std::atomic<qint64> processed{0};
+    bool running = false;
+    int generation = 0;
+
+    explicit Impl(StreamExecutor &self) : self(self) {}
+
+    void stageFinished() {
+        if (activeStages.fetch_sub(1) == 1) {
+            int finishedGeneration = generation;
+            QMetaObject::invokeMethod(
+                &self,
+                [this, finishedGeneration]() {
+                    if (running && (generation == finishedGeneration)) {
+                        teardown();
+                        emit self.finished();
+                    }
+                },
+                Qt::QueuedConnection);
+        }
+    }
+
+    void teardown() {
+        pool.waitForDone();
+
+        stages.clear();
+        queues.clear();
+        chunks.reset();
+        running = false;
+    }
+
+    bool build() {
+        if (!scene) {
+            return false;
+        }
+
+        std::unordered_map<Node *, Stage *> stageOf;
+        std::vector<Node *> nodes;
+
+        for (Node *node : scene->nodes()) {
+            std::unique_ptr<StreamProcessor> processor =
+                node->createStreamProcessor();
+            if (processor) {
+                stages.emplace_back(new Stage(*this, std::move(processor)));
+                stages.back()->node = node;
+                stages.back()->profiler = profiler;
+                stageOf.emplace(node, stages.back().get());
+                nodes.push_back(node);
+            }
+        }
+
+        size_t numInputs = 0, numOutputs = 0;
+
+        for (Node *node : nodes) {
+            Stage *stage = stageOf.at(node);
+            stage->inputs.assign(
+                static_cast<size_t>(node->slotCount(Slot::Input)), nullptr);
+            stage->inputStages.assign(stage->inputs.size(), nullptr);
+            stage->outputs.resize(
+                static_cast<size_t>(node->slotCount(Slot::Output)));
+            stage->inChunks.resize(stage->inputs.size());
+            stage->outChunks.resize(stage->outputs.size());
+            stage->probes.resize(stage->outputs.size());
+
+            numInputs += stage->inputs.size();
+            numOutputs += stage->outputs.size();
+        }
+
+        // Only the first connection of an input slot is used.
+        for (Node *node : nodes) {
+            Stage *stage = stageOf.at(node);
+
+            for (size_t i = 0; i < stage->inputs.size(); ++i) {
+                Slot *slot = node->slot(Slot::Input, static_cast<int>(i));
+
+                for (Connection *conn : slot->connections()) {
+                    Slot *source = conn->sourceSlot();
+                    auto it = source ? stageOf.find(source->node())
+                                     : stageOf.end();
+                    if ((conn->targetSlot() != slot) ||
+                        (it == stageOf.end())) {
+                        continue;
+                    }
+
+                    Stage *sourceStage = it->second;
+                    int outputIndex = source->node()->slotIndex(source);
+
+                    queues.emplace_back(new ChunkQueue(
+                        static_cast<size_t>(queueCapacity)));
+                    stage->inputs[i] = queues.back().get();
+                    stage->inputStages[i] = sourceStage;
+                    sourceStage->outputs[static_cast<size_t>(outputIndex)]
+                        .push_back(queues.back().get());
+                    if (std::shared_ptr<Probe> probe = conn->probe()) {
+                        sourceStage->probes[static_cast<size_t>(outputIndex)]
+                            .push_back(std::move(probe));
+                    }
+
+                    stage->upstream.push_back(sourceStage);
+                    sourceStage->downstream.push_back(stage);
+                    break;
+                }
+            }
+        }
+
+        if (hasCycle()) {
+            stages.clear();
+            queues.clear();
+            return false;
+        }
+
+        // Every queue slot, every chunk being produced and every chunk being
+        // consumed may hold one chunk, so acquire() never fails.
+        size_t chunkCount =
+            queues.size() * size_t(queueCapacity) + numInputs + numOutputs;
+        chunks.reset(new ChunkPool(chunkSize, std::max<size_t>(1, chunkCount)));
+
+        return !stages.empty();
+    }
+
+    // Bounded queues around a cycle would never receive their first chunk.
+    bool hasCycle() const {
+        std::unordered_map<const Stage *, size_t> pending;
+        std::vector<const Stage *> ready;
+
+        for (const auto &stage : stages) {
+            pending[stage.get()] = stage->upstream.size();
+            if (stage->upstream.empty()) {
+                ready.push_back(stage.get());
+            }
+        }
+
+        size_t visited = 0;
+        while (!ready.empty()) {
+            const Stage *stage = ready.back();
+            ready.pop_back();
+            ++visited;
+
+            for (const Stage *next : stage->downstream) {
+                if (--pending[next] == 0) {
+                    ready.push_back(next);
+                }
+            }
+        }
+
+        return visited != stages.size();
+    }
+};
+
+StreamExecutor::StreamExecutor(Scene *scene, QObject *parent)
+    : QObject(parent), m_impl(new Impl(*this)) {
+    m_impl->scene = scene;
+}
+
+StreamExecutor::~StreamExecutor() {
+    stop();
+    delete m_impl;
+}
+
+void StreamExecutor::setChunkSize(int samples) {
+    m_impl->chunkSize = std::max(1, samples);
+}
+
+int StreamExecutor::chunkSize() const { return m_impl->chunkSize; }
+
+void StreamExecutor::setQueueCapacity(int chunks) {
+    m_impl->queueCapacity = std::max(1, chunks);
+}
+
+int StreamExecutor::queueCapacity() const { return m_impl->queueCapacity; }
+
+void StreamExecutor::setProfiler(Profiler *profiler) {
+    m_impl->profiler = profiler;
+}
+
+Profiler *StreamExecutor::profiler() const { return m_impl->profiler; }
+
+bool StreamExecutor::start() {
+    if (m_impl->running || !m_impl->build()) {
+        return false;
+    }
+
+    m_impl->running = true;
+    ++m_impl->generation;
+    m_impl->stopping.store(false);
+    m_impl->processed.store(0);
+    m_impl->activeStages.store(static_cast<int>(m_impl->stages.size()));
+
+    // Stages without connected inputs either produce data or, if all their
+    // inputs are unconnected, finish right away.
+    for (const auto &stage : m_impl->stages) {
+        if (stage->upstream.empty()) {
+            stage->schedule();
+        }
+    }
+
+    return true;
+}
+
+void StreamExecutor::stop() {
+    if (m_impl->running) {
+        m_impl->stopping.store(true);
+        m_impl->teardown();
+    }
+}
+
+bool StreamExecutor::isRunning() const { return m_impl->running; }
+
+qint64 StreamExecutor::processedChunks() const {
+    return m_impl->processed.load();
+}
+
+} // namespace qnodes
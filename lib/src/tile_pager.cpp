@@ -0,0 +1,694 @@
+#include <QGraphicsView>
+#include <QHash>
+#include <QPainter>
+#include <QPointer>
+#include <QRandomGenerator>
+#include <QScrollBar>
+#include <QStyleOptionGraphicsItem>
+#include <QTimer>
+#include <algorithm>
+#include <cmath>
+#include <list>
+#include <qnodes/connection.hpp>
+#include <qnodes/node.hpp>
+#include <qnodes/scene.hpp>
+#include <qnodes/tile_pager.hpp>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace qnodes {
+
+// Stands in for the far end of a connection whose other node is not
+// materialized.
+class TileProxy : public Node {
+public:
+    explicit TileProxy(Slot::Type type) {
+        setFlag(ItemIsMovable, false);
+        setFlag(ItemIsSelectable, false);
+        setOpacity(0.5);
+        setLabel("...");
+        addSlot(type, {});
+    }
+
+    bool isPlaceholder() const override { return true; }
+};
+
+// Stands in for a square of tiles while the view is zoomed out too far to
+// show their nodes.
+class TileSummary : public QGraphicsObject {
+public:
+    TileSummary(const QRectF &rect, int nodeCount)
+        : m_rect(rect), m_text(QString::number(nodeCount)) {
+        setZValue(-1.0);
+        setAcceptedMouseButtons(Qt::NoButton);
+    }
+
+    QRectF boundingRect() const override { return m_rect; }
+
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
+               QWidget *widget) override {
+        ((void)option);
+        ((void)widget);
+
+        QPalette plt = scene()->palette();
+        QColor fill = plt.color(QPalette::Highlight);
+        fill.setAlphaF(0.2);
+
+        painter->setPen(QPen(plt.color(QPalette::Mid), 0.0));
+        painter->setBrush(fill);
+        painter->drawRect(m_rect.adjusted(2.0, 2.0, -2.0, -2.0));
+
+        // The count keeps its size however far the view is zoomed out
+        QPointF center = painter->worldTransform().map(m_rect.center());
+        painter->save();
+        painter->resetTransform();
+        painter->setPen(plt.color(QPalette::WindowText));
+        QRectF label(center - QPointF(40.0, 10.0), QSizeF(80.0, 20.0));
+        painter->drawText(label, Qt::AlignCenter, m_text);
+        painter->restore();
+    }
+
+private:
+    QRectF m_rect;
+    QString m_text;
+};
+
+const int TilePager::refreshInterval = 33;
+const int TilePager::maxPooledNodes = 4096;
+const int TilePager::maxResidentTiles = 64;
+const int TilePager::maxSummaryCells = 256;
+const double TilePager::summaryScale = 0.2;
+
+struct TilePager::Impl {
+    struct EdgeKey {
+        StoredNodeId source;
+        StoredNodeId target;
+        int sourceSlot;
+        int targetSlot;
+
+        bool operator==(const EdgeKey &other) const {
+            return (source == other.source) && (target == other.target) &&
+                   (sourceSlot == other.sourceSlot) &&
+                   (targetSlot == other.targetSlot);
+        }
+    };
+
+    struct EdgeKeyHash {
+        size_t operator()(const EdgeKey &key) const {
+            quint64 h = key.source * 0x9e3779b97f4a7c15ull;
+            h ^= key.target + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+            h ^= quint64(quint32(key.sourceSlot)) << 32;
+            h ^= quint64(quint32(key.targetSlot));
+            return static_cast<size_t>(h);
+        }
+    };
+
+    struct LiveEdge {
+        QPointer<Connection> connection;
+        QPointer<Node> proxy;
+        bool proxyIsSource;
+    };
+
+    struct Tile {
+        std::vector<StoredNodeId> ids;
+        std::list<TileKey>::iterator recent;
+    };
+
+    // Every node the pager created, resident or pooled
+    struct NodeInfo {
+        QByteArray typeName;
+        StoredNodeId id = 0;
+        bool resident = false;
+    };
+
+    TilePager &self;
+    QPointer<Scene> scene;
+    const TileStore *store;
+    GraphSnapshot::NodeFactory factory;
+
+    QPointer<QGraphicsView> view;
+    std::vector<QMetaObject::Connection> viewConnections;
+    QRectF viewport;
+    int margin = 1;
+    QTimer refreshTimer;
+
+    std::unordered_map<TileKey, Tile> tiles;
+    std::list<TileKey> recentTiles; // most recently wanted first
+    std::unordered_map<StoredNodeId, Node *> resident;
+    std::unordered_map<EdgeKey, LiveEdge, EdgeKeyHash> edges;
+    QHash<QByteArray, std::unordered_set<Node *>> pool;
+    std::unordered_map<const Node *, NodeInfo> infoOf;
+    int pooledCount = 0;
+
+    // Summaries cover the cells of a grid of factor x factor tiles; a
+    // factor of 0 means none are shown.
+    std::vector<QPointer<TileSummary>> summaries;
+    int summaryFactor = 0;
+    QRect summaryCells;
+
+    Impl(TilePager &self, Scene *scene, const TileStore *store,
+         GraphSnapshot::NodeFactory factory)
+        : self(self), scene(scene), store(store), factory(std::move(factory)) {
+        refreshTimer.setSingleShot(true);
+        refreshTimer.setInterval(refreshInterval);
+        QObject::connect(&refreshTimer, &QTimer::timeout, &self,
+                         [this]() { refresh(); });
+    }
+
+    void scheduleRefresh() {
+        if (!refreshTimer.isActive()) {
+            refreshTimer.start();
+        }
+    }
+
+    void detachView() {
+        for (const auto &c : viewConnections) {
+            QObject::disconnect(c);
+        }
+
+        viewConnections.clear();
+    }
+
+    void attachView() {
+        if (!view) {
+            return;
+        }
+
+        auto changed = [this]() { scheduleRefresh(); };
+
+        for (QScrollBar *bar :
+             {view->horizontalScrollBar(), view->verticalScrollBar()}) {
+            viewConnections.push_back(QObject::connect(
+                bar, &QScrollBar::valueChanged, &self, changed));
+            viewConnections.push_back(QObject::connect(
+                bar, &QScrollBar::rangeChanged, &self, changed));
+        }
+
+        scheduleRefresh();
+    }
+
+    QRectF currentViewport() const {
+        if (view && view->viewport()) {
+            return view->mapToScene(view->viewport()->rect()).boundingRect();
+        }
+
+        return viewport;
+    }
+
+    double viewScale() const {
+        if (!view) {
+            return 1.0;
+        }
+
+        return QStyleOptionGraphicsItem::levelOfDetailFromTransform(
+            view->transform());
+    }
+
+    Node *residentNode(StoredNodeId id) const {
+        auto it = resident.find(id);
+        return (it != resident.end()) ? it->second : nullptr;
+    }
+
+    Node *acquire(const QByteArray &typeName) {
+        auto it = pool.find(typeName);
+        if ((it != pool.end()) && !it->empty()) {
+            Node *node = *it->begin();
+            it->erase(it->begin());
+            --pooledCount;
+            return node;
+        }
+
+        Node *node = factory(typeName);
+        if (!node) {
+            return nullptr;
+        }
+
+        infoOf[node].typeName = typeName;
+        QObject::connect(node, &QObject::destroyed, &self,
+                         [this, node]() { forget(node); });
+        return node;
+    }
+
+    // What the previous user of a pooled node may have changed and
+    // restoreState() does not cover
+    static void reset(Node *node) {
+        for (const QString &key : node->metadataKeys()) {
+            node->setMetadata(key, {});
+        }
+
+        node->setId(QRandomGenerator::global()->generate64());
+        node->setEvaluationState(Node::Idle);
+        node->setProgress(-1.0);
+        node->setOverlayColor({});
+        node->setTintColor({});
+        node->setEnabled(true);
+        node->setVisible(true);
+    }
+
+    void release(Node *node) {
+        // Connections not managed by the pager, e.g. ones drawn by the user
+        for (Slot::Type type : {Slot::Input, Slot::Output}) {
+            for (int i = 0; i < node->slotCount(type); ++i) {
+                for (Connection *conn : node->slot(type, i)->connections()) {
+                    delete conn;
+                }
+            }
+        }
+
+        node->setSelected(false);
+        if (node->scene()) {
+            node->scene()->removeItem(node);
+        }
+
+        if (pooledCount < maxPooledNodes) {
+            reset(node);
+            pool[infoOf[node].typeName].insert(node);
+            ++pooledCount;
+        } else {
+            delete node;
+        }
+    }
+
+    // A node was deleted, by the pager or by someone else
+    void forget(Node *node) {
+        auto info = infoOf.find(node);
+        if (info == infoOf.end()) {
+            return;
+        }
+
+        if (info->second.resident) {
+            auto it = resident.find(info->second.id);
+            if ((it != resident.end()) && (it->second == node)) {
+                resident.erase(it);
+            }
+        } else {
+            auto pooled = pool.find(info->second.typeName);
+            if ((pooled != pool.end()) && pooled->erase(node)) {
+                --pooledCount;
+            }
+        }
+
+        infoOf.erase(info);
+    }
+
+    void setResident(Node *node, StoredNodeId id, bool isResident) {
+        NodeInfo &info = infoOf[node];
+        info.id = id;
+        info.resident = isResident;
+
+        if (isResident) {
+            resident.emplace(id, node);
+        } else {
+            resident.erase(id);
+        }
+    }
+
+    void removeEdge(
+        std::unordered_map<EdgeKey, LiveEdge, EdgeKeyHash>::iterator it) {
+        delete it->second.connection.data();
+        delete it->second.proxy.data();
+        edges.erase(it);
+    }
+
+    Slot *proxySlot(StoredNodeId id, Slot::Type type, Node **proxy) {
+        *proxy = new TileProxy(type);
+        (*proxy)->setPos(store->nodePos(id));
+        scene->addItem(*proxy);
+        return (*proxy)->slot(type, 0);
+    }
+
+    // Brings the edge in line with which of its ends are materialized
+    void syncEdge(const StoredEdge &edge) {
+        EdgeKey key{edge.source, edge.target, edge.sourceSlot,
+                    edge.targetSlot};
+
+        Node *source = residentNode(edge.source);
+        Node *target = residentNode(edge.target);
+        bool wantReal = source && target;
+        bool wantProxy = !wantReal && (source || target);
+        bool proxyIsSource = !source;
+
+        auto it = edges.find(key);
+        if (it != edges.end()) {
+            const LiveEdge &live = it->second;
+            bool isReal = !live.proxy;
+
+            if (live.connection &&
+                ((wantReal && isReal) ||
+                 (wantProxy && !isReal &&
+                  (live.proxyIsSource == proxyIsSource)))) {
+                return;
+            }
+
+            removeEdge(it);
+        }
+
+        if (!wantReal && !wantProxy) {
+            return;
+        }
+
+        Node *proxy = nullptr;
+        Slot *sourceSlot =
+            source ? source->slot(Slot::Output, edge.sourceSlot)
+                   : proxySlot(edge.source, Slot::Output, &proxy);
+        Slot *targetSlot =
+            target ? target->slot(Slot::Input, edge.targetSlot)
+                   : proxySlot(edge.target, Slot::Input, &proxy);
+
+        if (!sourceSlot || !targetSlot) {
+            delete proxy;
+            return;
+        }
+
+        Connection *conn = new Connection(sourceSlot);
+        conn->setTargetSlot(targetSlot);
+        scene->addItem(conn);
+
+        edges.emplace(key, LiveEdge{conn, proxy, proxyIsSource});
+    }
+
+    void materialize(TileKey key) {
+        std::vector<StoredNodeId> ids;
+
+        for (StoredNodeId id : store->tileNodes(key)) {
+            StoredNode stored = store->node(id);
+
+            Node *node = acquire(stored.typeName);
+            if (!node) {
+                continue;
+            }
+
+            node->restoreState(stored.state);
+            node->setLabel(stored.label);
+            node->setPos(stored.pos);
+            scene->addItem(node);
+
+            setResident(node, id, true);
+            ids.push_back(id);
+        }
+
+        recentTiles.push_front(key);
+        tiles.emplace(key, Tile{std::move(ids), recentTiles.begin()});
+
+        for (const StoredEdge &edge : store->tileEdges(key)) {
+            syncEdge(edge);
+        }
+    }
+
+    void evict(TileKey key) {
+        auto tile = tiles.find(key);
+        std::vector<Node *> nodes;
+
+        for (StoredNodeId id : tile->second.ids) {
+            auto it = resident.find(id);
+            if (it != resident.end()) {
+                Node *node = it->second;
+                nodes.push_back(node);
+                setResident(node, id, false);
+            }
+        }
+
+        recentTiles.erase(tile->second.recent);
+        tiles.erase(tile);
+
+        for (const StoredEdge &edge : store->tileEdges(key)) {
+            syncEdge(edge);
+        }
+
+        for (Node *node : nodes) {
+            release(node);
+        }
+    }
+
+    void touch(TileKey key) {
+        auto tile = tiles.find(key);
+        if (tile != tiles.end()) {
+            recentTiles.splice(recentTiles.begin(), recentTiles,
+                               tile->second.recent);
+        }
+    }
+
+    static int floorDiv(int a, int b) {
+        return (a >= 0) ? (a / b) : -((b - 1 - a) / b);
+    }
+
+    // Returns whether there were any
+    bool clearSummaries() {
+        bool changed = summaryFactor != 0;
+        for (const auto &summary : summaries) {
+            delete summary.data();
+        }
+
+        summaries.clear();
+        summaryFactor = 0;
+        return changed;
+    }
+
+    // Tiles are grouped into squares of a power of two tiles, coarse
+    // enough that at most maxSummaryCells of them cover the area. Counts
+    // are for whole cells, so they do not change while scrolling.
+    bool showSummaries(const QRectF &area) {
+        double size = store->tileSize();
+        QRectF a = area.normalized() & store->bounds();
+        if (a.isEmpty()) {
+            return clearSummaries();
+        }
+
+        int x0 = int(std::floor(a.left() / size));
+        int y0 = int(std::floor(a.top() / size));
+        int x1 = int(std::floor(a.right() / size));
+        int y1 = int(std::floor(a.bottom() / size));
+
+        int factor = 1;
+        QRect cells;
+        for (;;) {
+            cells = QRect(QPoint(floorDiv(x0, factor), floorDiv(y0, factor)),
+                          QPoint(floorDiv(x1, factor), floorDiv(y1, factor)));
+            if ((qint64(cells.width()) * cells.height() <= maxSummaryCells) ||
+                (factor >= (1 << 29))) {
+                break;
+            }
+
+            factor *= 2;
+        }
+
+        if ((factor == summaryFactor) && (cells == summaryCells)) {
+            return false;
+        }
+
+        clearSummaries();
+        summaryFactor = factor;
+        summaryCells = cells;
+
+        std::vector<int> counts(size_t(cells.width()) * size_t(cells.height()),
+                                0);
+        double cellSize = factor * size;
+        QRectF covered(cells.left() * cellSize, cells.top() * cellSize,
+                       cells.width() * cellSize, cells.height() * cellSize);
+
+        store->forEachTileIn(covered, [&](TileKey key) {
+            QPoint index = TileStore::tileIndex(key);
+            QPoint cell(floorDiv(index.x(), factor),
+                        floorDiv(index.y(), factor));
+            if (cells.contains(cell)) {
+                counts[size_t(cell.y() - cells.top()) * size_t(cells.width()) +
+                       size_t(cell.x() - cells.left())] +=
+                    store->tileNodeCount(key);
+            }
+
+            return true;
+        });
+
+        for (int y = cells.top(); y <= cells.bottom(); ++y) {
+            for (int x = cells.left(); x <= cells.right(); ++x) {
+                int count = counts[size_t(y - cells.top()) *
+                                       size_t(cells.width()) +
+                                   size_t(x - cells.left())];
+                if (count == 0) {
+                    continue;
+                }
+
+                auto summary = new TileSummary(
+                    QRectF(x * cellSize, y * cellSize, cellSize, cellSize),
+                    count);
+                scene->addItem(summary);
+                summaries.push_back(summary);
+            }
+        }
+
+        return true;
+    }
+
+    // Too many tiles in view, or too small to read: summaries only, so
+    // that the items in the scene are bounded by maxSummaryCells however
+    // far the view is zoomed out
+    bool refreshSummarized(const QRectF &area) {
+        bool changed = !tiles.empty();
+
+        std::vector<TileKey> all;
+        for (const auto &entry : tiles) {
+            all.push_back(entry.first);
+        }
+
+        for (TileKey key : all) {
+            evict(key);
+        }
+
+        return showSummaries(area) || changed;
+    }
+
+    // Counts no further than needed to know
+    bool moreTilesThan(const QRectF &area, int limit) const {
+        int count = 0;
+        return !store->forEachTileIn(area, [&count, limit](TileKey) {
+            return ++count <= limit;
+        });
+    }
+
+    void refresh() {
+        if (!scene || !store->isOpen()) {
+            return;
+        }
+
+        QRectF area = currentViewport();
+
+        if ((viewScale() < summaryScale) ||
+            moreTilesThan(area, maxResidentTiles)) {
+            if (refreshSummarized(area)) {
+                emit self.tilesChanged();
+            }
+            return;
+        }
+
+        bool changed = clearSummaries();
+
+        double load = margin * store->tileSize();
+        double keep = (margin + 1) * store->tileSize();
+
+        // Nearest tiles first, and no more than can be resident
+        std::vector<TileKey> wanted =
+            store->tilesIn(area.adjusted(-load, -load, load, load));
+        QPointF center = area.center();
+        auto distance = [&](TileKey key) {
+            QPointF d = store->tileRect(key).center() - center;
+            return d.x() * d.x() + d.y() * d.y();
+        };
+        std::sort(wanted.begin(), wanted.end(), [&](TileKey a, TileKey b) {
+            return distance(a) < distance(b);
+        });
+        if (wanted.size() > size_t(maxResidentTiles)) {
+            wanted.resize(size_t(maxResidentTiles));
+        }
+
+        // Tiles just outside the load area are kept, so that scrolling back
+        // and forth over a tile border does not thrash
+        std::vector<TileKey> kept =
+            store->tilesIn(area.adjusted(-keep, -keep, keep, keep));
+        std::unordered_set<TileKey> keepSet(kept.begin(), kept.end());
+
+        std::vector<TileKey> stale;
+        for (const auto &entry : tiles) {
+            if (!keepSet.count(entry.first)) {
+                stale.push_back(entry.first);
+            }
+        }
+
+        // Evict first, so that the pool can serve the new tiles
+        for (TileKey key : stale) {
+            evict(key);
+            changed = true;
+        }
+
+        size_t missing = 0;
+        for (auto it = wanted.rbegin(); it != wanted.rend(); ++it) {
+            if (tiles.count(*it)) {
+                touch(*it);
+            } else {
+                ++missing;
+            }
+        }
+
+        // Wanted tiles were just touched, so the least recently used ones
+        // are kept tiles outside the load area
+        while (!recentTiles.empty() &&
+               (tiles.size() + missing > size_t(maxResidentTiles))) {
+            evict(recentTiles.back());
+            changed = true;
+        }
+
+        for (TileKey key : wanted) {
+            if (!tiles.count(key)) {
+                materialize(key);
+                changed = true;
+            }
+        }
+
+        if (changed) {
+            emit self.tilesChanged();
+        }
+    }
+};
+
+TilePager::TilePager(Scene *scene, const TileStore *store,
+                     GraphSnapshot::NodeFactory factory, QObject *parent)
+    : QObject(parent),
+      m_impl(new Impl(*this, scene, store, std::move(factory))) {
+    if (store->isOpen()) {
+        double m = store->tileSize();
+        scene->setSceneRect(store->bounds().adjusted(-m, -m, m, m));
+    }
+}
+
+TilePager::~TilePager() {
+    m_impl->detachView();
+    m_impl->clearSummaries();
+
+    for (auto &pooled : m_impl->pool) {
+        for (Node *node : pooled) {
+            m_impl->infoOf.erase(node);
+            delete node;
+        }
+    }
+
+    delete m_impl;
+}
+
+void TilePager::setView(QGraphicsView *view) {
+    m_impl->detachView();
+    m_impl->view = view;
+    m_impl->attachView();
+}
+
+QGraphicsView *TilePager::view() const { return m_impl->view; }
+
+void TilePager::setMargin(int tiles) {
+    m_impl->margin = std::max(0, tiles);
+    m_impl->scheduleRefresh();
+}
+
+int TilePager::margin() const { return m_impl->margin; }
+
+void TilePager::setViewport(const QRectF &sceneRect) {
+    m_impl->viewport = sceneRect;
+    m_impl->refresh();
+}
+
+int TilePager::residentTileCount() const {
+    return static_cast<int>(m_impl->tiles.size());
+}
+
+int TilePager::residentNodeCount() const {
+    return static_cast<int>(m_impl->resident.size());
+}
+
+int TilePager::pooledNodeCount() const { return m_impl->pooledCount; }
+
+int TilePager::summaryTileCount() const {
+    return static_cast<int>(m_impl->summaries.size());
+}
+
+Node *TilePager::node(StoredNodeId id) const {
+    return m_impl->residentNode(id);
+}
+
+} // namespace qnodes
@@ -0,0 +1,472 @@
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <qnodes/tile_store.hpp>
+
+namespace qnodes {
+
+static const quint32 storeMagic = 0x514e5453;
+static const quint32 storeVersion = 1;
+
+// All offsets are relative to the start of the file, except for blob
+// references, which are relative to the blob section.
+struct TileStore::Header {
+    quint32 magic;
+    quint32 version;
+    double tileSize;
+    double left, top, right, bottom;
+    quint64 tileCount, nodeCount, edgeCount, edgeRefCount, typeCount;
+    quint64 tilesOffset, nodesOffset, edgesOffset, typesOffset, blobOffset;
+    quint64 fileSize;
+};
+
+struct TileStore::BlobRef {
+    quint64 offset;
+    quint64 size;
+};
+
+struct TileStore::TileRecord {
+    qint32 x, y;
+    quint64 firstNode, nodeCount;
+    quint64 firstEdge, edgeCount;
+};
+
+struct TileStore::NodeRecord {
+    double x, y;
+    quint32 type;
+    quint32 tile;
+    BlobRef label;
+    BlobRef state;
+};
+
+struct TileStore::EdgeRecord {
+    quint64 source, target;
+    qint32 sourceSlot, targetSlot;
+};
+
+static quint64 align8(quint64 offset) { return (offset + 7) & ~quint64(7); }
+
+static QPoint tileCoords(const QPointF &pos, double tileSize) {
+    return QPoint(static_cast<int>(std::floor(pos.x() / tileSize)),
+                  static_cast<int>(std::floor(pos.y() / tileSize)));
+}
+
+template <typename T> const T *TileStore::records(quint64 offset) const {
+    return reinterpret_cast<const T *>(m_data + offset);
+}
+
+TileStore::TileStore() = default;
+
+TileStore::~TileStore() { close(); }
+
+bool TileStore::open(const QString &fileName) {
+    close();
+
+    m_file.setFileName(fileName);
+    if (!m_file.open(QFile::ReadOnly) ||
+        (m_file.size() < qint64(sizeof(Header)))) {
+        close();
+        return false;
+    }
+
+    m_data = m_file.map(0, m_file.size());
+    if (!m_data) {
+        close();
+        return false;
+    }
+
+    const Header *h = reinterpret_cast<const Header *>(m_data);
+    const quint64 size = quint64(m_file.size());
+
+    auto fits = [size](quint64 offset, quint64 count, quint64 itemSize) {
+        return (offset <= size) && (count <= (size - offset) / itemSize);
+    };
+
+    if ((h->magic != storeMagic) || (h->version != storeVersion) ||
+        (h->fileSize != size) || !(h->tileSize > 0.0) ||
+        !fits(h->tilesOffset, h->tileCount, sizeof(TileRecord)) ||
+        !fits(h->nodesOffset, h->nodeCount, sizeof(NodeRecord)) ||
+        !fits(h->edgesOffset, h->edgeRefCount, sizeof(EdgeRecord)) ||
+        !fits(h->typesOffset, h->typeCount, sizeof(BlobRef)) ||
+        (h->blobOffset > size)) {
+        close();
+        return false;
+    }
+
+    m_header = h;
+
+    const TileRecord *tiles = records<TileRecord>(h->tilesOffset);
+    m_tiles.reserve(h->tileCount);
+    for (quint64 i = 0; i < h->tileCount; ++i) {
+        const TileRecord &t = tiles[i];
+        if ((t.firstNode + t.nodeCount > h->nodeCount) ||
+            (t.firstEdge + t.edgeCount > h->edgeRefCount)) {
+            close();
+            return false;
+        }
+
+        m_tiles.emplace(tileKey(t.x, t.y), i);
+    }
+
+    return true;
+}
+
+void TileStore::close() {
+    if (m_data) {
+        m_file.unmap(const_cast<uchar *>(m_data));
+    }
+
+    m_file.close();
+    m_data = nullptr;
+    m_header = nullptr;
+    m_tiles.clear();
+}
+
+bool TileStore::isOpen() const { return m_header != nullptr; }
+
+double TileStore::tileSize() const {
+    return m_header ? m_header->tileSize : 0.0;
+}
+
+QRectF TileStore::bounds() const {
+    if (!m_header) {
+        return {};
+    }
+
+    return QRectF(QPointF(m_header->left, m_header->top),
+                  QPointF(m_header->right, m_header->bottom));
+}
+
+quint64 TileStore::nodeCount() const {
+    return m_header ? m_header->nodeCount : 0;
+}
+
+quint64 TileStore::edgeCount() const {
+    return m_header ? m_header->edgeCount : 0;
+}
+
+TileKey TileStore::tileKey(int x, int y) {
+    return (quint64(quint32(x)) << 32) | quint64(quint32(y));
+}
+
+QPoint TileStore::tileIndex(TileKey key) {
+    return QPoint(static_cast<qint32>(quint32(key >> 32)),
+                  static_cast<qint32>(quint32(key)));
+}
+
+std::vector<TileKey> TileStore::tilesIn(const QRectF &area) const {
+    std::vector<TileKey> result;
+    forEachTileIn(area, [&result](TileKey key) {
+        result.push_back(key);
+        return true;
+    });
+
+    return result;
+}
+
+bool TileStore::forEachTileIn(
+    const QRectF &area, const std::function<bool(TileKey)> &visit) const {
+    if (!m_header) {
+        return true;
+    }
+
+    QRectF a = area.normalized();
+    QPoint tl = tileCoords(a.topLeft(), m_header->tileSize);
+    QPoint br = tileCoords(a.bottomRight(), m_header->tileSize);
+
+    qint64 count = qint64(br.x() - tl.x() + 1) * qint64(br.y() - tl.y() + 1);
+    if (count > qint64(m_tiles.size())) {
+        // Cheaper to look at the stored tiles than the requested ones
+        for (const auto &entry : m_tiles) {
+            const TileRecord &t =
+                records<TileRecord>(m_header->tilesOffset)[entry.second];
+            if ((t.x >= tl.x()) && (t.x <= br.x()) && (t.y >= tl.y()) &&
+                (t.y <= br.y()) && !visit(entry.first)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    for (int y = tl.y(); y <= br.y(); ++y) {
+        for (int x = tl.x(); x <= br.x(); ++x) {
+            TileKey key = tileKey(x, y);
+            if (m_tiles.count(key) && !visit(key)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+QRectF TileStore::tileRect(TileKey key) const {
+    double size = tileSize();
+    QPoint index = tileIndex(key);
+    return QRectF(index.x() * size, index.y() * size, size, size);
+}
+
+std::vector<StoredNodeId> TileStore::tileNodes(TileKey key) const {
+    auto it = m_tiles.find(key);
+    if (it == m_tiles.end()) {
+        return {};
+    }
+
+    const TileRecord &t =
+        records<TileRecord>(m_header->tilesOffset)[it->second];
+    std::vector<StoredNodeId> ids(t.nodeCount);
+    std::iota(ids.begin(), ids.end(), t.firstNode);
+    return ids;
+}
+
+int TileStore::tileNodeCount(TileKey key) const {
+    auto it = m_tiles.find(key);
+    if (it == m_tiles.end()) {
+        return 0;
+    }
+
+    return static_cast<int>(
+        records<TileRecord>(m_header->tilesOffset)[it->second].nodeCount);
+}
+
+std::vector<StoredEdge> TileStore::tileEdges(TileKey key) const {
+    auto it = m_tiles.find(key);
+    if (it == m_tiles.end()) {
+        return {};
+    }
+
+    const TileRecord &t =
+        records<TileRecord>(m_header->tilesOffset)[it->second];
+    const EdgeRecord *edges = records<EdgeRecord>(m_header->edgesOffset);
+
+    std::vector<StoredEdge> result;
+    result.reserve(t.edgeCount);
+    for (quint64 i = t.firstEdge; i < t.firstEdge + t.edgeCount; ++i) {
+        const EdgeRecord &e = edges[i];
+        result.push_back(
+            StoredEdge{e.source, e.sourceSlot, e.target, e.targetSlot});
+    }
+
+    return result;
+}
+
+StoredNode TileStore::node(StoredNodeId id) const {
+    if (!m_header || (id >= m_header->nodeCount)) {
+        return {};
+    }
+
+    const NodeRecord &n = records<NodeRecord>(m_header->nodesOffset)[id];
+
+    QByteArray typeName;
+    if (n.type < m_header->typeCount) {
+        typeName = blob(records<BlobRef>(m_header->typesOffset)[n.type]);
+    }
+
+    return StoredNode{id, typeName, QString::fromUtf8(blob(n.label)),
+                      QPointF(n.x, n.y), blob(n.state)};
+}
+
+QPointF TileStore::nodePos(StoredNodeId id) const {
+    if (!m_header || (id >= m_header->nodeCount)) {
+        return {};
+    }
+
+    const NodeRecord &n = records<NodeRecord>(m_header->nodesOffset)[id];
+    return QPointF(n.x, n.y);
+}
+
+TileKey TileStore::nodeTile(StoredNodeId id) const {
+    QPoint t = tileCoords(nodePos(id), tileSize());
+    return tileKey(t.x(), t.y());
+}
+
+QByteArray TileStore::blob(const BlobRef &ref) const {
+    quint64 start = m_header->blobOffset + ref.offset;
+    if ((ref.size == 0) || (start + ref.size > m_header->fileSize)) {
+        return {};
+    }
+
+    // No copy; the data stays in the mapped file
+    return QByteArray::fromRawData(
+        reinterpret_cast<const char *>(m_data + start), int(ref.size));
+}
+
+TileStoreBuilder::TileStoreBuilder(double tileSize) : m_tileSize(tileSize) {}
+
+quint64 TileStoreBuilder::addNode(const QByteArray &typeName,
+                                  const QString &label, const QPointF &pos,
+                                  const QByteArray &state) {
+    auto it = m_typeIds.constFind(typeName);
+    quint32 type = 0;
+    if (it != m_typeIds.constEnd()) {
+        type = it.value();
+    } else {
+        type = quint32(m_typeNames.size());
+        m_typeIds.insert(typeName, type);
+        m_typeNames.push_back(typeName);
+    }
+
+    m_nodes.push_back(PendingNode{type, pos, label.toUtf8(), state});
+    return m_nodes.size() - 1;
+}
+
+void TileStoreBuilder::addConnection(quint64 source, int sourceSlot,
+                                     quint64 target, int targetSlot) {
+    if ((source < m_nodes.size()) && (target < m_nodes.size())) {
+        m_edges.push_back(StoredEdge{source, sourceSlot, target, targetSlot});
+    }
+}
+
+bool TileStoreBuilder::save(const QString &fileName) const {
+    using Header = TileStore::Header;
+    using BlobRef = TileStore::BlobRef;
+    using TileRecord = TileStore::TileRecord;
+    using NodeRecord = TileStore::NodeRecord;
+    using EdgeRecord = TileStore::EdgeRecord;
+
+    if (!(m_tileSize > 0.0)) {
+        return false;
+    }
+
+    // Order the nodes by tile, so that each tile is one run of IDs
+    std::vector<TileKey> keyOf(m_nodes.size());
+    for (size_t i = 0; i < m_nodes.size(); ++i) {
+        QPoint t = tileCoords(m_nodes[i].pos, m_tileSize);
+        keyOf[i] = TileStore::tileKey(t.x(), t.y());
+    }
+
+    std::vector<quint64> order(m_nodes.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](quint64 a, quint64 b) {
+        return keyOf[a] < keyOf[b];
+    });
+
+    std::vector<quint64> newId(m_nodes.size());
+    std::vector<TileRecord> tiles;
+    std::vector<quint32> tileOf(m_nodes.size());
+
+    for (size_t i = 0; i < order.size(); ++i) {
+        quint64 old = order[i];
+        newId[old] = i;
+
+        if (tiles.empty() || (keyOf[order[i - 1]] != keyOf[old])) {
+            QPoint t = tileCoords(m_nodes[old].pos, m_tileSize);
+            tiles.push_back(TileRecord{t.x(), t.y(), i, 0, 0, 0});
+        }
+
+        tiles.back().nodeCount++;
+        tileOf[old] = quint32(tiles.size() - 1);
+    }
+
+    // Every edge goes to its target's tile, and also to its source's tile
+    // if that is a different one
+    std::vector<std::vector<EdgeRecord>> tileEdges(tiles.size());
+    for (const StoredEdge &e : m_edges) {
+        EdgeRecord record{newId[e.source], newId[e.target], e.sourceSlot,
+                          e.targetSlot};
+
+        tileEdges[tileOf[e.target]].push_back(record);
+        if (tileOf[e.source] != tileOf[e.target]) {
+            tileEdges[tileOf[e.source]].push_back(record);
+        }
+    }
+
+    quint64 edgeRefCount = 0;
+    for (size_t i = 0; i < tiles.size(); ++i) {
+        tiles[i].firstEdge = edgeRefCount;
+        tiles[i].edgeCount = tileEdges[i].size();
+        edgeRefCount += tileEdges[i].size();
+    }
+
+    Header header = {};
+    header.magic = storeMagic;
+    header.version = storeVersion;
+    header.tileSize = m_tileSize;
+    header.tileCount = tiles.size();
+    header.nodeCount = m_nodes.size();
+    header.edgeCount = m_edges.size();
+    header.edgeRefCount = edgeRefCount;
+    header.typeCount = m_typeNames.size();
+
+    QRectF bounds;
+    for (const PendingNode &n : m_nodes) {
+        bounds |= QRectF(n.pos, QSizeF(1.0, 1.0));
+    }
+
+    header.left = bounds.left();
+    header.top = bounds.top();
+    header.right = bounds.right();
+    header.bottom = bounds.bottom();
+
+    header.tilesOffset = align8(sizeof(Header));
+    header.nodesOffset =
+        align8(header.tilesOffset + tiles.size() * sizeof(TileRecord));
+    header.edgesOffset =
+        align8(header.nodesOffset + m_nodes.size() * sizeof(NodeRecord));
+    header.typesOffset =
+        align8(header.edgesOffset + edgeRefCount * sizeof(EdgeRecord));
+    header.blobOffset =
+        align8(header.typesOffset + m_typeNames.size() * sizeof(BlobRef));
+
+    QByteArray blobData;
+    auto addBlob = [&](const QByteArray &data) {
+        BlobRef ref{quint64(blobData.size()), quint64(data.size())};
+        blobData.append(data);
+        return ref;
+    };
+
+    std::vector<BlobRef> types;
+    for (const QByteArray &name : m_typeNames) {
+        types.push_back(addBlob(name));
+    }
+
+    std::vector<NodeRecord> nodes;
+    nodes.reserve(m_nodes.size());
+    for (quint64 old : order) {
+        const PendingNode &n = m_nodes[old];
+        nodes.push_back(NodeRecord{n.pos.x(), n.pos.y(), n.type, tileOf[old],
+                                   addBlob(n.label), addBlob(n.state)});
+    }
+
+    header.fileSize = header.blobOffset + quint64(blobData.size());
+
+    QFile file(fileName);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
+        return false;
+    }
+
+    auto write = [&](quint64 offset, const void *data, quint64 size) {
+        if (size == 0) {
+            return true;
+        }
+
+        return file.seek(qint64(offset)) &&
+               (file.write(static_cast<const char *>(data), qint64(size)) ==
+                qint64(size));
+    };
+
+    bool ok = write(0, &header, sizeof(header)) &&
+              write(header.tilesOffset, tiles.data(),
+                    tiles.size() * sizeof(TileRecord)) &&
+              write(header.nodesOffset, nodes.data(),
+                    nodes.size() * sizeof(NodeRecord));
+
+    quint64 edgeOffset = header.edgesOffset;
+    for (size_t i = 0; ok && (i < tileEdges.size()); ++i) {
+        ok = write(edgeOffset, tileEdges[i].data(),
+                   tileEdges[i].size() * sizeof(EdgeRecord));
+        edgeOffset += tileEdges[i].size() * sizeof(EdgeRecord);
+    }
+
+    ok = ok &&
+         write(header.typesOffset, types.data(),
+               types.size() * sizeof(BlobRef)) &&
+         write(header.blobOffset, blobData.constData(),
+               quint64(blobData.size())) &&
+         file.resize(qint64(header.fileSize));
+
+    return ok;
+}
+
+} // namespace qnodes
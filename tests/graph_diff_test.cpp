@@ -0,0 +1,48 @@
+#include <QtTest>
+#include <qnodes/graph_diff.hpp>
+
+namespace {
+
+using Snapshot = std::shared_ptr<const qnodes::GraphSnapshot>;
+
+Snapshot nodeAt(const QPointF &pos) {
+    qnodes::GraphSnapshot::NodeRecord record{"Add", "add", pos, {}, 1, 0};
+    return qnodes::GraphSnapshot::fromRecords({record}, {});
+}
+
+} // namespace
+
+class GraphDiffTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void moveOnOneSideIsTaken() {
+        Snapshot base = nodeAt({0, 0});
+        qnodes::MergeResult result =
+            qnodes::mergeGraphs(*base, *base, *nodeAt({10, 0}));
+
+        QVERIFY(result.conflicts.empty());
+        QCOMPARE(result.graph->nodes().at(0).pos, QPointF(10, 0));
+    }
+
+    void moveOnBothSidesIsAConflict() {
+        Snapshot base = nodeAt({0, 0});
+        qnodes::MergeResult result =
+            qnodes::mergeGraphs(*base, *nodeAt({10, 0}), *nodeAt({0, 10}));
+
+        QCOMPARE(result.conflicts.size(), size_t(1));
+        QCOMPARE(result.conflicts[0].kind, qnodes::MergeConflict::BothMoved);
+        QCOMPARE(result.graph->nodes().at(0).pos, QPointF(10, 0));
+    }
+
+    void sameMoveOnBothSidesIsNoConflict() {
+        Snapshot base = nodeAt({0, 0});
+        qnodes::MergeResult result =
+            qnodes::mergeGraphs(*base, *nodeAt({10, 0}), *nodeAt({10, 0}));
+
+        QVERIFY(result.conflicts.empty());
+    }
+};
+
+QTEST_MAIN(GraphDiffTest)
+#include "graph_diff_test.moc"
@@ -0,0 +1,116 @@
+#include <QtTest>
+#include <qnodes/connection.hpp>
+#include <qnodes/group_node.hpp>
+#include <qnodes/scene.hpp>
+
+namespace {
+
+qnodes::Node *addNode(qnodes::Scene &scene, int inputs, int outputs) {
+    auto node = new qnodes::Node();
+    for (int i = 0; i < inputs; ++i) {
+        node->addSlot(qnodes::Slot::Input, QString("in %1").arg(i));
+    }
+
+    for (int i = 0; i < outputs; ++i) {
+        node->addSlot(qnodes::Slot::Output, QString("out %1").arg(i));
+    }
+
+    scene.addItem(node);
+    return node;
+}
+
+qnodes::Connection *link(qnodes::Scene &scene, qnodes::Slot *source,
+                         qnodes::Slot *target) {
+    auto conn = new qnodes::Connection(source);
+    conn->setTargetSlot(target);
+    scene.addItem(conn);
+    return conn;
+}
+
+std::vector<qnodes::Slot *> sourcesOf(qnodes::Slot *input) {
+    std::vector<qnodes::Slot *> sources;
+    for (qnodes::Connection *conn : input->connections()) {
+        if (conn->targetSlot() == input) {
+            sources.push_back(conn->sourceSlot());
+        }
+    }
+
+    return sources;
+}
+
+void flushDeletes() {
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+}
+
+} // namespace
+
+class GroupNodeTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void expandKeepsConnectionsMadeWhileCollapsed() {
+        qnodes::Scene scene;
+        qnodes::Node *first = addNode(scene, 0, 1);
+        qnodes::Node *second = addNode(scene, 0, 1);
+        qnodes::Node *member = addNode(scene, 1, 0);
+
+        qnodes::Slot *input = member->slot(qnodes::Slot::Input, 0);
+        link(scene, first->slot(qnodes::Slot::Output, 0), input);
+
+        qnodes::GroupNode *group = qnodes::GroupNode::collapse({member});
+        QVERIFY(group);
+
+        qnodes::Slot *proxy = group->outerSlot(input);
+        QVERIFY(proxy);
+        QCOMPARE(sourcesOf(proxy).size(), size_t(1));
+
+        // Rewire the collapsed group from the first node to the second
+        delete proxy->connections().front();
+        link(scene, second->slot(qnodes::Slot::Output, 0), proxy);
+
+        group->expand();
+        flushDeletes();
+
+        std::vector<qnodes::Slot *> sources = sourcesOf(input);
+        QCOMPARE(sources.size(), size_t(1));
+        QCOMPARE(sources.front(), second->slot(qnodes::Slot::Output, 0));
+        QCOMPARE(scene.connections().size(), size_t(1));
+    }
+
+    void expandDropsConnectionsRemovedWhileCollapsed() {
+        qnodes::Scene scene;
+        qnodes::Node *source = addNode(scene, 0, 1);
+        qnodes::Node *member = addNode(scene, 1, 0);
+
+        qnodes::Slot *input = member->slot(qnodes::Slot::Input, 0);
+        link(scene, source->slot(qnodes::Slot::Output, 0), input);
+
+        qnodes::GroupNode *group = qnodes::GroupNode::collapse({member});
+        QVERIFY(group);
+
+        delete group->outerSlot(input)->connections().front();
+
+        group->expand();
+        flushDeletes();
+
+        QVERIFY(sourcesOf(input).empty());
+        QVERIFY(scene.connections().empty());
+    }
+
+    void collapseSkipsConnectionsBeingDragged() {
+        qnodes::Scene scene;
+        qnodes::Node *member = addNode(scene, 0, 1);
+
+        // No target yet
+        auto dragged =
+            new qnodes::Connection(member->slot(qnodes::Slot::Output, 0));
+        scene.addItem(dragged);
+
+        qnodes::GroupNode *group = qnodes::GroupNode::collapse({member});
+        QVERIFY(group);
+        QVERIFY(!group->outerSlot(member->slot(qnodes::Slot::Output, 0)));
+    }
+};
+
+QTEST_MAIN(GroupNodeTest)
+#include "group_node_test.moc"
@@ -0,0 +1,81 @@
+#include <QtTest>
+#include <qnodes/layout.hpp>
+
+namespace {
+
+// Nodes of 100 x 50 with their ports at the top
+int addNode(qnodes::LayoutGraph &graph, const QPointF &pos, bool movable) {
+    graph.sizes.emplace_back(100.0, 50.0);
+    graph.positions.push_back(pos);
+    graph.movable.push_back(movable);
+    return int(graph.sizes.size()) - 1;
+}
+
+void link(qnodes::LayoutGraph &graph, int source, int target) {
+    graph.edges.push_back({source, target, 0.0, 0.0});
+}
+
+QRectF rectOf(const std::vector<QPointF> &positions, int node) {
+    return QRectF(positions[size_t(node)], QSizeF(100.0, 50.0));
+}
+
+} // namespace
+
+class LayoutTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void regionFollowsFixedSources() {
+        qnodes::LayoutGraph graph;
+        int top = addNode(graph, {0.0, 0.0}, false);
+        int bottom = addNode(graph, {0.0, 1000.0}, false);
+
+        // Start out in the opposite order of their sources
+        int first = addNode(graph, {300.0, 900.0}, true);
+        int second = addNode(graph, {300.0, 100.0}, true);
+
+        link(graph, top, first);
+        link(graph, bottom, second);
+
+        std::vector<QPointF> result = qnodes::layeredLayout(graph);
+
+        QCOMPARE(result[size_t(top)], QPointF(0.0, 0.0));
+        QCOMPARE(result[size_t(bottom)], QPointF(0.0, 1000.0));
+
+        // One layer right of their sources, ordered and aligned like them
+        QCOMPARE(result[size_t(first)], QPointF(180.0, 0.0));
+        QCOMPARE(result[size_t(second)], QPointF(180.0, 1000.0));
+    }
+
+    void regionFollowsFixedTargets() {
+        qnodes::LayoutGraph graph;
+        int sink = addNode(graph, {1000.0, 500.0}, false);
+        int moved = addNode(graph, {0.0, 0.0}, true);
+        link(graph, moved, sink);
+
+        std::vector<QPointF> result = qnodes::layeredLayout(graph);
+
+        QCOMPARE(result[size_t(sink)], QPointF(1000.0, 500.0));
+        QCOMPARE(result[size_t(moved)], QPointF(820.0, 500.0));
+    }
+
+    void regionIsPushedClearOfFixedNodes() {
+        qnodes::LayoutGraph graph;
+        int source = addNode(graph, {0.0, 0.0}, false);
+
+        // Right where the region would go, next to its source
+        int blocker = addNode(graph, {180.0, 0.0}, false);
+        int moved = addNode(graph, {500.0, 500.0}, true);
+        link(graph, source, moved);
+
+        std::vector<QPointF> result = qnodes::layeredLayout(graph);
+
+        QCOMPARE(result[size_t(blocker)], QPointF(180.0, 0.0));
+        QVERIFY(result[size_t(moved)].x() > 100.0);
+        QVERIFY(!rectOf(result, moved).intersects(rectOf(result, blocker)));
+        QVERIFY(!rectOf(result, moved).intersects(rectOf(result, source)));
+    }
+};
+
+QTEST_MAIN(LayoutTest)
+#include "layout_test.moc"
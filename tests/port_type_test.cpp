@@ -0,0 +1,27 @@
+#include <QtTest>
+#include <qnodes/port_type.hpp>
+
+using qnodes::PortTypeRegistry;
+
+class PortTypeTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void typesBeyondTheLimitCannotConnect() {
+        PortTypeRegistry registry;
+        while (registry.typeCount() < PortTypeRegistry::maxTypes) {
+            registry.registerType(QByteArray::number(registry.typeCount()));
+        }
+
+        qnodes::PortTypeId extra = registry.registerType("extra");
+        QCOMPARE(extra, PortTypeRegistry::invalidType);
+
+        qnodes::PortTypeMask any =
+            PortTypeRegistry::maskOf(PortTypeRegistry::anyType);
+        QVERIFY(!registry.canConnect(extra, any));
+        QVERIFY(registry.canConnect(PortTypeRegistry::anyType, any));
+    }
+};
+
+QTEST_MAIN(PortTypeTest)
+#include "port_type_test.moc"
@@ -0,0 +1,42 @@
+#include <QThread>
+#include <QtTest>
+#include <qnodes/profiler.hpp>
+
+namespace {
+
+class RecordThread : public QThread {
+public:
+    explicit RecordThread(qnodes::Profiler *profiler)
+        : m_profiler(profiler) {}
+
+protected:
+    void run() override { m_profiler->record(nullptr, 10, 0); }
+
+private:
+    qnodes::Profiler *m_profiler;
+};
+
+} // namespace
+
+class ProfilerTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void keepsSamplesOfExitedThreads() {
+        qnodes::Profiler profiler;
+
+        // Later threads may take over the buffer released by an earlier one
+        for (int i = 0; i < 3; ++i) {
+            RecordThread thread(&profiler);
+            thread.start();
+            QVERIFY(thread.wait());
+        }
+
+        profiler.collect();
+        QCOMPARE(profiler.stats(nullptr).calls, qint64(3));
+        QCOMPARE(profiler.stats(nullptr).totalTime, qint64(30));
+    }
+};
+
+QTEST_MAIN(ProfilerTest)
+#include "profiler_test.moc"
@@ -0,0 +1,65 @@
+#include <QtTest>
+#include <qnodes/node.hpp>
+#include <qnodes/result_cache.hpp>
+
+namespace {
+
+// Custom type whose toString() is empty, like most registered types
+struct Handle {
+    int id = 0;
+    bool operator==(const Handle &other) const { return id == other.id; }
+};
+
+class PureNode : public qnodes::Node {
+public:
+    bool isPure() const override { return true; }
+};
+
+} // namespace
+
+Q_DECLARE_METATYPE(Handle)
+
+class ResultCacheTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase() {
+        QMetaType::registerEqualsComparator<Handle>();
+    }
+
+    void customTypesWithoutHasherAreNotCached() {
+        PureNode node;
+        QVariantList inputs{QVariant::fromValue(Handle{1})};
+
+        qnodes::ResultCache::Key key;
+        QVERIFY(!qnodes::ResultCache::isHashable(inputs[0]));
+        QVERIFY(!qnodes::ResultCache::makeKey(node, inputs, &key));
+    }
+
+    void equalStringsDoNotShareResults() {
+        // Every Handle hashes alike, so the keys collide
+        qnodes::ResultCache::registerHasher(
+            qMetaTypeId<Handle>(), [](const QVariant &) { return 0; });
+
+        PureNode node;
+        QVariantList a{QVariant::fromValue(Handle{1})};
+        QVariantList b{QVariant::fromValue(Handle{2})};
+        QCOMPARE(a[0].toString(), b[0].toString());
+
+        qnodes::ResultCache::Key keyA, keyB;
+        QVERIFY(qnodes::ResultCache::makeKey(node, a, &keyA));
+        QVERIFY(qnodes::ResultCache::makeKey(node, b, &keyB));
+        QCOMPARE(keyA.hash, keyB.hash);
+
+        qnodes::ResultCache cache;
+        cache.insert(keyA, {1.0});
+
+        QVariantList outputs;
+        QVERIFY(!cache.lookup(keyB, &outputs));
+        QVERIFY(cache.lookup(keyA, &outputs));
+        QCOMPARE(outputs, QVariantList{1.0});
+    }
+};
+
+QTEST_MAIN(ResultCacheTest)
+#include "result_cache_test.moc"
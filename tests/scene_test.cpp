@@ -0,0 +1,30 @@
+#include <QtTest>
+#include <qnodes/node.hpp>
+#include <qnodes/scene.hpp>
+
+class SceneTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void lassoInsideANodeIntersectsIt() {
+        qnodes::Scene scene;
+        auto node = new qnodes::Node();
+        node->addSlot(qnodes::Slot::Input, "in");
+        scene.addItem(node);
+
+        QPointF c = node->sceneBoundingRect().center();
+        QPolygonF lasso({c + QPointF(-2.0, -2.0), c + QPointF(2.0, -2.0),
+                         c + QPointF(2.0, 2.0), c + QPointF(-2.0, 2.0)});
+
+        scene.selectInPolygon(lasso, Qt::IntersectsItemShape,
+                              Qt::ReplaceSelection);
+        QVERIFY(node->isSelected());
+
+        scene.selectInPolygon(lasso, Qt::ContainsItemShape,
+                              Qt::ReplaceSelection);
+        QVERIFY(!node->isSelected());
+    }
+};
+
+QTEST_MAIN(SceneTest)
+#include "scene_test.moc"
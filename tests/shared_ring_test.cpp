@@ -0,0 +1,56 @@
+#include <QCoreApplication>
+#include <QSharedMemory>
+#include <QtTest>
+#include <cstring>
+#include <qnodes/shared_ring.hpp>
+
+namespace {
+
+QString uniqueKey(const char *name) {
+    return QString("qnodes-test-%1-%2")
+        .arg(QCoreApplication::applicationPid())
+        .arg(name);
+}
+
+} // namespace
+
+class SharedRingTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void wrapsAround() {
+        qnodes::SharedRing writer, reader;
+        QVERIFY(writer.create(uniqueKey("wrap"), 8));
+        QVERIFY(reader.attach(uniqueKey("wrap")));
+
+        char data[8];
+        QCOMPARE(writer.write("abcdef", 6), qint64(6));
+        QCOMPARE(reader.read(data, 4), qint64(4));
+        QCOMPARE(writer.write("ghijkl", 6), qint64(6));
+        QCOMPARE(reader.read(data, 8), qint64(8));
+        QCOMPARE(QByteArray(data, 8), QByteArray("efghijkl"));
+    }
+
+    void corruptIndicesCloseTheRing() {
+        qnodes::SharedRing ring;
+        QVERIFY(ring.create(uniqueKey("corrupt"), 64));
+
+        // The tail is the second cache line of the header
+        QSharedMemory memory(uniqueKey("corrupt"));
+        QVERIFY(memory.attach());
+        quint64 tail = 1000;
+        memory.lock();
+        std::memcpy(static_cast<char *>(memory.data()) + 64, &tail,
+                    sizeof(tail));
+        memory.unlock();
+
+        char data[16];
+        QCOMPARE(ring.bytesAvailable(), qint64(-1));
+        QCOMPARE(ring.read(data, sizeof(data)), qint64(-1));
+        QCOMPARE(ring.write(data, sizeof(data)), qint64(-1));
+        QCOMPARE(ring.freeSpace(), qint64(0));
+    }
+};
+
+QTEST_MAIN(SharedRingTest)
+#include "shared_ring_test.moc"
@@ -0,0 +1,562 @@
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QGraphicsSceneMouseEvent>
+#include <QRandomGenerator>
+#include <algorithm>
+#include <cstdio>
+#include <qnodes/connection.hpp>
+#include <qnodes/evaluator.hpp>
+#include <qnodes/graph_generator.hpp>
+#include <qnodes/memory_stats.hpp>
+#include <qnodes/node.hpp>
+#include <qnodes/scene.hpp>
+#include <unordered_map>
+#include <unordered_set>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(Q_OS_UNIX)
+#include <sys/resource.h>
+#endif
+
+// Replays random edits against a generated graph and checks the scene's
+// invariants along the way, e.g.
+//   qnodes_soak --seed 7 --nodes 2000 --edits 1000000
+// Build with QNodes_SANITIZER=address or thread to run it under a
+// sanitizer. Exits with 1 on the first broken invariant.
+
+using namespace qnodes;
+
+static qint64 peakRssKiB() {
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters,
+                             sizeof(counters))) {
+        return qint64(counters.PeakWorkingSetSize / 1024);
+    }
+    return -1;
+#elif defined(Q_OS_UNIX)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return -1;
+    }
+#if defined(Q_OS_MACOS)
+    return qint64(usage.ru_maxrss) / 1024;
+#else
+    return qint64(usage.ru_maxrss);
+#endif
+#else
+    return -1;
+#endif
+}
+
+// Vector with constant time removal, to pick random elements from.
+template <typename T> class PickSet {
+public:
+    void insert(T value) {
+        if (m_index.emplace(value, m_values.size()).second) {
+            m_values.push_back(value);
+        }
+    }
+
+    void erase(T value) {
+        auto it = m_index.find(value);
+        if (it == m_index.end()) {
+            return;
+        }
+
+        T last = m_values.back();
+        m_values[it->second] = last;
+        m_index[last] = it->second;
+        m_values.pop_back();
+        m_index.erase(value);
+    }
+
+    bool contains(T value) const { return m_index.count(value) != 0; }
+    size_t size() const { return m_values.size(); }
+    bool empty() const { return m_values.empty(); }
+
+    T pick(QRandomGenerator &random) const {
+        return m_values[size_t(random.bounded(int(m_values.size())))];
+    }
+
+private:
+    std::vector<T> m_values;
+    std::unordered_map<T, size_t> m_index;
+};
+
+class Soak {
+public:
+    Soak(Scene *scene, quint32 seed, int maxNodes)
+        : m_scene(scene), m_random(seed), m_maxNodes(maxNodes) {
+        for (Node *node : scene->nodes()) {
+            m_nodes.insert(node);
+        }
+        for (Connection *conn : scene->connections()) {
+            m_connections.insert(conn);
+        }
+
+        // Follow the scene, so that nodes and connections deleted by a
+        // cascade are never picked again
+        QObject::connect(scene, &Scene::nodeAdded, &m_context,
+                         [this](Node *node) { m_nodes.insert(node); });
+        QObject::connect(scene, &Scene::nodeRemoved, &m_context,
+                         [this](Node *node) { m_nodes.erase(node); });
+        QObject::connect(
+            scene, &Scene::connectionAdded, &m_context,
+            [this](Connection *conn) { m_connections.insert(conn); });
+        QObject::connect(
+            scene, &Scene::connectionRemoved, &m_context,
+            [this](Connection *conn) { m_connections.erase(conn); });
+    }
+
+    int nodeCount() const { return int(m_nodes.size()); }
+    int connectionCount() const { return int(m_connections.size()); }
+
+    void edit() {
+        int op = int(m_random.bounded(100));
+
+        if (op < 15) {
+            if (nodeCount() < m_maxNodes) {
+                addNode();
+            } else {
+                deleteNode();
+            }
+        } else if (op < 25) {
+            deleteNode();
+        } else if (op < 50) {
+            connectSlots();
+        } else if (op < 60) {
+            disconnectSlots();
+        } else if (op < 70) {
+            rewire();
+        } else if (op < 98) {
+            moveNode();
+        } else {
+            drag();
+        }
+    }
+
+    // Runs the deleteLater() calls of the connection cascades.
+    static void flush() {
+        QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+    }
+
+    // Returns a description of the first broken invariant, or an empty
+    // string. Only meaningful right after flush().
+    QString check() const {
+        std::unordered_set<Node *> nodes;
+        std::unordered_set<Connection *> connections;
+
+        for (QGraphicsItem *item : m_scene->items()) {
+            if (Node *node = dynamic_cast<Node *>(item)) {
+                nodes.insert(node);
+            } else if (Connection *conn = dynamic_cast<Connection *>(item)) {
+                connections.insert(conn);
+            }
+        }
+
+        std::vector<Node *> sceneNodes = m_scene->nodes();
+        if ((sceneNodes.size() != nodes.size()) ||
+            (m_nodes.size() != nodes.size())) {
+            return QString("%1 node items, %2 registered, %3 tracked")
+                .arg(nodes.size())
+                .arg(sceneNodes.size())
+                .arg(m_nodes.size());
+        }
+
+        const SpatialIndex &nodeIndex = m_scene->nodeIndex();
+        if (nodeIndex.size() != nodes.size()) {
+            return QString("%1 nodes, %2 in the node index")
+                .arg(nodes.size())
+                .arg(nodeIndex.size());
+        }
+
+        for (Node *node : sceneNodes) {
+            quintptr id = reinterpret_cast<quintptr>(node);
+            if (!nodes.count(node) || !m_nodes.contains(node)) {
+                return QString("stray registered node %1").arg(node->label());
+            }
+            if (nodeIndex.rect(id) != node->sceneBoundingRect()) {
+                return QString("stale index rect of %1").arg(node->label());
+            }
+        }
+
+        std::vector<Connection *> sceneConnections = m_scene->connections();
+        if ((sceneConnections.size() != connections.size()) ||
+            (m_connections.size() != connections.size()) ||
+            (m_scene->connectionIndex().size() != connections.size())) {
+            return QString("%1 connection items, %2 registered, %3 tracked, "
+                           "%4 in the connection index")
+                .arg(connections.size())
+                .arg(sceneConnections.size())
+                .arg(m_connections.size())
+                .arg(m_scene->connectionIndex().size());
+        }
+
+        for (Connection *conn : sceneConnections) {
+            if (!connections.count(conn) ||
+                !m_scene->connectionIndex().contains(
+                    reinterpret_cast<quintptr>(conn))) {
+                return "stray registered connection";
+            }
+
+            Slot *source = conn->sourceSlot();
+            Slot *target = conn->targetSlot();
+            if (!source || !target) {
+                return "connection with a deleted slot survived a flush";
+            }
+            if ((source->slotType() != Slot::Output) ||
+                (target->slotType() != Slot::Input)) {
+                return "connection between slots of the wrong type";
+            }
+            if (!nodes.count(source->node()) || !nodes.count(target->node())) {
+                return "connection to a node outside the scene";
+            }
+            if (!attached(source, conn) || !attached(target, conn)) {
+                return "connection missing from the list of its slot";
+            }
+        }
+
+        for (Node *node : sceneNodes) {
+            for (Slot::Type type : {Slot::Input, Slot::Output}) {
+                for (int i = 0; i < node->slotCount(type); ++i) {
+                    Slot *slot = node->slot(type, i);
+                    for (Connection *conn : slot->connections()) {
+                        if (!connections.count(conn)) {
+                            return QString("slot of %1 lists a connection "
+                                           "that is not in the scene")
+                                .arg(node->label());
+                        }
+                        if ((conn->sourceSlot() != slot) &&
+                            (conn->targetSlot() != slot)) {
+                            return QString("slot of %1 lists a foreign "
+                                           "connection")
+                                .arg(node->label());
+                        }
+                    }
+                }
+            }
+        }
+
+        // Every item has exactly one account while it exists
+        MemoryUsage memory = MemoryStats::snapshot();
+        qint64 slots = 0;
+        for (Node *node : sceneNodes) {
+            slots += node->slotCount(Slot::Input) +
+                     node->slotCount(Slot::Output);
+        }
+
+        if ((memory[MemoryUsage::NodeItems].count != qint64(nodes.size())) ||
+            (memory[MemoryUsage::SlotItems].count != slots) ||
+            (memory[MemoryUsage::ConnectionItems].count !=
+             qint64(connections.size()))) {
+            return QString("memory accounts for %1 nodes, %2 slots and %3 "
+                           "connections")
+                .arg(memory[MemoryUsage::NodeItems].count)
+                .arg(memory[MemoryUsage::SlotItems].count)
+                .arg(memory[MemoryUsage::ConnectionItems].count);
+        }
+
+        return {};
+    }
+
+private:
+    Scene *m_scene;
+    QRandomGenerator m_random;
+    int m_maxNodes;
+    PickSet<Node *> m_nodes;
+    PickSet<Connection *> m_connections;
+    int m_created = 0;
+    QObject m_context; // disconnects from the scene when the soak ends
+
+    static bool attached(const Slot *slot, const Connection *conn) {
+        for (Connection *other : slot->connections()) {
+            if (other == conn) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static bool connected(const Slot *source, const Slot *target) {
+        for (Connection *conn : source->connections()) {
+            if (conn->targetSlot() == target) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    QPointF randomPos() {
+        return QPointF(m_random.bounded(20000.0), m_random.bounded(20000.0));
+    }
+
+    Slot *randomSlot(Slot::Type type) {
+        if (m_nodes.empty()) {
+            return nullptr;
+        }
+
+        Node *node = m_nodes.pick(m_random);
+        int count = node->slotCount(type);
+        return count ? node->slot(type, int(m_random.bounded(count)))
+                     : nullptr;
+    }
+
+    void addNode() {
+        Node *node = new Node();
+        node->setLabel(QString("Soak %1").arg(m_created++));
+
+        int inputs = int(m_random.bounded(4));
+        int outputs = int(m_random.bounded(3));
+        for (int i = 0; i < inputs; ++i) {
+            node->addSlot(Slot::Input, QString("in %1").arg(i));
+        }
+        for (int i = 0; i < outputs; ++i) {
+            node->addSlot(Slot::Output, QString("out %1").arg(i));
+        }
+
+        node->setPos(randomPos());
+        m_scene->addItem(node);
+    }
+
+    // Mostly immediate deletes, which cascade to the connections through
+    // Slot::destroyed, and some deferred ones.
+    void deleteNode() {
+        if (m_nodes.empty()) {
+            return;
+        }
+
+        Node *node = m_nodes.pick(m_random);
+        if (m_random.bounded(4) == 0) {
+            node->deleteLater();
+        } else {
+            delete node;
+        }
+    }
+
+    void connectSlots() {
+        Slot *source = randomSlot(Slot::Output);
+        Slot *target = randomSlot(Slot::Input);
+        if (!source || !target || (source->node() == target->node()) ||
+            connected(source, target)) {
+            return;
+        }
+
+        // Both orders in which the library itself builds connections
+        Connection *conn = new Connection(source);
+        if (m_random.bounded(2)) {
+            conn->setTargetSlot(target);
+            m_scene->addItem(conn);
+        } else {
+            m_scene->addItem(conn);
+            conn->setTargetSlot(target);
+        }
+    }
+
+    void disconnectSlots() {
+        if (m_connections.empty()) {
+            return;
+        }
+
+        Connection *conn = m_connections.pick(m_random);
+        if (m_random.bounded(2)) {
+            conn->deleteLater();
+        } else {
+            delete conn;
+        }
+    }
+
+    void rewire() {
+        if (m_connections.empty()) {
+            return;
+        }
+
+        Connection *conn = m_connections.pick(m_random);
+        Slot *source = conn->sourceSlot();
+        Slot *target = randomSlot(Slot::Input);
+        if (!source || !conn->targetSlot() || !target ||
+            (source->node() == target->node()) || connected(source, target)) {
+            return;
+        }
+
+        conn->setTargetSlot(target);
+    }
+
+    void moveNode() {
+        if (m_nodes.empty()) {
+            return;
+        }
+
+        Node *node = m_nodes.pick(m_random);
+        if (m_random.bounded(4) == 0) {
+            node->setPos(randomPos());
+        } else {
+            node->moveBy(m_random.bounded(200.0) - 100.0,
+                         m_random.bounded(200.0) - 100.0);
+        }
+    }
+
+    void sendMouse(Slot *slot, QEvent::Type type, const QPointF &pos) {
+        QGraphicsSceneMouseEvent event(type);
+        event.setScenePos(pos);
+        event.setButton(Qt::LeftButton);
+        event.setButtons(type == QEvent::GraphicsSceneMouseRelease
+                             ? Qt::NoButton
+                             : Qt::LeftButton);
+        m_scene->sendEvent(slot, &event);
+    }
+
+    // Drags a connection out of an output slot the way the mouse does, and
+    // finishes it on an input, in empty space, or by deleting the node at
+    // either end while the drag is in progress.
+    void drag() {
+        Slot *source = randomSlot(Slot::Output);
+        if (!source) {
+            return;
+        }
+
+        Slot *target = randomSlot(Slot::Input);
+        QPointF end = target ? target->scenePos() : randomPos();
+
+        sendMouse(source, QEvent::GraphicsSceneMousePress, source->scenePos());
+        sendMouse(source, QEvent::GraphicsSceneMouseMove, end);
+
+        switch (m_random.bounded(4)) {
+        case 0:
+            delete source->node();
+            return;
+        case 1:
+            if (target && (target->node() != source->node())) {
+                delete target->node();
+            }
+            break;
+        default:
+            break;
+        }
+
+        sendMouse(source, QEvent::GraphicsSceneMouseRelease, end);
+    }
+};
+
+int main(int argc, char **argv) {
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Replays random edits against a scene and checks its invariants.");
+    parser.addHelpOption();
+
+    QCommandLineOption seedOption("seed", "Random seed.", "number", "1");
+    QCommandLineOption nodesOption("nodes", "Nodes in the initial graph.",
+                                   "count", "1000");
+    QCommandLineOption depthOption("depth", "Layers of the initial graph.",
+                                   "count", "10");
+    QCommandLineOption editsOption("edits", "Number of edits.", "count",
+                                   "1000000");
+    QCommandLineOption maxNodesOption(
+        "max-nodes", "Nodes are deleted instead of added above this.",
+        "count", "5000");
+    QCommandLineOption flushOption(
+        "flush-interval", "Edits between running deferred deletes.", "count",
+        "64");
+    QCommandLineOption checkOption(
+        "check-interval", "Edits between invariant checks and reports.",
+        "count", "10000");
+    QCommandLineOption evaluateOption(
+        "evaluate-interval", "Edits between evaluations, 0 for none.",
+        "count", "0");
+
+    parser.addOptions({seedOption, nodesOption, depthOption, editsOption,
+                       maxNodesOption, flushOption, checkOption,
+                       evaluateOption});
+    parser.process(app);
+
+    quint32 seed = parser.value(seedOption).toUInt();
+    qint64 edits = parser.value(editsOption).toLongLong();
+    int flushInterval = std::max(1, parser.value(flushOption).toInt());
+    int checkInterval = std::max(1, parser.value(checkOption).toInt());
+    int evaluateInterval = parser.value(evaluateOption).toInt();
+
+    GeneratorOptions generator;
+    generator.seed = seed;
+    generator.nodeCount = parser.value(nodesOption).toInt();
+    generator.depth = parser.value(depthOption).toInt();
+
+    Scene scene;
+    scene.setItemIndexMethod(QGraphicsScene::NoIndex);
+
+    QElapsedTimer timer;
+    timer.start();
+    instantiateGraph(&scene, generateGraph(generator));
+    std::printf("generated %d nodes and %d connections in %lld ms\n",
+                int(scene.nodes().size()), int(scene.connections().size()),
+                static_cast<long long>(timer.elapsed()));
+
+    Soak soak(&scene, seed, parser.value(maxNodesOption).toInt());
+    Evaluator evaluator(&scene);
+
+    auto fail = [&](qint64 edit, const QString &error) {
+        std::fprintf(stderr, "invariant broken after edit %lld (seed %u): %s\n",
+                     static_cast<long long>(edit), seed, qPrintable(error));
+        return 1;
+    };
+
+    QString error = soak.check();
+    if (!error.isEmpty()) {
+        return fail(0, error);
+    }
+
+    timer.restart();
+    qint64 lastReport = 0;
+    qint64 lastElapsed = 0;
+
+    for (qint64 edit = 1; edit <= edits; ++edit) {
+        soak.edit();
+
+        if ((edit % flushInterval) == 0) {
+            Soak::flush();
+        }
+
+        if ((evaluateInterval > 0) && ((edit % evaluateInterval) == 0)) {
+            evaluator.evaluate();
+        }
+
+        if (((edit % checkInterval) == 0) || (edit == edits)) {
+            Soak::flush();
+            error = soak.check();
+            if (!error.isEmpty()) {
+                return fail(edit, error);
+            }
+
+            qint64 elapsed = timer.elapsed();
+            double rate = double(edit - lastReport) * 1000.0 /
+                          double(std::max<qint64>(1, elapsed - lastElapsed));
+            lastReport = edit;
+            lastElapsed = elapsed;
+
+            std::printf("%lld edits, %d nodes, %d connections, %.0f edits/s, "
+                        "accounted %lld KiB, peak RSS %lld KiB\n",
+                        static_cast<long long>(edit), soak.nodeCount(),
+                        soak.connectionCount(), rate,
+                        static_cast<long long>(
+                            MemoryStats::snapshot().totalBytes() / 1024),
+                        static_cast<long long>(peakRssKiB()));
+            std::fflush(stdout);
+        }
+    }
+
+    double seconds = double(std::max<qint64>(1, timer.elapsed())) / 1000.0;
+    std::printf("passed %lld edits in %.1f s, %.0f edits/s, peak RSS %lld "
+                "KiB\n",
+                static_cast<long long>(edits), seconds,
+                double(edits) / seconds,
+                static_cast<long long>(peakRssKiB()));
+    return 0;
+}
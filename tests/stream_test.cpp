@@ -0,0 +1,157 @@
+#include <QtTest>
+#include <atomic>
+#include <functional>
+#include <qnodes/connection.hpp>
+#include <qnodes/node.hpp>
+#include <qnodes/scene.hpp>
+#include <qnodes/stream.hpp>
+
+namespace {
+
+using Factory = std::function<std::unique_ptr<qnodes::StreamProcessor>()>;
+
+class StreamNode : public qnodes::Node {
+public:
+    StreamNode(int inputs, int outputs, Factory factory)
+        : m_factory(std::move(factory)) {
+        for (int i = 0; i < inputs; ++i) {
+            addSlot(qnodes::Slot::Input, QString("in %1").arg(i));
+        }
+
+        for (int i = 0; i < outputs; ++i) {
+            addSlot(qnodes::Slot::Output, QString("out %1").arg(i));
+        }
+    }
+
+    std::unique_ptr<qnodes::StreamProcessor> createStreamProcessor() override {
+        return m_factory();
+    }
+
+private:
+    Factory m_factory;
+};
+
+// Emits `count` chunks holding a single 1.0
+class CountingSource : public qnodes::StreamProcessor {
+public:
+    explicit CountingSource(int count) : m_remaining(count) {}
+
+    bool process(const std::vector<const qnodes::Chunk *> &inputs,
+                 const std::vector<qnodes::Chunk *> &outputs) override {
+        ((void)inputs);
+
+        if (m_remaining == 0) {
+            return false;
+        }
+
+        --m_remaining;
+        outputs[0]->data()[0] = 1.0f;
+        outputs[0]->setSize(1);
+        return true;
+    }
+
+private:
+    int m_remaining;
+};
+
+struct Totals {
+    std::atomic<int> calls{0};
+    std::atomic<int> samples[2];
+
+    Totals() {
+        samples[0] = 0;
+        samples[1] = 0;
+    }
+};
+
+// Sums the samples that arrive on each input
+class SummingSink : public qnodes::StreamProcessor {
+public:
+    explicit SummingSink(std::shared_ptr<Totals> totals)
+        : m_totals(std::move(totals)) {}
+
+    bool process(const std::vector<const qnodes::Chunk *> &inputs,
+                 const std::vector<qnodes::Chunk *> &outputs) override {
+        ((void)outputs);
+
+        ++m_totals->calls;
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            if (inputs[i]) {
+                for (int j = 0; j < inputs[i]->size(); ++j) {
+                    m_totals->samples[i] += int(inputs[i]->data()[j]);
+                }
+            }
+        }
+
+        return true;
+    }
+
+private:
+    std::shared_ptr<Totals> m_totals;
+};
+
+StreamNode *addSource(qnodes::Scene &scene, int count) {
+    auto node = new StreamNode(0, 1, [count]() {
+        return std::make_unique<CountingSource>(count);
+    });
+    scene.addItem(node);
+    return node;
+}
+
+StreamNode *addSink(qnodes::Scene &scene, std::shared_ptr<Totals> totals) {
+    auto node = new StreamNode(2, 0, [totals]() {
+        return std::make_unique<SummingSink>(totals);
+    });
+    scene.addItem(node);
+    return node;
+}
+
+void link(qnodes::Scene &scene, qnodes::Node *source,
+          qnodes::Node *target, int input) {
+    auto conn = new qnodes::Connection(source->slot(qnodes::Slot::Output, 0));
+    conn->setTargetSlot(target->slot(qnodes::Slot::Input, input));
+    scene.addItem(conn);
+}
+
+} // namespace
+
+class StreamTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void sourcesOfDifferentLengths() {
+        qnodes::Scene scene;
+        auto totals = std::make_shared<Totals>();
+
+        StreamNode *sink = addSink(scene, totals);
+        link(scene, addSource(scene, 3), sink, 0);
+        link(scene, addSource(scene, 50), sink, 1);
+
+        qnodes::StreamExecutor executor(&scene);
+        executor.setQueueCapacity(2);
+        QSignalSpy finished(&executor, &qnodes::StreamExecutor::finished);
+
+        QVERIFY(executor.start());
+        QVERIFY(finished.wait(10000));
+
+        QCOMPARE(totals->samples[0].load(), 3);
+        QCOMPARE(totals->samples[1].load(), 50);
+        QCOMPARE(totals->calls.load(), 50);
+    }
+
+    void unconnectedInputsAreClosed() {
+        qnodes::Scene scene;
+        auto totals = std::make_shared<Totals>();
+        addSink(scene, totals);
+
+        qnodes::StreamExecutor executor(&scene);
+        QSignalSpy finished(&executor, &qnodes::StreamExecutor::finished);
+
+        QVERIFY(executor.start());
+        QVERIFY(finished.wait(10000));
+        QCOMPARE(totals->calls.load(), 0);
+    }
+};
+
+QTEST_MAIN(StreamTest)
+#include "stream_test.moc"
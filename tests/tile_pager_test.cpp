@@ -0,0 +1,65 @@
+#include <QTemporaryDir>
+#include <QtTest>
+#include <qnodes/node.hpp>
+#include <qnodes/scene.hpp>
+#include <qnodes/tile_pager.hpp>
+#include <qnodes/tile_store.hpp>
+
+class TilePagerTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase() {
+        QVERIFY(m_dir.isValid());
+
+        // One node in each tile of a 300 x 300 grid
+        qnodes::TileStoreBuilder builder(100.0);
+        for (int y = 0; y < 300; ++y) {
+            for (int x = 0; x < 300; ++x) {
+                builder.addNode("Node", {}, QPointF(x * 100.0, y * 100.0));
+            }
+        }
+
+        QVERIFY(builder.save(m_dir.filePath("store")));
+        QVERIFY(m_store.open(m_dir.filePath("store")));
+    }
+
+    void zoomedOutSummariesAreBounded() {
+        qnodes::Scene scene;
+        qnodes::TilePager pager(&scene, &m_store, &createNode);
+
+        pager.setViewport(m_store.bounds());
+        QCOMPARE(pager.residentTileCount(), 0);
+        QVERIFY(pager.summaryTileCount() > 0);
+        QVERIFY(pager.summaryTileCount() <= qnodes::TilePager::maxSummaryCells);
+        QVERIFY(scene.items().size() <= qnodes::TilePager::maxSummaryCells);
+
+        // Far larger than the store
+        pager.setViewport(m_store.bounds().adjusted(-1e7, -1e7, 1e7, 1e7));
+        QVERIFY(pager.summaryTileCount() <= qnodes::TilePager::maxSummaryCells);
+    }
+
+    void zoomingInReplacesSummariesWithNodes() {
+        qnodes::Scene scene;
+        qnodes::TilePager pager(&scene, &m_store, &createNode);
+
+        pager.setViewport(m_store.bounds());
+        pager.setViewport(QRectF(1000.0, 1000.0, 300.0, 300.0));
+        QCOMPARE(pager.summaryTileCount(), 0);
+        QVERIFY(pager.residentTileCount() > 0);
+        QVERIFY(pager.residentTileCount() <=
+                qnodes::TilePager::maxResidentTiles);
+    }
+
+private:
+    QTemporaryDir m_dir;
+    qnodes::TileStore m_store;
+
+    static qnodes::Node *createNode(const QByteArray &typeName) {
+        ((void)typeName);
+        return new qnodes::Node();
+    }
+};
+
+QTEST_MAIN(TilePagerTest)
+#include "tile_pager_test.moc"